@@ -0,0 +1,33 @@
+struct Uniforms {
+    mvp: mat4x4<f32>,
+    // Rotation of the cube, used to light the normals in world space
+    rotation: mat4x4<f32>,
+    color: vec4<f32>,
+};
+
+@group(0) @binding(0) var<uniform> uniforms: Uniforms;
+
+struct VertexInput {
+    @location(0) position: vec3<f32>,
+    @location(1) normal: vec3<f32>,
+};
+
+struct VertexOutput {
+    @builtin(position) clip_position: vec4<f32>,
+    @location(0) normal: vec3<f32>,
+};
+
+@vertex
+fn vs_main(in: VertexInput) -> VertexOutput {
+    var out: VertexOutput;
+    out.clip_position = uniforms.mvp * vec4<f32>(in.position, 1.0);
+    out.normal = (uniforms.rotation * vec4<f32>(in.normal, 0.0)).xyz;
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
+    let light = normalize(vec3<f32>(0.4, 0.8, 0.6));
+    let diffuse = max(dot(normalize(in.normal), light), 0.0);
+    return vec4<f32>(uniforms.color.rgb * (0.15 + 0.85 * diffuse), 1.0);
+}
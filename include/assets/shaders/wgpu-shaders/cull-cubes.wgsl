@@ -0,0 +1,54 @@
+struct Uniforms {
+    view_proj: mat4x4<f32>,
+    color: vec4<f32>,
+};
+
+@group(0) @binding(0) var<uniform> uniforms: Uniforms;
+// Bounding sphere of every cube, the center in xyz and the radius in w
+@group(0) @binding(1) var<storage, read> spheres: array<vec4<f32>>;
+// Indices of the cubes that passed the GPU culling, see nano_create_cull()
+@group(0) @binding(2) var<storage, read> visible: array<u32>;
+
+struct VertexInput {
+    @location(0) position: vec3<f32>,
+    @location(1) normal: vec3<f32>,
+};
+
+struct VertexOutput {
+    @builtin(position) clip_position: vec4<f32>,
+    @location(0) normal: vec3<f32>,
+    @location(1) tint: vec3<f32>,
+};
+
+// A color per cube from a hash of its index
+fn tint(index: u32) -> vec3<f32> {
+    let h = f32((index * 2654435761u) >> 8u) / 16777216.0;
+    return 0.6 + 0.4 * cos(6.2831853 * (h + vec3<f32>(0.0, 0.33, 0.67)));
+}
+
+@vertex
+fn vs_main(in: VertexInput,
+           @builtin(instance_index) instance: u32) -> VertexOutput {
+    let index = visible[instance];
+    let sphere = spheres[index];
+
+    // The unit cube spans -1 to 1, its bounding sphere has a radius of
+    // sqrt(3) times its half size
+    let half_size = sphere.w * 0.57735027;
+
+    var out: VertexOutput;
+    out.clip_position =
+        uniforms.view_proj * vec4<f32>(sphere.xyz + in.position * half_size,
+                                       1.0);
+    out.normal = in.normal;
+    out.tint = tint(index);
+    return out;
+}
+
+@fragment
+fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {
+    let light = normalize(vec3<f32>(0.4, 0.8, 0.6));
+    let diffuse = max(dot(normalize(in.normal), light), 0.0);
+    let color = uniforms.color.rgb * in.tint;
+    return vec4<f32>(color * (0.2 + 0.8 * diffuse), 1.0);
+}
@@ -1,9 +1,15 @@
-struct Uniforms {
-    @align(8) time: f32,
-    @align(8) resolution: vec2<f32>,
+// Written by Nano once per frame and shared by every shader that declares
+// it, see nano_frame_uniforms_t in nano.h
+struct NanoFrame {
+    resolution: vec2<f32>,
+    mouse: vec2<f32>,
+    time: f32,
+    delta_time: f32,
+    frame: u32,
+    seed: u32,
 };
 
-@group(0) @binding(0) var<uniform> uniforms: Uniforms;
+@group(0) @binding(0) var<uniform> frame: NanoFrame;
 
 struct VertexOutput {
     @builtin(position) position: vec4<f32>,
@@ -30,11 +36,11 @@ fn vs_main(@builtin(vertex_index) vertexIndex: u32) -> VertexOutput {
 
 @fragment
 fn fs_main(@location(0) uv: vec2<f32>) -> @location(0) vec4<f32> {
-    let aspect = uniforms.resolution.x / uniforms.resolution.y;
+    let aspect = frame.resolution.x / frame.resolution.y;
     let uv_aspect = vec2<f32>((uv.x - 0.5) * aspect, uv.y - 0.5);
     
     // Oscillating offset
-    let offset = vec2<f32>(0.0, sin(uniforms.time * 2.0) * 0.2);
+    let offset = vec2<f32>(0.0, sin(frame.time * 2.0) * 0.2);
     
     // Calculate distance from current pixel to the oscillating center
     let dist = length(uv_aspect - offset);
@@ -0,0 +1,24 @@
+// A triangle a few pixels wide in the middle of the screen. It costs
+// almost nothing to rasterize, so drawing it many times measures the
+// overhead of each draw.
+struct VertexOutput {
+    @builtin(position) position: vec4<f32>,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32) -> VertexOutput {
+    var pos = array<vec2<f32>, 3>(
+        vec2<f32>(-0.005, -0.005),
+        vec2<f32>(0.005, -0.005),
+        vec2<f32>(0.0, 0.005)
+    );
+
+    var output: VertexOutput;
+    output.position = vec4<f32>(pos[vertexIndex], 0.0, 1.0);
+    return output;
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+    return vec4<f32>(1.0, 0.5, 0.0, 1.0);
+}
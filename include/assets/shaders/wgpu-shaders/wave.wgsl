@@ -1,10 +1,12 @@
+// The C side of this struct is generated with tools/nano_structgen.c,
+// see samples/wave_demo/wave_structs.h
 struct Uniforms {
-    @align(8) time: f32,
-    @align(8) resolution: vec2<f32>,
-    @align(4) frequency: f32,
-    @align(4) amplitude: f32,
-    @align(4) speed: f32,
-    @align(4) thickness: f32,
+    time: f32,
+    resolution: vec2<f32>,
+    frequency: f32,
+    amplitude: f32,
+    speed: f32,
+    thickness: f32,
 };
 
 @group(0) @binding(0) var<uniform> uniforms: Uniforms;
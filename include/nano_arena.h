@@ -0,0 +1,195 @@
+// ---------------------------------------------------------------------
+//  nano_arena.h
+//  --------------------------------------------------------------------
+//  Linear arena allocators for Nano
+//  --------------------------------------------------------------------
+//
+//  An arena hands out memory by bumping an offset and frees everything at
+//  once, so transient allocations never go through malloc() and free().
+//
+//  Nano keeps two arenas:
+//  - nano_frame_arena: reset by nano_start_frame(), for data that only has
+//    to live until the end of the frame.
+//  - nano_build_arena: used in scopes while creating and building shaders,
+//    see nano_arena_mark() and nano_arena_rewind().
+//
+//  The arenas are thread local, each render thread gets its own pair.
+//
+//  When an arena runs out of space it chains a new block. The next reset
+//  merges the blocks into one block sized for the peak usage, so an arena
+//  stops allocating once it has seen its largest frame.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_ARENA_H
+#define NANO_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Alignment of every allocation, enough for any scalar or SIMD type
+#define NANO_ARENA_ALIGN 16
+
+// Size of the first block of an arena
+#ifndef NANO_ARENA_BLOCK_SIZE
+    #define NANO_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+typedef struct nano_arena_block_t {
+    struct nano_arena_block_t *prev;
+    size_t capacity;
+    size_t used;
+    _Alignas(NANO_ARENA_ALIGN) uint8_t data[];
+} nano_arena_block_t;
+
+typedef struct {
+    const char *name;
+    nano_arena_block_t *block;
+
+    // Stats shown in the debug UI
+    size_t used;
+    size_t peak;
+    size_t capacity;
+    uint32_t block_count;
+    // Number of times the arena had to call malloc()
+    uint32_t system_allocs;
+} nano_arena_t;
+
+// Position in an arena that it can be rewound to
+typedef struct {
+    nano_arena_block_t *block;
+    size_t block_used;
+    size_t used;
+} nano_arena_mark_t;
+
+static _Thread_local nano_arena_t nano_frame_arena = {.name = "Frame Arena"};
+static _Thread_local nano_arena_t nano_build_arena = {.name = "Build Arena"};
+
+// Chain a new block with room for at least size bytes
+static bool _nano_arena_grow(nano_arena_t *arena, size_t size) {
+    size_t capacity = NANO_ARENA_BLOCK_SIZE;
+    if (arena->block != NULL && arena->block->capacity * 2 > capacity) {
+        capacity = arena->block->capacity * 2;
+    }
+    if (capacity < size) {
+        capacity = size;
+    }
+
+    nano_arena_block_t *block =
+        (nano_arena_block_t *)malloc(sizeof(nano_arena_block_t) + capacity);
+    if (block == NULL) {
+        return false;
+    }
+
+    block->prev = arena->block;
+    block->capacity = capacity;
+    block->used = 0;
+
+    arena->block = block;
+    arena->capacity += capacity;
+    arena->block_count++;
+    arena->system_allocs++;
+    return true;
+}
+
+// Allocate size bytes from the arena, returns NULL if out of memory
+void *nano_arena_alloc(nano_arena_t *arena, size_t size) {
+    size = (size + NANO_ARENA_ALIGN - 1) & ~(size_t)(NANO_ARENA_ALIGN - 1);
+    if (size == 0) {
+        size = NANO_ARENA_ALIGN;
+    }
+
+    nano_arena_block_t *block = arena->block;
+    if (block == NULL || block->used + size > block->capacity) {
+        if (!_nano_arena_grow(arena, size)) {
+            return NULL;
+        }
+        block = arena->block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return ptr;
+}
+
+// Allocate zeroed memory from the arena
+void *nano_arena_calloc(nano_arena_t *arena, size_t count, size_t size) {
+    void *ptr = nano_arena_alloc(arena, count * size);
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+// Copy a string into the arena
+char *nano_arena_strdup(nano_arena_t *arena, const char *str) {
+    size_t length = strlen(str) + 1;
+    char *copy = (char *)nano_arena_alloc(arena, length);
+    if (copy != NULL) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+// Remember the current position of the arena
+nano_arena_mark_t nano_arena_mark(nano_arena_t *arena) {
+    return (nano_arena_mark_t){
+        .block = arena->block,
+        .block_used = arena->block ? arena->block->used : 0,
+        .used = arena->used,
+    };
+}
+
+// Free everything allocated since the mark was taken
+// Blocks chained after the mark are kept until the next reset.
+void nano_arena_rewind(nano_arena_t *arena, nano_arena_mark_t mark) {
+    for (nano_arena_block_t *block = arena->block; block != mark.block;
+         block = block->prev) {
+        block->used = 0;
+    }
+    if (mark.block != NULL) {
+        mark.block->used = mark.block_used;
+    }
+    arena->used = mark.used;
+}
+
+// Free every block of the arena
+void nano_arena_release(nano_arena_t *arena) {
+    nano_arena_block_t *block = arena->block;
+    while (block != NULL) {
+        nano_arena_block_t *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+
+    arena->block = NULL;
+    arena->used = 0;
+    arena->capacity = 0;
+    arena->block_count = 0;
+}
+
+// Free everything in the arena. If the arena needed more than one block,
+// they are replaced with a single block large enough for the peak usage.
+void nano_arena_reset(nano_arena_t *arena) {
+    if (arena->block_count > 1) {
+        size_t peak = arena->peak;
+        nano_arena_release(arena);
+        _nano_arena_grow(arena, peak);
+        return;
+    }
+
+    if (arena->block != NULL) {
+        arena->block->used = 0;
+    }
+    arena->used = 0;
+}
+
+#endif // NANO_ARENA_H
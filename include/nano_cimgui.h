@@ -12,6 +12,9 @@
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #include "cimgui/cimgui.h"
 
+// Transient vertex and index data is staged in the frame arena
+#include "nano_arena.h"
+
 // Replace ImGui macros with standard C equivalents
 #define IM_ASSERT(expr) assert(expr)
 #define IM_ALLOC(size) malloc(size)
@@ -244,6 +247,7 @@ void nano_cimgui_end_frame(WGPUCommandEncoder cmd_encoder,
                            WGPUTextureView (*get_resolve_view)(void));
 bool nano_cimgui_create_device_objects();
 void nano_cimgui_invalidate_device_objects(void);
+bool nano_cimgui_has_device_objects(void);
 WGPUShaderModule nano_cimgui_create_shader_module(WGPUDevice device,
                                                   const char *source);
 bool nano_cimgui_create_font_textures(void);
@@ -387,10 +391,7 @@ void nano_cimgui_new_frame(void) {
 
     ImGuiIO *io = igGetIO();
 
-    // Update display size for window resizing
-    int width, height;
-    emscripten_get_canvas_element_size("#canvas", &width, &height);
-    io->DisplaySize = (ImVec2){(float)width, (float)height};
+    // The caller sets io->DisplaySize to the size of the canvas
 
     // Update time step (targeting 144 FPS MAX for ImGui)
     double current_time = emscripten_get_now() / 1000.0;
@@ -398,8 +399,10 @@ void nano_cimgui_new_frame(void) {
                                   : (float)(1.0f / 144.0f);
     bd->deltaTime = current_time;
 
-    // Create device objects if not already created
-    nano_cimgui_create_device_objects();
+    // The device objects are created by nano_cimgui_end_frame() once there
+    // is something to draw, ImGui only needs the font atlas to start a frame
+    if (!ImFontAtlas_IsBuilt(io->Fonts))
+        ImFontAtlas_Build(io->Fonts);
 
     // Start new frame
     igNewFrame();
@@ -431,6 +434,7 @@ void nano_cimgui_render_draw_data(ImDrawData *draw_data,
         bd->VertexBufferSize < draw_data->TotalVtxCount) {
         if (bd->VertexBuffer) {
             wgpuBufferDestroy(bd->VertexBuffer);
+            wgpuBufferRelease(bd->VertexBuffer);
         }
         bd->VertexBufferSize = draw_data->TotalVtxCount + 5000;
         WGPUBufferDescriptor vb_desc = {
@@ -446,6 +450,7 @@ void nano_cimgui_render_draw_data(ImDrawData *draw_data,
         bd->IndexBufferSize < draw_data->TotalIdxCount) {
         if (bd->IndexBuffer) {
             wgpuBufferDestroy(bd->IndexBuffer);
+            wgpuBufferRelease(bd->IndexBuffer);
         }
         bd->IndexBufferSize = draw_data->TotalIdxCount + 10000;
         WGPUBufferDescriptor ib_desc = {
@@ -456,8 +461,14 @@ void nano_cimgui_render_draw_data(ImDrawData *draw_data,
     }
 
     // Upload vertex/index data
-    ImDrawVert *vtx_dst = (ImDrawVert *)malloc(vertex_size);
-    ImDrawIdx *idx_dst = (ImDrawIdx *)malloc(index_size);
+    // The staging memory is reclaimed when the frame arena is reset
+    ImDrawVert *vtx_dst =
+        (ImDrawVert *)nano_arena_alloc(&nano_frame_arena, vertex_size);
+    ImDrawIdx *idx_dst =
+        (ImDrawIdx *)nano_arena_alloc(&nano_frame_arena, index_size);
+    if (vtx_dst == NULL || idx_dst == NULL) {
+        return;
+    }
     ImDrawVert *vtx_ptr = vtx_dst;
     ImDrawIdx *idx_ptr = idx_dst;
 
@@ -478,10 +489,6 @@ void nano_cimgui_render_draw_data(ImDrawData *draw_data,
     wgpuQueueWriteBuffer(bd->defaultQueue, bd->IndexBuffer, 0, idx_dst,
                          index_size);
 
-    // Free temporary buffers
-    free(vtx_dst);
-    free(idx_dst);
-
     // Setup orthographic projection matrix
     float L = draw_data->DisplayPos.x;
     float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
@@ -562,7 +569,12 @@ void nano_cimgui_end_frame(WGPUCommandEncoder cmd_encoder,
     nano_cimgui_data *bd = nano_cimgui_get_backend_data();
 
     igRender();
-    if (igGetDrawData() == NULL)
+    ImDrawData *draw_data = igGetDrawData();
+    if (draw_data == NULL || draw_data->TotalVtxCount == 0)
+        return;
+
+    // Create device objects on the first frame that draws something
+    if (!bd->PipelineState && !nano_cimgui_create_device_objects())
         return;
 
     // Set the ImGui encoder to our current encoder
@@ -603,9 +615,10 @@ void nano_cimgui_end_frame(WGPUCommandEncoder cmd_encoder,
     // This will be refactored into a nano_cimgui_render function
     // I am thinking of making all nano + cimgui functionality
     // optional using macros
-    nano_cimgui_render_draw_data(igGetDrawData(), render_pass);
+    nano_cimgui_render_draw_data(draw_data, render_pass);
 
     wgpuRenderPassEncoderEnd(render_pass);
+    wgpuRenderPassEncoderRelease(render_pass);
 }
 
 // Create WGPU device objects (pipeline, buffers, textures, etc.)
@@ -766,8 +779,10 @@ bool nano_cimgui_create_font_textures() {
         .mipLevelCount = 1,
         .sampleCount = 1,
     };
-    if (bd->FontTexture)
+    if (bd->FontTexture) {
         wgpuTextureDestroy(bd->FontTexture);
+        wgpuTextureRelease(bd->FontTexture);
+    }
     bd->FontTexture = wgpuDeviceCreateTexture(bd->wgpuDevice, &tex_desc);
 
     // Create texture view descriptor
@@ -818,8 +833,10 @@ bool nano_cimgui_create_font_textures() {
         .size = 64, // 4x4 matrix
         .mappedAtCreation = false,
         .label = "Dear ImGui Uniform Buffer"};
-    if (bd->Uniforms)
+    if (bd->Uniforms) {
         wgpuBufferDestroy(bd->Uniforms);
+        wgpuBufferRelease(bd->Uniforms);
+    }
     bd->Uniforms = wgpuDeviceCreateBuffer(bd->wgpuDevice, &uniform_buffer_desc);
 
     if (!bd->PipelineState)
@@ -837,6 +854,7 @@ bool nano_cimgui_create_font_textures() {
     if (bd->CommonBindGroup)
         wgpuBindGroupRelease(bd->CommonBindGroup);
     bd->CommonBindGroup = wgpuDeviceCreateBindGroup(bd->wgpuDevice, &bg_desc);
+    wgpuBindGroupLayoutRelease(bg_desc.layout);
 
     // Set font texture ID
     ImFontAtlas_SetTexID(io->Fonts, (ImTextureID)(intptr_t)bd->FontTextureView);
@@ -844,9 +862,15 @@ bool nano_cimgui_create_font_textures() {
     return true;
 }
 
+// True once the device objects were created, i.e. ImGui drew something
+bool nano_cimgui_has_device_objects(void) {
+    nano_cimgui_data *bd = nano_cimgui_get_backend_data();
+    return bd != NULL && bd->PipelineState != NULL;
+}
+
 void nano_cimgui_invalidate_device_objects(void) {
     nano_cimgui_data *bd = nano_cimgui_get_backend_data();
-    if (!bd->wgpuDevice)
+    if (!bd || !bd->wgpuDevice)
         return;
 
     if (bd->PipelineState) {
@@ -855,6 +879,7 @@ void nano_cimgui_invalidate_device_objects(void) {
     }
     if (bd->FontTexture) {
         wgpuTextureDestroy(bd->FontTexture);
+        wgpuTextureRelease(bd->FontTexture);
         bd->FontTexture = NULL;
     }
     if (bd->FontTextureView) {
@@ -867,6 +892,7 @@ void nano_cimgui_invalidate_device_objects(void) {
     }
     if (bd->Uniforms) {
         wgpuBufferDestroy(bd->Uniforms);
+        wgpuBufferRelease(bd->Uniforms);
         bd->Uniforms = NULL;
     }
     if (bd->CommonBindGroup) {
@@ -875,18 +901,22 @@ void nano_cimgui_invalidate_device_objects(void) {
     }
     if (bd->VertexBuffer) {
         wgpuBufferDestroy(bd->VertexBuffer);
+        wgpuBufferRelease(bd->VertexBuffer);
         bd->VertexBuffer = NULL;
     }
     if (bd->IndexBuffer) {
         wgpuBufferDestroy(bd->IndexBuffer);
+        wgpuBufferRelease(bd->IndexBuffer);
         bd->IndexBuffer = NULL;
     }
     if (bd->VertexBuffer) {
         wgpuBufferDestroy(bd->VertexBuffer);
+        wgpuBufferRelease(bd->VertexBuffer);
         bd->VertexBuffer = NULL;
     }
     if (bd->IndexBuffer) {
         wgpuBufferDestroy(bd->IndexBuffer);
+        wgpuBufferRelease(bd->IndexBuffer);
         bd->IndexBuffer = NULL;
     }
     bd->VertexBufferSize = 0;
@@ -894,6 +924,9 @@ void nano_cimgui_invalidate_device_objects(void) {
 }
 
 void nano_cimgui_process_key_event(int key, bool down) {
+    // Events can arrive before ImGui is initialized, or without a GPU
+    if (!cimgui_ready)
+        return;
     ImGuiIO *io = igGetIO();
     nano_cimgui_data *bd = nano_cimgui_get_backend_data();
 
@@ -929,11 +962,15 @@ void nano_cimgui_process_key_event(int key, bool down) {
 }
 
 void nano_cimgui_process_char_event(unsigned int c) {
+    if (!cimgui_ready)
+        return;
     ImGuiIO *io = igGetIO();
     ImGuiIO_AddInputCharacter(io, c);
 }
 
 void nano_cimgui_process_mousepress_event(int button, bool down) {
+    if (!cimgui_ready)
+        return;
     ImGuiIO *io = igGetIO();
     // We have to swap the button order because emsc uses a different order
     if (button >= 0 && button < 5) {
@@ -948,11 +985,15 @@ void nano_cimgui_process_mousepress_event(int button, bool down) {
 }
 
 void nano_cimgui_process_mousepos_event(float x, float y) {
+    if (!cimgui_ready)
+        return;
     ImGuiIO *io = igGetIO();
     io->MousePos = (ImVec2){x, y};
 }
 
 void nano_cimgui_process_mousewheel_event(float delta) {
+    if (!cimgui_ready)
+        return;
     ImGuiIO *io = igGetIO();
     ImGuiIO_AddMouseWheelEvent(io, 0.0f, delta);
 }
@@ -0,0 +1,832 @@
+// ---------------------------------------------------------------------
+//  nano_draw.h
+//  --------------------------------------------------------------------
+//  Immediate mode 2D batch renderer for Nano
+//  --------------------------------------------------------------------
+//
+//  nano_draw_line(), nano_draw_rect(), nano_draw_sprite() and
+//  nano_draw_points() can be called anywhere between nano_start_frame()
+//  and nano_end_frame(). Every primitive is a single 32 byte instance of
+//  a unit quad, so nothing is tessellated on the CPU: a line is expanded
+//  along its normal in the vertex shader, and rects, sprites and points
+//  are boxes between two corners.
+//
+//  nano_draw_flush() is called by nano_end_frame() before ImGui is drawn.
+//  It groups the instances by texture with a counting sort that keeps the
+//  submission order within a texture, uploads them with one write into
+//  the streaming buffer of the current frame in flight, and records one
+//  instanced draw per texture. A frame that only draws untextured
+//  primitives is a single draw call.
+//
+//  Coordinates are in framebuffer pixels with the origin in the top left
+//  corner. Colors are packed with NANO_RGBA().
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_DRAW_H
+#define NANO_DRAW_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <webgpu/webgpu.h>
+
+// The sorted copy of the instances is staged in the frame arena
+#include "nano_arena.h"
+
+// Errors are logged like the rest of Nano, nano.h defines LOG_ERR before
+// including this file
+#ifndef LOG_ERR
+    #define LOG_ERR(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// Largest number of primitives drawn in a single frame, anything past it
+// is dropped. Each primitive takes 33 bytes with its texture id, plus 32
+// for the sorted copy in the frame arena when several textures are drawn,
+// so a full frame of the default 4M primitives needs about 260 MB. Lower
+// it for builds without ALLOW_MEMORY_GROWTH.
+#ifndef NANO_DRAW_MAX_INSTANCES
+    #define NANO_DRAW_MAX_INSTANCES (1 << 22)
+#endif
+
+// Number of different textures that can be drawn in a single frame, the
+// first one is the white texture used by untextured primitives
+#ifndef NANO_DRAW_MAX_TEXTURES
+    #define NANO_DRAW_MAX_TEXTURES 64
+#endif
+
+#define NANO_DRAW_MAX_FRAMES_IN_FLIGHT 3
+
+// Pack a color into the unorm8x4 layout used by the instances
+#define NANO_RGBA(r, g, b, a)                                                  \
+    ((uint32_t)(r) | (uint32_t)(g) << 8 | (uint32_t)(b) << 16 |               \
+     (uint32_t)(a) << 24)
+
+// One primitive, matching the instance attributes of the shader below.
+// A width greater than 0 draws a line from p0 to p1 with that thickness,
+// otherwise the primitive is the box between the corners p0 and p1.
+typedef struct nano_draw_instance_t {
+    float p0[2];
+    float p1[2];
+    // Texture coordinates of p0 and p1 as unorm16
+    uint16_t uv[4];
+    float width;
+    uint32_t color;
+} nano_draw_instance_t;
+
+_Static_assert(sizeof(nano_draw_instance_t) == 32,
+               "nano_draw_instance_t must stay 32 bytes");
+
+// Counters of the last flush
+typedef struct nano_draw_stats_t {
+    uint32_t instances;
+    uint32_t draw_calls;
+    uint32_t textures;
+    // Primitives dropped because a limit was reached
+    uint32_t dropped;
+} nano_draw_stats_t;
+
+typedef struct nano_draw_state_t {
+    WGPUDevice device;
+    WGPUTextureFormat format;
+    uint32_t frames_in_flight;
+
+    // Device objects, created by the first flush that has work to do
+    uint32_t sample_count;
+    WGPURenderPipeline pipeline;
+    WGPUBindGroupLayout viewport_layout;
+    WGPUBindGroupLayout texture_layout;
+    WGPUBuffer viewport_buffer;
+    WGPUBindGroup viewport_group;
+    WGPUSampler sampler;
+    WGPUTexture white_texture;
+    WGPUTextureView white_view;
+    WGPUBindGroup white_group;
+    float viewport[4];
+
+    // Streaming instance buffers, one per frame in flight
+    WGPUBuffer buffers[NANO_DRAW_MAX_FRAMES_IN_FLIGHT];
+    uint64_t buffer_sizes[NANO_DRAW_MAX_FRAMES_IN_FLIGHT];
+    uint32_t frame_index;
+
+    // Instances of the current frame and the texture each one samples
+    nano_draw_instance_t *instances;
+    uint8_t *texture_ids;
+    size_t count;
+    size_t capacity;
+
+    // Textures in the order they were first used this frame
+    WGPUTextureView textures[NANO_DRAW_MAX_TEXTURES];
+    uint32_t texture_counts[NANO_DRAW_MAX_TEXTURES];
+    uint32_t texture_count;
+    uint8_t last_texture_id;
+
+    nano_draw_stats_t stats;
+    uint32_t dropped;
+    bool dropped_logged;
+} nano_draw_state_t;
+
+static nano_draw_state_t _nano_draw;
+
+static const char *_nano_draw_shader_wgsl =
+    "struct Viewport {\n"
+    "    scale: vec2<f32>,\n"
+    "    pad: vec2<f32>,\n"
+    "};\n"
+    "\n"
+    "@group(0) @binding(0) var<uniform> viewport: Viewport;\n"
+    "@group(1) @binding(0) var draw_sampler: sampler;\n"
+    "@group(1) @binding(1) var draw_texture: texture_2d<f32>;\n"
+    "\n"
+    "struct Instance {\n"
+    "    @location(0) p0: vec2<f32>,\n"
+    "    @location(1) p1: vec2<f32>,\n"
+    "    @location(2) uv: vec4<f32>,\n"
+    "    @location(3) width: f32,\n"
+    "    @location(4) color: vec4<f32>,\n"
+    "};\n"
+    "\n"
+    "struct VertexOutput {\n"
+    "    @builtin(position) position: vec4<f32>,\n"
+    "    @location(0) uv: vec2<f32>,\n"
+    "    @location(1) color: vec4<f32>,\n"
+    "};\n"
+    "\n"
+    "@vertex\n"
+    "fn vs_main(@builtin(vertex_index) vertex: u32,\n"
+    "           instance: Instance) -> VertexOutput {\n"
+    "    // Corner of the unit quad, drawn as a 4 vertex triangle strip\n"
+    "    let corner = vec2<f32>(f32(vertex & 1u), f32(vertex >> 1u));\n"
+    "    var position = mix(instance.p0, instance.p1, corner);\n"
+    "    if (instance.width > 0.0) {\n"
+    "        let dir = instance.p1 - instance.p0;\n"
+    "        let normal = vec2<f32>(-dir.y, dir.x) /\n"
+    "                     max(length(dir), 1e-6) * instance.width;\n"
+    "        position = instance.p0 + dir * corner.x +\n"
+    "                   normal * (corner.y - 0.5);\n"
+    "    }\n"
+    "    var out: VertexOutput;\n"
+    "    out.position = vec4<f32>(\n"
+    "        position * viewport.scale + vec2<f32>(-1.0, 1.0), 0.0, 1.0);\n"
+    "    out.uv = mix(instance.uv.xy, instance.uv.zw, corner);\n"
+    "    out.color = instance.color;\n"
+    "    return out;\n"
+    "}\n"
+    "\n"
+    "@fragment\n"
+    "fn fs_main(in: VertexOutput) -> @location(0) vec4<f32> {\n"
+    "    return textureSample(draw_texture, draw_sampler, in.uv) * "
+    "in.color;\n"
+    "}\n";
+
+// Function Declarations
+// ----------------------------------------------------------------------------
+
+void nano_draw_init(WGPUDevice device, WGPUTextureFormat format,
+                    int num_frames_in_flight);
+void nano_draw_shutdown(void);
+void nano_draw_line(float x0, float y0, float x1, float y1, float thickness,
+                    uint32_t color);
+void nano_draw_rect(float x, float y, float w, float h, uint32_t color);
+void nano_draw_sprite(WGPUTextureView texture, float x, float y, float w,
+                      float h, const float *uv, uint32_t color);
+void nano_draw_points(const float *points, size_t count, float size,
+                      uint32_t color);
+void nano_draw_flush(WGPUCommandEncoder encoder, WGPUTextureView view,
+                     WGPUTextureView resolve_view, uint32_t width,
+                     uint32_t height, uint32_t sample_count);
+nano_draw_stats_t nano_draw_get_stats(void);
+
+// Function Implementations
+// ----------------------------------------------------------------------------
+
+// Store the device and render target format. Nothing is created on the
+// device until a frame draws something.
+void nano_draw_init(WGPUDevice device, WGPUTextureFormat format,
+                    int num_frames_in_flight) {
+    if (num_frames_in_flight < 1)
+        num_frames_in_flight = 1;
+    if (num_frames_in_flight > NANO_DRAW_MAX_FRAMES_IN_FLIGHT)
+        num_frames_in_flight = NANO_DRAW_MAX_FRAMES_IN_FLIGHT;
+
+    memset(&_nano_draw, 0, sizeof(_nano_draw));
+    _nano_draw.device = device;
+    _nano_draw.format = format;
+    _nano_draw.frames_in_flight = (uint32_t)num_frames_in_flight;
+
+    // Slot 0 is the white texture of untextured primitives
+    _nano_draw.texture_count = 1;
+}
+
+// Release the pipeline, leaving the resources shared between sample counts
+static void _nano_draw_release_pipeline(void) {
+    if (_nano_draw.pipeline) {
+        wgpuRenderPipelineRelease(_nano_draw.pipeline);
+        _nano_draw.pipeline = NULL;
+    }
+}
+
+static WGPUShaderModule _nano_draw_create_shader_module(void) {
+    WGPUShaderModuleWGSLDescriptor wgsl_desc = {
+        .chain =
+            (WGPUChainedStruct){.next = NULL,
+                                .sType = WGPUSType_ShaderModuleWGSLDescriptor},
+        .code = _nano_draw_shader_wgsl};
+    WGPUShaderModuleDescriptor desc = {.nextInChain = &wgsl_desc.chain,
+                                       .label = "Nano Draw Shader"};
+    return wgpuDeviceCreateShaderModule(_nano_draw.device, &desc);
+}
+
+// Create the layouts, the viewport uniform and the white texture
+static bool _nano_draw_create_resources(void) {
+    WGPUDevice device = _nano_draw.device;
+    WGPUQueue queue = wgpuDeviceGetQueue(device);
+
+    WGPUBindGroupLayoutEntry viewport_entry = {
+        .binding = 0,
+        .visibility = WGPUShaderStage_Vertex,
+        .buffer = {.type = WGPUBufferBindingType_Uniform,
+                   .minBindingSize = sizeof(_nano_draw.viewport)},
+    };
+    _nano_draw.viewport_layout = wgpuDeviceCreateBindGroupLayout(
+        device, &(WGPUBindGroupLayoutDescriptor){
+                    .label = "Nano Draw Viewport Layout",
+                    .entryCount = 1,
+                    .entries = &viewport_entry,
+                });
+
+    WGPUBindGroupLayoutEntry texture_entries[2] = {
+        {
+            .binding = 0,
+            .visibility = WGPUShaderStage_Fragment,
+            .sampler = {.type = WGPUSamplerBindingType_Filtering},
+        },
+        {
+            .binding = 1,
+            .visibility = WGPUShaderStage_Fragment,
+            .texture = {.sampleType = WGPUTextureSampleType_Float,
+                        .viewDimension = WGPUTextureViewDimension_2D},
+        },
+    };
+    _nano_draw.texture_layout = wgpuDeviceCreateBindGroupLayout(
+        device, &(WGPUBindGroupLayoutDescriptor){
+                    .label = "Nano Draw Texture Layout",
+                    .entryCount = 2,
+                    .entries = texture_entries,
+                });
+
+    _nano_draw.viewport_buffer = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Draw Viewport",
+                    .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(_nano_draw.viewport),
+                });
+    _nano_draw.viewport_group = wgpuDeviceCreateBindGroup(
+        device, &(WGPUBindGroupDescriptor){
+                    .label = "Nano Draw Viewport Bind Group",
+                    .layout = _nano_draw.viewport_layout,
+                    .entryCount = 1,
+                    .entries =
+                        &(WGPUBindGroupEntry){
+                            .binding = 0,
+                            .buffer = _nano_draw.viewport_buffer,
+                            .size = sizeof(_nano_draw.viewport),
+                        },
+                });
+    memset(_nano_draw.viewport, 0, sizeof(_nano_draw.viewport));
+
+    _nano_draw.sampler = wgpuDeviceCreateSampler(
+        device, &(WGPUSamplerDescriptor){
+                    .label = "Nano Draw Sampler",
+                    .addressModeU = WGPUAddressMode_ClampToEdge,
+                    .addressModeV = WGPUAddressMode_ClampToEdge,
+                    .addressModeW = WGPUAddressMode_ClampToEdge,
+                    .magFilter = WGPUFilterMode_Linear,
+                    .minFilter = WGPUFilterMode_Linear,
+                    .mipmapFilter = WGPUMipmapFilterMode_Nearest,
+                    .maxAnisotropy = 1,
+                });
+
+    // 1x1 white texture, so untextured primitives share the pipeline
+    WGPUExtent3D white_size = {
+        .width = 1, .height = 1, .depthOrArrayLayers = 1};
+    _nano_draw.white_texture = wgpuDeviceCreateTexture(
+        device, &(WGPUTextureDescriptor){
+                    .label = "Nano Draw White Texture",
+                    .usage = WGPUTextureUsage_TextureBinding |
+                             WGPUTextureUsage_CopyDst,
+                    .dimension = WGPUTextureDimension_2D,
+                    .size = white_size,
+                    .format = WGPUTextureFormat_RGBA8Unorm,
+                    .mipLevelCount = 1,
+                    .sampleCount = 1,
+                });
+    if (!_nano_draw.white_texture)
+        return false;
+
+    uint32_t white = 0xFFFFFFFFu;
+    wgpuQueueWriteTexture(
+        queue,
+        &(WGPUImageCopyTexture){.texture = _nano_draw.white_texture,
+                                .aspect = WGPUTextureAspect_All},
+        &white, sizeof(white),
+        &(WGPUTextureDataLayout){.bytesPerRow = 4, .rowsPerImage = 1},
+        &white_size);
+    _nano_draw.white_view =
+        wgpuTextureCreateView(_nano_draw.white_texture, NULL);
+
+    WGPUBindGroupEntry white_entries[2] = {
+        {.binding = 0, .sampler = _nano_draw.sampler},
+        {.binding = 1, .textureView = _nano_draw.white_view},
+    };
+    _nano_draw.white_group = wgpuDeviceCreateBindGroup(
+        device, &(WGPUBindGroupDescriptor){
+                    .label = "Nano Draw White Bind Group",
+                    .layout = _nano_draw.texture_layout,
+                    .entryCount = 2,
+                    .entries = white_entries,
+                });
+
+    return _nano_draw.viewport_group != NULL && _nano_draw.white_group != NULL;
+}
+
+// Create the pipeline for a sample count
+static bool _nano_draw_create_pipeline(uint32_t sample_count) {
+    WGPUDevice device = _nano_draw.device;
+
+    WGPUShaderModule module = _nano_draw_create_shader_module();
+    if (!module)
+        return false;
+
+    WGPUBindGroupLayout layouts[2] = {_nano_draw.viewport_layout,
+                                      _nano_draw.texture_layout};
+    WGPUPipelineLayout pipeline_layout = wgpuDeviceCreatePipelineLayout(
+        device, &(WGPUPipelineLayoutDescriptor){
+                    .label = "Nano Draw Pipeline Layout",
+                    .bindGroupLayoutCount = 2,
+                    .bindGroupLayouts = layouts,
+                });
+
+    WGPUVertexAttribute attributes[5] = {
+        {.format = WGPUVertexFormat_Float32x2,
+         .offset = offsetof(nano_draw_instance_t, p0),
+         .shaderLocation = 0},
+        {.format = WGPUVertexFormat_Float32x2,
+         .offset = offsetof(nano_draw_instance_t, p1),
+         .shaderLocation = 1},
+        {.format = WGPUVertexFormat_Unorm16x4,
+         .offset = offsetof(nano_draw_instance_t, uv),
+         .shaderLocation = 2},
+        {.format = WGPUVertexFormat_Float32,
+         .offset = offsetof(nano_draw_instance_t, width),
+         .shaderLocation = 3},
+        {.format = WGPUVertexFormat_Unorm8x4,
+         .offset = offsetof(nano_draw_instance_t, color),
+         .shaderLocation = 4},
+    };
+
+    // The quad corners come from the vertex index, the only buffer steps
+    // per instance
+    WGPUVertexBufferLayout instance_layout = {
+        .arrayStride = sizeof(nano_draw_instance_t),
+        .stepMode = WGPUVertexStepMode_Instance,
+        .attributeCount = 5,
+        .attributes = attributes,
+    };
+
+    WGPUBlendState blend = {
+        .color = {.operation = WGPUBlendOperation_Add,
+                  .srcFactor = WGPUBlendFactor_SrcAlpha,
+                  .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha},
+        .alpha = {.operation = WGPUBlendOperation_Add,
+                  .srcFactor = WGPUBlendFactor_One,
+                  .dstFactor = WGPUBlendFactor_OneMinusSrcAlpha},
+    };
+    WGPUColorTargetState color_target = {
+        .format = _nano_draw.format,
+        .blend = &blend,
+        .writeMask = WGPUColorWriteMask_All,
+    };
+
+    _nano_draw.pipeline = wgpuDeviceCreateRenderPipeline(
+        device,
+        &(WGPURenderPipelineDescriptor){
+            .label = "Nano Draw Pipeline",
+            .layout = pipeline_layout,
+            .vertex = {.module = module,
+                       .entryPoint = "vs_main",
+                       .bufferCount = 1,
+                       .buffers = &instance_layout},
+            .primitive = {.topology = WGPUPrimitiveTopology_TriangleStrip,
+                          .stripIndexFormat = WGPUIndexFormat_Undefined,
+                          .frontFace = WGPUFrontFace_CCW,
+                          .cullMode = WGPUCullMode_None},
+            .multisample = {.count = sample_count, .mask = ~0u},
+            .fragment = &(WGPUFragmentState){.module = module,
+                                             .entryPoint = "fs_main",
+                                             .targetCount = 1,
+                                             .targets = &color_target},
+        });
+    _nano_draw.sample_count = sample_count;
+
+    wgpuPipelineLayoutRelease(pipeline_layout);
+    wgpuShaderModuleRelease(module);
+
+    return _nano_draw.pipeline != NULL;
+}
+
+// Release every device object and the CPU side instance storage
+void nano_draw_shutdown(void) {
+    _nano_draw_release_pipeline();
+
+    for (uint32_t i = 0; i < NANO_DRAW_MAX_FRAMES_IN_FLIGHT; i++) {
+        if (_nano_draw.buffers[i])
+            wgpuBufferRelease(_nano_draw.buffers[i]);
+    }
+    if (_nano_draw.white_group)
+        wgpuBindGroupRelease(_nano_draw.white_group);
+    if (_nano_draw.white_view)
+        wgpuTextureViewRelease(_nano_draw.white_view);
+    if (_nano_draw.white_texture)
+        wgpuTextureRelease(_nano_draw.white_texture);
+    if (_nano_draw.sampler)
+        wgpuSamplerRelease(_nano_draw.sampler);
+    if (_nano_draw.viewport_group)
+        wgpuBindGroupRelease(_nano_draw.viewport_group);
+    if (_nano_draw.viewport_buffer)
+        wgpuBufferRelease(_nano_draw.viewport_buffer);
+    if (_nano_draw.texture_layout)
+        wgpuBindGroupLayoutRelease(_nano_draw.texture_layout);
+    if (_nano_draw.viewport_layout)
+        wgpuBindGroupLayoutRelease(_nano_draw.viewport_layout);
+
+    free(_nano_draw.instances);
+    free(_nano_draw.texture_ids);
+    memset(&_nano_draw, 0, sizeof(_nano_draw));
+}
+
+// Make room for count more instances. Returns the number that fit.
+static size_t _nano_draw_reserve(size_t count) {
+    size_t needed = _nano_draw.count + count;
+    if (needed > NANO_DRAW_MAX_INSTANCES)
+        needed = NANO_DRAW_MAX_INSTANCES;
+
+    if (needed > _nano_draw.capacity) {
+        size_t capacity = _nano_draw.capacity ? _nano_draw.capacity : 1024;
+        while (capacity < needed)
+            capacity *= 2;
+        if (capacity > NANO_DRAW_MAX_INSTANCES)
+            capacity = NANO_DRAW_MAX_INSTANCES;
+
+        nano_draw_instance_t *instances = (nano_draw_instance_t *)realloc(
+            _nano_draw.instances, capacity * sizeof(nano_draw_instance_t));
+        if (instances)
+            _nano_draw.instances = instances;
+        uint8_t *texture_ids =
+            (uint8_t *)realloc(_nano_draw.texture_ids, capacity);
+        if (texture_ids)
+            _nano_draw.texture_ids = texture_ids;
+        if (instances && texture_ids)
+            _nano_draw.capacity = capacity;
+    }
+
+    size_t available = _nano_draw.capacity - _nano_draw.count;
+    if (count > available) {
+        _nano_draw.dropped += (uint32_t)(count - available);
+        return available;
+    }
+    return count;
+}
+
+// Look up the slot of a texture, adding it on first use. Returns -1 when
+// the frame already uses NANO_DRAW_MAX_TEXTURES textures.
+static int _nano_draw_texture_id(WGPUTextureView texture) {
+    if (texture == NULL)
+        return 0;
+
+    // Sprites usually come in runs of the same texture
+    if (_nano_draw.textures[_nano_draw.last_texture_id] == texture)
+        return _nano_draw.last_texture_id;
+
+    for (uint32_t i = 1; i < _nano_draw.texture_count; i++) {
+        if (_nano_draw.textures[i] == texture) {
+            _nano_draw.last_texture_id = (uint8_t)i;
+            return (int)i;
+        }
+    }
+
+    if (_nano_draw.texture_count == NANO_DRAW_MAX_TEXTURES)
+        return -1;
+
+    uint32_t id = _nano_draw.texture_count++;
+    _nano_draw.textures[id] = texture;
+    _nano_draw.texture_counts[id] = 0;
+    _nano_draw.last_texture_id = (uint8_t)id;
+    return (int)id;
+}
+
+// Append count instances that sample texture. The caller fills them in.
+static nano_draw_instance_t *_nano_draw_push(WGPUTextureView texture,
+                                             size_t *count) {
+    if (_nano_draw.device == NULL) {
+        *count = 0;
+        return NULL;
+    }
+
+    int id = _nano_draw_texture_id(texture);
+    if (id < 0) {
+        _nano_draw.dropped += (uint32_t)*count;
+        *count = 0;
+        return NULL;
+    }
+
+    *count = _nano_draw_reserve(*count);
+    if (*count == 0)
+        return NULL;
+
+    nano_draw_instance_t *first = &_nano_draw.instances[_nano_draw.count];
+    memset(_nano_draw.texture_ids + _nano_draw.count, id, *count);
+    _nano_draw.texture_counts[id] += (uint32_t)*count;
+    _nano_draw.count += *count;
+    return first;
+}
+
+// Draw a line of the given thickness in pixels
+void nano_draw_line(float x0, float y0, float x1, float y1, float thickness,
+                    uint32_t color) {
+    size_t count = 1;
+    nano_draw_instance_t *instance = _nano_draw_push(NULL, &count);
+    if (!instance)
+        return;
+
+    *instance = (nano_draw_instance_t){
+        .p0 = {x0, y0},
+        .p1 = {x1, y1},
+        .width = thickness > 0.0f ? thickness : 1.0f,
+        .color = color,
+    };
+}
+
+// Draw a filled rectangle with its top left corner at (x, y)
+void nano_draw_rect(float x, float y, float w, float h, uint32_t color) {
+    size_t count = 1;
+    nano_draw_instance_t *instance = _nano_draw_push(NULL, &count);
+    if (!instance)
+        return;
+
+    *instance = (nano_draw_instance_t){
+        .p0 = {x, y},
+        .p1 = {x + w, y + h},
+        .color = color,
+    };
+}
+
+// Draw a textured rectangle. uv holds the texture coordinates of the top
+// left and bottom right corners, NULL draws the whole texture. The color
+// multiplies the texture.
+void nano_draw_sprite(WGPUTextureView texture, float x, float y, float w,
+                      float h, const float *uv, uint32_t color) {
+    size_t count = 1;
+    nano_draw_instance_t *instance = _nano_draw_push(texture, &count);
+    if (!instance)
+        return;
+
+    *instance = (nano_draw_instance_t){
+        .p0 = {x, y},
+        .p1 = {x + w, y + h},
+        .uv = {0, 0, 65535, 65535},
+        .color = color,
+    };
+    if (uv != NULL) {
+        for (int i = 0; i < 4; i++) {
+            float value = uv[i] < 0.0f ? 0.0f : uv[i] > 1.0f ? 1.0f : uv[i];
+            instance->uv[i] = (uint16_t)(value * 65535.0f + 0.5f);
+        }
+    }
+}
+
+// Draw count square points of the given size in pixels. points holds
+// count interleaved x and y centers.
+void nano_draw_points(const float *points, size_t count, float size,
+                      uint32_t color) {
+    nano_draw_instance_t *instances = _nano_draw_push(NULL, &count);
+    if (!instances)
+        return;
+
+    float half = size * 0.5f;
+    for (size_t i = 0; i < count; i++) {
+        float x = points[i * 2 + 0];
+        float y = points[i * 2 + 1];
+        instances[i] = (nano_draw_instance_t){
+            .p0 = {x - half, y - half},
+            .p1 = {x + half, y + half},
+            .color = color,
+        };
+    }
+}
+
+// Grow the streaming buffer of the current frame to hold size bytes
+static WGPUBuffer _nano_draw_frame_buffer(uint64_t size) {
+    uint32_t frame = _nano_draw.frame_index;
+    if (_nano_draw.buffer_sizes[frame] >= size)
+        return _nano_draw.buffers[frame];
+
+    uint64_t buffer_size = _nano_draw.buffer_sizes[frame]
+                               ? _nano_draw.buffer_sizes[frame]
+                               : 1024 * sizeof(nano_draw_instance_t);
+    while (buffer_size < size)
+        buffer_size *= 2;
+
+    if (_nano_draw.buffers[frame])
+        wgpuBufferRelease(_nano_draw.buffers[frame]);
+    _nano_draw.buffers[frame] = wgpuDeviceCreateBuffer(
+        _nano_draw.device,
+        &(WGPUBufferDescriptor){
+            .label = "Nano Draw Instances",
+            .usage = WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst,
+            .size = buffer_size,
+        });
+    _nano_draw.buffer_sizes[frame] =
+        _nano_draw.buffers[frame] ? buffer_size : 0;
+    return _nano_draw.buffers[frame];
+}
+
+// Forget the instances and textures of the frame
+static void _nano_draw_reset(void) {
+    _nano_draw.count = 0;
+    _nano_draw.texture_count = 1;
+    _nano_draw.texture_counts[0] = 0;
+    _nano_draw.last_texture_id = 0;
+    _nano_draw.dropped = 0;
+}
+
+// Upload the instances of the frame and draw them on top of view
+void nano_draw_flush(WGPUCommandEncoder encoder, WGPUTextureView view,
+                     WGPUTextureView resolve_view, uint32_t width,
+                     uint32_t height, uint32_t sample_count) {
+    if (_nano_draw.device == NULL)
+        return;
+
+    _nano_draw.stats = (nano_draw_stats_t){.dropped = _nano_draw.dropped};
+    if (_nano_draw.dropped != 0 && !_nano_draw.dropped_logged) {
+        _nano_draw.dropped_logged = true;
+        LOG_ERR("NANO: nano_draw_flush() -> Dropped %u primitives, the frame "
+                "is limited to %d primitives and %d textures\n",
+                _nano_draw.dropped, NANO_DRAW_MAX_INSTANCES,
+                NANO_DRAW_MAX_TEXTURES);
+    }
+
+    size_t count = _nano_draw.count;
+    if (count == 0 || width == 0 || height == 0) {
+        _nano_draw_reset();
+        return;
+    }
+
+    if (_nano_draw.viewport_layout == NULL && !_nano_draw_create_resources()) {
+        LOG_ERR("NANO: nano_draw_flush() -> Could not create the "
+                "draw resources\n");
+        nano_draw_shutdown();
+        return;
+    }
+
+    // MSAA can be changed at runtime, the pipeline follows the target
+    if (_nano_draw.pipeline == NULL ||
+        _nano_draw.sample_count != sample_count) {
+        _nano_draw_release_pipeline();
+        if (!_nano_draw_create_pipeline(sample_count)) {
+            LOG_ERR("NANO: nano_draw_flush() -> Could not create the "
+                    "draw pipeline\n");
+            _nano_draw_reset();
+            return;
+        }
+    }
+
+    // Group the instances by texture, keeping the submission order within
+    // each texture. Textures are numbered in first use order, so the first
+    // group starts at 0.
+    uint32_t first_instance[NANO_DRAW_MAX_TEXTURES];
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < _nano_draw.texture_count; i++) {
+        first_instance[i] = offset;
+        offset += _nano_draw.texture_counts[i];
+    }
+
+    const nano_draw_instance_t *upload = _nano_draw.instances;
+    nano_arena_mark_t mark = nano_arena_mark(&nano_frame_arena);
+    bool single_texture = _nano_draw.texture_counts[0] == count;
+    for (uint32_t i = 1; i < _nano_draw.texture_count && !single_texture; i++)
+        single_texture = _nano_draw.texture_counts[i] == count;
+
+    if (!single_texture) {
+        nano_draw_instance_t *sorted = (nano_draw_instance_t *)nano_arena_alloc(
+            &nano_frame_arena, count * sizeof(nano_draw_instance_t));
+        if (sorted != NULL) {
+            uint32_t cursor[NANO_DRAW_MAX_TEXTURES];
+            memcpy(cursor, first_instance,
+                   _nano_draw.texture_count * sizeof(uint32_t));
+            for (size_t i = 0; i < count; i++) {
+                sorted[cursor[_nano_draw.texture_ids[i]]++] =
+                    _nano_draw.instances[i];
+            }
+            upload = sorted;
+        }
+    }
+
+    // Skip the buffer of the previous frame, which may still be in use
+    _nano_draw.frame_index =
+        (_nano_draw.frame_index + 1) % _nano_draw.frames_in_flight;
+    uint64_t upload_size = count * sizeof(nano_draw_instance_t);
+    WGPUBuffer buffer = _nano_draw_frame_buffer(upload_size);
+    if (buffer == NULL) {
+        nano_arena_rewind(&nano_frame_arena, mark);
+        _nano_draw_reset();
+        return;
+    }
+
+    WGPUQueue queue = wgpuDeviceGetQueue(_nano_draw.device);
+    wgpuQueueWriteBuffer(queue, buffer, 0, upload, upload_size);
+    nano_arena_rewind(&nano_frame_arena, mark);
+
+    float scale[2] = {2.0f / (float)width, -2.0f / (float)height};
+    if (scale[0] != _nano_draw.viewport[0] ||
+        scale[1] != _nano_draw.viewport[1]) {
+        _nano_draw.viewport[0] = scale[0];
+        _nano_draw.viewport[1] = scale[1];
+        wgpuQueueWriteBuffer(queue, _nano_draw.viewport_buffer, 0,
+                             _nano_draw.viewport, sizeof(_nano_draw.viewport));
+    }
+
+    WGPURenderPassColorAttachment color_attachment = {
+        .view = view,
+        .depthSlice = ~0u,
+        .resolveTarget = resolve_view,
+        .loadOp = WGPULoadOp_Load,
+        .storeOp = WGPUStoreOp_Store,
+    };
+    WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(
+        encoder, &(WGPURenderPassDescriptor){
+                     .label = "Nano Draw Render Pass",
+                     .colorAttachmentCount = 1,
+                     .colorAttachments = &color_attachment,
+                 });
+    if (!pass) {
+        LOG_ERR("NANO: nano_draw_flush() -> Could not begin the "
+                "render pass\n");
+        _nano_draw_reset();
+        return;
+    }
+
+    wgpuRenderPassEncoderSetPipeline(pass, _nano_draw.pipeline);
+    wgpuRenderPassEncoderSetBindGroup(pass, 0, _nano_draw.viewport_group, 0,
+                                      NULL);
+    wgpuRenderPassEncoderSetVertexBuffer(pass, 0, buffer, 0, upload_size);
+
+    // One instanced draw per texture. Bind groups of caller textures only
+    // live for this flush, since the views may be released after it.
+    WGPUBindGroup groups[NANO_DRAW_MAX_TEXTURES] = {0};
+    for (uint32_t i = 0; i < _nano_draw.texture_count; i++) {
+        uint32_t instances = _nano_draw.texture_counts[i];
+        if (instances == 0)
+            continue;
+
+        WGPUBindGroup group = _nano_draw.white_group;
+        if (i != 0) {
+            WGPUBindGroupEntry entries[2] = {
+                {.binding = 0, .sampler = _nano_draw.sampler},
+                {.binding = 1, .textureView = _nano_draw.textures[i]},
+            };
+            groups[i] = wgpuDeviceCreateBindGroup(
+                _nano_draw.device, &(WGPUBindGroupDescriptor){
+                                       .label = "Nano Draw Texture Bind Group",
+                                       .layout = _nano_draw.texture_layout,
+                                       .entryCount = 2,
+                                       .entries = entries,
+                                   });
+            group = groups[i];
+        }
+
+        wgpuRenderPassEncoderSetBindGroup(pass, 1, group, 0, NULL);
+        wgpuRenderPassEncoderDraw(pass, 4, instances, 0, first_instance[i]);
+        _nano_draw.stats.draw_calls++;
+        _nano_draw.stats.textures++;
+    }
+
+    wgpuRenderPassEncoderEnd(pass);
+    wgpuRenderPassEncoderRelease(pass);
+
+    for (uint32_t i = 1; i < _nano_draw.texture_count; i++) {
+        if (groups[i])
+            wgpuBindGroupRelease(groups[i]);
+    }
+
+    _nano_draw.stats.instances = (uint32_t)count;
+    _nano_draw_reset();
+}
+
+// Counters of the last nano_draw_flush()
+nano_draw_stats_t nano_draw_get_stats(void) { return _nano_draw.stats; }
+
+#endif // NANO_DRAW_H
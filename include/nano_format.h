@@ -0,0 +1,330 @@
+// ---------------------------------------------------------------------
+//  nano_format.h
+//  --------------------------------------------------------------------
+//  Packed buffer element formats for Nano
+//  --------------------------------------------------------------------
+//
+//  Bandwidth-bound shaders run faster when their buffers hold fewer bytes
+//  per value. A nano_format_t describes how f32 values on the host are
+//  stored on the GPU:
+//
+//  - NANO_FORMAT_F32:        array<f32>
+//  - NANO_FORMAT_F16:        array<f16> with the shader-f16 feature, or
+//                            array<u32> and unpack2x16float() without it
+//  - NANO_FORMAT_UNORM8X4:   array<u32> and unpack4x8unorm()
+//  - NANO_FORMAT_SNORM16X2:  array<u32> and unpack2x16snorm()
+//
+//  nano_format_pack() and nano_format_unpack() convert between f32 and a
+//  format. The f16 conversions use F16C on x86, NEON on AArch64 and SIMD128
+//  on WebAssembly when the compiler enables them, and round to nearest even
+//  everywhere so every path gives the same bits.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_FORMAT_H
+#define NANO_FORMAT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__F16C__) && defined(__AVX__)
+    #include <immintrin.h>
+    #define NANO_FORMAT_F16C 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #include <arm_neon.h>
+    #define NANO_FORMAT_NEON 1
+#elif defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+    #define NANO_FORMAT_WASM_SIMD 1
+#endif
+
+typedef enum {
+    NANO_FORMAT_F32,
+    NANO_FORMAT_F16,
+    NANO_FORMAT_UNORM8X4,
+    NANO_FORMAT_SNORM16X2,
+    NANO_FORMAT_COUNT,
+} nano_format_t;
+
+// Describes how a format stores its values
+// A format packs components f32 values into bytes bytes.
+typedef struct {
+    const char *name;
+    // Type of the array elements in WGSL
+    const char *wgsl_type;
+    uint8_t components;
+    uint8_t bytes;
+} nano_format_info_t;
+
+static const nano_format_info_t nano_format_infos[NANO_FORMAT_COUNT] = {
+    [NANO_FORMAT_F32] = {"f32", "f32", 1, 4},
+    [NANO_FORMAT_F16] = {"f16", "f16", 1, 2},
+    [NANO_FORMAT_UNORM8X4] = {"unorm8x4", "u32", 4, 4},
+    [NANO_FORMAT_SNORM16X2] = {"snorm16x2", "u32", 2, 4},
+};
+
+// Return the description of a format
+static inline const nano_format_info_t *nano_format_info(nano_format_t format) {
+    return &nano_format_infos[format < NANO_FORMAT_COUNT ? format : 0];
+}
+
+// Bytes needed to store count f32 values in a format
+// count is rounded up to a whole number of elements.
+static inline size_t nano_format_size(nano_format_t format, size_t count) {
+    const nano_format_info_t *info = nano_format_info(format);
+    return (count + info->components - 1) / info->components * info->bytes;
+}
+
+// Scalar Conversions
+// -------------------------------------------------
+
+typedef union {
+    float f;
+    uint32_t u;
+} _nano_f32_bits_t;
+
+// Convert a float to half precision bits, rounding to nearest even
+static inline uint16_t nano_f32_to_f16(float value) {
+    const _nano_f32_bits_t f32_inf = {.u = 255u << 23};
+    const _nano_f32_bits_t f16_max = {.u = (127u + 16u) << 23};
+    const _nano_f32_bits_t denorm_magic = {.u = ((127u - 15u) + (23u - 10u) +
+                                                 1u)
+                                                << 23};
+
+    _nano_f32_bits_t f = {.f = value};
+    uint32_t sign = f.u & 0x80000000u;
+    f.u ^= sign;
+
+    uint16_t result;
+    if (f.u >= f16_max.u) {
+        // Overflow becomes infinity, NaN stays a quiet NaN
+        result = f.u > f32_inf.u ? 0x7e00 : 0x7c00;
+    } else if (f.u < (113u << 23)) {
+        // The result is a half denormal or zero, let the FPU round it
+        f.f += denorm_magic.f;
+        result = (uint16_t)(f.u - denorm_magic.u);
+    } else {
+        uint32_t mant_odd = (f.u >> 13) & 1;
+        f.u += ((uint32_t)(15 - 127) << 23) + 0xfff;
+        f.u += mant_odd;
+        result = (uint16_t)(f.u >> 13);
+    }
+
+    return result | (uint16_t)(sign >> 16);
+}
+
+// Convert half precision bits to a float
+static inline float nano_f16_to_f32(uint16_t value) {
+    const _nano_f32_bits_t magic = {.u = 113u << 23};
+    const uint32_t shifted_exp = 0x7c00u << 13;
+
+    _nano_f32_bits_t o = {.u = (uint32_t)(value & 0x7fff) << 13};
+    uint32_t exp = shifted_exp & o.u;
+    o.u += (127u - 15u) << 23;
+
+    if (exp == shifted_exp) {
+        // Infinity or NaN
+        o.u += (128u - 16u) << 23;
+    } else if (exp == 0) {
+        // Zero or denormal, renormalize with the FPU
+        o.u += 1u << 23;
+        o.f -= magic.f;
+    }
+
+    o.u |= (uint32_t)(value & 0x8000) << 16;
+    return o.f;
+}
+
+static inline uint32_t _nano_pack_unorm8(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (uint32_t)lrintf(value * 255.0f);
+}
+
+static inline uint32_t _nano_pack_snorm16(float value) {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (uint32_t)(uint16_t)(int16_t)lrintf(value * 32767.0f);
+}
+
+static inline float _nano_unpack_snorm16(uint32_t value) {
+    float f = (float)(int16_t)(uint16_t)value / 32767.0f;
+    return f < -1.0f ? -1.0f : f;
+}
+
+// Bulk Conversions
+// -------------------------------------------------
+
+#if NANO_FORMAT_WASM_SIMD
+// Same algorithm as nano_f32_to_f16() on four lanes
+static inline v128_t _nano_f32x4_to_f16x4(v128_t f) {
+    v128_t sign = wasm_v128_and(f, wasm_u32x4_splat(0x80000000u));
+    f = wasm_v128_xor(f, sign);
+
+    v128_t inf_nan = wasm_v128_bitselect(
+        wasm_u32x4_splat(0x7e00), wasm_u32x4_splat(0x7c00),
+        wasm_u32x4_gt(f, wasm_u32x4_splat(255u << 23)));
+    v128_t is_big = wasm_u32x4_ge(f, wasm_u32x4_splat((127u + 16u) << 23));
+
+    v128_t denorm_magic = wasm_u32x4_splat(((127u - 15u) + (23u - 10u) + 1u)
+                                           << 23);
+    v128_t denorm =
+        wasm_i32x4_sub(wasm_f32x4_add(f, denorm_magic), denorm_magic);
+    v128_t is_denorm = wasm_u32x4_lt(f, wasm_u32x4_splat(113u << 23));
+
+    v128_t mant_odd =
+        wasm_v128_and(wasm_u32x4_shr(f, 13), wasm_u32x4_splat(1));
+    v128_t normal = wasm_i32x4_add(
+        f, wasm_u32x4_splat(((uint32_t)(15 - 127) << 23) + 0xfff));
+    normal = wasm_u32x4_shr(wasm_i32x4_add(normal, mant_odd), 13);
+
+    v128_t result = wasm_v128_bitselect(denorm, normal, is_denorm);
+    result = wasm_v128_bitselect(inf_nan, result, is_big);
+    return wasm_v128_or(result, wasm_u32x4_shr(sign, 16));
+}
+
+// Same algorithm as nano_f16_to_f32() on four lanes
+static inline v128_t _nano_f16x4_to_f32x4(v128_t h) {
+    const v128_t shifted_exp = wasm_u32x4_splat(0x7c00u << 13);
+
+    v128_t o = wasm_i32x4_shl(wasm_v128_and(h, wasm_u32x4_splat(0x7fff)), 13);
+    v128_t exp = wasm_v128_and(o, shifted_exp);
+    o = wasm_i32x4_add(o, wasm_u32x4_splat((127u - 15u) << 23));
+
+    v128_t inf_nan = wasm_i32x4_eq(exp, shifted_exp);
+    o = wasm_i32x4_add(
+        o, wasm_v128_and(inf_nan, wasm_u32x4_splat((128u - 16u) << 23)));
+
+    v128_t denorm = wasm_f32x4_sub(
+        wasm_i32x4_add(o, wasm_u32x4_splat(1u << 23)),
+        wasm_u32x4_splat(113u << 23));
+    o = wasm_v128_bitselect(denorm, o,
+                            wasm_i32x4_eq(exp, wasm_i32x4_splat(0)));
+
+    return wasm_v128_or(
+        o, wasm_i32x4_shl(wasm_v128_and(h, wasm_u32x4_splat(0x8000)), 16));
+}
+#endif
+
+// Convert count floats to half precision
+static inline void nano_f32_to_f16_n(const float *src, uint16_t *dst,
+                                     size_t count) {
+    size_t i = 0;
+#if NANO_FORMAT_F16C
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                    _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *)(dst + i), h);
+    }
+#elif NANO_FORMAT_NEON
+    for (; i + 4 <= count; i += 4) {
+        float16x4_t h = vcvt_f16_f32(vld1q_f32(src + i));
+        vst1_u16(dst + i, vreinterpret_u16_f16(h));
+    }
+#elif NANO_FORMAT_WASM_SIMD
+    for (; i + 4 <= count; i += 4) {
+        v128_t h = _nano_f32x4_to_f16x4(wasm_v128_load(src + i));
+        // The lanes are at most 0xffff so narrowing never saturates
+        h = wasm_u16x8_narrow_i32x4(h, h);
+        wasm_v128_store64_lane(dst + i, h, 0);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = nano_f32_to_f16(src[i]);
+    }
+}
+
+// Convert count half precision values to floats
+static inline void nano_f16_to_f32_n(const uint16_t *src, float *dst,
+                                     size_t count) {
+    size_t i = 0;
+#if NANO_FORMAT_F16C
+    for (; i + 8 <= count; i += 8) {
+        __m128i h = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+#elif NANO_FORMAT_NEON
+    for (; i + 4 <= count; i += 4) {
+        float16x4_t h = vreinterpret_f16_u16(vld1_u16(src + i));
+        vst1q_f32(dst + i, vcvt_f32_f16(h));
+    }
+#elif NANO_FORMAT_WASM_SIMD
+    for (; i + 4 <= count; i += 4) {
+        v128_t h = wasm_u32x4_load16x4(src + i);
+        wasm_v128_store(dst + i, _nano_f16x4_to_f32x4(h));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = nano_f16_to_f32(src[i]);
+    }
+}
+
+// Pack count f32 values into a format
+// dst must hold nano_format_size(format, count) bytes. A partial last
+// element is padded with zeros.
+static inline void nano_format_pack(nano_format_t format, const float *src,
+                                    void *dst, size_t count) {
+    switch (format) {
+    case NANO_FORMAT_F32:
+        memcpy(dst, src, count * sizeof(float));
+        break;
+    case NANO_FORMAT_F16:
+        nano_f32_to_f16_n(src, (uint16_t *)dst, count);
+        break;
+    case NANO_FORMAT_UNORM8X4: {
+        uint32_t *out = (uint32_t *)dst;
+        for (size_t i = 0; i < count; i += 4) {
+            uint32_t packed = 0;
+            for (size_t c = 0; c < 4 && i + c < count; c++) {
+                packed |= _nano_pack_unorm8(src[i + c]) << (8 * c);
+            }
+            out[i / 4] = packed;
+        }
+        break;
+    }
+    case NANO_FORMAT_SNORM16X2: {
+        uint32_t *out = (uint32_t *)dst;
+        for (size_t i = 0; i < count; i += 2) {
+            uint32_t packed = _nano_pack_snorm16(src[i]);
+            if (i + 1 < count) {
+                packed |= _nano_pack_snorm16(src[i + 1]) << 16;
+            }
+            out[i / 2] = packed;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Unpack count f32 values from a format
+static inline void nano_format_unpack(nano_format_t format, const void *src,
+                                      float *dst, size_t count) {
+    switch (format) {
+    case NANO_FORMAT_F32:
+        memcpy(dst, src, count * sizeof(float));
+        break;
+    case NANO_FORMAT_F16:
+        nano_f16_to_f32_n((const uint16_t *)src, dst, count);
+        break;
+    case NANO_FORMAT_UNORM8X4: {
+        const uint32_t *in = (const uint32_t *)src;
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = (float)((in[i / 4] >> (8 * (i % 4))) & 0xff) / 255.0f;
+        }
+        break;
+    }
+    case NANO_FORMAT_SNORM16X2: {
+        const uint32_t *in = (const uint32_t *)src;
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = _nano_unpack_snorm16(in[i / 2] >> (16 * (i % 2)));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+#endif // NANO_FORMAT_H
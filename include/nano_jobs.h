@@ -0,0 +1,463 @@
+// ---------------------------------------------------------------------
+//  nano_jobs.h
+//  --------------------------------------------------------------------
+//  Work-stealing job system for Nano
+//  --------------------------------------------------------------------
+//
+//  A fixed number of worker threads is created once by nano_jobs_init()
+//  and reused until nano_jobs_shutdown(). Every worker owns a Chase-Lev
+//  deque: it pushes and pops jobs at the bottom while idle workers steal
+//  from the top. Threads that are not workers (the main thread) submit
+//  through a small locked queue, and help run jobs while they wait.
+//
+//  Large ranges are split lazily: a job whose range is bigger than its
+//  grain pushes the upper half back onto the deque before running the
+//  lower half, so idle workers can steal the remaining work.
+//
+//  By default one worker is created per hardware thread minus one for the
+//  calling thread, at least one and at most NANO_MAX_WORKERS. Define
+//  NANO_NUM_WORKERS before including nano.h to pick the count, or define it
+//  as 0 to opt out. With NANO_NUM_WORKERS 0, or when building with
+//  Emscripten without -pthread, every job runs inline on the calling thread.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_JOBS_H
+#define NANO_JOBS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Upper bound on the workers created when the count is picked at runtime
+#ifndef NANO_MAX_WORKERS
+    #define NANO_MAX_WORKERS 16
+#endif
+
+// -1 picks the count from the hardware concurrency in nano_jobs_init()
+#ifndef NANO_NUM_WORKERS
+    #define NANO_NUM_WORKERS -1
+#endif
+
+// Emscripten only provides real threads when built with -pthread
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    #undef NANO_NUM_WORKERS
+    #define NANO_NUM_WORKERS 0
+#endif
+
+// Number of worker slots reserved in nano_jobs_t
+#if NANO_NUM_WORKERS < 0
+    #define NANO_WORKER_SLOTS NANO_MAX_WORKERS
+#else
+    #define NANO_WORKER_SLOTS NANO_NUM_WORKERS
+#endif
+
+#if NANO_WORKER_SLOTS > 0
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+// Capacity of each worker deque, must be a power of two
+#define NANO_JOB_DEQUE_SIZE 256
+
+// Capacity of the queue used by threads that are not workers
+#define NANO_JOB_QUEUE_SIZE 256
+
+// Run a job over the index range [begin, end)
+typedef void (*nano_job_fn)(void *data, uint32_t begin, uint32_t end);
+
+// Tracks the number of unfinished jobs for nano_jobs_wait()
+typedef struct {
+    atomic_int pending;
+} nano_job_counter_t;
+
+typedef struct {
+    nano_job_fn fn;
+    void *data;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t grain;
+    nano_job_counter_t *counter;
+} nano_job_t;
+
+// Chase-Lev work-stealing deque
+typedef struct {
+    atomic_long top;
+    atomic_long bottom;
+    nano_job_t jobs[NANO_JOB_DEQUE_SIZE];
+} nano_job_deque_t;
+
+typedef struct {
+    bool running;
+    int worker_count;
+#if NANO_WORKER_SLOTS > 0
+    pthread_t threads[NANO_WORKER_SLOTS];
+    nano_job_deque_t deques[NANO_WORKER_SLOTS];
+
+    // Jobs submitted by threads that are not workers
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    nano_job_t queue[NANO_JOB_QUEUE_SIZE];
+    uint32_t queue_head;
+    uint32_t queue_count;
+
+    // Number of jobs waiting in any deque or the queue
+    atomic_int queued;
+    atomic_int sleeping;
+    atomic_bool shutdown;
+#endif
+} nano_jobs_t;
+
+static nano_jobs_t nano_jobs = {0};
+
+// Spinlock for short critical sections that any thread may enter
+// A zero initialized lock is unlocked.
+typedef struct {
+    atomic_flag flag;
+} nano_spinlock_t;
+
+static inline void nano_spin_lock(nano_spinlock_t *lock) {
+    while (atomic_flag_test_and_set_explicit(&lock->flag,
+                                             memory_order_acquire)) {
+    }
+}
+
+static inline void nano_spin_unlock(nano_spinlock_t *lock) {
+    atomic_flag_clear_explicit(&lock->flag, memory_order_release);
+}
+
+// Index of the worker running on this thread, -1 if not a worker
+static _Thread_local int nano_job_worker_index = -1;
+
+#if NANO_WORKER_SLOTS > 0
+
+// Deque Functions
+// -------------------------------------------------
+
+// Push a job onto the bottom of a deque, only called by the owner
+static bool _nano_deque_push(nano_job_deque_t *q, const nano_job_t *job) {
+    long b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&q->top, memory_order_acquire);
+    if (b - t >= NANO_JOB_DEQUE_SIZE) {
+        return false;
+    }
+
+    q->jobs[b & (NANO_JOB_DEQUE_SIZE - 1)] = *job;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+// Pop a job from the bottom of a deque, only called by the owner
+static bool _nano_deque_pop(nano_job_deque_t *q, nano_job_t *job) {
+    long b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+    if (t > b) {
+        // Deque was empty
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *job = q->jobs[b & (NANO_JOB_DEQUE_SIZE - 1)];
+    if (t == b) {
+        // Last job, race against thieves for it
+        bool won = atomic_compare_exchange_strong_explicit(
+            &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+
+    return true;
+}
+
+// Steal a job from the top of another worker's deque
+static bool _nano_deque_steal(nano_job_deque_t *q, nano_job_t *job) {
+    long t = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (t >= b) {
+        return false;
+    }
+
+    nano_job_t stolen = q->jobs[t & (NANO_JOB_DEQUE_SIZE - 1)];
+    if (!atomic_compare_exchange_strong_explicit(
+            &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return false;
+    }
+
+    *job = stolen;
+    return true;
+}
+
+// Scheduler Functions
+// -------------------------------------------------
+
+// Queue a job on the current worker's deque or the shared queue
+static bool _nano_jobs_push(const nano_job_t *job) {
+    int self = nano_job_worker_index;
+    bool pushed = false;
+
+    if (self >= 0) {
+        pushed = _nano_deque_push(&nano_jobs.deques[self], job);
+    } else {
+        pthread_mutex_lock(&nano_jobs.lock);
+        if (nano_jobs.queue_count < NANO_JOB_QUEUE_SIZE) {
+            uint32_t slot = (nano_jobs.queue_head + nano_jobs.queue_count) %
+                            NANO_JOB_QUEUE_SIZE;
+            nano_jobs.queue[slot] = *job;
+            nano_jobs.queue_count++;
+            pushed = true;
+        }
+        pthread_mutex_unlock(&nano_jobs.lock);
+    }
+
+    if (!pushed) {
+        return false;
+    }
+
+    // Wake a sleeping worker if there is one
+    atomic_fetch_add(&nano_jobs.queued, 1);
+    if (atomic_load(&nano_jobs.sleeping) > 0) {
+        pthread_mutex_lock(&nano_jobs.lock);
+        pthread_cond_signal(&nano_jobs.wake);
+        pthread_mutex_unlock(&nano_jobs.lock);
+    }
+
+    return true;
+}
+
+// Find the next job to run: own deque, then shared queue, then steal
+static bool _nano_jobs_next(nano_job_t *job) {
+    int self = nano_job_worker_index;
+    int count = nano_jobs.worker_count;
+
+    if (self >= 0 && _nano_deque_pop(&nano_jobs.deques[self], job)) {
+        goto found;
+    }
+
+    pthread_mutex_lock(&nano_jobs.lock);
+    if (nano_jobs.queue_count > 0) {
+        *job = nano_jobs.queue[nano_jobs.queue_head];
+        nano_jobs.queue_head = (nano_jobs.queue_head + 1) % NANO_JOB_QUEUE_SIZE;
+        nano_jobs.queue_count--;
+        pthread_mutex_unlock(&nano_jobs.lock);
+        goto found;
+    }
+    pthread_mutex_unlock(&nano_jobs.lock);
+
+    // Start with the next worker so thieves spread across victims
+    for (int i = 1; i <= count; i++) {
+        int victim = (self + i + count) % count;
+        if (victim == self) {
+            continue;
+        }
+        if (_nano_deque_steal(&nano_jobs.deques[victim], job)) {
+            goto found;
+        }
+    }
+
+    return false;
+
+found:
+    atomic_fetch_sub(&nano_jobs.queued, 1);
+    return true;
+}
+
+#endif // NANO_WORKER_SLOTS > 0
+
+// Run a job, splitting off the upper half of large ranges first
+static void _nano_jobs_run(nano_job_t *job) {
+#if NANO_WORKER_SLOTS > 0
+    while (job->end - job->begin > job->grain) {
+        uint32_t mid = job->begin + (job->end - job->begin) / 2;
+        nano_job_t half = *job;
+        half.begin = mid;
+
+        atomic_fetch_add(&job->counter->pending, 1);
+        if (!_nano_jobs_push(&half)) {
+            atomic_fetch_sub(&job->counter->pending, 1);
+            break;
+        }
+        job->end = mid;
+    }
+#endif
+
+    job->fn(job->data, job->begin, job->end);
+    atomic_fetch_sub(&job->counter->pending, 1);
+}
+
+#if NANO_WORKER_SLOTS > 0
+
+// Main loop for every worker thread
+static void *_nano_jobs_worker(void *arg) {
+    nano_job_worker_index = (int)(intptr_t)arg;
+
+    nano_job_t job;
+    while (!atomic_load(&nano_jobs.shutdown)) {
+        if (_nano_jobs_next(&job)) {
+            _nano_jobs_run(&job);
+            continue;
+        }
+
+        // Nothing to do, sleep until a job is queued
+        pthread_mutex_lock(&nano_jobs.lock);
+        atomic_fetch_add(&nano_jobs.sleeping, 1);
+        while (atomic_load(&nano_jobs.queued) == 0 &&
+               !atomic_load(&nano_jobs.shutdown)) {
+            pthread_cond_wait(&nano_jobs.wake, &nano_jobs.lock);
+        }
+        atomic_fetch_sub(&nano_jobs.sleeping, 1);
+        pthread_mutex_unlock(&nano_jobs.lock);
+    }
+
+    return NULL;
+}
+
+// Number of workers to create, NANO_NUM_WORKERS if it was set, otherwise
+// one per hardware thread that is left after the calling thread
+static int _nano_jobs_target_count(void) {
+#if NANO_NUM_WORKERS > 0
+    return NANO_NUM_WORKERS;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int count = cores > 1 ? (int)cores - 1 : 1;
+    return count < NANO_MAX_WORKERS ? count : NANO_MAX_WORKERS;
+#endif
+}
+
+#endif // NANO_WORKER_SLOTS > 0
+
+// Job System Functions
+// -------------------------------------------------
+
+// Create the worker threads. Safe to call more than once, the threads
+// are only ever created the first time.
+int nano_jobs_init(void) {
+    if (nano_jobs.running) {
+        return 0;
+    }
+
+#if NANO_WORKER_SLOTS > 0
+    pthread_mutex_init(&nano_jobs.lock, NULL);
+    pthread_cond_init(&nano_jobs.wake, NULL);
+    atomic_store(&nano_jobs.shutdown, false);
+
+    for (int i = 0; i < NANO_WORKER_SLOTS; i++) {
+        // Workers may steal from any deque as soon as they start
+        atomic_store(&nano_jobs.deques[i].top, 0);
+        atomic_store(&nano_jobs.deques[i].bottom, 0);
+    }
+
+    int target = _nano_jobs_target_count();
+    nano_jobs.worker_count = target;
+    for (int i = 0; i < target; i++) {
+        if (pthread_create(&nano_jobs.threads[i], NULL, _nano_jobs_worker,
+                           (void *)(intptr_t)i) != 0) {
+            fprintf(stderr, "NANO: nano_jobs_init() -> Could only create %d "
+                            "of %d workers\n",
+                    i, target);
+            nano_jobs.worker_count = i;
+            break;
+        }
+    }
+#endif
+
+    nano_jobs.running = true;
+    return 0;
+}
+
+// Stop and join the worker threads
+void nano_jobs_shutdown(void) {
+    if (!nano_jobs.running) {
+        return;
+    }
+
+#if NANO_WORKER_SLOTS > 0
+    pthread_mutex_lock(&nano_jobs.lock);
+    atomic_store(&nano_jobs.shutdown, true);
+    pthread_cond_broadcast(&nano_jobs.wake);
+    pthread_mutex_unlock(&nano_jobs.lock);
+
+    for (int i = 0; i < nano_jobs.worker_count; i++) {
+        pthread_join(nano_jobs.threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&nano_jobs.wake);
+    pthread_mutex_destroy(&nano_jobs.lock);
+#endif
+
+    nano_jobs.worker_count = 0;
+    nano_jobs.running = false;
+}
+
+// Number of worker threads that are running
+int nano_jobs_worker_count(void) { return nano_jobs.worker_count; }
+
+// Submit fn over [begin, end) in chunks of at least grain indices.
+// The counter is incremented here and decremented once the whole range
+// has run. Without workers the job runs inline before returning.
+void nano_jobs_submit(nano_job_fn fn, void *data, uint32_t begin,
+                      uint32_t end, uint32_t grain,
+                      nano_job_counter_t *counter) {
+    nano_job_t job = {
+        .fn = fn,
+        .data = data,
+        .begin = begin,
+        .end = end,
+        .grain = grain > 0 ? grain : 1,
+        .counter = counter,
+    };
+
+    atomic_fetch_add(&counter->pending, 1);
+
+#if NANO_WORKER_SLOTS > 0
+    if (nano_jobs.worker_count > 0 && _nano_jobs_push(&job)) {
+        return;
+    }
+#endif
+
+    _nano_jobs_run(&job);
+}
+
+// Check if every job tracked by the counter has finished
+bool nano_jobs_done(nano_job_counter_t *counter) {
+    return atomic_load(&counter->pending) == 0;
+}
+
+// Wait for every job tracked by the counter to finish. The calling thread
+// runs queued jobs instead of blocking so it never sits idle, which also
+// keeps the browser main thread from blocking on a futex.
+void nano_jobs_wait(nano_job_counter_t *counter) {
+#if NANO_WORKER_SLOTS > 0
+    nano_job_t job;
+    while (atomic_load(&counter->pending) > 0) {
+        if (_nano_jobs_next(&job)) {
+            _nano_jobs_run(&job);
+        } else {
+            sched_yield();
+        }
+    }
+#else
+    (void)counter;
+#endif
+}
+
+// Run fn over [0, count) across the workers and wait for it to finish
+void nano_parallel_for(uint32_t count, uint32_t grain, nano_job_fn fn,
+                       void *data) {
+    if (count == 0 || fn == NULL) {
+        return;
+    }
+
+    nano_job_counter_t counter = {0};
+    nano_jobs_submit(fn, data, 0, count, grain, &counter);
+    nano_jobs_wait(&counter);
+}
+
+#endif // NANO_JOBS_H
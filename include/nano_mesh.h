@@ -0,0 +1,794 @@
+// ---------------------------------------------------------------------
+//  nano_mesh.h
+//  --------------------------------------------------------------------
+//  OBJ and binary glTF mesh loading for Nano
+//  --------------------------------------------------------------------
+//
+//  nano_mesh_load() maps a .obj or .glb file into memory and describes its
+//  vertex attributes and indices as streams. A stream is a pointer, a
+//  stride and a component type, so it can be uploaded to a vertex buffer
+//  as is.
+//
+//  - glTF binary: streams point straight into the mapped BIN chunk, nothing
+//    is copied. Only the first primitive of the first mesh is loaded and
+//    node transforms are ignored.
+//  - OBJ: faces are triangulated, vertices are deduplicated and the streams
+//    point to memory owned by the mesh.
+//
+//  nano_mesh_free() unmaps the file, so the streams are only valid until
+//  then. The header only depends on the C standard library and POSIX mmap.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_MESH_H
+#define NANO_MESH_H
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Maximum number of JSON tokens in the glTF chunk of a .glb file
+#ifndef NANO_MESH_MAX_JSON_TOKENS
+    #define NANO_MESH_MAX_JSON_TOKENS 4096
+#endif
+
+// glTF component types, also used for OBJ data
+#define NANO_MESH_I8 5120
+#define NANO_MESH_U8 5121
+#define NANO_MESH_I16 5122
+#define NANO_MESH_U16 5123
+#define NANO_MESH_U32 5125
+#define NANO_MESH_F32 5126
+
+typedef enum {
+    NANO_MESH_POSITION,
+    NANO_MESH_NORMAL,
+    NANO_MESH_TEXCOORD,
+    NANO_MESH_COLOR,
+    NANO_MESH_ATTRIBUTE_COUNT,
+} nano_mesh_attribute_t;
+
+// A strided array of vertex attributes or indices
+// data is NULL if the mesh does not have the attribute.
+typedef struct {
+    const uint8_t *data;
+    // Bytes from the first element to the end of the last one
+    size_t size;
+    uint32_t stride;
+    uint32_t component_type;
+    uint8_t components;
+    bool normalized;
+} nano_mesh_stream_t;
+
+typedef struct {
+    nano_mesh_stream_t attributes[NANO_MESH_ATTRIBUTE_COUNT];
+    // U16 or U32 indices, data is NULL for non-indexed meshes
+    nano_mesh_stream_t indices;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    float bounds_min[3];
+    float bounds_max[3];
+
+    // The mapped file and memory for data decoded from it
+    void *map;
+    size_t map_size;
+    void *owned;
+} nano_mesh_data_t;
+
+// Size in bytes of a component type
+static inline uint32_t nano_mesh_component_size(uint32_t component_type) {
+    switch (component_type) {
+    case NANO_MESH_I8:
+    case NANO_MESH_U8:
+        return 1;
+    case NANO_MESH_I16:
+    case NANO_MESH_U16:
+        return 2;
+    case NANO_MESH_U32:
+    case NANO_MESH_F32:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Map a whole file read-only, returns NULL on failure
+static void *_nano_mesh_map(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    *size = (size_t)st.st_size;
+    return map;
+}
+
+static void _nano_mesh_bounds(nano_mesh_data_t *mesh) {
+    nano_mesh_stream_t *pos = &mesh->attributes[NANO_MESH_POSITION];
+    for (int c = 0; c < 3; c++) {
+        mesh->bounds_min[c] = mesh->vertex_count ? 3.4e38f : 0.0f;
+        mesh->bounds_max[c] = mesh->vertex_count ? -3.4e38f : 0.0f;
+    }
+    for (uint32_t i = 0; i < mesh->vertex_count; i++) {
+        const float *v = (const float *)(pos->data + (size_t)i * pos->stride);
+        for (int c = 0; c < 3; c++) {
+            if (v[c] < mesh->bounds_min[c])
+                mesh->bounds_min[c] = v[c];
+            if (v[c] > mesh->bounds_max[c])
+                mesh->bounds_max[c] = v[c];
+        }
+    }
+}
+
+// OBJ Loading
+// -------------------------------------------------
+
+// Parse the next OBJ line, returns a pointer to the start of the next line
+static const char *_nano_obj_next_line(const char *s, const char *end) {
+    const char *nl = memchr(s, '\n', (size_t)(end - s));
+    return nl ? nl + 1 : end;
+}
+
+// Tokens on a line are separated by spaces or tabs
+static inline bool _nano_obj_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static const char *_nano_obj_skip_space(const char *s, const char *end) {
+    while (s < end && _nano_obj_is_space(*s)) {
+        s++;
+    }
+    return s;
+}
+
+static const char *_nano_obj_token_end(const char *s, const char *end) {
+    while (s < end && !_nano_obj_is_space(*s) && *s != '\n') {
+        s++;
+    }
+    return s;
+}
+
+// Return the arguments of a line that starts with keyword, or NULL
+static const char *_nano_obj_keyword(const char *s, const char *end,
+                                     const char *keyword) {
+    size_t length = strlen(keyword);
+    if ((size_t)(end - s) <= length || memcmp(s, keyword, length) != 0 ||
+        !_nano_obj_is_space(s[length])) {
+        return NULL;
+    }
+    return s + length;
+}
+
+// Parse the next float on a line. The mapped file is not NUL terminated,
+// so the token is copied before strtof() reads it.
+static float _nano_obj_float(const char **s, const char *end) {
+    const char *start = _nano_obj_skip_space(*s, end);
+    const char *stop = _nano_obj_token_end(start, end);
+    char token[64];
+    size_t length = (size_t)(stop - start);
+    if (length >= sizeof(token)) {
+        length = sizeof(token) - 1;
+    }
+    memcpy(token, start, length);
+    token[length] = '\0';
+    *s = stop;
+    return strtof(token, NULL);
+}
+
+// Parse an optionally negative integer, 0 if there are no digits
+static int64_t _nano_obj_int(const char **s, const char *end) {
+    const char *p = *s;
+    bool negative = p < end && *p == '-';
+    if (negative) {
+        p++;
+    }
+    int64_t value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        // Anything this large is out of range anyway
+        if (value < ((int64_t)1 << 40)) {
+            value = value * 10 + (*p - '0');
+        }
+    }
+    *s = p;
+    return negative ? -value : value;
+}
+
+// Resolve a 1-based or negative OBJ index, returns -1 if it is invalid
+static int64_t _nano_obj_index(int64_t value, uint32_t count) {
+    int64_t index = value < 0 ? (int64_t)count + value : value - 1;
+    return index >= 0 && index < (int64_t)count ? index : -1;
+}
+
+typedef struct {
+    int64_t v, vt, vn;
+} _nano_obj_corner_t;
+
+// Parse a v, v/vt, v//vn or v/vt/vn token that ends at end
+static void _nano_obj_corner(const char *s, const char *end,
+                             _nano_obj_corner_t *c, uint32_t v_count,
+                             uint32_t vt_count, uint32_t vn_count) {
+    c->vt = c->vn = -1;
+    c->v = _nano_obj_index(_nano_obj_int(&s, end), v_count);
+    if (s < end && *s == '/') {
+        s++;
+        if (s < end && *s != '/') {
+            c->vt = _nano_obj_index(_nano_obj_int(&s, end), vt_count);
+        }
+        if (s < end && *s == '/') {
+            s++;
+            c->vn = _nano_obj_index(_nano_obj_int(&s, end), vn_count);
+        }
+    }
+}
+
+// Number of corner tokens of a face, both passes skip faces with less
+// than 3 so that the arrays sized by the first pass always fit
+static uint32_t _nano_obj_face_size(const char *s, const char *end) {
+    uint32_t n = 0;
+    for (s = _nano_obj_skip_space(s, end); s < end && *s != '\n';
+         s = _nano_obj_skip_space(_nano_obj_token_end(s, end), end)) {
+        n++;
+    }
+    return n;
+}
+
+// Load an OBJ file that has already been mapped
+// The file is scanned twice, once to size the arrays and once to fill them.
+static bool _nano_mesh_load_obj(nano_mesh_data_t *mesh) {
+    const char *begin = (const char *)mesh->map;
+    const char *end = begin + mesh->map_size;
+
+    uint32_t v_count = 0, vt_count = 0, vn_count = 0, corner_count = 0;
+    uint32_t tri_count = 0;
+    const char *line_end;
+    for (const char *s = begin; s < end; s = line_end) {
+        line_end = _nano_obj_next_line(s, end);
+        const char *args;
+        if (_nano_obj_keyword(s, line_end, "v")) {
+            v_count++;
+        } else if (_nano_obj_keyword(s, line_end, "vt")) {
+            vt_count++;
+        } else if (_nano_obj_keyword(s, line_end, "vn")) {
+            vn_count++;
+        } else if ((args = _nano_obj_keyword(s, line_end, "f")) != NULL) {
+            uint32_t n = _nano_obj_face_size(args, line_end);
+            if (n >= 3) {
+                corner_count += n;
+                tri_count += n - 2;
+            }
+        }
+    }
+
+    if (v_count == 0 || tri_count == 0) {
+        return false;
+    }
+
+    // One allocation for the raw OBJ arrays, the unique vertex streams, the
+    // indices and the deduplication table
+    uint32_t table_size = 1;
+    while (table_size < corner_count * 2) {
+        table_size <<= 1;
+    }
+    size_t raw_floats = (size_t)v_count * 3 + vt_count * 2 + vn_count * 3;
+    size_t out_floats = (size_t)corner_count * (3 + 3 + 2);
+    size_t bytes = raw_floats * sizeof(float) + out_floats * sizeof(float) +
+                   (size_t)tri_count * 3 * sizeof(uint32_t) +
+                   (size_t)table_size * sizeof(uint32_t) +
+                   (size_t)corner_count * sizeof(_nano_obj_corner_t);
+    uint8_t *memory = (uint8_t *)calloc(1, bytes);
+    if (memory == NULL) {
+        return false;
+    }
+    mesh->owned = memory;
+
+    // The 8 byte keys go first, the rest only needs 4 byte alignment
+    _nano_obj_corner_t *keys = (_nano_obj_corner_t *)memory;
+    float *v = (float *)(keys + corner_count);
+    float *vt = v + (size_t)v_count * 3;
+    float *vn = vt + (size_t)vt_count * 2;
+    float *positions = vn + (size_t)vn_count * 3;
+    float *normals = positions + (size_t)corner_count * 3;
+    float *uvs = normals + (size_t)corner_count * 3;
+    uint32_t *indices = (uint32_t *)(uvs + (size_t)corner_count * 2);
+    uint32_t *table = indices + (size_t)tri_count * 3;
+
+    uint32_t vi = 0, vti = 0, vni = 0, index_count = 0, vertex_count = 0;
+    for (const char *s = begin; s < end; s = line_end) {
+        line_end = _nano_obj_next_line(s, end);
+        const char *args;
+        if ((args = _nano_obj_keyword(s, line_end, "v")) != NULL) {
+            for (int c = 0; c < 3; c++) {
+                v[vi * 3 + c] = _nano_obj_float(&args, line_end);
+            }
+            vi++;
+        } else if ((args = _nano_obj_keyword(s, line_end, "vt")) != NULL) {
+            for (int c = 0; c < 2; c++) {
+                vt[vti * 2 + c] = _nano_obj_float(&args, line_end);
+            }
+            // OBJ puts the texture origin at the bottom left
+            vt[vti * 2 + 1] = 1.0f - vt[vti * 2 + 1];
+            vti++;
+        } else if ((args = _nano_obj_keyword(s, line_end, "vn")) != NULL) {
+            for (int c = 0; c < 3; c++) {
+                vn[vni * 3 + c] = _nano_obj_float(&args, line_end);
+            }
+            vni++;
+        } else if ((args = _nano_obj_keyword(s, line_end, "f")) != NULL &&
+                   _nano_obj_face_size(args, line_end) >= 3) {
+            uint32_t first = 0, prev = 0, n = 0;
+            const char *token = _nano_obj_skip_space(args, line_end);
+            while (token < line_end && *token != '\n') {
+                const char *token_end = _nano_obj_token_end(token, line_end);
+                _nano_obj_corner_t corner;
+                _nano_obj_corner(token, token_end, &corner, vi, vti, vni);
+                token = _nano_obj_skip_space(token_end, line_end);
+                if (corner.v < 0) {
+                    break;
+                }
+
+                // Find or add the unique vertex for this corner
+                uint64_t key = (uint64_t)corner.v * 0x9E3779B97F4A7C15ull;
+                key ^= (uint64_t)(corner.vt + 1) * 0xC2B2AE3D27D4EB4Full;
+                key ^= (uint64_t)(corner.vn + 1) * 0x165667B19E3779F9ull;
+                uint32_t slot = (uint32_t)(key >> 32) & (table_size - 1);
+                uint32_t index;
+                for (;;) {
+                    uint32_t entry = table[slot];
+                    if (entry == 0) {
+                        index = vertex_count++;
+                        table[slot] = index + 1;
+                        keys[index] = corner;
+                        memcpy(&positions[index * 3], &v[corner.v * 3],
+                               3 * sizeof(float));
+                        if (corner.vn >= 0) {
+                            memcpy(&normals[index * 3], &vn[corner.vn * 3],
+                                   3 * sizeof(float));
+                        }
+                        if (corner.vt >= 0) {
+                            memcpy(&uvs[index * 2], &vt[corner.vt * 2],
+                                   2 * sizeof(float));
+                        }
+                        break;
+                    }
+                    _nano_obj_corner_t *k = &keys[entry - 1];
+                    if (k->v == corner.v && k->vt == corner.vt &&
+                        k->vn == corner.vn) {
+                        index = entry - 1;
+                        break;
+                    }
+                    slot = (slot + 1) & (table_size - 1);
+                }
+
+                // Triangulate the face as a fan
+                if (n == 0) {
+                    first = index;
+                } else if (n >= 2) {
+                    indices[index_count++] = first;
+                    indices[index_count++] = prev;
+                    indices[index_count++] = index;
+                }
+                prev = index;
+                n++;
+            }
+        }
+    }
+
+    // Every face referenced vertices that do not exist
+    if (index_count == 0) {
+        return false;
+    }
+
+    mesh->vertex_count = vertex_count;
+    mesh->index_count = index_count;
+    mesh->attributes[NANO_MESH_POSITION] = (nano_mesh_stream_t){
+        .data = (const uint8_t *)positions,
+        .size = (size_t)vertex_count * 3 * sizeof(float),
+        .stride = 3 * sizeof(float),
+        .component_type = NANO_MESH_F32,
+        .components = 3,
+    };
+    if (vn_count > 0) {
+        mesh->attributes[NANO_MESH_NORMAL] = (nano_mesh_stream_t){
+            .data = (const uint8_t *)normals,
+            .size = (size_t)vertex_count * 3 * sizeof(float),
+            .stride = 3 * sizeof(float),
+            .component_type = NANO_MESH_F32,
+            .components = 3,
+        };
+    }
+    if (vt_count > 0) {
+        mesh->attributes[NANO_MESH_TEXCOORD] = (nano_mesh_stream_t){
+            .data = (const uint8_t *)uvs,
+            .size = (size_t)vertex_count * 2 * sizeof(float),
+            .stride = 2 * sizeof(float),
+            .component_type = NANO_MESH_F32,
+            .components = 2,
+        };
+    }
+    mesh->indices = (nano_mesh_stream_t){
+        .data = (const uint8_t *)indices,
+        .size = (size_t)index_count * sizeof(uint32_t),
+        .stride = sizeof(uint32_t),
+        .component_type = NANO_MESH_U32,
+        .components = 1,
+    };
+
+    _nano_mesh_bounds(mesh);
+    return true;
+}
+
+// glTF Loading
+// -------------------------------------------------
+
+typedef enum {
+    _NANO_JSON_PRIMITIVE,
+    _NANO_JSON_STRING,
+    _NANO_JSON_ARRAY,
+    _NANO_JSON_OBJECT,
+} _nano_json_type_t;
+
+// A JSON value, objects and arrays know how many tokens they span
+typedef struct {
+    _nano_json_type_t type;
+    uint32_t start;
+    uint32_t end;
+    // Number of children, for objects every key and value is a child
+    uint32_t size;
+    // Index of the token after this value and all of its children
+    uint32_t next;
+} _nano_json_token_t;
+
+typedef struct {
+    const char *json;
+    size_t length;
+    size_t pos;
+    _nano_json_token_t *tokens;
+    uint32_t count;
+    uint32_t max;
+} _nano_json_t;
+
+static bool _nano_json_value(_nano_json_t *j);
+
+static void _nano_json_space(_nano_json_t *j) {
+    while (j->pos < j->length &&
+           (j->json[j->pos] == ' ' || j->json[j->pos] == '\n' ||
+            j->json[j->pos] == '\r' || j->json[j->pos] == '\t')) {
+        j->pos++;
+    }
+}
+
+// Tokenize one JSON value and its children
+static bool _nano_json_value(_nano_json_t *j) {
+    _nano_json_space(j);
+    if (j->pos >= j->length || j->count >= j->max) {
+        return false;
+    }
+
+    uint32_t index = j->count++;
+    _nano_json_token_t *t = &j->tokens[index];
+    *t = (_nano_json_token_t){.start = (uint32_t)j->pos};
+
+    char c = j->json[j->pos];
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        j->tokens[index].type = c == '{' ? _NANO_JSON_OBJECT : _NANO_JSON_ARRAY;
+        j->pos++;
+        uint32_t size = 0;
+        for (;;) {
+            _nano_json_space(j);
+            if (j->pos < j->length && j->json[j->pos] == close) {
+                j->pos++;
+                break;
+            }
+            if (!_nano_json_value(j)) {
+                return false;
+            }
+            size++;
+            _nano_json_space(j);
+            if (j->pos < j->length &&
+                (j->json[j->pos] == ',' || j->json[j->pos] == ':')) {
+                j->pos++;
+            }
+        }
+        j->tokens[index].size = size;
+    } else if (c == '"') {
+        j->tokens[index].type = _NANO_JSON_STRING;
+        j->tokens[index].start = (uint32_t)++j->pos;
+        while (j->pos < j->length && j->json[j->pos] != '"') {
+            j->pos += j->json[j->pos] == '\\' ? 2 : 1;
+        }
+        j->tokens[index].end = (uint32_t)j->pos++;
+        j->tokens[index].next = j->count;
+        return j->pos <= j->length;
+    } else {
+        j->tokens[index].type = _NANO_JSON_PRIMITIVE;
+        while (j->pos < j->length && !strchr(",:]} \n\r\t", j->json[j->pos])) {
+            j->pos++;
+        }
+    }
+
+    j->tokens[index].end = (uint32_t)j->pos;
+    j->tokens[index].next = j->count;
+    return true;
+}
+
+static bool _nano_json_eq(_nano_json_t *j, uint32_t token, const char *str) {
+    _nano_json_token_t *t = &j->tokens[token];
+    size_t length = strlen(str);
+    return t->type == _NANO_JSON_STRING && t->end - t->start == length &&
+           memcmp(j->json + t->start, str, length) == 0;
+}
+
+// Value of key in an object, or -1
+static int64_t _nano_json_get(_nano_json_t *j, int64_t object,
+                              const char *key) {
+    if (object < 0 || j->tokens[object].type != _NANO_JSON_OBJECT) {
+        return -1;
+    }
+    uint32_t token = (uint32_t)object + 1;
+    for (uint32_t i = 0; i < j->tokens[object].size; i += 2) {
+        uint32_t value = j->tokens[token].next;
+        if (_nano_json_eq(j, token, key)) {
+            return value;
+        }
+        token = j->tokens[value].next;
+    }
+    return -1;
+}
+
+// Element n of an array, or -1
+static int64_t _nano_json_at(_nano_json_t *j, int64_t array, int64_t n) {
+    if (array < 0 || n < 0 || j->tokens[array].type != _NANO_JSON_ARRAY ||
+        n >= j->tokens[array].size) {
+        return -1;
+    }
+    uint32_t token = (uint32_t)array + 1;
+    while (n-- > 0) {
+        token = j->tokens[token].next;
+    }
+    return token;
+}
+
+static double _nano_json_number(_nano_json_t *j, int64_t token,
+                                double fallback) {
+    if (token < 0 || j->tokens[token].type != _NANO_JSON_PRIMITIVE) {
+        return fallback;
+    }
+    return strtod(j->json + j->tokens[token].start, NULL);
+}
+
+// Describe a glTF accessor as a stream into the BIN chunk
+static bool _nano_gltf_accessor(_nano_json_t *j, int64_t accessor,
+                                const uint8_t *bin, size_t bin_length,
+                                nano_mesh_stream_t *stream, uint32_t *count) {
+    int64_t accessors = _nano_json_get(j, 0, "accessors");
+    int64_t views = _nano_json_get(j, 0, "bufferViews");
+    int64_t a = _nano_json_at(j, accessors, accessor);
+    int64_t view =
+        _nano_json_at(j, views, (int64_t)_nano_json_number(
+                                    j, _nano_json_get(j, a, "bufferView"), -1));
+    if (a < 0 || view < 0) {
+        return false;
+    }
+
+    const char *types[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+    int64_t type = _nano_json_get(j, a, "type");
+    uint8_t components = 0;
+    for (int i = 0; i < 4; i++) {
+        if (type >= 0 && _nano_json_eq(j, (uint32_t)type, types[i])) {
+            components = (uint8_t)(i + 1);
+        }
+    }
+
+    stream->component_type = (uint32_t)_nano_json_number(
+        j, _nano_json_get(j, a, "componentType"), 0);
+    stream->components = components;
+    int64_t normalized = _nano_json_get(j, a, "normalized");
+    stream->normalized =
+        normalized >= 0 && j->json[j->tokens[normalized].start] == 't';
+
+    uint32_t element = components *
+                       nano_mesh_component_size(stream->component_type);
+    *count = (uint32_t)_nano_json_number(j, _nano_json_get(j, a, "count"), 0);
+    stream->stride = (uint32_t)_nano_json_number(
+        j, _nano_json_get(j, view, "byteStride"), element);
+
+    size_t offset =
+        (size_t)_nano_json_number(j, _nano_json_get(j, view, "byteOffset"),
+                                  0) +
+        (size_t)_nano_json_number(j, _nano_json_get(j, a, "byteOffset"), 0);
+    stream->size =
+        *count ? (size_t)(*count - 1) * stream->stride + element : 0;
+    stream->data = bin + offset;
+
+    return element > 0 && offset + stream->size <= bin_length;
+}
+
+// Load a glTF binary file that has already been mapped
+static bool _nano_mesh_load_glb(nano_mesh_data_t *mesh) {
+    const uint8_t *data = (const uint8_t *)mesh->map;
+    uint32_t header[5];
+    if (mesh->map_size < 28) {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+
+    // "glTF", version 2, then the JSON chunk length and type
+    if (header[0] != 0x46546C67 || header[1] != 2 ||
+        header[4] != 0x4E4F534A) {
+        return false;
+    }
+
+    const char *json = (const char *)data + 20;
+    size_t json_length = header[3];
+    size_t bin_header = 20 + json_length;
+    if (bin_header + 8 > mesh->map_size) {
+        return false;
+    }
+
+    uint32_t chunk[2];
+    memcpy(chunk, data + bin_header, sizeof(chunk));
+    if (chunk[1] != 0x004E4942 || bin_header + 8 + chunk[0] > mesh->map_size) {
+        return false;
+    }
+    const uint8_t *bin = data + bin_header + 8;
+    size_t bin_length = chunk[0];
+
+    _nano_json_token_t *tokens = (_nano_json_token_t *)malloc(
+        NANO_MESH_MAX_JSON_TOKENS * sizeof(_nano_json_token_t));
+    if (tokens == NULL) {
+        return false;
+    }
+
+    _nano_json_t j = {
+        .json = json,
+        .length = json_length,
+        .tokens = tokens,
+        .max = NANO_MESH_MAX_JSON_TOKENS,
+    };
+
+    bool ok = _nano_json_value(&j) && tokens[0].type == _NANO_JSON_OBJECT;
+
+    int64_t meshes = ok ? _nano_json_get(&j, 0, "meshes") : -1;
+    int64_t mesh_json = _nano_json_at(&j, meshes, 0);
+    int64_t primitive =
+        _nano_json_at(&j, _nano_json_get(&j, mesh_json, "primitives"), 0);
+    int64_t attributes = _nano_json_get(&j, primitive, "attributes");
+    ok = ok && attributes >= 0;
+
+    const char *semantics[NANO_MESH_ATTRIBUTE_COUNT] = {
+        [NANO_MESH_POSITION] = "POSITION",
+        [NANO_MESH_NORMAL] = "NORMAL",
+        [NANO_MESH_TEXCOORD] = "TEXCOORD_0",
+        [NANO_MESH_COLOR] = "COLOR_0",
+    };
+
+    for (int i = 0; ok && i < NANO_MESH_ATTRIBUTE_COUNT; i++) {
+        int64_t accessor = _nano_json_get(&j, attributes, semantics[i]);
+        if (accessor < 0) {
+            continue;
+        }
+        uint32_t count;
+        ok = _nano_gltf_accessor(&j, (int64_t)_nano_json_number(&j, accessor,
+                                                                -1),
+                                 bin, bin_length, &mesh->attributes[i],
+                                 &count);
+
+        // Positions come first and set the vertex count, every stream is
+        // read for that many vertices
+        if (i == NANO_MESH_POSITION) {
+            mesh->vertex_count = count;
+        } else if (count != mesh->vertex_count) {
+            ok = false;
+        }
+    }
+
+    // The bounds and quantization read positions as three floats
+    ok = ok && mesh->attributes[NANO_MESH_POSITION].data != NULL &&
+         mesh->attributes[NANO_MESH_POSITION].component_type ==
+             NANO_MESH_F32 &&
+         mesh->attributes[NANO_MESH_POSITION].components == 3;
+
+    int64_t indices = _nano_json_get(&j, primitive, "indices");
+    if (ok && indices >= 0) {
+        ok = _nano_gltf_accessor(&j, (int64_t)_nano_json_number(&j, indices,
+                                                                -1),
+                                 bin, bin_length, &mesh->indices,
+                                 &mesh->index_count);
+        ok = ok && mesh->indices.components == 1 &&
+             (mesh->indices.component_type == NANO_MESH_U8 ||
+              mesh->indices.component_type == NANO_MESH_U16 ||
+              mesh->indices.component_type == NANO_MESH_U32);
+    }
+
+    free(tokens);
+    if (!ok) {
+        return false;
+    }
+
+    // WebGPU has no 8-bit indices, widen them to 16 bits
+    if (mesh->indices.data && mesh->indices.component_type == NANO_MESH_U8) {
+        uint16_t *wide =
+            (uint16_t *)malloc(mesh->index_count * sizeof(uint16_t));
+        if (wide == NULL) {
+            return false;
+        }
+        for (uint32_t i = 0; i < mesh->index_count; i++) {
+            wide[i] = mesh->indices.data[(size_t)i * mesh->indices.stride];
+        }
+        mesh->owned = wide;
+        mesh->indices = (nano_mesh_stream_t){
+            .data = (const uint8_t *)wide,
+            .size = mesh->index_count * sizeof(uint16_t),
+            .stride = sizeof(uint16_t),
+            .component_type = NANO_MESH_U16,
+            .components = 1,
+        };
+    }
+
+    _nano_mesh_bounds(mesh);
+    return true;
+}
+
+// Public API
+// -------------------------------------------------
+
+// Release the memory of a mesh, its streams are invalid afterwards
+void nano_mesh_free(nano_mesh_data_t *mesh) {
+    if (mesh == NULL) {
+        return;
+    }
+    if (mesh->map) {
+        munmap(mesh->map, mesh->map_size);
+    }
+    free(mesh->owned);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+// Load a .obj or .glb file, chosen by the file extension
+// Returns false if the file could not be read or parsed.
+bool nano_mesh_load(const char *path, nano_mesh_data_t *mesh) {
+    memset(mesh, 0, sizeof(*mesh));
+
+    const char *ext = strrchr(path, '.');
+    if (ext == NULL) {
+        return false;
+    }
+
+    mesh->map = _nano_mesh_map(path, &mesh->map_size);
+    if (mesh->map == NULL) {
+        return false;
+    }
+
+    bool ok = false;
+    if (strcmp(ext, ".obj") == 0) {
+        ok = _nano_mesh_load_obj(mesh);
+    } else if (strcmp(ext, ".glb") == 0) {
+        ok = _nano_mesh_load_glb(mesh);
+    }
+
+    if (!ok) {
+        nano_mesh_free(mesh);
+    }
+    return ok;
+}
+
+#endif // NANO_MESH_H
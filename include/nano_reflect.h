@@ -0,0 +1,759 @@
+// ---------------------------------------------------------------------
+//  nano_reflect.h
+//  --------------------------------------------------------------------
+//  WGSL struct reflection and C header generation for Nano
+//  --------------------------------------------------------------------
+//
+//  nano_reflect_structs() finds the structs declared in a WGSL source and
+//  computes the offset, size and alignment of every member using the WGSL
+//  host-shareable layout rules, including @align(n) and @size(n).
+//
+//  nano_reflect_write_header() turns the structs used by uniform and
+//  storage bindings into C structs with explicit padding, _Static_assert
+//  checks on every offset and size, and typed setters. A C struct written
+//  this way can be uploaded with a single memcpy() or wgpuQueueWriteBuffer().
+//
+//  nano_reflect_vertex_inputs() lists the @location inputs of a vertex
+//  entry point, including the members of struct parameters, so vertex
+//  buffer layouts can be built from the shader.
+//
+//  The header only depends on the C standard library so it can be used by
+//  native tools, see tools/nano_structgen.c.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_REFLECT_H
+#define NANO_REFLECT_H
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NANO_REFLECT_MAX_STRUCTS 16
+#define NANO_REFLECT_MAX_MEMBERS 32
+#define NANO_REFLECT_NAME_LENGTH 64
+// Maximum number of array dimensions of a member in C
+#define NANO_REFLECT_MAX_DIMS 4
+// Maximum number of @location inputs of a vertex entry point
+#define NANO_REFLECT_MAX_INPUTS 16
+
+typedef enum {
+    NANO_WGSL_F32,
+    NANO_WGSL_I32,
+    NANO_WGSL_U32,
+    NANO_WGSL_F16,
+    NANO_WGSL_STRUCT,
+} nano_wgsl_scalar_t;
+
+// Layout of a WGSL type and the C array that represents it
+// dims[0] is 0 for runtime-sized arrays.
+typedef struct {
+    nano_wgsl_scalar_t scalar;
+    int struct_index;
+    uint32_t dims[NANO_REFLECT_MAX_DIMS];
+    uint8_t dim_count;
+    uint32_t size;
+    uint32_t align;
+} nano_wgsl_type_t;
+
+typedef struct {
+    char name[NANO_REFLECT_NAME_LENGTH];
+    nano_wgsl_type_t type;
+    uint32_t offset;
+    // Size of the member, including any @size(n) padding
+    uint32_t size;
+    // Value of @location(n), -1 if the member has none
+    int location;
+} nano_wgsl_member_t;
+
+typedef struct {
+    char name[NANO_REFLECT_NAME_LENGTH];
+    nano_wgsl_member_t members[NANO_REFLECT_MAX_MEMBERS];
+    uint8_t member_count;
+    uint32_t size;
+    uint32_t align;
+    // Ends with a runtime-sized array
+    bool runtime_sized;
+    // Has @builtin or @location members, used for shader stage IO only
+    bool stage_io;
+    // Used by a var<uniform> or var<storage> binding, directly or nested
+    bool host_shareable;
+} nano_wgsl_struct_t;
+
+// An @location input of a vertex entry point
+typedef struct {
+    char name[NANO_REFLECT_NAME_LENGTH];
+    uint32_t location;
+    // Only scalars and vectors are valid vertex inputs
+    nano_wgsl_type_t type;
+} nano_wgsl_vertex_input_t;
+
+typedef struct {
+    const char *input;
+    int position;
+    nano_wgsl_struct_t *structs;
+    int struct_count;
+    int max_structs;
+    bool error;
+} nano_reflect_parser_t;
+
+// Parsing
+// -------------------------------------------------
+
+// Skip whitespace and comments
+static void _nano_reflect_skip(nano_reflect_parser_t *p) {
+    for (;;) {
+        const char *s = p->input + p->position;
+        if (isspace((unsigned char)*s)) {
+            p->position++;
+        } else if (s[0] == '/' && s[1] == '/') {
+            while (p->input[p->position] && p->input[p->position] != '\n') {
+                p->position++;
+            }
+        } else if (s[0] == '/' && s[1] == '*') {
+            const char *end = strstr(s + 2, "*/");
+            p->position = end ? (int)(end - p->input) + 2
+                              : (int)strlen(p->input);
+        } else {
+            return;
+        }
+    }
+}
+
+static bool _nano_reflect_accept(nano_reflect_parser_t *p, char c) {
+    _nano_reflect_skip(p);
+    if (p->input[p->position] == c) {
+        p->position++;
+        return true;
+    }
+    return false;
+}
+
+static void _nano_reflect_expect(nano_reflect_parser_t *p, char c) {
+    if (!_nano_reflect_accept(p, c)) {
+        p->error = true;
+    }
+}
+
+// Read an identifier, returns false if there is none
+static bool _nano_reflect_ident(nano_reflect_parser_t *p, char *ident) {
+    _nano_reflect_skip(p);
+    int i = 0;
+    char c = p->input[p->position];
+    while (isalnum((unsigned char)c) || c == '_') {
+        if (i < NANO_REFLECT_NAME_LENGTH - 1) {
+            ident[i++] = c;
+        }
+        c = p->input[++p->position];
+    }
+    ident[i] = '\0';
+    return i > 0;
+}
+
+// Read an integer literal with an optional i or u suffix
+static uint32_t _nano_reflect_number(nano_reflect_parser_t *p) {
+    _nano_reflect_skip(p);
+    uint32_t result = 0;
+    if (!isdigit((unsigned char)p->input[p->position])) {
+        p->error = true;
+        return 0;
+    }
+    while (isdigit((unsigned char)p->input[p->position])) {
+        result = result * 10 + (uint32_t)(p->input[p->position++] - '0');
+    }
+    if (p->input[p->position] == 'i' || p->input[p->position] == 'u') {
+        p->position++;
+    }
+    return result;
+}
+
+// Skip a parenthesized attribute argument list if there is one
+static void _nano_reflect_skip_args(nano_reflect_parser_t *p) {
+    if (!_nano_reflect_accept(p, '(')) {
+        return;
+    }
+    int depth = 1;
+    while (depth > 0 && p->input[p->position]) {
+        char c = p->input[p->position++];
+        depth += (c == '(') - (c == ')');
+    }
+}
+
+static uint32_t _nano_reflect_round_up(uint32_t value, uint32_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static int _nano_reflect_find_struct(nano_reflect_parser_t *p,
+                                     const char *name) {
+    for (int i = 0; i < p->struct_count; i++) {
+        if (strcmp(p->structs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Size in bytes of a scalar type, 0 if the name is not a scalar
+static uint32_t _nano_reflect_scalar(const char *name,
+                                     nano_wgsl_scalar_t *scalar) {
+    if (strcmp(name, "f32") == 0) {
+        *scalar = NANO_WGSL_F32;
+        return 4;
+    } else if (strcmp(name, "i32") == 0) {
+        *scalar = NANO_WGSL_I32;
+        return 4;
+    } else if (strcmp(name, "u32") == 0) {
+        *scalar = NANO_WGSL_U32;
+        return 4;
+    } else if (strcmp(name, "f16") == 0) {
+        *scalar = NANO_WGSL_F16;
+        return 2;
+    }
+    return 0;
+}
+
+// Read the component type of vecN<T> or matCxR<T>, or the f, i, u or h
+// suffix of the shorthand aliases such as vec3f and mat4x4f
+static uint32_t _nano_reflect_component(nano_reflect_parser_t *p,
+                                        const char *suffix,
+                                        nano_wgsl_scalar_t *scalar) {
+    char component[NANO_REFLECT_NAME_LENGTH];
+    if (*suffix == '\0') {
+        _nano_reflect_expect(p, '<');
+        _nano_reflect_ident(p, component);
+        _nano_reflect_expect(p, '>');
+    } else {
+        // vec3f is an alias for vec3<f32>, vec3h for vec3<f16> and so on
+        const char *aliases[] = {"f32", "i32", "u32", "f16"};
+        const char *letters = "fiuh";
+        const char *letter = strchr(letters, suffix[0]);
+        if (letter == NULL || suffix[1] != '\0') {
+            p->error = true;
+            return 4;
+        }
+        snprintf(component, sizeof(component), "%s",
+                 aliases[letter - letters]);
+    }
+
+    uint32_t size = _nano_reflect_scalar(component, scalar);
+    if (size == 0) {
+        p->error = true;
+        return 4;
+    }
+    return size;
+}
+
+// Parse a type and compute its layout
+static void _nano_reflect_type(nano_reflect_parser_t *p,
+                               nano_wgsl_type_t *type) {
+    char name[NANO_REFLECT_NAME_LENGTH];
+    memset(type, 0, sizeof(*type));
+    type->struct_index = -1;
+
+    if (!_nano_reflect_ident(p, name)) {
+        p->error = true;
+        return;
+    }
+
+    uint32_t scalar_size = 0;
+
+    if (strcmp(name, "atomic") == 0) {
+        _nano_reflect_expect(p, '<');
+        _nano_reflect_type(p, type);
+        _nano_reflect_expect(p, '>');
+    } else if (strcmp(name, "array") == 0) {
+        nano_wgsl_type_t element;
+        _nano_reflect_expect(p, '<');
+        _nano_reflect_type(p, &element);
+        uint32_t count = 0;
+        if (_nano_reflect_accept(p, ',')) {
+            count = _nano_reflect_number(p);
+        }
+        _nano_reflect_expect(p, '>');
+
+        if (element.dim_count >= NANO_REFLECT_MAX_DIMS) {
+            p->error = true;
+            return;
+        }
+
+        // Elements are placed at a stride rounded up to their alignment,
+        // which only pads vec3 elements since every other type already has
+        // a size that is a multiple of its alignment
+        uint32_t stride = _nano_reflect_round_up(element.size, element.align);
+        if (stride != element.size && element.dim_count > 0) {
+            uint32_t scalar = element.scalar == NANO_WGSL_F16 ? 2 : 4;
+            element.dims[element.dim_count - 1] = stride / scalar;
+        }
+
+        *type = element;
+        memmove(type->dims + 1, type->dims,
+                type->dim_count * sizeof(uint32_t));
+        type->dims[0] = count;
+        type->dim_count++;
+        type->size = stride * (count ? count : 1);
+    } else if (strncmp(name, "vec", 3) == 0 && name[3] >= '2' &&
+               name[3] <= '4') {
+        uint32_t n = (uint32_t)(name[3] - '0');
+        scalar_size = _nano_reflect_component(p, name + 4, &type->scalar);
+        type->dims[0] = n;
+        type->dim_count = 1;
+        type->size = n * scalar_size;
+        type->align = (n == 3 ? 4 : n) * scalar_size;
+    } else if (strncmp(name, "mat", 3) == 0 && strlen(name) >= 6 &&
+               name[4] == 'x') {
+        uint32_t columns = (uint32_t)(name[3] - '0');
+        uint32_t rows = (uint32_t)(name[5] - '0');
+        if (columns < 2 || columns > 4 || rows < 2 || rows > 4) {
+            p->error = true;
+            return;
+        }
+        scalar_size = _nano_reflect_component(p, name + 6, &type->scalar);
+
+        // Every column is a vecR, so mat3x3 columns are padded to 16 bytes
+        uint32_t column_align = (rows == 3 ? 4 : rows) * scalar_size;
+        type->dims[0] = columns;
+        type->dims[1] = column_align / scalar_size;
+        type->dim_count = 2;
+        type->size = columns * column_align;
+        type->align = column_align;
+    } else if ((scalar_size = _nano_reflect_scalar(name, &type->scalar))) {
+        type->size = scalar_size;
+        type->align = scalar_size;
+    } else {
+        int index = _nano_reflect_find_struct(p, name);
+        if (index < 0) {
+            // WGSL allows structs to be used before they are declared, but
+            // that is rare enough that we only support declaration order
+            p->error = true;
+            return;
+        }
+        type->scalar = NANO_WGSL_STRUCT;
+        type->struct_index = index;
+        type->size = p->structs[index].size;
+        type->align = p->structs[index].align;
+    }
+}
+
+// Parse a struct declaration after the struct keyword
+static void _nano_reflect_struct(nano_reflect_parser_t *p) {
+    if (p->struct_count >= p->max_structs) {
+        p->error = true;
+        return;
+    }
+
+    nano_wgsl_struct_t *s = &p->structs[p->struct_count];
+    memset(s, 0, sizeof(*s));
+    _nano_reflect_ident(p, s->name);
+    _nano_reflect_expect(p, '{');
+
+    uint32_t offset = 0;
+    s->align = 1;
+
+    while (!p->error && !_nano_reflect_accept(p, '}')) {
+        if (s->member_count >= NANO_REFLECT_MAX_MEMBERS) {
+            p->error = true;
+            return;
+        }
+
+        uint32_t align = 0;
+        uint32_t size = 0;
+        int location = -1;
+        char attr[NANO_REFLECT_NAME_LENGTH];
+
+        // Member attributes
+        while (_nano_reflect_accept(p, '@')) {
+            _nano_reflect_ident(p, attr);
+            if (strcmp(attr, "align") == 0) {
+                _nano_reflect_expect(p, '(');
+                align = _nano_reflect_number(p);
+                _nano_reflect_expect(p, ')');
+            } else if (strcmp(attr, "size") == 0) {
+                _nano_reflect_expect(p, '(');
+                size = _nano_reflect_number(p);
+                _nano_reflect_expect(p, ')');
+            } else if (strcmp(attr, "location") == 0) {
+                _nano_reflect_expect(p, '(');
+                location = (int)_nano_reflect_number(p);
+                _nano_reflect_expect(p, ')');
+                s->stage_io = true;
+            } else {
+                if (strcmp(attr, "builtin") == 0) {
+                    s->stage_io = true;
+                }
+                _nano_reflect_skip_args(p);
+            }
+        }
+
+        nano_wgsl_member_t *m = &s->members[s->member_count++];
+        m->location = location;
+        _nano_reflect_ident(p, m->name);
+        _nano_reflect_expect(p, ':');
+        _nano_reflect_type(p, &m->type);
+        _nano_reflect_accept(p, ',');
+
+        if (align == 0) {
+            align = m->type.align;
+        }
+        m->size = size ? size : m->type.size;
+        m->offset = _nano_reflect_round_up(offset, align);
+        offset = m->offset + m->size;
+
+        if (align > s->align) {
+            s->align = align;
+        }
+        if (m->type.dim_count > 0 && m->type.dims[0] == 0) {
+            s->runtime_sized = true;
+        }
+    }
+    _nano_reflect_accept(p, ';');
+
+    s->size = _nano_reflect_round_up(offset, s->align);
+    if (!p->error) {
+        p->struct_count++;
+    }
+}
+
+// Mark a struct and every struct nested in it as host-shareable
+static void _nano_reflect_mark_shared(nano_reflect_parser_t *p, int index) {
+    nano_wgsl_struct_t *s = &p->structs[index];
+    if (s->host_shareable) {
+        return;
+    }
+    s->host_shareable = true;
+    for (int i = 0; i < s->member_count; i++) {
+        if (s->members[i].type.scalar == NANO_WGSL_STRUCT) {
+            _nano_reflect_mark_shared(p, s->members[i].type.struct_index);
+        }
+    }
+}
+
+// Parse a var declaration after the var keyword and mark the struct it uses
+static void _nano_reflect_var(nano_reflect_parser_t *p) {
+    char ident[NANO_REFLECT_NAME_LENGTH];
+    if (!_nano_reflect_accept(p, '<')) {
+        return;
+    }
+    _nano_reflect_ident(p, ident);
+    bool shared = strcmp(ident, "uniform") == 0 ||
+                  strcmp(ident, "storage") == 0;
+    while (p->input[p->position] && p->input[p->position] != '>') {
+        p->position++;
+    }
+    _nano_reflect_expect(p, '>');
+    _nano_reflect_ident(p, ident);
+    if (!shared || !_nano_reflect_accept(p, ':')) {
+        return;
+    }
+
+    // Storage buffers may also be runtime-sized arrays of structs
+    nano_wgsl_type_t type;
+    _nano_reflect_type(p, &type);
+    if (type.scalar == NANO_WGSL_STRUCT) {
+        _nano_reflect_mark_shared(p, type.struct_index);
+    }
+}
+
+// Reflect the structs declared in a WGSL source
+// Returns the number of structs written to structs, or -1 if the source
+// could not be parsed or declares more than max_structs structs.
+int nano_reflect_structs(const char *source, nano_wgsl_struct_t *structs,
+                         int max_structs) {
+    nano_reflect_parser_t p = {
+        .input = source,
+        .structs = structs,
+        .max_structs = max_structs,
+    };
+
+    char ident[NANO_REFLECT_NAME_LENGTH];
+    while (!p.error) {
+        _nano_reflect_skip(&p);
+        char c = p.input[p.position];
+        if (c == '\0') {
+            break;
+        }
+        if (!isalpha((unsigned char)c) && c != '_') {
+            p.position++;
+            continue;
+        }
+
+        _nano_reflect_ident(&p, ident);
+        if (strcmp(ident, "struct") == 0) {
+            _nano_reflect_struct(&p);
+        } else if (strcmp(ident, "var") == 0) {
+            _nano_reflect_var(&p);
+            // A binding that is not a struct is not an error
+            p.error = false;
+        }
+    }
+
+    if (p.error) {
+        return -1;
+    }
+
+    return p.struct_count;
+}
+
+// Add an input, returns false if there is no room left
+static bool _nano_reflect_add_input(nano_wgsl_vertex_input_t *inputs,
+                                    int *count, int max_inputs,
+                                    const char *name, uint32_t location,
+                                    const nano_wgsl_type_t *type) {
+    if (*count >= max_inputs) {
+        return false;
+    }
+    nano_wgsl_vertex_input_t *input = &inputs[(*count)++];
+    snprintf(input->name, sizeof(input->name), "%s", name);
+    input->location = location;
+    input->type = *type;
+    return true;
+}
+
+// Parse the parameter list of an entry point after its name
+static int _nano_reflect_params(nano_reflect_parser_t *p,
+                                nano_wgsl_vertex_input_t *inputs,
+                                int max_inputs) {
+    char attr[NANO_REFLECT_NAME_LENGTH];
+    char name[NANO_REFLECT_NAME_LENGTH];
+    int count = 0;
+
+    _nano_reflect_expect(p, '(');
+    while (!p->error && !_nano_reflect_accept(p, ')')) {
+        int location = -1;
+        while (_nano_reflect_accept(p, '@')) {
+            _nano_reflect_ident(p, attr);
+            if (strcmp(attr, "location") == 0) {
+                _nano_reflect_expect(p, '(');
+                location = (int)_nano_reflect_number(p);
+                _nano_reflect_expect(p, ')');
+            } else {
+                _nano_reflect_skip_args(p);
+            }
+        }
+
+        nano_wgsl_type_t type;
+        if (!_nano_reflect_ident(p, name)) {
+            p->error = true;
+            break;
+        }
+        _nano_reflect_expect(p, ':');
+        _nano_reflect_type(p, &type);
+        _nano_reflect_accept(p, ',');
+        if (p->error) {
+            break;
+        }
+
+        if (location >= 0) {
+            if (!_nano_reflect_add_input(inputs, &count, max_inputs, name,
+                                         (uint32_t)location, &type)) {
+                p->error = true;
+            }
+        } else if (type.scalar == NANO_WGSL_STRUCT && type.dim_count == 0) {
+            // Struct inputs bring the @location members with them
+            nano_wgsl_struct_t *s = &p->structs[type.struct_index];
+            for (int i = 0; i < s->member_count; i++) {
+                nano_wgsl_member_t *m = &s->members[i];
+                if (m->location >= 0 &&
+                    !_nano_reflect_add_input(inputs, &count, max_inputs,
+                                             m->name, (uint32_t)m->location,
+                                             &m->type)) {
+                    p->error = true;
+                }
+            }
+        }
+    }
+
+    return p->error ? -1 : count;
+}
+
+// Reflect the @location inputs of the vertex entry point named entry
+// structs is scratch space for the structs of the source, which must be
+// declared before the entry point uses them. Returns the number of inputs
+// written, or -1 if the entry point was not found or could not be parsed.
+int nano_reflect_vertex_inputs(const char *source, const char *entry,
+                               nano_wgsl_struct_t *structs, int max_structs,
+                               nano_wgsl_vertex_input_t *inputs,
+                               int max_inputs) {
+    int struct_count = nano_reflect_structs(source, structs, max_structs);
+    if (struct_count < 0) {
+        return -1;
+    }
+
+    nano_reflect_parser_t p = {
+        .input = source,
+        .structs = structs,
+        .struct_count = struct_count,
+        .max_structs = max_structs,
+    };
+
+    char ident[NANO_REFLECT_NAME_LENGTH];
+    while (!p.error) {
+        _nano_reflect_skip(&p);
+        char c = p.input[p.position];
+        if (c == '\0') {
+            break;
+        }
+        if (!isalpha((unsigned char)c) && c != '_') {
+            p.position++;
+            continue;
+        }
+
+        _nano_reflect_ident(&p, ident);
+        if (strcmp(ident, "fn") != 0) {
+            continue;
+        }
+        _nano_reflect_ident(&p, ident);
+        if (strcmp(ident, entry) == 0) {
+            return _nano_reflect_params(&p, inputs, max_inputs);
+        }
+    }
+
+    return -1;
+}
+
+// Header Generation
+// -------------------------------------------------
+
+static const char *_nano_reflect_c_type(const nano_wgsl_struct_t *structs,
+                                        const nano_wgsl_type_t *type) {
+    switch (type->scalar) {
+    case NANO_WGSL_F32:
+        return "float";
+    case NANO_WGSL_I32:
+        return "int32_t";
+    case NANO_WGSL_U32:
+        return "uint32_t";
+    case NANO_WGSL_F16:
+        // There is no portable half type in C, f16 is stored as raw bits
+        return "uint16_t";
+    case NANO_WGSL_STRUCT:
+        return structs[type->struct_index].name;
+    }
+    return "uint8_t";
+}
+
+// Write the C array dimensions of a type, skipping the first if it is a
+// runtime-sized array
+static void _nano_reflect_write_dims(FILE *out, const nano_wgsl_type_t *type,
+                                     bool flexible) {
+    for (int i = 0; i < type->dim_count; i++) {
+        if (type->dims[i] == 0) {
+            fprintf(out, flexible ? "[]" : "[1]");
+        } else {
+            fprintf(out, "[%u]", type->dims[i]);
+        }
+    }
+}
+
+static void _nano_reflect_write_struct(FILE *out,
+                                       const nano_wgsl_struct_t *structs,
+                                       const nano_wgsl_struct_t *s,
+                                       const char *prefix) {
+    fprintf(out, "// WGSL struct %s: size %u, align %u\n", s->name, s->size,
+            s->align);
+    fprintf(out, "typedef struct %s%s {\n", prefix, s->name);
+
+    // Flexible array members need at least one other member
+    bool flexible = s->member_count > 1;
+    uint32_t offset = 0;
+    int pad = 0;
+    for (int i = 0; i < s->member_count; i++) {
+        const nano_wgsl_member_t *m = &s->members[i];
+        if (m->offset > offset) {
+            fprintf(out, "    uint8_t _pad%d[%u];\n", pad++,
+                    m->offset - offset);
+        }
+
+        fprintf(out, "    %s%s %s",
+                m->type.scalar == NANO_WGSL_STRUCT ? prefix : "",
+                _nano_reflect_c_type(structs, &m->type), m->name);
+        _nano_reflect_write_dims(out, &m->type, flexible);
+        fprintf(out, ";\n");
+
+        offset = m->offset + m->type.size;
+        if (m->size > m->type.size && !s->runtime_sized) {
+            fprintf(out, "    uint8_t _pad%d[%u];\n", pad++,
+                    m->size - m->type.size);
+            offset = m->offset + m->size;
+        }
+    }
+    if (s->size > offset && !s->runtime_sized) {
+        fprintf(out, "    uint8_t _pad%d[%u];\n", pad++, s->size - offset);
+    }
+    fprintf(out, "} %s%s;\n\n", prefix, s->name);
+
+    // Check the C layout against the reflected WGSL layout
+    for (int i = 0; i < s->member_count; i++) {
+        const nano_wgsl_member_t *m = &s->members[i];
+        fprintf(out,
+                "_Static_assert(offsetof(%s%s, %s) == %u, \"%s.%s offset\");\n",
+                prefix, s->name, m->name, m->offset, s->name, m->name);
+    }
+    if (!s->runtime_sized) {
+        fprintf(out, "_Static_assert(sizeof(%s%s) == %u, \"%s size\");\n",
+                prefix, s->name, s->size, s->name);
+    }
+    fprintf(out, "\n");
+
+    // Typed setters, runtime-sized arrays are written through the struct
+    for (int i = 0; i < s->member_count; i++) {
+        const nano_wgsl_member_t *m = &s->members[i];
+        if (m->type.dim_count > 0 && m->type.dims[0] == 0) {
+            continue;
+        }
+
+        const char *c_type = _nano_reflect_c_type(structs, &m->type);
+        const char *type_prefix =
+            m->type.scalar == NANO_WGSL_STRUCT ? prefix : "";
+        fprintf(out, "static inline void %s%s_set_%s(%s%s *s, ", prefix,
+                s->name, m->name, prefix, s->name);
+        if (m->type.dim_count == 0 && m->type.scalar != NANO_WGSL_STRUCT) {
+            fprintf(out, "%s value) {\n    s->%s = value;\n}\n\n", c_type,
+                    m->name);
+        } else if (m->type.dim_count == 0) {
+            fprintf(out,
+                    "const %s%s *value) {\n    s->%s = *value;\n}\n\n",
+                    type_prefix, c_type, m->name);
+        } else {
+            fprintf(out, "const %s%s value", type_prefix, c_type);
+            _nano_reflect_write_dims(out, &m->type, true);
+            fprintf(out,
+                    ") {\n    memcpy(s->%s, value, sizeof(s->%s));\n}\n\n",
+                    m->name, m->name);
+        }
+    }
+}
+
+// Write every struct that is reachable from a uniform or storage binding,
+// nested structs first. The prefix is added to every generated type name.
+// Returns the number of structs written.
+int nano_reflect_write_header(FILE *out, const nano_wgsl_struct_t *structs,
+                              int struct_count, const char *guard,
+                              const char *prefix, const char *source_name) {
+    if (prefix == NULL) {
+        prefix = "";
+    }
+
+    fprintf(out, "// Generated by nano_structgen from %s, do not edit.\n",
+            source_name ? source_name : "WGSL source");
+    fprintf(out, "// Layouts follow the WGSL host-shareable layout rules.\n\n");
+    fprintf(out, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(out, "#include <stddef.h>\n#include <stdint.h>\n"
+                 "#include <string.h>\n\n");
+
+    // Structs can only use structs declared before them, so declaration
+    // order is already a valid C order
+    int written = 0;
+    for (int i = 0; i < struct_count; i++) {
+        if (structs[i].host_shareable && !structs[i].stage_io) {
+            _nano_reflect_write_struct(out, structs, &structs[i], prefix);
+            written++;
+        }
+    }
+
+    fprintf(out, "#endif // %s\n", guard);
+    return written;
+}
+
+#endif // NANO_REFLECT_H
@@ -81,7 +81,9 @@
 #define NANO_H
 
 #include <ctype.h>
+#include <float.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -89,6 +91,10 @@
 #include <unistd.h>
 #include <webgpu/webgpu.h>
 
+// Defined before the backend include, the backend only declares its ImGui
+// hooks such as wgpu_imgui_init() when NANO_CIMGUI is set
+#define NANO_CIMGUI
+
 // Use web based entry point for Nano
 // if NANO_NATIVE is not defined
 #ifndef NANO_NATIVE
@@ -97,8 +103,6 @@
     #include "nano_native.h"
 #endif
 
-#define NANO_CIMGUI
-
 // Include CImGui for Nano
 // Assumes that nano_cimgui.h & cimgui.h are in the include path
 // and cimgui should be available as a static or shared library
@@ -118,6 +122,24 @@
     #define LOG(...) fprintf(stdout, __VA_ARGS__)
 #endif
 
+// Include the job system used to run CPU kernels across worker threads
+#include "nano_jobs.h"
+
+// Include the frame and build arenas used for transient allocations
+#include "nano_arena.h"
+
+// Include the WGSL struct reflection used for named uniforms
+#include "nano_reflect.h"
+
+// Include the packed buffer formats and their f32 conversions
+#include "nano_format.h"
+
+// Include the OBJ and glTF binary mesh loader
+#include "nano_mesh.h"
+
+// Include the immediate mode 2D batch renderer
+#include "nano_draw.h"
+
 // Total number of fonts included in nano
 #define NANO_MAX_FONTS 16
 #ifndef NANO_NUM_FONTS
@@ -135,6 +157,7 @@
 #define NANO_GROUP_MAX_BINDINGS 8     // Maximum number of bindings per group
 #define NANO_MAX_VERTEX_BUFFERS 8     // Maximum number of vertex buffers
 #define NANO_MAX_VERTEX_ATTRIBUTES 16 // Maximum cumulative vertex attributes
+#define NANO_MAX_FUNCTIONS 64         // Functions walked for binding use
 
 // Maximum number of buffers that can be stored in the buffer pool
 #define NANO_MAX_BUFFERS 16
@@ -142,6 +165,77 @@
 // Maximum number of compute shaders that can be stored in the shader pool
 #define NANO_MAX_SHADERS 16
 
+// Limits for the built-in GPU statistics kernels
+// These must match the constants in nano_stats_wgsl
+#define NANO_STATS_MAX_BINS 256
+#define NANO_STATS_MAX_TOP_K 16
+#define NANO_STATS_MAX_PARTIALS 256
+#define NANO_STATS_MAX_TOP_K_PARTIALS 64
+
+// Workgroup size of the built-in culling kernel
+// This must match WG_SIZE in nano_cull_wgsl
+#define NANO_CULL_WORKGROUP_SIZE 64
+
+// CPU Fallback Definitions
+// Shaders with at most this many elements are timed on the CPU once so that
+// NANO_EXEC_AUTO has a cost to compare against the GPU latency.
+#ifndef NANO_CPU_PROBE_ELEMS
+    #define NANO_CPU_PROBE_ELEMS 65536
+#endif
+// Minimum number of invocations given to a worker at a time
+#ifndef NANO_CPU_GRAIN
+    #define NANO_CPU_GRAIN 4096
+#endif
+// Assumed GPU submit-to-completion latency until one has been measured
+#define NANO_GPU_LATENCY_MS 1.0f
+
+// Bytes hashed by a single job in nano_checksum()
+#define NANO_CHECKSUM_CHUNK 65536
+
+// Values converted by a single job in nano_write_buffer_f32() and
+// nano_read_buffer_f32(), a multiple of every format's component count
+#define NANO_CONVERT_CHUNK 16384
+
+// Transfer Definitions
+// Transfers are grouped in power of two size classes from 256 B to 256 MB,
+// each class can use a different strategy, see nano_transfer_strategy()
+#define NANO_TRANSFER_MIN_SHIFT 8
+#define NANO_TRANSFER_CLASSES 21
+// Transfers a strategy needs to be timed before it replaces the default
+#define NANO_TRANSFER_MIN_SAMPLES 4
+// Every Nth automatic transfer of a size class tries the least timed
+// strategy instead, so each strategy keeps getting timed
+#define NANO_TRANSFER_EXPLORE_INTERVAL 16
+// Staging buffers kept for reuse and the bytes they may hold in total
+#define NANO_MAX_STAGING_BUFFERS 32
+#ifndef NANO_STAGING_POOL_BYTES
+    #define NANO_STAGING_POOL_BYTES (64 * 1024 * 1024)
+#endif
+
+// String Interning Definitions
+// Maximum number of unique strings and the bytes available to store them
+#ifndef NANO_MAX_ATOMS
+    #define NANO_MAX_ATOMS 1024
+#endif
+#ifndef NANO_ATOM_STORAGE_SIZE
+    #define NANO_ATOM_STORAGE_SIZE (64 * 1024)
+#endif
+// Size of the open addressing table, must be a power of two
+#define NANO_ATOM_TABLE_SIZE (NANO_MAX_ATOMS * 2)
+
+// Uniform Definitions
+// Size of the GPU buffer shared by every reflected uniform block
+#ifndef NANO_UNIFORM_BUFFER_SIZE
+    #define NANO_UNIFORM_BUFFER_SIZE (64 * 1024)
+#endif
+#define NANO_MAX_UNIFORM_BLOCKS 64
+#define NANO_MAX_UNIFORM_MEMBERS 32
+// Uniform blocks must start at a multiple of minUniformBufferOffsetAlignment
+#define NANO_UNIFORM_ALIGN 256
+// WGSL struct of the values shared by every shader, see
+// nano_frame_uniforms_t
+#define NANO_FRAME_STRUCT "NanoFrame"
+
 // Generic Array/Stack Implementation Based on old GGYL code
 // Only works with simple data types, not structs or pointers
 // Useful for working with handles instead of pointers as they
@@ -286,6 +380,46 @@ typedef struct {
     int position;
 } nano_wgsl_parser_t;
 
+// A function declared in the shader source, a node of the call graph that
+// decides which entry points reference which bindings
+typedef struct {
+    // Name and body of the function, as offsets into the source
+    int name_start;
+    int name_length;
+    int body_start;
+    int body_end;
+    // Bit i is set if the body references info->bindings[i]
+    uint32_t bindings;
+    // Bit i is set if the body calls functions[i]
+    uint64_t calls;
+    // Set if the body calls a function that did not fit in the table
+    bool calls_unknown;
+} wgsl_function_t;
+
+// Nano String Intern Declarations
+// ---------------------------------------
+
+// Handle to a string stored once in the intern table, see nano_intern()
+// Two atoms are equal exactly when their strings are equal. 0 is the empty
+// string.
+typedef uint32_t nano_atom_t;
+
+// Strings are never removed, so the pointer returned by nano_atom_str()
+// stays valid for the lifetime of the program. The table is shared by every
+// context and the lock allows strings to be interned from any thread.
+typedef struct {
+    nano_spinlock_t lock;
+    uint32_t atom_count;
+    uint32_t storage_used;
+    // Hash table of atoms, 0 marks an empty slot
+    nano_atom_t table[NANO_ATOM_TABLE_SIZE];
+    uint32_t hashes[NANO_MAX_ATOMS + 1];
+    uint32_t offsets[NANO_MAX_ATOMS + 1];
+    char storage[NANO_ATOM_STORAGE_SIZE];
+} nano_intern_table_t;
+
+static nano_intern_table_t nano_intern_table;
+
 // Nano Binding & Buffer Declarations
 // ---------------------------------------
 typedef WGPUBufferDescriptor nano_buffer_desc_t;
@@ -300,28 +434,182 @@ typedef struct {
     uint32_t count;
     size_t offset;
     void *data;
-    char label[NANO_MAX_IDENT_LENGTH];
+    nano_atom_t label;
+
+    // Host copy used by CPU kernels when data is NULL, see nano_buffer_host()
+    void *host;
+    // Set when a GPU dispatch may have written the buffer since the host
+    // copy was last uploaded, so the host copy can no longer be trusted
+    bool gpu_dirty;
+    // How f32 values are stored, see nano_write_buffer_f32()
+    nano_format_t format;
 } nano_buffer_t;
 
+// The attributes of a vertex buffer are stored in the shader, so the
+// attributes pointer of the layout is only set when the pipeline is built
 typedef struct {
     WGPUVertexBufferLayout vertex_buffer_layout;
     uint32_t buffer_id;
+    // Set for the buffers of a mesh, which nano_release_mesh() releases
+    bool borrowed;
+    // Byte offset of the first vertex, see nano_shader_set_vertex_buffer()
+    uint64_t offset;
     uint8_t attribute_count;
+    // Index of the first attribute in nano_shader_t.vertex_attributes
+    uint8_t first_attribute;
 } nano_vertex_buffer_t;
 
+// How the reflected vertex inputs of a shader are laid out in a vertex
+// buffer, see nano_shader_bind_vertex_layout()
+typedef struct {
+    // Names of the inputs in the buffer, NULL for every input of the vertex
+    // entry point that is not bound to another buffer yet
+    const char **inputs;
+    uint8_t input_count;
+    // Format of each input, NULL or WGPUVertexFormat_Undefined to use the
+    // format of its WGSL type
+    const WGPUVertexFormat *formats;
+    // Offset of each input for data interleaved by the caller, NULL to let
+    // Nano pack the inputs
+    const uint32_t *offsets;
+    // Bytes between two vertices, 0 for the size of the inputs
+    uint32_t stride;
+    // Advance the buffer once per instance instead of once per vertex
+    bool per_instance;
+} nano_vertex_layout_desc_t;
+
+// Nano Transfer Declarations
+// ---------------------------------------
+
+// Ways of moving data between the CPU and a GPU buffer
+typedef enum {
+    // Use the fastest strategy timed for the size class, see
+    // nano_transfer_strategy()
+    NANO_TRANSFER_AUTO,
+    // Uploads
+    // wgpuQueueWriteBuffer(), the browser stages the data itself
+    NANO_TRANSFER_QUEUE_WRITE,
+    // A new staging buffer mapped at creation, copied to the destination
+    NANO_TRANSFER_MAPPED_AT_CREATION,
+    // Staging buffers from the pool that are mapped again as soon as their
+    // copy is submitted, so the next upload doesn't wait for a map
+    NANO_TRANSFER_STAGING_RING,
+    // Readbacks
+    // A new MapRead staging buffer for every readback
+    NANO_TRANSFER_READ_PER_CALL,
+    // MapRead staging buffers from the pool
+    NANO_TRANSFER_READ_POOLED,
+    NANO_TRANSFER_STRATEGY_COUNT,
+} nano_transfer_strategy_t;
+
+typedef enum {
+    NANO_TRANSFER_UPLOAD,
+    NANO_TRANSFER_READBACK,
+    NANO_TRANSFER_DIRECTIONS,
+} nano_transfer_dir_t;
+
+// A staging buffer kept for reuse
+typedef enum {
+    NANO_STAGING_FREE, // The slot holds no buffer
+    NANO_STAGING_IDLE, // Ready, upload buffers are mapped for writing
+    NANO_STAGING_BUSY, // Used by a copy or waiting for a map
+} nano_staging_state_t;
+
+typedef struct {
+    WGPUBuffer buffer;
+    size_t size;
+    // MapWrite buffers for uploads, MapRead buffers for readbacks
+    bool upload;
+    nano_staging_state_t state;
+    // Bumped when the slot is dropped so late map callbacks can tell the
+    // buffer they were for is gone
+    uint32_t generation;
+} nano_staging_buffer_t;
+
+// Moving average of the bandwidth of a strategy for one size class
+typedef struct {
+    uint32_t count;
+    float gbps;
+} nano_transfer_sample_t;
+
+typedef struct {
+    nano_staging_buffer_t staging[NANO_MAX_STAGING_BUFFERS];
+    size_t staging_bytes;
+    // Strategy set with nano_transfer_set_strategy(), NANO_TRANSFER_AUTO
+    // when the class picks its own
+    nano_transfer_strategy_t forced[NANO_TRANSFER_DIRECTIONS]
+                                   [NANO_TRANSFER_CLASSES];
+    nano_transfer_sample_t samples[NANO_TRANSFER_DIRECTIONS]
+                                  [NANO_TRANSFER_CLASSES]
+                                  [NANO_TRANSFER_STRATEGY_COUNT];
+    // Automatic transfers of each class, see NANO_TRANSFER_EXPLORE_INTERVAL
+    uint32_t picks[NANO_TRANSFER_DIRECTIONS][NANO_TRANSFER_CLASSES];
+    // The upload waiting for the queue to finish, one is timed at a time
+    bool upload_pending;
+    nano_transfer_strategy_t upload_strategy;
+    size_t upload_size;
+    double upload_start;
+} nano_transfers_t;
+
 // Represents data that is copied from the GPU to the CPU
-// See: nano_copy_buffer_to_cpu()
+// See: nano_copy_buffer_to_cpu() and nano_request_readback()
+// locked is atomic so other threads can poll it for a requested readback.
 typedef struct {
-    bool locked;
+    atomic_bool locked;
     size_t size;
     WGPUBuffer src;
     size_t src_offset;
     // The destination pointer for the data
     void *data;
     size_t dst_offset;
+    // How the data is read back, NANO_TRANSFER_AUTO lets Nano pick
+    nano_transfer_strategy_t strategy;
+    // Milliseconds from the request to the data being copied out
+    double latency_ms;
     WGPUBuffer _staging;
+    nano_staging_buffer_t *_pooled;
+    nano_transfer_strategy_t _used;
+    double _start;
 } nano_gpu_data_t;
 
+// Nano Command Queue Declarations
+// ---------------------------------------
+
+// Work that other threads hand to the render thread, which is the only
+// thread allowed to use the WGPU device and queue.
+typedef enum {
+    NANO_CMD_CREATE_BUFFER,
+    NANO_CMD_WRITE_BUFFER,
+    NANO_CMD_RELEASE_BUFFER,
+    NANO_CMD_READBACK,
+} nano_cmd_type_t;
+
+typedef struct nano_cmd_t {
+    struct nano_cmd_t *next;
+    nano_cmd_type_t type;
+    uint32_t buffer_id;
+    // Buffer to release for NANO_CMD_RELEASE_BUFFER
+    WGPUBuffer buffer;
+    // Usage and size for NANO_CMD_CREATE_BUFFER
+    WGPUBufferUsageFlags usage;
+    size_t offset;
+    size_t size;
+    // Destination for NANO_CMD_READBACK
+    nano_gpu_data_t *readback;
+    // Copy of the data for NANO_CMD_WRITE_BUFFER
+    uint8_t data[];
+} nano_cmd_t;
+
+// Lock-free multi-producer, single-consumer queue of commands
+// Producers push onto the head, the render thread takes the whole list
+// once per frame and runs it in submission order.
+typedef struct {
+    _Atomic(nano_cmd_t *) head;
+    // Stats for the last drain, shown in the debug UI
+    uint32_t last_count;
+    size_t last_bytes;
+} nano_cmd_queue_t;
+
 // Contains the information that is parsed from the shader source
 // for each binding in the shader
 typedef struct {
@@ -347,8 +635,12 @@ typedef struct {
     int binding;
 
     uint32_t shader_id;
-    char data_type[32];
-    char name[NANO_MAX_IDENT_LENGTH];
+    nano_atom_t data_type;
+    nano_atom_t name;
+
+    // Stages of the entry points that reference the binding, directly or
+    // through the functions they call
+    WGPUShaderStageFlags visibility;
 } nano_binding_info_t;
 
 // Nano Pipeline Declarations
@@ -374,6 +666,31 @@ typedef struct {
     wgsl_workgroup_size_t workgroup_size;
 } nano_entry_t;
 
+// Nano CPU Kernel Declarations
+// ----------------------------------------
+
+// Host pointers for every buffer bound to a shader, indexed like the
+// @group and @binding attributes in the WGSL source.
+typedef struct {
+    void *data[NANO_MAX_GROUPS][NANO_GROUP_MAX_BINDINGS];
+    size_t size[NANO_MAX_GROUPS][NANO_GROUP_MAX_BINDINGS];
+    size_t num_elems;
+} nano_cpu_bindings_t;
+
+// CPU implementation of a compute entry point.
+// The kernel is called with a range of global_invocation_id.x values and may
+// be called from several threads at once, so every invocation must only
+// write to its own outputs. Workgroup memory and barriers are not available.
+typedef void (*nano_cpu_kernel_t)(const nano_cpu_bindings_t *bindings,
+                                  uint32_t begin, uint32_t end);
+
+// Where compute entry points with a CPU kernel are executed
+typedef enum {
+    NANO_EXEC_AUTO, // Pick whichever is expected to finish first
+    NANO_EXEC_GPU,
+    NANO_EXEC_CPU,
+} nano_exec_mode_t;
+
 // Nano Shader Declarations
 // ----------------------------------------
 
@@ -390,8 +707,10 @@ typedef struct {
     uint32_t buffer_size;
 
     char *source;
-    char label[64];
-    char path[256];
+    // Hash of the source, part of the pipeline cache keys
+    uint64_t source_hash;
+    nano_atom_t label;
+    nano_atom_t path;
 
     // Initialized to -1 to indicate that the group is not set
     // Any binding index that is -1 is not used
@@ -426,14 +745,43 @@ typedef struct {
 
     // Number of vertices to pass to the draw call
     uint64_t vertex_count;
+    // Number of instances to pass to the draw call, 1 by default
+    uint32_t instance_count;
 
     // Vertex Buffers for the vertex shader
     nano_vertex_buffer_t vertex_buffers[NANO_MAX_VERTEX_BUFFERS];
     uint8_t vertex_buffer_count;
     uint8_t vertex_attribute_count;
+    // Attributes of every vertex buffer, owned by the shader
+    WGPUVertexAttribute vertex_attributes[NANO_MAX_VERTEX_ATTRIBUTES];
+
+    // @location inputs of the vertex entry point, reflected when the
+    // shader is created
+    nano_wgsl_vertex_input_t vertex_inputs[NANO_MAX_VERTEX_ATTRIBUTES];
+    uint8_t vertex_input_count;
+
+    // Index buffer for indexed draws, 0 to draw vertex_count vertices
+    // See nano_shader_set_index_buffer()
+    uint32_t index_buffer;
+    WGPUIndexFormat index_format;
+    // Set if the index buffer belongs to a mesh, see nano_shader_bind_mesh()
+    bool index_borrowed;
+    WGPUCullMode cull_mode;
+
+    // Buffer holding the draw arguments, 0 to draw with vertex_count and
+    // instance_count. See nano_shader_set_indirect_buffer()
+    uint32_t indirect_buffer;
+    uint64_t indirect_offset;
 
     // Used for calculating the workgroup size for compute shaders
     size_t num_elems;
+    // Workgroups to dispatch, all 0 to derive them from num_elems
+    // See nano_shader_set_workgroups()
+    uint32_t workgroups[3];
+
+    // Index of the shader's packet in the shader pool, -1 if it has none
+    // The dispatch and draw parameters are patched in place through it.
+    int16_t packet_index;
 
     // Using the buffer size from the buffer data, we can create the bindgroups
     // so that we can bind the buffers to the shader pipeline
@@ -443,6 +791,20 @@ typedef struct {
     WGPUComputePipeline compute_pipeline;
     WGPURenderPipeline render_pipeline;
 
+    // Pipelines still compiling asynchronously, and the request that
+    // started them. The shader is skipped until they are ready.
+    uint8_t pending_pipelines;
+    uint32_t pipeline_request;
+
+    // Optional CPU kernels indexed like info.entry_points
+    // See nano_shader_set_cpu_kernel()
+    nano_cpu_kernel_t cpu_kernels[NANO_MAX_ENTRIES];
+    nano_exec_mode_t exec_mode;
+
+    // Moving average of the CPU kernel cost, 0 until it is measured
+    double cpu_ns_per_elem;
+    bool ran_on_cpu;
+
 } nano_shader_t;
 
 // Nano Buffer Pool Declarations
@@ -458,10 +820,12 @@ typedef struct {
 } nano_buffer_node_t;
 
 // Buffer pool struct to hold all of the buffers for the Nano instance
+// The lock allows buffers to be created and released from any thread
 typedef struct {
     nano_buffer_node_t buffers[NANO_MAX_BUFFERS];
     size_t buffer_count;
     nano_buffer_array active_buffers;
+    nano_spinlock_t lock;
 } nano_buffer_pool_t;
 
 // Nano Shader Pool Declarations
@@ -476,6 +840,44 @@ typedef struct {
     bool occupied;
 } nano_shader_node_t;
 
+// Everything needed to dispatch or draw an active shader, copied out of
+// nano_shader_t so that executing shaders walks a small dense array instead
+// of the reflection data. Packets are rebuilt when shaders are activated,
+// deactivated or changed, see _nano_build_packets(). The dispatch and draw
+// parameters are patched in place, see _nano_packet_set_params().
+typedef struct {
+    _Alignas(64) uint32_t shader_id;
+    uint8_t num_layouts;
+    uint8_t vertex_buffer_count;
+    bool has_compute;
+    bool has_render;
+    // Set if the compute entry point has a CPU kernel
+    bool has_cpu_kernel;
+    int8_t compute_index;
+
+    uint32_t workgroups[3];
+    uint32_t vertex_count;
+    uint32_t instance_count;
+
+    WGPUComputePipeline compute_pipeline;
+    WGPURenderPipeline render_pipeline;
+    WGPUBindGroup bind_groups[NANO_MAX_GROUPS];
+
+    // Uniform buffer written before every execution, NULL if none
+    nano_buffer_t *uniform_buffer;
+    nano_buffer_t *vertex_buffers[NANO_MAX_VERTEX_BUFFERS];
+    uint64_t vertex_offsets[NANO_MAX_VERTEX_BUFFERS];
+    // Draws vertex_count indices from this buffer if it is not NULL
+    nano_buffer_t *index_buffer;
+    WGPUIndexFormat index_format;
+    // Takes the draw arguments from this buffer if it is not NULL
+    nano_buffer_t *indirect_buffer;
+    uint64_t indirect_offset;
+
+    // Cold data, only used when the shader may run on the CPU
+    nano_shader_t *shader;
+} nano_shader_packet_t;
+
 typedef struct {
     nano_shader_node_t shaders[NANO_MAX_SHADERS];
     size_t shader_count;
@@ -483,8 +885,312 @@ typedef struct {
     // Only updated when a shader is added or removed from the pool
     char shader_labels[NANO_MAX_SHADERS * 64];
     nano_shader_array active_shaders;
+
+    // Active shaders in order of execution
+    nano_shader_packet_t packets[NANO_MAX_SHADERS];
+    int packet_count;
+    bool packets_dirty;
 } nano_shader_pool_t;
 
+// Nano Mesh Declarations
+// ----------------------------------------
+
+// Flags for nano_load_mesh()
+typedef enum {
+    NANO_MESH_DEFAULT = 0,
+    // Store float positions as snorm16x4, normals as snorm8x4, texture
+    // coordinates as unorm16x2 and colors as unorm8x4. Positions are
+    // normalized to the bounds of the mesh, see nano_mesh_t.
+    NANO_MESH_QUANTIZE = 1 << 0,
+} nano_mesh_flags_t;
+
+// The buffer pool entries and vertex layouts of a mesh
+// See nano_load_mesh() and nano_shader_bind_mesh()
+typedef struct {
+    // One vertex buffer per nano_mesh_attribute_t, 0 if the file has none
+    uint32_t vertex_buffers[NANO_MESH_ATTRIBUTE_COUNT];
+    WGPUVertexAttribute attributes[NANO_MESH_ATTRIBUTE_COUNT];
+    uint32_t strides[NANO_MESH_ATTRIBUTE_COUNT];
+
+    // 0 if the mesh is not indexed
+    uint32_t index_buffer;
+    WGPUIndexFormat index_format;
+    uint32_t vertex_count;
+    uint32_t index_count;
+
+    float bounds_min[3];
+    float bounds_max[3];
+    // Positions in object space are position * scale + offset, which is the
+    // identity unless the mesh is quantized
+    float scale[3];
+    float offset[3];
+    bool quantized;
+} nano_mesh_t;
+
+// Nano GPU Statistics Declarations
+// ----------------------------------------
+
+// Select which statistics are computed by nano_stats_dispatch()
+typedef enum {
+    NANO_STATS_MOMENTS = 1 << 0,   // min, max, mean, variance
+    NANO_STATS_HISTOGRAM = 1 << 1, // bin counts between range_min/range_max
+    NANO_STATS_TOP_K = 1 << 2,     // largest values and their indices
+    NANO_STATS_ALL = 0x7,
+} nano_stats_flags_t;
+
+// Describes the f32 buffer we want statistics for
+// The source buffer must have been created with WGPUBufferUsage_Storage
+// and src_offset must be a multiple of 256 bytes.
+typedef struct {
+    WGPUBuffer src;
+    size_t src_offset;
+    uint32_t count;
+    uint32_t flags;
+    uint32_t bin_count;
+    float range_min;
+    float range_max;
+    uint32_t top_k;
+} nano_stats_desc_t;
+
+// Mirrors the Result struct in nano_stats_wgsl
+// Only the sections requested by the flags are copied back to the CPU
+typedef struct {
+    float min;
+    float max;
+    float mean;
+    float variance;
+    uint32_t count;
+    uint32_t _pad[3];
+    float top_k_values[NANO_STATS_MAX_TOP_K];
+    uint32_t top_k_indices[NANO_STATS_MAX_TOP_K];
+    uint32_t bins[NANO_STATS_MAX_BINS];
+} nano_stats_result_t;
+
+// Mirrors the Params uniform struct in nano_stats_wgsl
+typedef struct {
+    uint32_t count;
+    uint32_t bin_count;
+    float range_min;
+    float range_max;
+    uint32_t partial_count;
+    uint32_t top_k_partial_count;
+    uint32_t _pad[2];
+} nano_stats_params_t;
+
+// A statistics request for a single source buffer
+// The struct must stay at the same address while a readback is pending
+// since it is passed as the userdata to the map callback.
+typedef struct {
+    nano_stats_desc_t desc;
+
+    WGPUBuffer params;
+    WGPUBuffer result;
+    WGPUBuffer partials;
+    WGPUBuffer top_k_partials;
+    WGPUBuffer staging;
+    WGPUBindGroup bind_group;
+
+    size_t readback_size;
+    bool pending;
+    bool ready;
+
+    // Latest results copied back from the GPU
+    nano_stats_result_t data;
+} nano_stats_t;
+
+// Implementations of the built-in kernels, see nano_stats_set_variant()
+typedef enum {
+    // Subgroups when the device supports them, otherwise shared memory
+    NANO_KERNEL_AUTO,
+    // Reductions through workgroup memory and barriers
+    NANO_KERNEL_SHARED_MEMORY,
+    // Reductions with subgroup shuffles, needs the subgroups feature
+    NANO_KERNEL_SUBGROUPS,
+} nano_kernel_variant_t;
+
+// Pipelines shared by every nano_stats_t, created on first use
+typedef struct {
+    bool ready;
+    // Variant asked for by the app and the variant that was built
+    nano_kernel_variant_t requested;
+    nano_kernel_variant_t variant;
+    WGPUShaderModule module;
+    WGPUBindGroupLayout bg_layout;
+    WGPUPipelineLayout layout;
+    WGPUComputePipeline histogram;
+    WGPUComputePipeline moments_partial;
+    WGPUComputePipeline moments_final;
+    WGPUComputePipeline top_k_partial;
+    WGPUComputePipeline top_k_final;
+} nano_stats_kernels_t;
+
+// Nano GPU Culling Declarations
+// ----------------------------------------
+
+// Describes the instances tested by nano_cull_dispatch()
+// Every instance has a bounding sphere, a vec4<f32> with the center in xyz
+// and the radius in w, in the space the matrix of the dispatch expects.
+typedef struct {
+    uint32_t count;
+    // count spheres to upload, or NULL to write them later with
+    // nano_queue_write_buffer()
+    const float *spheres;
+    // Indices, or vertices, drawn for each instance
+    uint32_t element_count;
+} nano_cull_desc_t;
+
+// Mirrors the Params uniform struct in nano_cull_wgsl
+typedef struct {
+    float planes[6][4];
+    uint32_t count;
+    uint32_t element_count;
+    uint32_t _pad[2];
+} nano_cull_params_t;
+
+// A GPU culling stage for one set of instances
+// The buffers live in the buffer pool so they can be bound to the render
+// shader: visible holds the indices of the instances that passed, in no
+// particular order, and args the draw arguments with the number of visible
+// instances as the instance count, see nano_shader_set_indirect_buffer().
+typedef struct {
+    uint32_t count;
+    uint32_t element_count;
+
+    uint32_t spheres;
+    uint32_t visible;
+    uint32_t args;
+
+    WGPUBuffer params;
+    WGPUBindGroup bind_group;
+} nano_cull_t;
+
+// Pipelines shared by every nano_cull_t, created on first use
+typedef struct {
+    bool ready;
+    // Keeps the buffer labels, and so the buffer ids, of every cull unique
+    uint32_t created;
+    WGPUShaderModule module;
+    WGPUBindGroupLayout bg_layout;
+    WGPUPipelineLayout layout;
+    WGPUComputePipeline reset;
+    WGPUComputePipeline cull;
+} nano_cull_kernels_t;
+
+// Nano Uniform Declarations
+// ----------------------------------------
+
+// Handle to a member of a uniform block, see nano_shader_get_uniform()
+// Holds the member index in bits 0-7, the block index plus one in bits
+// 8-15 and the generation of the block in bits 16-31, so handles to a
+// released block are rejected. 0 is an invalid handle.
+typedef uint32_t nano_uniform_t;
+
+// Member of a reflected uniform struct, nested struct members are named
+// like "light.color"
+typedef struct {
+    nano_atom_t name;
+    // Offset from the start of the block
+    uint32_t offset;
+    uint32_t size;
+} nano_uniform_member_t;
+
+// A var<uniform> binding of a shader, stored in the shared uniform buffer
+typedef struct {
+    // 0 if the block is free
+    uint32_t shader_id;
+    // Incremented when the block is released, see nano_uniform_t
+    uint16_t generation;
+    uint8_t group;
+    uint8_t binding;
+    uint8_t member_count;
+    // Offset in the shared uniform buffer, a multiple of NANO_UNIFORM_ALIGN
+    uint32_t offset;
+    uint32_t size;
+    nano_uniform_member_t members[NANO_MAX_UNIFORM_MEMBERS];
+} nano_uniform_block_t;
+
+// Every uniform block of a context lives in one GPU buffer. Setters only
+// write to the shadow copy and grow the dirty range, which is uploaded with
+// a single write before the next shader is executed.
+typedef struct {
+    WGPUBuffer buffer;
+    nano_uniform_block_t blocks[NANO_MAX_UNIFORM_BLOCKS];
+    uint32_t dirty_begin;
+    uint32_t dirty_end;
+    // Bytes sent by the last upload, shown in the debug UI
+    uint32_t last_upload;
+    _Alignas(16) uint8_t shadow[NANO_UNIFORM_BUFFER_SIZE];
+} nano_uniforms_t;
+
+// Values written once per frame in nano_start_frame() and shared by every
+// shader, laid out like this WGSL struct:
+//
+//     struct NanoFrame {
+//         resolution: vec2<f32>,
+//         mouse: vec2<f32>,
+//         time: f32,
+//         delta_time: f32,
+//         frame: u32,
+//         seed: u32,
+//     };
+//
+// A shader that declares
+//     @group(N) @binding(0) var<uniform> frame: NanoFrame;
+// as the only binding of group N gets the shared bind group there, there
+// is no buffer to create or bind.
+typedef struct {
+    float resolution[2];
+    // Last cursor or touch position in canvas pixels
+    float mouse[2];
+    // Seconds since the app started, and since the last frame
+    float time;
+    float delta_time;
+    uint32_t frame;
+    // Changes every frame, seeds random numbers in shaders
+    uint32_t seed;
+} nano_frame_uniforms_t;
+
+// The buffer behind NanoFrame and the one bind group layout every pipeline
+// uses for it, created the first time a shader declares it
+typedef struct {
+    nano_frame_uniforms_t values;
+    uint32_t frame_count;
+    WGPUBuffer buffer;
+    WGPUBindGroupLayout layout;
+    WGPUBindGroup bind_group;
+} nano_frame_group_t;
+
+// Nano Pipeline Cache Declarations
+// -------------------------------------------
+
+// Compiled pipelines, a released shader's are evicted once no other shader
+// uses them and the least recently used unused one makes room when full
+#ifndef NANO_PIPELINE_CACHE_SIZE
+    #define NANO_PIPELINE_CACHE_SIZE 64
+#endif
+
+// A pipeline and the hash of everything that was used to create it
+// The cache owns the pipeline, shaders only borrow it.
+typedef struct {
+    uint64_t key;
+    WGPUComputePipeline compute_pipeline;
+    WGPURenderPipeline render_pipeline;
+    uint32_t hits;
+    // Value of the cache clock when the entry was last added or hit
+    uint32_t last_used;
+} nano_pipeline_cache_entry_t;
+
+// Shaders that are rebuilt, or that share their source and state with
+// another shader, reuse the pipeline instead of compiling it again
+typedef struct {
+    nano_pipeline_cache_entry_t entries[NANO_PIPELINE_CACHE_SIZE];
+    int count;
+    uint32_t hits;
+    uint32_t misses;
+    // Counts lookups and inserts, orders the entries by last use
+    uint32_t clock;
+} nano_pipeline_cache_t;
+
 // Nano Font Declarations
 // -------------------------------------------
 
@@ -553,6 +1259,8 @@ typedef wgpu_state_t nano_wgpu_state_t;
 
 // This is the struct that will hold all of the running application data
 // In simple terms, this is the state of the application
+// Each nano_context_t owns its own pools, settings and WGPU state, see
+// nano_create_context().
 typedef struct {
     nano_wgpu_state_t *wgpu;
     bool show_debug;
@@ -562,10 +1270,42 @@ typedef struct {
     nano_buffer_pool_t buffer_pool;
     nano_shader_pool_t shader_pool;
     nano_settings_t settings;
+    nano_stats_kernels_t stats_kernels;
+    nano_cull_kernels_t cull_kernels;
+    nano_cmd_queue_t cmd_queue;
+    nano_uniforms_t uniforms;
+    nano_frame_group_t frame_group;
+    nano_pipeline_cache_t pipeline_cache;
+    nano_transfers_t transfers;
+
+    // Moving average of the time between submitting a compute pass and the
+    // queue reporting it done. Used by NANO_EXEC_AUTO.
+    float gpu_latency_ms;
+    bool gpu_latency_pending;
+    double gpu_latency_start;
+
+    // Identifies the thread that initialized the context, the only thread
+    // that may use its WGPU device and queue
+    const void *render_thread;
+
+    // Set once the pools and worker threads are initialized before the
+    // device exists, see nano_start_app()
+    bool preloaded;
+    // The custom fonts are loaded once ImGui is created, or with fast_start
+    // once it first draws something
+    bool fonts_deferred;
+    // Set while an ImGui frame is started, see nano_ui_begin()
+    bool ui_frame;
 } nano_t;
 
+typedef nano_t nano_context_t;
+
+// The address of this variable is unique to each thread
+static _Thread_local char nano_thread_tag;
+
 // Initialize a static nano_t struct to hold the running application data
-static nano_t nano_app = {
+// This is the context every thread uses until nano_set_context() is called
+static nano_t nano_default_context = {
     .wgpu = 0,
     .show_debug = NANO_DEBUG_UI,
     .frametime = 0.0f,
@@ -574,21 +1314,161 @@ static nano_t nano_app = {
     .buffer_pool = {0},
     .shader_pool = {0},
     .settings = {0},
+    .stats_kernels = {0},
+    .cmd_queue = {0},
+    .uniforms = {0},
+    .transfers = {0},
+    .gpu_latency_ms = NANO_GPU_LATENCY_MS,
 };
 
+// Context used by the calling thread
+static _Thread_local nano_context_t *nano_current_context =
+    &nano_default_context;
+
+// Every Nano function works on the calling thread's current context
+#define nano_app (*nano_current_context)
+
+// preload_cb of the application, called by _nano_preload()
+static wgpu_init_func _nano_app_preload_cb;
+
+static void _nano_init_core(void);
+
+// Initialize everything that doesn't need the device while the adapter
+// and device are requested, then run the application's preload_cb
+static void _nano_preload(void) {
+    _nano_init_core();
+    nano_app.preloaded = true;
+
+    if (_nano_app_preload_cb != NULL) {
+        _nano_app_preload_cb();
+    }
+}
+
 // Start the Nano application with the given app description
 // THIS IS THE MAIN ENTRY POINT FOR NANO
+//
+// With desc->fast_start or a desc->preload_cb, the pools and worker
+// threads are initialized and preload_cb runs while the adapter and device
+// are requested, so shaders created there with
+// nano_create_shader_from_file() are read and parsed before the device
+// exists. With desc->fast_start, pipelines built before the first frame
+// also compile asynchronously, a shader is skipped until its pipelines are
+// ready, and the custom fonts are only loaded once ImGui first draws
+// something, usually when the debug UI is shown.
+//
+// With desc->ui_on_demand, ImGui is created the first time a UI is
+// requested and frames without one skip it entirely. The app then calls
+// nano_ui_begin() before its own ig* calls, the debug UI does it itself.
 int nano_start_app(nano_app_desc_t *desc) {
+    nano_app_desc_t app_desc = *desc;
+
+    if (app_desc.fast_start || app_desc.preload_cb != NULL) {
+        _nano_app_preload_cb = desc->preload_cb;
+        app_desc.preload_cb = _nano_preload;
+    }
 
     // Call wgpu_start() with the WGPU description
     // wgpu_start() should be defined in nano_web.h or nano_native.h
-    wgpu_start((wgpu_desc_t *)desc);
+    wgpu_start((wgpu_desc_t *)&app_desc);
 
     return NANO_OK;
 }
 
 // -------------------------------------------------------------------------------------------
 
+// Nano String Interning Functions
+// ---------------------------------------
+
+// FNV-1a hash of the whole string, 0 is reserved for empty table slots
+static uint32_t _nano_atom_hash(const char *str) {
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+// Find the table slot holding str, or the empty slot where it belongs
+// The intern table lock must be held.
+static uint32_t _nano_atom_slot(const char *str, uint32_t hash) {
+    nano_intern_table_t *table = &nano_intern_table;
+    uint32_t slot = hash & (NANO_ATOM_TABLE_SIZE - 1);
+    while (table->table[slot] != 0) {
+        nano_atom_t atom = table->table[slot];
+        if (table->hashes[atom] == hash &&
+            strcmp(table->storage + table->offsets[atom], str) == 0) {
+            break;
+        }
+        slot = (slot + 1) & (NANO_ATOM_TABLE_SIZE - 1);
+    }
+    return slot;
+}
+
+// Return the atom for a string, adding the string to the table if needed
+// Returns 0 for NULL or empty strings, or if the table is full. Atom 0 is
+// never found by name, so whatever needed the string should fail instead of
+// sharing it.
+nano_atom_t nano_intern(const char *str) {
+    if (str == NULL || str[0] == '\0') {
+        return 0;
+    }
+
+    nano_intern_table_t *table = &nano_intern_table;
+    uint32_t hash = _nano_atom_hash(str);
+
+    nano_spin_lock(&table->lock);
+    uint32_t slot = _nano_atom_slot(str, hash);
+    nano_atom_t atom = table->table[slot];
+    if (atom != 0) {
+        nano_spin_unlock(&table->lock);
+        return atom;
+    }
+
+    size_t length = strlen(str) + 1;
+    if (table->atom_count >= NANO_MAX_ATOMS ||
+        table->storage_used + length > NANO_ATOM_STORAGE_SIZE) {
+        nano_spin_unlock(&table->lock);
+        LOG_ERR("NANO: nano_intern() -> Intern table is full\n");
+        return 0;
+    }
+
+    atom = ++table->atom_count;
+    table->hashes[atom] = hash;
+    table->offsets[atom] = table->storage_used;
+    memcpy(table->storage + table->storage_used, str, length);
+    table->storage_used += length;
+    table->table[slot] = atom;
+    nano_spin_unlock(&table->lock);
+
+    return atom;
+}
+
+// Return the atom for a string without adding it to the table
+// Returns 0 if the string has never been interned.
+nano_atom_t nano_find_atom(const char *str) {
+    if (str == NULL || str[0] == '\0') {
+        return 0;
+    }
+
+    nano_intern_table_t *table = &nano_intern_table;
+    uint32_t hash = _nano_atom_hash(str);
+
+    nano_spin_lock(&table->lock);
+    nano_atom_t atom = table->table[_nano_atom_slot(str, hash)];
+    nano_spin_unlock(&table->lock);
+
+    return atom;
+}
+
+// Return the string for an atom, the empty string for 0
+const char *nano_atom_str(nano_atom_t atom) {
+    if (atom == 0 || atom > NANO_MAX_ATOMS) {
+        return "";
+    }
+    return nano_intern_table.storage + nano_intern_table.offsets[atom];
+}
+
 // Nano WGSL Parser Functions
 // ---------------------------------------
 
@@ -682,16 +1562,20 @@ WGPUFlags parse_storage_class_and_access(nano_wgsl_parser_t *parser) {
 }
 
 // Determine the type of the binding being parsed
+// The data type of a buffer binding is left for the caller to parse.
 wgsl_binding_type parse_binding_type(nano_wgsl_parser_t *parser) {
     wgsl_binding_type type = BUFFER;
     char identifier[NANO_MAX_IDENT_LENGTH];
     skip_whitespace(parser);
+    int start = parser->position;
     parse_identifier(parser, identifier, false);
 
     if (strcmp(identifier, "texture") == 0) {
         type = TEXTURE;
     } else if (strcmp(identifier, "storage_texture") == 0) {
         type = STORAGE_TEXTURE;
+    } else {
+        parser->position = start;
     }
 
     return type;
@@ -738,6 +1622,7 @@ void parse_binding(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
     skip_whitespace(parser);
     char name[NANO_MAX_IDENT_LENGTH];
     parse_identifier(parser, name, false);
+    char data_type[NANO_MAX_IDENT_LENGTH];
 
     skip_whitespace(parser);
     next(parser); // Skip ':'
@@ -747,6 +1632,7 @@ void parse_binding(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
     bi->group = group;
     bi->binding = binding;
     bi->shader_id = info->id;
+    bi->visibility = WGPUShaderStage_None;
 
     // Get binding type so we can parse the correct information
     wgsl_binding_type binding_type = parse_binding_type(parser);
@@ -762,12 +1648,13 @@ void parse_binding(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
         case BUFFER:
             bi->binding_type = BUFFER;
             bi->info.buffer_usage = buffer_usage;
-            parse_identifier(parser, bi->data_type, true);
+            parse_identifier(parser, data_type, true);
+            bi->data_type = nano_intern(data_type);
             break;
     }
 
     // Save the name of the binding
-    strcpy(bi->name, name);
+    bi->name = nano_intern(name);
 }
 
 // Parse the entry point information from the shader source
@@ -827,55 +1714,310 @@ void parse_entry_point(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
     }
 }
 
-// Top level function to parse the shader source into a wgpu_shader_info_t
-// struct
-void parse_shader(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
-    while (!is_eof(parser)) {
-        skip_whitespace(parser);
-        if (peek(parser) == '@') {
-            int saved_position = parser->position;
-            next(parser); // Skip '@'
-            char attr[NANO_MAX_IDENT_LENGTH];
-            parse_identifier(parser, attr, false);
-            parser->position = saved_position;
+// Characters that can start and continue a WGSL identifier, without the
+// locale lookups of isalpha() and isalnum()
+static inline bool wgsl_ident_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
 
-            if (strcmp(attr, "group") == 0) {
-                parse_binding(parser, info);
-            } else if (strcmp(attr, "compute") == 0 ||
-                       strcmp(attr, "vertex") == 0 ||
-                       strcmp(attr, "fragment") == 0) {
-                parse_entry_point(parser, info);
-            } else {
-                next(parser); // Skip unrecognized attribute
+static inline bool wgsl_ident_char(char c) {
+    return wgsl_ident_start(c) || (c >= '0' && c <= '9');
+}
+
+// Skip the comment that starts at c, if any
+static inline const char *wgsl_skip_comment(const char *c, const char *stop) {
+    if (c + 1 >= stop || c[0] != '/') {
+        return c;
+    }
+    if (c[1] == '/') {
+        while (c < stop && *c != '\n') {
+            c++;
+        }
+    } else if (c[1] == '*') {
+        c += 2;
+        while (c + 1 < stop && !(c[0] == '*' && c[1] == '/')) {
+            c++;
+        }
+        c += 2;
+    }
+    return c < stop ? c : stop;
+}
+
+// Find the next identifier in source[pos, end), outside of comments
+// Returns its offset and sets length, or returns -1 if there is none.
+static int wgsl_next_identifier(const char *source, int pos, int end,
+                                int *length) {
+    const char *c = source + pos;
+    const char *stop = source + end;
+    while (c < stop) {
+        if (*c == '/') {
+            const char *after = wgsl_skip_comment(c, stop);
+            if (after != c) {
+                c = after;
+                continue;
+            }
+        }
+        if (wgsl_ident_start(*c)) {
+            const char *start = c;
+            while (c < stop && wgsl_ident_char(*c)) {
+                c++;
+            }
+            *length = (int)(c - start);
+            return (int)(start - source);
+        } else if (*c >= '0' && *c <= '9') {
+            // Numbers are skipped whole so that suffixes like 1u are not
+            // identifiers
+            while (c < stop && (wgsl_ident_char(*c) || *c == '.')) {
+                c++;
             }
         } else {
-            next(parser); // Skip other tokens
+            c++;
         }
     }
+    return -1;
 }
 
-void nano_print_shader_info(wgpu_shader_info_t *info) {
-    LOG("------ Nano Shader Info ------\n");
-    LOG("Shader Info:\n");
-    LOG("ID: %d\n", info->id);
-    LOG("Path: %s\n", info->path);
-    LOG("Binding Count: %d\n", info->binding_count);
-    LOG("Entry Point Count: %d\n", info->entry_point_count);
-    for (int i = 0; i < info->binding_count; i++) {
-        nano_binding_info_t *bi = &info->bindings[i];
-        LOG("Binding %d:\n", i);
-        LOG("\tName: %s\n", bi->name);
-        LOG("\tGroup: %d\n", bi->group);
-        LOG("\tBinding: %d\n", bi->binding);
-        LOG("\tData Type: %s\n", bi->data_type);
+// Find the function declarations of the shader source and their bodies
+// Returns the number of functions found. Only the first NANO_MAX_FUNCTIONS
+// fit in the table, full is set if the source declares more.
+int parse_functions(const char *source, wgsl_function_t *functions,
+                    bool *full) {
+    int count = 0;
+    int end = (int)strlen(source);
+    int pos = 0;
+    int length;
+
+    *full = false;
+    for (;;) {
+        pos = wgsl_next_identifier(source, pos, end, &length);
+        if (pos < 0) {
+            break;
+        }
+        pos += length;
+        if (length != 2 || strncmp(&source[pos - 2], "fn", 2) != 0) {
+            continue;
+        }
+        if (count == NANO_MAX_FUNCTIONS) {
+            *full = true;
+            break;
+        }
+
+        wgsl_function_t *fn = &functions[count];
+        fn->name_start = wgsl_next_identifier(source, pos, end, &length);
+        if (fn->name_start < 0) {
+            break;
+        }
+        fn->name_length = length;
+
+        // The body is the first brace block after the signature
+        const char *c = source + fn->name_start + length;
+        const char *stop = source + end;
+        int depth = 0;
+        while (c < stop) {
+            const char *after = wgsl_skip_comment(c, stop);
+            if (after != c) {
+                c = after;
+                continue;
+            }
+            if (*c == '{' && depth++ == 0) {
+                fn->body_start = (int)(c - source);
+            } else if (*c == '}' && depth > 0 && --depth == 0) {
+                break;
+            }
+            c++;
+        }
+        if (c == stop) {
+            break;
+        }
+
+        pos = (int)(c - source) + 1;
+        fn->body_end = pos;
+        fn->bindings = 0;
+        fn->calls = 0;
+        fn->calls_unknown = false;
+        count++;
     }
-    for (int i = 0; i < info->entry_point_count; i++) {
-        nano_entry_t *ep = &info->entry_points[i];
-        LOG("Entry Point %d:\n", i);
-        LOG("\tType: %d\n", ep->type);
-        LOG("\tEntry: %s\n", ep->entry);
+
+    return count;
+}
+
+// Index of the function with the given name, or -1
+static int find_function(const char *source, const wgsl_function_t *functions,
+                         int count, const char *name, int length) {
+    for (int i = 0; i < count; i++) {
+        if (functions[i].name_length == length &&
+            strncmp(&source[functions[i].name_start], name, length) == 0) {
+            return i;
+        }
     }
-    LOG("-------------------------\n");
+    return -1;
+}
+
+// Set the visibility of every binding to the stages of the entry points that
+// reference it. The bodies of the functions are scanned for the names of the
+// bindings and for calls, then the call graph is walked from every entry
+// point. A local that shadows a binding only makes the binding visible to
+// more stages than it needs, which is still valid. Entry points that may
+// reach a function missing from a full table see every binding.
+void parse_binding_visibility(const char *source, wgpu_shader_info_t *info) {
+    wgsl_function_t functions[NANO_MAX_FUNCTIONS];
+    bool full;
+    int count = parse_functions(source, functions, &full);
+    if (full) {
+        LOG("NANO: parse_binding_visibility() -> More than %d functions, "
+            "calls to the others are assumed to use every binding\n",
+            NANO_MAX_FUNCTIONS);
+    }
+
+    // Bindings are matched by name, most shaders only have a few
+    const char *names[32];
+    int lengths[32];
+    int num_names = info->binding_count < 32 ? info->binding_count : 32;
+    for (int j = 0; j < num_names; j++) {
+        names[j] = nano_atom_str(info->bindings[j].name);
+        lengths[j] = (int)strlen(names[j]);
+    }
+
+    // The edges of the call graph and the bindings used by each function
+    for (int i = 0; i < count; i++) {
+        wgsl_function_t *fn = &functions[i];
+        int length;
+        int pos = fn->body_start;
+        while ((pos = wgsl_next_identifier(source, pos, fn->body_end,
+                                           &length)) >= 0) {
+            const char *ident = &source[pos];
+            pos += length;
+
+            // Member names after a '.' are never bindings or functions
+            if (ident[-1] == '.') {
+                continue;
+            }
+
+            int callee = find_function(source, functions, count, ident, length);
+            if (callee >= 0) {
+                fn->calls |= 1ull << callee;
+                continue;
+            }
+
+            // With a full table, any other call may be to a missing function.
+            // Builtins are counted too, which is only more conservative.
+            if (full) {
+                int next = pos;
+                while (next < fn->body_end &&
+                       isspace((unsigned char)source[next])) {
+                    next++;
+                }
+                if (next < fn->body_end && source[next] == '(') {
+                    fn->calls_unknown = true;
+                }
+            }
+
+            for (int j = 0; j < num_names; j++) {
+                if (lengths[j] == length &&
+                    memcmp(names[j], ident, length) == 0) {
+                    fn->bindings |= 1u << j;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < info->entry_point_count; i++) {
+        nano_entry_t *ep = &info->entry_points[i];
+        WGPUShaderStageFlags stage = WGPUShaderStage_Fragment;
+        if (ep->type == COMPUTE) {
+            stage = WGPUShaderStage_Compute;
+        } else if (ep->type == VERTEX) {
+            stage = WGPUShaderStage_Vertex;
+        }
+
+        // An entry point whose body was not found may use any binding
+        int root = find_function(source, functions, count, ep->entry,
+                                 (int)strlen(ep->entry));
+        uint32_t used = UINT32_MAX;
+        if (root >= 0) {
+            uint64_t visited = 1ull << root;
+            uint64_t pending = visited;
+            used = 0;
+            while (pending != 0) {
+                int f = __builtin_ctzll(pending);
+                pending &= pending - 1;
+                if (functions[f].calls_unknown) {
+                    used = UINT32_MAX;
+                    break;
+                }
+                used |= functions[f].bindings;
+                pending |= functions[f].calls & ~visited;
+                visited |= functions[f].calls;
+            }
+        }
+
+        for (int j = 0; j < info->binding_count; j++) {
+            if (j >= 32 || (used & (1u << j)) != 0) {
+                info->bindings[j].visibility |= stage;
+            }
+        }
+    }
+}
+
+// Top level function to parse the shader source into a wgpu_shader_info_t
+// struct
+void parse_shader(nano_wgsl_parser_t *parser, wgpu_shader_info_t *info) {
+    while (!is_eof(parser)) {
+        skip_whitespace(parser);
+        // Trailing whitespace, stepping over the terminator reads past it
+        if (is_eof(parser)) {
+            break;
+        }
+        if (peek(parser) == '@') {
+            int saved_position = parser->position;
+            next(parser); // Skip '@'
+            char attr[NANO_MAX_IDENT_LENGTH];
+            parse_identifier(parser, attr, false);
+            parser->position = saved_position;
+
+            if (strcmp(attr, "group") == 0) {
+                parse_binding(parser, info);
+            } else if (strcmp(attr, "compute") == 0 ||
+                       strcmp(attr, "vertex") == 0 ||
+                       strcmp(attr, "fragment") == 0) {
+                parse_entry_point(parser, info);
+            } else {
+                next(parser); // Skip unrecognized attribute
+            }
+        } else {
+            next(parser); // Skip other tokens
+        }
+    }
+
+    parse_binding_visibility(parser->input, info);
+}
+
+void nano_print_shader_info(wgpu_shader_info_t *info) {
+    LOG("------ Nano Shader Info ------\n");
+    LOG("Shader Info:\n");
+    LOG("ID: %d\n", info->id);
+    LOG("Path: %s\n", nano_atom_str(info->path));
+    LOG("Binding Count: %d\n", info->binding_count);
+    LOG("Entry Point Count: %d\n", info->entry_point_count);
+    for (int i = 0; i < info->binding_count; i++) {
+        nano_binding_info_t *bi = &info->bindings[i];
+        LOG("Binding %d:\n", i);
+        LOG("\tName: %s\n", nano_atom_str(bi->name));
+        LOG("\tGroup: %d\n", bi->group);
+        LOG("\tBinding: %d\n", bi->binding);
+        LOG("\tData Type: %s\n", nano_atom_str(bi->data_type));
+        LOG("\tVisibility:%s%s%s\n",
+            (bi->visibility & WGPUShaderStage_Vertex) ? " vertex" : "",
+            (bi->visibility & WGPUShaderStage_Fragment) ? " fragment" : "",
+            (bi->visibility & WGPUShaderStage_Compute) ? " compute" : "");
+    }
+    for (int i = 0; i < info->entry_point_count; i++) {
+        nano_entry_t *ep = &info->entry_points[i];
+        LOG("Entry Point %d:\n", i);
+        LOG("\tType: %d\n", ep->type);
+        LOG("\tEntry: %s\n", ep->entry);
+    }
+    LOG("-------------------------\n");
 }
 
 // -------------------------------------------------------------------------------------------
@@ -901,9 +2043,112 @@ uint32_t fnv1a_32(const char *key) {
  */
 uint32_t nano_hash_shader(const char *shader) { return fnv1a_32(shader); }
 
+// FNV-1a over a block of bytes
+static uint32_t _nano_fnv1a_bytes(uint32_t hash, const uint8_t *data,
+                                  size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint32_t)data[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+// 64-bit FNV-1a over a block of bytes, for keys where collisions must be
+// practically impossible
+static uint64_t _nano_fnv1a64_bytes(uint64_t hash, const void *data,
+                                    size_t size) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint64_t)bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#define NANO_FNV64_OFFSET 14695981039346656037ull
+
+// Job data for nano_checksum()
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint32_t *chunk_hashes;
+} _nano_checksum_job_t;
+
+static void _nano_checksum_chunks(void *data, uint32_t begin, uint32_t end) {
+    _nano_checksum_job_t *job = (_nano_checksum_job_t *)data;
+    for (uint32_t i = begin; i < end; i++) {
+        size_t offset = (size_t)i * NANO_CHECKSUM_CHUNK;
+        size_t size = job->size - offset;
+        if (size > NANO_CHECKSUM_CHUNK) {
+            size = NANO_CHECKSUM_CHUNK;
+        }
+        job->chunk_hashes[i] =
+            _nano_fnv1a_bytes(2166136261u, job->data + offset, size);
+    }
+}
+
+// Checksum a block of memory, such as data read back from the GPU.
+// Chunks are hashed in parallel on the job system and the chunk hashes are
+// hashed in order, so the result does not depend on the number of workers.
+uint32_t nano_checksum(const void *data, size_t size) {
+    if (data == NULL || size == 0) {
+        return 0;
+    }
+
+    uint32_t chunk_count =
+        (uint32_t)((size + NANO_CHECKSUM_CHUNK - 1) / NANO_CHECKSUM_CHUNK);
+    uint32_t *chunk_hashes = (uint32_t *)malloc(chunk_count * sizeof(uint32_t));
+    if (chunk_hashes == NULL) {
+        LOG_ERR("NANO: nano_checksum() -> Memory allocation failed\n");
+        return 0;
+    }
+
+    _nano_checksum_job_t job = {
+        .data = (const uint8_t *)data,
+        .size = size,
+        .chunk_hashes = chunk_hashes,
+    };
+    nano_parallel_for(chunk_count, 1, _nano_checksum_chunks, &job);
+
+    uint32_t hash = _nano_fnv1a_bytes(2166136261u, (const uint8_t *)chunk_hashes,
+                                      chunk_count * sizeof(uint32_t));
+    free(chunk_hashes);
+
+    return hash;
+}
+
 // Toggle flag to show debug UI
 void nano_toggle_debug() { nano_app.show_debug = !nano_app.show_debug; }
 
+// Check if Nano is running with a WebGPU device
+// This is false when the app was started with cpu_fallback and no adapter
+// or device could be created.
+bool nano_has_gpu(void) {
+    return nano_app.wgpu != NULL && nano_app.wgpu->device != NULL;
+}
+
+// Check if shaders can use the f16 type
+// True when the adapter supports shader-f16, the device is then created with
+// it and shaders can start with "enable f16;".
+bool nano_has_f16(void) { return nano_has_gpu() && nano_app.wgpu->has_f16; }
+
+// Check if shaders can use subgroup operations
+// When true the built-in kernels use their subgroup variants, see
+// nano_stats_set_variant().
+bool nano_has_subgroups(void) {
+    return nano_has_gpu() && nano_app.wgpu->has_subgroups;
+}
+
+// Check if the calling thread is the render thread
+bool nano_is_render_thread(void) {
+    return nano_app.render_thread == &nano_thread_tag;
+}
+
+// Rebuild the shader packets before the next nano_execute_shaders()
+static void _nano_invalidate_packets(void) {
+    nano_app.shader_pool.packets_dirty = true;
+}
+
 // Settings Functions
 // -------------------------------------------------
 
@@ -931,8 +2176,9 @@ nano_settings_t nano_default_settings() {
 // File IO
 // -----------------------------------------------
 
-// Function to read a shader into a string
-char *nano_read_file(const char *filename) {
+// Read a file into a string allocated from the arena, or with malloc() if
+// the arena is NULL
+static char *_nano_read_file_into(const char *filename, nano_arena_t *arena) {
     assert(filename != NULL);
 
     FILE *file = fopen(filename, "rb");
@@ -947,10 +2193,8 @@ char *nano_read_file(const char *filename) {
     size_t length = (size_t)ftell(file);
     fseek(file, 0, SEEK_SET);
 
-    // It is important to free the buffer after using it, it might be a good
-    // idea to implement an arena structure into the Nano STL for better
-    // handling of dynamic memory allocations.
-    char *buffer = (char *)malloc(length + 1);
+    char *buffer = arena ? (char *)nano_arena_alloc(arena, length + 1)
+                         : (char *)malloc(length + 1);
     if (!buffer) {
         LOG_ERR("NANO: nano_read_file() -> Memory allocation failed\n");
         fclose(file);
@@ -964,6 +2208,12 @@ char *nano_read_file(const char *filename) {
     return buffer;
 }
 
+// Function to read a shader into a string
+// It is important to free the buffer after using it.
+char *nano_read_file(const char *filename) {
+    return _nano_read_file_into(filename, NULL);
+}
+
 // Buffer Pool Functions
 // -------------------------------------------------
 
@@ -1019,7 +2269,9 @@ int nano_find_buffer_slot(nano_buffer_pool_t *pool, uint32_t buffer_id) {
 nano_buffer_t *nano_get_buffer(uint32_t buffer_id) {
     assert(&nano_app.buffer_pool != NULL);
     nano_buffer_pool_t *pool = &nano_app.buffer_pool;
+    nano_spin_lock(&pool->lock);
     int index = nano_find_buffer_slot(pool, buffer_id);
+    nano_spin_unlock(&pool->lock);
     if (index < 0) {
         LOG_ERR(
             "NANO: nano_get_buffer() -> Buffer not found in the buffer pool\n");
@@ -1030,15 +2282,22 @@ nano_buffer_t *nano_get_buffer(uint32_t buffer_id) {
                                          : NULL;
 }
 
+// Forward declaration, see Thread Safe Command Functions
+static int _nano_push_cmd(nano_cmd_t *cmd);
+
 // Release a buffer from the buffer pool using the buffer id
 // This does not free the data associated with the buffer, it just releases
 // the WGPU buffer and marks the buffer slot as unoccupied.
 // If you used malloc() to allocate the buffer data, you should free it
+// Can be called from any thread, the WGPU buffer is then released by the
+// render thread at the start of the next frame.
 int nano_release_buffer(uint32_t buffer_id) {
     assert(&nano_app.buffer_pool != NULL);
     nano_buffer_pool_t *pool = &nano_app.buffer_pool;
+    nano_spin_lock(&pool->lock);
     int index = nano_find_buffer_slot(pool, buffer_id);
     if (index < 0) {
+        nano_spin_unlock(&pool->lock);
         return NANO_FAIL;
     }
 
@@ -1046,7 +2305,21 @@ int nano_release_buffer(uint32_t buffer_id) {
 
     // Release the buffer
     if (buffer->buffer != NULL) {
-        wgpuBufferRelease(buffer->buffer);
+        if (nano_is_render_thread()) {
+            wgpuBufferRelease(buffer->buffer);
+        } else {
+            nano_cmd_t *cmd = (nano_cmd_t *)calloc(1, sizeof(nano_cmd_t));
+            if (cmd != NULL) {
+                cmd->type = NANO_CMD_RELEASE_BUFFER;
+                cmd->buffer = buffer->buffer;
+                _nano_push_cmd(cmd);
+            }
+        }
+    }
+
+    // Free the host copy if Nano allocated one
+    if (buffer->host != NULL) {
+        free(buffer->host);
     }
 
     // Reset the buffer entry after releasing the buffer
@@ -1054,6 +2327,10 @@ int nano_release_buffer(uint32_t buffer_id) {
     pool->buffer_count--;
     pool->buffers[index].buffer_entry = (nano_buffer_t){0};
     nano_buffer_array_remove(&pool->active_buffers, buffer_id);
+    nano_spin_unlock(&pool->lock);
+
+    // Packets may point at this buffer
+    _nano_invalidate_packets();
 
     return NANO_OK;
 }
@@ -1061,7 +2338,17 @@ int nano_release_buffer(uint32_t buffer_id) {
 // Buffer Functions
 // -------------------------------------------------
 
+// Forward declaration, see Thread Safe Command Functions
+int nano_queue_write_buffer(uint32_t buffer_id, size_t offset,
+                            const void *data, size_t size);
+
+// Forward declaration, see Transfer Functions
+int nano_upload_buffer(WGPUBuffer dst, size_t offset, const void *data,
+                       size_t size, nano_transfer_strategy_t strategy);
+
 // Write data to a buffer object using the WGPU API
+// When called from another thread the write is staged with
+// nano_queue_write_buffer() and happens at the start of the next frame.
 void nano_write_buffer(nano_buffer_t *buffer) {
     if (buffer == NULL) {
         LOG_ERR("NANO: nano_write_buffer() -> Buffer is NULL\n");
@@ -1076,19 +2363,61 @@ void nano_write_buffer(nano_buffer_t *buffer) {
         return;
     }
 
-    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
-    wgpuQueueWriteBuffer(queue, buffer->buffer, buffer->offset, buffer->data,
-                         buffer->size);
+    // Other threads stage the write for the render thread
+    if (!nano_is_render_thread()) {
+        nano_queue_write_buffer(buffer->id, buffer->offset, buffer->data,
+                                buffer->size);
+        return;
+    }
+
+    // The host copy now matches what the GPU will see
+    buffer->gpu_dirty = false;
+
+    // CPU kernels read the data pointer directly when there is no device
+    if (!nano_has_gpu()) {
+        return;
+    }
+
+    nano_upload_buffer(buffer->buffer, buffer->offset, buffer->data,
+                       buffer->size, NANO_TRANSFER_AUTO);
 
     LOG("NANO: Buffer %u: \'%s\': Successfully wrote %zu bytes.\n", buffer->id,
-        (char *)buffer->label ? (char *)buffer->label : "Unnamed",
+        buffer->label ? nano_atom_str(buffer->label) : "Unnamed",
         buffer->size);
 }
 
+// Return the host memory that CPU kernels use for a buffer
+// This is the data pointer given when the buffer was created, otherwise Nano
+// allocates a zeroed host copy that is freed with the buffer.
+void *nano_buffer_host(nano_buffer_t *buffer) {
+    if (buffer == NULL) {
+        LOG_ERR("NANO: nano_buffer_host() -> Buffer is NULL\n");
+        return NULL;
+    }
+
+    if (buffer->data != NULL) {
+        return buffer->data;
+    }
+
+    if (buffer->host == NULL) {
+        buffer->host = calloc(1, buffer->size);
+        if (buffer->host == NULL) {
+            LOG_ERR("NANO: nano_buffer_host() -> Could not allocate %zu "
+                    "bytes\n",
+                    buffer->size);
+        }
+    }
+
+    return buffer->host;
+}
+
 // Create a Nano WGPU buffer object using a shader binding description
 // This buffer is added to the buffer pool and can be retrieved using the
 // buffer id. The buffer pool exists so that shaders can share buffers as long
 // as they have the same description (these should be wgpu storage buffers)
+// Can be called from any thread. Off the render thread the id is reserved
+// right away and the WGPU buffer is created at the start of the next frame,
+// so shaders using it should be built after that.
 uint32_t nano_create_buffer(nano_binding_info_t *binding, size_t size,
                             uint32_t count, size_t offset, void *data) {
     if (binding == NULL) {
@@ -1111,35 +2440,45 @@ uint32_t nano_create_buffer(nano_binding_info_t *binding, size_t size,
 
     // Create the buffer descriptor
     WGPUBufferDescriptor desc = {
+        .label = nano_atom_str(binding->name),
         .usage = binding->info.buffer_usage,
         .size = cache_aligned_size,
         .mappedAtCreation = false,
     };
 
-    memcpy((char *)desc.label, binding->name, NANO_MAX_IDENT_LENGTH);
-
-    uint32_t buffer_id = fnv1a_32(binding->name);
-
-    // Get a buffer slot from the buffer pool
-    int slot = nano_find_empty_buffer_slot(&nano_app.buffer_pool, buffer_id);
-    if (slot < 0) {
-        LOG_ERR("NANO: nano_create_buffer() -> Buffer pool is full\n");
-        return 0;
+    uint32_t buffer_id = fnv1a_32(desc.label);
+
+    // Only the render thread may create the WGPU buffer right away
+    // Without a device the buffer only lives in host memory
+    bool create_now = nano_has_gpu() && nano_is_render_thread();
+    nano_cmd_t *cmd = NULL;
+    if (nano_has_gpu() && !create_now) {
+        cmd = (nano_cmd_t *)calloc(1, sizeof(nano_cmd_t));
+        if (cmd == NULL) {
+            LOG_ERR("NANO: nano_create_buffer() -> Memory allocation "
+                    "failed\n");
+            return 0;
+        }
+        cmd->type = NANO_CMD_CREATE_BUFFER;
+        cmd->buffer_id = buffer_id;
+        cmd->usage = desc.usage;
+        cmd->size = desc.size;
     }
 
     // Construct the buffer entry
     nano_buffer_t buffer = {
         .id = buffer_id,
-        .buffer = wgpuDeviceCreateBuffer(nano_app.wgpu->device, &desc),
+        .buffer = create_now
+                      ? wgpuDeviceCreateBuffer(nano_app.wgpu->device, &desc)
+                      : NULL,
         .size = cache_aligned_size,
         .count = count,
         .offset = offset,
         .data = data,
+        .label = binding->name,
     };
 
-    memcpy(buffer.label, binding->name, NANO_MAX_IDENT_LENGTH);
-
-    if (buffer.buffer == NULL) {
+    if (buffer.buffer == NULL && create_now) {
         LOG_ERR("NANO: nano_create_buffer() -> Could not create buffer\n");
         return 0;
     }
@@ -1147,17 +2486,36 @@ uint32_t nano_create_buffer(nano_binding_info_t *binding, size_t size,
     // Assign the buffer to the binding data field
     binding->data.buffer = buffer.buffer;
 
+    // Get a buffer slot from the buffer pool
+    nano_buffer_pool_t *pool = &nano_app.buffer_pool;
+    nano_spin_lock(&pool->lock);
+    int slot = nano_find_empty_buffer_slot(pool, buffer_id);
+    if (slot < 0) {
+        nano_spin_unlock(&pool->lock);
+        LOG_ERR("NANO: nano_create_buffer() -> Buffer pool is full\n");
+        if (buffer.buffer != NULL) {
+            wgpuBufferRelease(buffer.buffer);
+        }
+        free(cmd);
+        return 0;
+    }
+
     // Memcopy this nano_buffer_t to the buffer pool
-    memcpy(&nano_app.buffer_pool.buffers[slot].buffer_entry, &buffer,
-           sizeof(nano_buffer_t));
+    memcpy(&pool->buffers[slot].buffer_entry, &buffer, sizeof(nano_buffer_t));
 
     // Add the slot index to the active buffers array
-    nano_buffer_array_push(&nano_app.buffer_pool.active_buffers, slot);
-    nano_app.buffer_pool.buffer_count++;
-    nano_app.buffer_pool.buffers[slot].occupied = true;
+    nano_buffer_array_push(&pool->active_buffers, slot);
+    pool->buffer_count++;
+    pool->buffers[slot].occupied = true;
+    nano_spin_unlock(&pool->lock);
+
+    // Hand the creation to the render thread
+    if (cmd != NULL) {
+        _nano_push_cmd(cmd);
+    }
 
     LOG("NANO: Buffer %u: Successfully created %s buffer.\n", buffer_id,
-        buffer.label);
+        nano_atom_str(buffer.label));
 
     return buffer_id;
 }
@@ -1277,18 +2635,24 @@ uint32_t nano_create_vertex_buffer(size_t size, size_t offset,
             LOG_ERR("NANO: nano_create_vertex_buffer() -> Label is too long\n");
             return 0;
         }
-        strncpy(buffer_label, label, strlen(label));
+        snprintf(buffer_label, sizeof(buffer_label), "%s", label);
+    }
+
+    nano_atom_t label_atom = nano_intern(buffer_label);
+    if (label_atom == 0) {
+        LOG_ERR("NANO: nano_create_vertex_buffer() -> Could not intern the "
+                "label %s\n",
+                buffer_label);
+        return 0;
     }
 
     WGPUBufferDescriptor desc = {
+        .label = nano_atom_str(label_atom),
         .usage = WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst,
         .size = size,
         .mappedAtCreation = false,
     };
 
-    // Copy the buffer label to the buffer descriptor
-    memcpy((char *)desc.label, buffer_label, strlen(buffer_label));
-
     // Create the buffer object
     nano_buffer_t buffer = {
         .id = fnv1a_32(buffer_label),
@@ -1297,6 +2661,7 @@ uint32_t nano_create_vertex_buffer(size_t size, size_t offset,
         .count = 1,
         .offset = offset,
         .data = data,
+        .label = label_atom,
     };
 
     if (buffer.buffer == NULL) {
@@ -1305,9 +2670,6 @@ uint32_t nano_create_vertex_buffer(size_t size, size_t offset,
         return 0;
     }
 
-    // Copy the buffer label to the buffer struct
-    memcpy(buffer.label, buffer_label, strlen(buffer_label));
-
     // We need to add the vertex buffer to the buffer pool
     int slot = nano_find_empty_buffer_slot(&nano_app.buffer_pool, buffer.id);
     if (slot < 0) {
@@ -1325,19 +2687,18 @@ uint32_t nano_create_vertex_buffer(size_t size, size_t offset,
     nano_app.buffer_pool.buffers[slot].occupied = true;
 
     LOG("NANO: Buffer %u: Successfully created %s buffer.\n", buffer.id,
-        buffer.label);
+        nano_atom_str(buffer.label));
 
     return buffer.id;
 }
 
-// Add a vertex buffer to the shader. Requires the WGPUVertexAttribute array
-// of all attributes and the number of attributes in the array. The size of
-// the buffer and the data to be copied to the buffer should also be
-// provided.
-int nano_shader_bind_vertex_buffer(nano_shader_t *shader, uint32_t buffer_id,
-                                   WGPUVertexAttribute *attributes,
-                                   uint8_t attribute_count,
-                                   size_t attribute_stride) {
+// Add a vertex buffer to the shader
+static int _nano_shader_add_vertex_buffer(nano_shader_t *shader,
+                                          uint32_t buffer_id,
+                                          const WGPUVertexAttribute *attributes,
+                                          uint8_t attribute_count,
+                                          size_t attribute_stride,
+                                          WGPUVertexStepMode step_mode) {
     if (shader == NULL) {
         LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_buffer() -> Shader "
                 "is NULL\n",
@@ -1359,7 +2720,7 @@ int nano_shader_bind_vertex_buffer(nano_shader_t *shader, uint32_t buffer_id,
         return NANO_FAIL;
     }
 
-    if (shader->vertex_attribute_count + attribute_count >=
+    if (shader->vertex_attribute_count + attribute_count >
         NANO_MAX_VERTEX_ATTRIBUTES) {
         LOG_ERR(
             "NANO: Shader %u: nano_shader_bind_vertex_buffer() -> Max vertex "
@@ -1402,13 +2763,18 @@ int nano_shader_bind_vertex_buffer(nano_shader_t *shader, uint32_t buffer_id,
         .vertex_buffer_layout =
             {
                 .arrayStride = attribute_stride,
-                .stepMode = WGPUVertexStepMode_Vertex,
+                .stepMode = step_mode,
                 .attributeCount = attribute_count,
-                .attributes = attributes,
             },
         .buffer_id = buffer_id,
+        .attribute_count = attribute_count,
+        .first_attribute = shader->vertex_attribute_count,
     };
 
+    // Keep a copy of the attributes so the caller's array can be temporary
+    memcpy(&shader->vertex_attributes[shader->vertex_attribute_count],
+           attributes, attribute_count * sizeof(WGPUVertexAttribute));
+
     // Copy the vertex buffer data to the shader
     memcpy(&shader->vertex_buffers[shader->vertex_buffer_count], &vertex_buffer,
            sizeof(nano_vertex_buffer_t));
@@ -1420,62 +2786,341 @@ int nano_shader_bind_vertex_buffer(nano_shader_t *shader, uint32_t buffer_id,
     return NANO_OK;
 }
 
-// Remove a vertex buffer from the shader and shift the rest of the vertex
-// buffers down. This does not free the buffered data from the GPU, it just
-// removes the vertex buffer from the shader. 
-// You should call nano_release_buffer() to free the buffer data.
-int nano_shader_remove_vertex_buffer(nano_shader_t *shader,
-                                     uint32_t buffer_id) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Shader "
-                "is NULL\n",
-                shader->id);
-        return NANO_FAIL;
-    }
-    if (shader->in_use) {
-        LOG_ERR(
-            "NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Shader is "
-            "currently in"
-            "use. Make sure to assign buffer data before activating a "
-            "shader.\n",
-            shader->id);
-        return NANO_FAIL;
+// Add a vertex buffer to the shader. Requires the WGPUVertexAttribute array
+// of all attributes and the number of attributes in the array, which is
+// copied, and the stride between two vertices in the buffer.
+// See nano_shader_bind_vertex_layout() to build the attributes from the
+// vertex inputs of the shader instead.
+int nano_shader_bind_vertex_buffer(nano_shader_t *shader, uint32_t buffer_id,
+                                   WGPUVertexAttribute *attributes,
+                                   uint8_t attribute_count,
+                                   size_t attribute_stride) {
+    return _nano_shader_add_vertex_buffer(shader, buffer_id, attributes,
+                                          attribute_count, attribute_stride,
+                                          WGPUVertexStepMode_Vertex);
+}
+
+// Vertex format of a reflected vertex input
+// Returns WGPUVertexFormat_Undefined if the type is not a scalar or vector.
+static WGPUVertexFormat _nano_vertex_format(const nano_wgsl_type_t *type) {
+    static const WGPUVertexFormat formats[][4] = {
+        [NANO_WGSL_F32] = {WGPUVertexFormat_Float32,
+                           WGPUVertexFormat_Float32x2,
+                           WGPUVertexFormat_Float32x3,
+                           WGPUVertexFormat_Float32x4},
+        [NANO_WGSL_I32] = {WGPUVertexFormat_Sint32,
+                           WGPUVertexFormat_Sint32x2,
+                           WGPUVertexFormat_Sint32x3,
+                           WGPUVertexFormat_Sint32x4},
+        [NANO_WGSL_U32] = {WGPUVertexFormat_Uint32,
+                           WGPUVertexFormat_Uint32x2,
+                           WGPUVertexFormat_Uint32x3,
+                           WGPUVertexFormat_Uint32x4},
+        // There are no one and three component f16 formats, the missing
+        // components are ignored by the shader
+        [NANO_WGSL_F16] = {WGPUVertexFormat_Float16x2,
+                           WGPUVertexFormat_Float16x2,
+                           WGPUVertexFormat_Float16x4,
+                           WGPUVertexFormat_Float16x4},
+    };
+
+    if (type->scalar == NANO_WGSL_STRUCT || type->dim_count > 0) {
+        return WGPUVertexFormat_Undefined;
     }
-    if (buffer_id == 0) {
-        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Buffer "
-                "ID is 0\n",
-                shader->id);
-        return NANO_FAIL;
+
+    uint32_t scalar_size = type->scalar == NANO_WGSL_F16 ? 2 : 4;
+    uint32_t components = type->size / scalar_size;
+    if (components < 1 || components > 4) {
+        return WGPUVertexFormat_Undefined;
     }
-    if (shader->vertex_buffer_count == 0) {
-        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> No "
-                "vertex buffers "
-                "to remove\n",
-                shader->id);
-        return NANO_FAIL;
+
+    return formats[type->scalar][components - 1];
+}
+
+// Size in bytes of a vertex format, 0 if it is not known
+static uint32_t _nano_vertex_format_size(WGPUVertexFormat format) {
+    switch (format) {
+    case WGPUVertexFormat_Uint8x2:
+    case WGPUVertexFormat_Sint8x2:
+    case WGPUVertexFormat_Unorm8x2:
+    case WGPUVertexFormat_Snorm8x2:
+        return 2;
+    case WGPUVertexFormat_Uint8x4:
+    case WGPUVertexFormat_Sint8x4:
+    case WGPUVertexFormat_Unorm8x4:
+    case WGPUVertexFormat_Snorm8x4:
+    case WGPUVertexFormat_Uint16x2:
+    case WGPUVertexFormat_Sint16x2:
+    case WGPUVertexFormat_Unorm16x2:
+    case WGPUVertexFormat_Snorm16x2:
+    case WGPUVertexFormat_Float16x2:
+    case WGPUVertexFormat_Float32:
+    case WGPUVertexFormat_Uint32:
+    case WGPUVertexFormat_Sint32:
+        return 4;
+    case WGPUVertexFormat_Uint16x4:
+    case WGPUVertexFormat_Sint16x4:
+    case WGPUVertexFormat_Unorm16x4:
+    case WGPUVertexFormat_Snorm16x4:
+    case WGPUVertexFormat_Float16x4:
+    case WGPUVertexFormat_Float32x2:
+    case WGPUVertexFormat_Uint32x2:
+    case WGPUVertexFormat_Sint32x2:
+        return 8;
+    case WGPUVertexFormat_Float32x3:
+    case WGPUVertexFormat_Uint32x3:
+    case WGPUVertexFormat_Sint32x3:
+        return 12;
+    case WGPUVertexFormat_Float32x4:
+    case WGPUVertexFormat_Uint32x4:
+    case WGPUVertexFormat_Sint32x4:
+        return 16;
+    default:
+        return 0;
     }
+}
 
-    int index = -1;
+// Find a reflected vertex input of a shader by name
+static nano_wgsl_vertex_input_t *
+_nano_shader_find_vertex_input(nano_shader_t *shader, const char *name) {
+    for (int i = 0; i < shader->vertex_input_count; i++) {
+        if (strcmp(shader->vertex_inputs[i].name, name) == 0) {
+            return &shader->vertex_inputs[i];
+        }
+    }
+    return NULL;
+}
 
-    // find the vertex buffer index in the shader
-    for (int i = 0; i < shader->vertex_buffer_count; i++) {
-        if (shader->vertex_buffers[i].buffer_id == buffer_id) {
-            index = i;
-            break;
+// Whether an input location already has an attribute in a vertex buffer
+static bool _nano_shader_location_bound(nano_shader_t *shader,
+                                        uint32_t location) {
+    for (int i = 0; i < shader->vertex_attribute_count; i++) {
+        if (shader->vertex_attributes[i].shaderLocation == location) {
+            return true;
         }
     }
+    return false;
+}
 
-    if (index == -1) {
-        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Vertex "
-                "buffer not "
-                "found in the shader\n",
-                shader->id);
-        return NANO_FAIL;
+// Add a vertex buffer that holds reflected vertex inputs of the shader
+// Nano builds the attributes from the @location inputs of the vertex entry
+// point, including the members of struct inputs. Without offsets the inputs
+// are packed: they are sorted by alignment so that two byte formats share
+// four byte words after the wider ones and no padding is needed between
+// them. nano_shader_get_vertex_attribute() returns where each input was put.
+// A NULL desc packs every unbound input with the format of its WGSL type.
+int nano_shader_bind_vertex_layout(nano_shader_t *shader, uint32_t buffer_id,
+                                   const nano_vertex_layout_desc_t *desc) {
+    static const nano_vertex_layout_desc_t default_desc = {0};
+    if (desc == NULL) {
+        desc = &default_desc;
     }
 
-    // Erase the buffer data at the index and shift the rest of the data
-    for (int i = index; i < shader->vertex_buffer_count - 1; i++) {
-        shader->vertex_buffers[i] = shader->vertex_buffers[i + 1];
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_bind_vertex_layout() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (desc->inputs != NULL &&
+        desc->input_count > NANO_MAX_VERTEX_ATTRIBUTES) {
+        LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_layout() -> Too "
+                "many inputs\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    // Resolve the inputs in the order the caller gave them
+    nano_wgsl_vertex_input_t *inputs[NANO_MAX_VERTEX_ATTRIBUTES];
+    int count = 0;
+    if (desc->inputs != NULL) {
+        for (int i = 0; i < desc->input_count; i++) {
+            inputs[count] =
+                _nano_shader_find_vertex_input(shader, desc->inputs[i]);
+            if (inputs[count] == NULL) {
+                LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_layout() -> "
+                        "The vertex entry point has no input %s\n",
+                        shader->id, desc->inputs[i]);
+                return NANO_FAIL;
+            }
+            count++;
+        }
+    } else {
+        for (int i = 0; i < shader->vertex_input_count; i++) {
+            nano_wgsl_vertex_input_t *input = &shader->vertex_inputs[i];
+            if (!_nano_shader_location_bound(shader, input->location)) {
+                inputs[count++] = input;
+            }
+        }
+    }
+
+    if (count == 0) {
+        LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_layout() -> No "
+                "vertex inputs to bind\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    WGPUVertexAttribute attributes[NANO_MAX_VERTEX_ATTRIBUTES];
+    uint32_t sizes[NANO_MAX_VERTEX_ATTRIBUTES];
+    for (int i = 0; i < count; i++) {
+        WGPUVertexFormat format = desc->formats ? desc->formats[i]
+                                                : WGPUVertexFormat_Undefined;
+        if (format == WGPUVertexFormat_Undefined) {
+            format = _nano_vertex_format(&inputs[i]->type);
+        }
+
+        sizes[i] = _nano_vertex_format_size(format);
+        if (sizes[i] == 0) {
+            LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_layout() -> No "
+                    "vertex format for input %s\n",
+                    shader->id, inputs[i]->name);
+            return NANO_FAIL;
+        }
+
+        attributes[i] = (WGPUVertexAttribute){
+            .format = format,
+            .offset = desc->offsets ? desc->offsets[i] : 0,
+            .shaderLocation = inputs[i]->location,
+        };
+    }
+
+    // Without offsets place the inputs with the largest alignment first,
+    // attributes are aligned to their size up to four bytes
+    uint32_t packed_size = 0;
+    if (desc->offsets == NULL) {
+        for (uint32_t align = 4; align >= 1; align /= 2) {
+            for (int i = 0; i < count; i++) {
+                uint32_t a = sizes[i] < 4 ? sizes[i] : 4;
+                if (a == align) {
+                    attributes[i].offset = packed_size;
+                    packed_size += sizes[i];
+                }
+            }
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            uint32_t end = (uint32_t)attributes[i].offset + sizes[i];
+            packed_size = end > packed_size ? end : packed_size;
+        }
+    }
+
+    // WebGPU strides are multiples of four bytes
+    uint32_t stride = desc->stride ? desc->stride : (packed_size + 3) & ~3u;
+    if (stride < packed_size) {
+        LOG_ERR("NANO: Shader %u: nano_shader_bind_vertex_layout() -> Stride "
+                "%u is smaller than the %u bytes of the inputs\n",
+                shader->id, stride, packed_size);
+        return NANO_FAIL;
+    }
+
+    return _nano_shader_add_vertex_buffer(
+        shader, buffer_id, attributes, (uint8_t)count, stride,
+        desc->per_instance ? WGPUVertexStepMode_Instance
+                           : WGPUVertexStepMode_Vertex);
+}
+
+// Get the attribute of a vertex input and the stride of its vertex buffer
+// Use this to fill buffers whose layout was packed by
+// nano_shader_bind_vertex_layout().
+int nano_shader_get_vertex_attribute(nano_shader_t *shader, const char *input,
+                                     WGPUVertexAttribute *attribute,
+                                     uint32_t *stride) {
+    if (shader == NULL || input == NULL || attribute == NULL) {
+        LOG_ERR("NANO: nano_shader_get_vertex_attribute() -> Invalid "
+                "arguments\n");
+        return NANO_FAIL;
+    }
+
+    nano_wgsl_vertex_input_t *reflected =
+        _nano_shader_find_vertex_input(shader, input);
+    for (int i = 0; reflected && i < shader->vertex_buffer_count; i++) {
+        nano_vertex_buffer_t *vb = &shader->vertex_buffers[i];
+        for (int j = 0; j < vb->attribute_count; j++) {
+            WGPUVertexAttribute *a =
+                &shader->vertex_attributes[vb->first_attribute + j];
+            if (a->shaderLocation == reflected->location) {
+                *attribute = *a;
+                if (stride != NULL) {
+                    *stride = (uint32_t)vb->vertex_buffer_layout.arrayStride;
+                }
+                return NANO_OK;
+            }
+        }
+    }
+
+    LOG_ERR("NANO: Shader %u: nano_shader_get_vertex_attribute() -> Input %s "
+            "is not bound\n",
+            shader->id, input);
+    return NANO_FAIL;
+}
+
+// Remove a vertex buffer from the shader and shift the rest of the vertex
+// buffers down. This does not free the buffered data from the GPU, it just
+// removes the vertex buffer from the shader. 
+// You should call nano_release_buffer() to free the buffer data.
+int nano_shader_remove_vertex_buffer(nano_shader_t *shader,
+                                     uint32_t buffer_id) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Shader "
+                "is NULL\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+    if (shader->in_use) {
+        LOG_ERR(
+            "NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Shader is "
+            "currently in"
+            "use. Make sure to assign buffer data before activating a "
+            "shader.\n",
+            shader->id);
+        return NANO_FAIL;
+    }
+    if (buffer_id == 0) {
+        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Buffer "
+                "ID is 0\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+    if (shader->vertex_buffer_count == 0) {
+        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> No "
+                "vertex buffers "
+                "to remove\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    int index = -1;
+
+    // find the vertex buffer index in the shader
+    for (int i = 0; i < shader->vertex_buffer_count; i++) {
+        if (shader->vertex_buffers[i].buffer_id == buffer_id) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == -1) {
+        LOG_ERR("NANO: Shader %u: nano_shader_remove_vertex_buffer() -> Vertex "
+                "buffer not "
+                "found in the shader\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    // Erase the attributes of the buffer and shift the rest down
+    nano_vertex_buffer_t *removed = &shader->vertex_buffers[index];
+    uint8_t first = removed->first_attribute;
+    uint8_t removed_count = removed->attribute_count;
+    memmove(&shader->vertex_attributes[first],
+            &shader->vertex_attributes[first + removed_count],
+            (shader->vertex_attribute_count - first - removed_count) *
+                sizeof(WGPUVertexAttribute));
+    shader->vertex_attribute_count -= removed_count;
+
+    // Erase the buffer data at the index and shift the rest of the data
+    for (int i = index; i < shader->vertex_buffer_count - 1; i++) {
+        shader->vertex_buffers[i] = shader->vertex_buffers[i + 1];
+        shader->vertex_buffers[i].first_attribute -= removed_count;
     }
 
     shader->vertex_buffer_count--;
@@ -1528,6 +3173,417 @@ int nano_copy_buffer_to_buffer(WGPUBuffer src, size_t src_offset,
     return NANO_OK;
 }
 
+// Transfer Functions
+// -------------------------------------------------
+
+const char *nano_transfer_strategy_name(nano_transfer_strategy_t strategy) {
+    switch (strategy) {
+    case NANO_TRANSFER_AUTO:
+        return "Auto";
+    case NANO_TRANSFER_QUEUE_WRITE:
+        return "Queue Write";
+    case NANO_TRANSFER_MAPPED_AT_CREATION:
+        return "Mapped At Creation";
+    case NANO_TRANSFER_STAGING_RING:
+        return "Staging Ring";
+    case NANO_TRANSFER_READ_PER_CALL:
+        return "Staging Per Call";
+    case NANO_TRANSFER_READ_POOLED:
+        return "Pooled Staging";
+    default:
+        return "Unknown";
+    }
+}
+
+// Size class of a transfer, larger transfers fall in the last class
+static int _nano_transfer_class(size_t size) {
+    int index = 0;
+    size_t limit = (size_t)1 << NANO_TRANSFER_MIN_SHIFT;
+    while (size > limit && index < NANO_TRANSFER_CLASSES - 1) {
+        limit <<= 1;
+        index++;
+    }
+    return index;
+}
+
+// Check if a strategy moves data in the given direction
+static bool _nano_transfer_valid(nano_transfer_dir_t dir,
+                                 nano_transfer_strategy_t strategy) {
+    if (dir == NANO_TRANSFER_UPLOAD) {
+        return strategy == NANO_TRANSFER_QUEUE_WRITE ||
+               strategy == NANO_TRANSFER_MAPPED_AT_CREATION ||
+               strategy == NANO_TRANSFER_STAGING_RING;
+    }
+    return strategy == NANO_TRANSFER_READ_PER_CALL ||
+           strategy == NANO_TRANSFER_READ_POOLED;
+}
+
+// Fastest strategy timed for a size class, NANO_TRANSFER_AUTO if none has
+// been timed often enough
+static nano_transfer_strategy_t _nano_transfer_fastest(nano_transfer_dir_t dir,
+                                                       int index) {
+    nano_transfer_sample_t *samples = nano_app.transfers.samples[dir][index];
+    nano_transfer_strategy_t fastest = NANO_TRANSFER_AUTO;
+    for (int i = 0; i < NANO_TRANSFER_STRATEGY_COUNT; i++) {
+        if (samples[i].count < NANO_TRANSFER_MIN_SAMPLES) {
+            continue;
+        }
+        if (fastest == NANO_TRANSFER_AUTO ||
+            samples[i].gbps > samples[fastest].gbps) {
+            fastest = (nano_transfer_strategy_t)i;
+        }
+    }
+    return fastest;
+}
+
+// Strategy used for a transfer of size bytes
+// A strategy set with nano_transfer_set_strategy() comes first, then the
+// fastest strategy timed for the size class or the closest class that has
+// timings. Until anything is timed, uploads use wgpuQueueWriteBuffer() and
+// readbacks use pooled staging buffers.
+nano_transfer_strategy_t nano_transfer_strategy(nano_transfer_dir_t dir,
+                                                size_t size) {
+    int index = _nano_transfer_class(size);
+    nano_transfer_strategy_t strategy = nano_app.transfers.forced[dir][index];
+    if (strategy != NANO_TRANSFER_AUTO) {
+        return strategy;
+    }
+
+    for (int distance = 0; distance < NANO_TRANSFER_CLASSES; distance++) {
+        if (index - distance >= 0) {
+            strategy = _nano_transfer_fastest(dir, index - distance);
+            if (strategy != NANO_TRANSFER_AUTO) {
+                return strategy;
+            }
+        }
+        if (distance > 0 && index + distance < NANO_TRANSFER_CLASSES) {
+            strategy = _nano_transfer_fastest(dir, index + distance);
+            if (strategy != NANO_TRANSFER_AUTO) {
+                return strategy;
+            }
+        }
+    }
+
+    return dir == NANO_TRANSFER_UPLOAD ? NANO_TRANSFER_QUEUE_WRITE
+                                       : NANO_TRANSFER_READ_POOLED;
+}
+
+// Always use a strategy for the size class that holds size bytes
+// Pass NANO_TRANSFER_AUTO to let the class pick from its timings again.
+int nano_transfer_set_strategy(nano_transfer_dir_t dir, size_t size,
+                               nano_transfer_strategy_t strategy) {
+    if (dir >= NANO_TRANSFER_DIRECTIONS ||
+        (strategy != NANO_TRANSFER_AUTO &&
+         !_nano_transfer_valid(dir, strategy))) {
+        LOG_ERR("NANO: nano_transfer_set_strategy() -> %s can't be used "
+                "for this direction\n",
+                nano_transfer_strategy_name(strategy));
+        return NANO_FAIL;
+    }
+
+    nano_app.transfers.forced[dir][_nano_transfer_class(size)] = strategy;
+    return NANO_OK;
+}
+
+static void _nano_transfer_sample(nano_transfers_t *transfers,
+                                  nano_transfer_dir_t dir,
+                                  nano_transfer_strategy_t strategy,
+                                  size_t size, double ms) {
+    if (dir >= NANO_TRANSFER_DIRECTIONS ||
+        !_nano_transfer_valid(dir, strategy) || ms <= 0.0) {
+        return;
+    }
+
+    nano_transfer_sample_t *sample =
+        &transfers->samples[dir][_nano_transfer_class(size)][strategy];
+    float gbps = (float)((double)size / (ms * 1e6));
+    sample->gbps =
+        sample->count == 0 ? gbps : 0.75f * sample->gbps + 0.25f * gbps;
+    sample->count++;
+}
+
+// Record how long a transfer of size bytes took with a strategy
+// Nano times readbacks and one upload at a time itself, callers can add
+// timings of their own.
+void nano_transfer_record(nano_transfer_dir_t dir,
+                          nano_transfer_strategy_t strategy, size_t size,
+                          double ms) {
+    _nano_transfer_sample(&nano_app.transfers, dir, strategy, size, ms);
+}
+
+// Strategy for an automatic transfer of size bytes
+// Usually nano_transfer_strategy(), but every
+// NANO_TRANSFER_EXPLORE_INTERVAL transfers a class that picks its own
+// strategy tries the one with the fewest timings. Uploads wait for the
+// next one that can be timed.
+static nano_transfer_strategy_t _nano_transfer_pick(nano_transfer_dir_t dir,
+                                                    size_t size) {
+    nano_transfers_t *transfers = &nano_app.transfers;
+    int index = _nano_transfer_class(size);
+    if (transfers->forced[dir][index] != NANO_TRANSFER_AUTO ||
+        ++transfers->picks[dir][index] < NANO_TRANSFER_EXPLORE_INTERVAL ||
+        (dir == NANO_TRANSFER_UPLOAD && transfers->upload_pending)) {
+        return nano_transfer_strategy(dir, size);
+    }
+    transfers->picks[dir][index] = 0;
+
+    nano_transfer_sample_t *samples = transfers->samples[dir][index];
+    nano_transfer_strategy_t least = NANO_TRANSFER_AUTO;
+    for (int i = 0; i < NANO_TRANSFER_STRATEGY_COUNT; i++) {
+        if (!_nano_transfer_valid(dir, (nano_transfer_strategy_t)i)) {
+            continue;
+        }
+        if (least == NANO_TRANSFER_AUTO ||
+            samples[i].count < samples[least].count) {
+            least = (nano_transfer_strategy_t)i;
+        }
+    }
+    return least;
+}
+
+// Called once the queue has finished the upload timed by
+// _nano_transfer_time_upload()
+static void _nano_transfer_upload_cb(WGPUQueueWorkDoneStatus status,
+                                     void *userdata) {
+    // The callback may run while another context is current
+    nano_context_t *ctx = (nano_context_t *)userdata;
+    nano_transfers_t *transfers = &ctx->transfers;
+    transfers->upload_pending = false;
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        return;
+    }
+
+    _nano_transfer_sample(transfers, NANO_TRANSFER_UPLOAD,
+                          transfers->upload_strategy, transfers->upload_size,
+                          wgpu_now() - transfers->upload_start);
+}
+
+// Time an upload until the queue has finished it
+// Only one upload is timed at a time, the others are not recorded.
+static void _nano_transfer_time_upload(nano_transfer_strategy_t strategy,
+                                       size_t size, double start) {
+    nano_transfers_t *transfers = &nano_app.transfers;
+    if (transfers->upload_pending) {
+        return;
+    }
+
+    transfers->upload_pending = true;
+    transfers->upload_strategy = strategy;
+    transfers->upload_size = size;
+    transfers->upload_start = start;
+    wgpuQueueOnSubmittedWorkDone(wgpuDeviceGetQueue(nano_app.wgpu->device),
+                                 _nano_transfer_upload_cb,
+                                 nano_current_context);
+}
+
+// Staging buffers in the pool are rounded up to their size class so they
+// can be reused by transfers of similar sizes
+static size_t _nano_staging_size(size_t size) {
+    size_t rounded = (size_t)1 << NANO_TRANSFER_MIN_SHIFT;
+    while (rounded < size) {
+        rounded <<= 1;
+    }
+    if (rounded > (size_t)1 << (NANO_TRANSFER_MIN_SHIFT +
+                                 NANO_TRANSFER_CLASSES - 1)) {
+        return (size + 3) & ~(size_t)3;
+    }
+    return rounded;
+}
+
+static WGPUBuffer _nano_staging_create(bool upload, size_t size) {
+    WGPUBufferDescriptor desc = {
+        .label = upload ? "Nano Upload Staging Buffer"
+                        : "Nano Readback Staging Buffer",
+        .usage = upload ? WGPUBufferUsage_MapWrite | WGPUBufferUsage_CopySrc
+                        : WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst,
+        .size = size,
+        .mappedAtCreation = upload,
+    };
+    return wgpuDeviceCreateBuffer(nano_app.wgpu->device, &desc);
+}
+
+// Add a busy staging buffer to the pool
+// Returns NULL if the pool is full, the buffer is then used once.
+static nano_staging_buffer_t *_nano_staging_keep(WGPUBuffer buffer,
+                                                 size_t size, bool upload) {
+    nano_transfers_t *transfers = &nano_app.transfers;
+    if (transfers->staging_bytes + size > NANO_STAGING_POOL_BYTES) {
+        return NULL;
+    }
+
+    for (int i = 0; i < NANO_MAX_STAGING_BUFFERS; i++) {
+        nano_staging_buffer_t *staging = &transfers->staging[i];
+        if (staging->state == NANO_STAGING_FREE) {
+            *staging = (nano_staging_buffer_t){
+                .buffer = buffer,
+                .size = size,
+                .upload = upload,
+                .state = NANO_STAGING_BUSY,
+                .generation = staging->generation,
+            };
+            transfers->staging_bytes += size;
+            return staging;
+        }
+    }
+
+    return NULL;
+}
+
+// Take the smallest idle staging buffer of at least size bytes
+static nano_staging_buffer_t *_nano_staging_acquire(bool upload,
+                                                    size_t size) {
+    nano_staging_buffer_t *best = NULL;
+    for (int i = 0; i < NANO_MAX_STAGING_BUFFERS; i++) {
+        nano_staging_buffer_t *staging = &nano_app.transfers.staging[i];
+        if (staging->state != NANO_STAGING_IDLE ||
+            staging->upload != upload || staging->size < size) {
+            continue;
+        }
+        if (best == NULL || staging->size < best->size) {
+            best = staging;
+        }
+    }
+
+    if (best != NULL) {
+        best->state = NANO_STAGING_BUSY;
+    }
+    return best;
+}
+
+static void _nano_staging_drop(nano_staging_buffer_t *staging) {
+    wgpuBufferRelease(staging->buffer);
+    nano_app.transfers.staging_bytes -= staging->size;
+    *staging = (nano_staging_buffer_t){
+        .generation = staging->generation + 1,
+    };
+}
+
+// Release every staging buffer in the pool
+void nano_release_staging_buffers(void) {
+    for (int i = 0; i < NANO_MAX_STAGING_BUFFERS; i++) {
+        nano_staging_buffer_t *staging = &nano_app.transfers.staging[i];
+        if (staging->state != NANO_STAGING_FREE) {
+            _nano_staging_drop(staging);
+        }
+    }
+}
+
+// Map callbacks get the slot index in the low 8 bits of their userdata and
+// the generation of the slot above it
+static void *_nano_staging_userdata(nano_staging_buffer_t *staging) {
+    uintptr_t index = (uintptr_t)(staging - nano_app.transfers.staging);
+    return (void *)(((uintptr_t)staging->generation << 8) | index);
+}
+
+// An upload staging buffer is ready to be written again
+static void _nano_staging_map_callback(WGPUBufferMapAsyncStatus status,
+                                       void *userdata) {
+    nano_staging_buffer_t *staging =
+        &nano_app.transfers.staging[(uintptr_t)userdata & 0xFF];
+
+    // The pool may have been released while the buffer was being mapped,
+    // and the slot may hold a new buffer by now
+    if (staging->buffer == NULL || staging->state != NANO_STAGING_BUSY ||
+        _nano_staging_userdata(staging) != userdata) {
+        return;
+    }
+
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        staging->state = NANO_STAGING_IDLE;
+    } else {
+        _nano_staging_drop(staging);
+    }
+}
+
+// Upload size bytes to a GPU buffer with a transfer strategy
+// Staging strategies need offset and size to be multiples of 4, other
+// uploads use wgpuQueueWriteBuffer(). Must be called on the render thread,
+// nano_write_buffer() can be used from any thread.
+int nano_upload_buffer(WGPUBuffer dst, size_t offset, const void *data,
+                       size_t size, nano_transfer_strategy_t strategy) {
+    if (dst == NULL || data == NULL || size == 0) {
+        LOG_ERR("NANO: nano_upload_buffer() -> Buffer or data is NULL or "
+                "empty\n");
+        return NANO_FAIL;
+    }
+
+    double start = wgpu_now();
+    if (strategy == NANO_TRANSFER_AUTO) {
+        strategy = _nano_transfer_pick(NANO_TRANSFER_UPLOAD, size);
+    }
+    if (!_nano_transfer_valid(NANO_TRANSFER_UPLOAD, strategy)) {
+        LOG_ERR("NANO: nano_upload_buffer() -> %s is not an upload "
+                "strategy\n",
+                nano_transfer_strategy_name(strategy));
+        return NANO_FAIL;
+    }
+
+    // Buffer to buffer copies work in multiples of 4 bytes
+    if (strategy == NANO_TRANSFER_QUEUE_WRITE || (size & 3) || (offset & 3)) {
+        WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+        wgpuQueueWriteBuffer(queue, dst, offset, data, size);
+        _nano_transfer_time_upload(NANO_TRANSFER_QUEUE_WRITE, size, start);
+        return NANO_OK;
+    }
+
+    // The ring reuses a mapped buffer from the pool, a new one is mapped at
+    // creation when none is ready
+    nano_staging_buffer_t *pooled = NULL;
+    WGPUBuffer staging = NULL;
+    if (strategy == NANO_TRANSFER_STAGING_RING) {
+        pooled = _nano_staging_acquire(true, size);
+        if (pooled != NULL) {
+            staging = pooled->buffer;
+        } else {
+            size_t rounded = _nano_staging_size(size);
+            staging = _nano_staging_create(true, rounded);
+            if (staging != NULL) {
+                pooled = _nano_staging_keep(staging, rounded, true);
+            }
+        }
+    } else {
+        staging = _nano_staging_create(true, size);
+    }
+
+    if (staging == NULL) {
+        LOG_ERR("NANO: nano_upload_buffer() -> Could not create a %zu byte "
+                "staging buffer\n",
+                size);
+        return NANO_FAIL;
+    }
+
+    void *mapped = wgpuBufferGetMappedRange(staging, 0, size);
+    if (mapped == NULL) {
+        LOG_ERR("NANO: nano_upload_buffer() -> Staging buffer is not "
+                "mapped\n");
+        if (pooled != NULL) {
+            _nano_staging_drop(pooled);
+        } else {
+            wgpuBufferRelease(staging);
+        }
+        return NANO_FAIL;
+    }
+    memcpy(mapped, data, size);
+    wgpuBufferUnmap(staging);
+
+    int status = nano_copy_buffer_to_buffer(staging, 0, dst, offset, size);
+
+    // Map the ring buffer again right away, the map completes once the
+    // copy is done
+    if (pooled != NULL) {
+        wgpuBufferMapAsync(staging, WGPUMapMode_Write, 0, pooled->size,
+                           _nano_staging_map_callback,
+                           _nano_staging_userdata(pooled));
+    } else {
+        wgpuBufferRelease(staging);
+    }
+
+    if (status == NANO_OK) {
+        _nano_transfer_time_upload(strategy, size, start);
+    }
+    return status;
+}
+
 // Callback to handle the mapped data
 void nano_map_read_callback(WGPUBufferMapAsyncStatus status, void *userdata) {
     if (userdata == NULL) {
@@ -1536,8 +3592,8 @@ void nano_map_read_callback(WGPUBufferMapAsyncStatus status, void *userdata) {
     }
 
     // If the buffer mapping was successful, copy the data to the CPU
+    nano_gpu_data_t *data = (nano_gpu_data_t *)userdata;
     if (status == WGPUBufferMapAsyncStatus_Success) {
-        nano_gpu_data_t *data = (nano_gpu_data_t *)userdata;
         const void *mapped_data = wgpuBufferGetConstMappedRange(
             data->_staging, data->dst_offset, data->size);
 
@@ -1550,8 +3606,9 @@ void nano_map_read_callback(WGPUBufferMapAsyncStatus status, void *userdata) {
         // Copy success!
         LOG("NANO: Copied %zu byte buffer to CPU\n", data->size);
 
-        // Release the staging buffer after the copy operation is complete
-        wgpuBufferRelease(data->_staging);
+        data->latency_ms = wgpu_now() - data->_start;
+        nano_transfer_record(NANO_TRANSFER_READBACK, data->_used, data->size,
+                             data->latency_ms);
 
         // Lock the data so that it will not be overwritten
         // until the developer copies the data out from the
@@ -1560,10 +3617,37 @@ void nano_map_read_callback(WGPUBufferMapAsyncStatus status, void *userdata) {
     } else {
         LOG("NANO: Failed to map buffer for reading.\n");
     }
+
+    // Pooled staging buffers are kept for the next readback, the others
+    // are released after the copy operation is complete
+    if (data->_pooled != NULL) {
+        data->_pooled->state = NANO_STAGING_IDLE;
+        data->_pooled = NULL;
+    } else {
+        wgpuBufferRelease(data->_staging);
+    }
+    data->_staging = NULL;
+}
+
+// Forward declaration, see Thread Safe Command Functions
+int nano_request_readback(nano_gpu_data_t *data, uint32_t buffer_id);
+
+// Give back the staging buffer of a readback that was never mapped
+// Pooled buffers go back to the pool, the others are released.
+static void _nano_readback_abort(nano_gpu_data_t *data) {
+    if (data->_pooled != NULL) {
+        data->_pooled->state = NANO_STAGING_IDLE;
+        data->_pooled = NULL;
+    } else if (data->_staging != NULL) {
+        wgpuBufferRelease(data->_staging);
+    }
+    data->_staging = NULL;
 }
 
 // Copy the contents of a GPU buffer to the CPU
 // This is achieved using a staging buffer to read the data back to the CPU
+// From other threads this queues the copy with nano_request_readback() and
+// the staging descriptor is ignored.
 int nano_copy_buffer_to_cpu(nano_gpu_data_t *data,
                             WGPUBufferDescriptor *staging_desc) {
     if (data == NULL) {
@@ -1575,21 +3659,57 @@ int nano_copy_buffer_to_cpu(nano_gpu_data_t *data,
         return NANO_FAIL;
     }
 
+    // Other threads hand the copy to the render thread
+    if (!nano_is_render_thread()) {
+        return nano_request_readback(data, 0);
+    }
+
     WGPUDevice device = nano_app.wgpu->device;
-    // If the staging descriptor is NULL, we need to create a new staging
-    // buffer with default settings
-    if (staging_desc == NULL) {
-        // Create the staging buffer to read results back to the CPU
-        data->_staging = wgpuDeviceCreateBuffer(
-            device,
-            &(WGPUBufferDescriptor){
+    data->_staging = NULL;
+    data->_pooled = NULL;
+    data->_used = NANO_TRANSFER_READ_PER_CALL;
+    data->_start = wgpu_now();
+
+    nano_transfer_strategy_t strategy = data->strategy;
+    if (strategy == NANO_TRANSFER_AUTO) {
+        strategy = _nano_transfer_pick(NANO_TRANSFER_READBACK, data->size);
+    }
+
+    if (staging_desc != NULL) {
+        // Create the staging buffer with the provided descriptor
+        data->_staging = wgpuDeviceCreateBuffer(device, staging_desc);
+    } else if (strategy == NANO_TRANSFER_READ_POOLED) {
+        // Reuse a staging buffer from the pool, or add a new one to it
+        data->_used = NANO_TRANSFER_READ_POOLED;
+        data->_pooled = _nano_staging_acquire(false, data->size);
+        if (data->_pooled != NULL) {
+            data->_staging = data->_pooled->buffer;
+        } else {
+            size_t rounded = _nano_staging_size(data->size);
+            data->_staging = _nano_staging_create(false, rounded);
+            if (data->_staging != NULL) {
+                data->_pooled =
+                    _nano_staging_keep(data->_staging, rounded, false);
+            }
+        }
+    }
+
+    // If there is no staging buffer yet, we need to create a new one with
+    // default settings
+    if (data->_staging == NULL) {
+        // Create the staging buffer to read results back to the CPU
+        data->_staging = wgpuDeviceCreateBuffer(
+            device,
+            &(WGPUBufferDescriptor){
                 .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
                 .size = data->size,
                 .mappedAtCreation = false,
             });
-    } else {
-        // Create the staging buffer with the provided descriptor
-        data->_staging = wgpuDeviceCreateBuffer(device, staging_desc);
+        if (data->_staging == NULL) {
+            LOG_ERR("NANO: nano_copy_buffer_to_cpu() -> Failed to create "
+                    "staging buffer\n");
+            return NANO_FAIL;
+        }
     }
 
     int status =
@@ -1598,6 +3718,7 @@ int nano_copy_buffer_to_cpu(nano_gpu_data_t *data,
     if (status != NANO_OK) {
         LOG_ERR("NANO: nano_copy_buffer_to_cpu() -> Copy buffer to buffer "
                 "failed\n");
+        _nano_readback_abort(data);
         return NANO_FAIL;
     }
 
@@ -1631,6 +3752,381 @@ int nano_release_gpu_copy(nano_gpu_data_t *data) {
     return NANO_OK;
 }
 
+// Buffer Format Functions
+// -------------------------------------------------
+
+// Job data for converting values with nano_parallel_for()
+typedef struct {
+    nano_format_t format;
+    const void *src;
+    void *dst;
+    size_t count;
+    bool pack;
+} _nano_convert_job_t;
+
+static void _nano_convert_chunks(void *data, uint32_t begin, uint32_t end) {
+    _nano_convert_job_t *job = (_nano_convert_job_t *)data;
+    for (uint32_t i = begin; i < end; i++) {
+        size_t first = (size_t)i * NANO_CONVERT_CHUNK;
+        size_t count = job->count - first;
+        if (count > NANO_CONVERT_CHUNK) {
+            count = NANO_CONVERT_CHUNK;
+        }
+
+        size_t packed = nano_format_size(job->format, first);
+        if (job->pack) {
+            nano_format_pack(job->format, (const float *)job->src + first,
+                             (uint8_t *)job->dst + packed, count);
+        } else {
+            nano_format_unpack(job->format,
+                               (const uint8_t *)job->src + packed,
+                               (float *)job->dst + first, count);
+        }
+    }
+}
+
+// Convert count values between f32 and a format
+// Large conversions are split across the workers.
+static void _nano_convert(nano_format_t format, const void *src, void *dst,
+                          size_t count, bool pack) {
+    if (count <= NANO_CONVERT_CHUNK) {
+        if (pack) {
+            nano_format_pack(format, (const float *)src, dst, count);
+        } else {
+            nano_format_unpack(format, src, (float *)dst, count);
+        }
+        return;
+    }
+
+    _nano_convert_job_t job = {
+        .format = format,
+        .src = src,
+        .dst = dst,
+        .count = count,
+        .pack = pack,
+    };
+    uint32_t chunk_count =
+        (uint32_t)((count + NANO_CONVERT_CHUNK - 1) / NANO_CONVERT_CHUNK);
+    nano_parallel_for(chunk_count, 1, _nano_convert_chunks, &job);
+}
+
+// Set how a buffer stores f32 values
+// The shader has to declare the binding with the matching type, see
+// nano_format.h. This only changes how nano_write_buffer_f32() packs values,
+// the size of the buffer stays the same.
+int nano_buffer_set_format(uint32_t buffer_id, nano_format_t format) {
+    if (format >= NANO_FORMAT_COUNT) {
+        LOG_ERR("NANO: nano_buffer_set_format() -> Invalid format %d\n",
+                format);
+        return NANO_FAIL;
+    }
+
+    nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+    if (buffer == NULL) {
+        LOG_ERR("NANO: nano_buffer_set_format() -> Buffer not found\n");
+        return NANO_FAIL;
+    }
+
+    buffer->format = format;
+    return NANO_OK;
+}
+
+// Write count f32 values to a buffer starting at value first, packed in the
+// buffer's format. Packing f32 data as f16 halves the bytes uploaded.
+// Can be called from any thread, see nano_queue_write_buffer().
+int nano_write_buffer_f32(uint32_t buffer_id, size_t first,
+                          const float *values, size_t count) {
+    if (values == NULL || count == 0) {
+        LOG_ERR("NANO: nano_write_buffer_f32() -> Values are NULL or "
+                "empty\n");
+        return NANO_FAIL;
+    }
+
+    nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+    if (buffer == NULL) {
+        LOG_ERR("NANO: nano_write_buffer_f32() -> Buffer not found\n");
+        return NANO_FAIL;
+    }
+
+    nano_format_t format = buffer->format;
+    if (first % nano_format_info(format)->components != 0) {
+        LOG_ERR("NANO: nano_write_buffer_f32() -> First value %zu does not "
+                "start a %s element\n",
+                first, nano_format_info(format)->name);
+        return NANO_FAIL;
+    }
+
+    size_t offset = nano_format_size(format, first);
+    size_t size = nano_format_size(format, count);
+    if (offset + size > buffer->size) {
+        LOG_ERR("NANO: nano_write_buffer_f32() -> Write of %zu bytes at %zu "
+                "is out of bounds for buffer %s\n",
+                size, offset, nano_atom_str(buffer->label));
+        return NANO_FAIL;
+    }
+
+    // Other threads pack straight into the staged command
+    if (!nano_is_render_thread()) {
+        nano_cmd_t *cmd = (nano_cmd_t *)malloc(sizeof(nano_cmd_t) + size);
+        if (cmd == NULL) {
+            LOG_ERR("NANO: nano_write_buffer_f32() -> Memory allocation "
+                    "failed\n");
+            return NANO_FAIL;
+        }
+
+        *cmd = (nano_cmd_t){
+            .type = NANO_CMD_WRITE_BUFFER,
+            .buffer_id = buffer_id,
+            .offset = offset,
+            .size = size,
+        };
+        _nano_convert(format, values, cmd->data, count, true);
+
+        return _nano_push_cmd(cmd);
+    }
+
+    // Without a device the host copy is the buffer
+    if (!nano_has_gpu()) {
+        uint8_t *host = (uint8_t *)nano_buffer_host(buffer);
+        if (host == NULL) {
+            return NANO_FAIL;
+        }
+        _nano_convert(format, values, host + offset, count, true);
+        return NANO_OK;
+    }
+
+    // The packed copy only has to live until wgpuQueueWriteBuffer() returns
+    nano_arena_mark_t mark = nano_arena_mark(&nano_frame_arena);
+    void *packed = nano_arena_alloc(&nano_frame_arena, size);
+    if (packed == NULL) {
+        LOG_ERR("NANO: nano_write_buffer_f32() -> Memory allocation "
+                "failed\n");
+        return NANO_FAIL;
+    }
+    _nano_convert(format, values, packed, count, true);
+
+    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    wgpuQueueWriteBuffer(queue, buffer->buffer, offset, packed, size);
+    nano_arena_rewind(&nano_frame_arena, mark);
+
+    buffer->gpu_dirty = true;
+    return NANO_OK;
+}
+
+// Unpack count f32 values from data read back with nano_copy_buffer_to_cpu()
+// or nano_request_readback(). format is the format of the source buffer.
+int nano_read_buffer_f32(nano_gpu_data_t *data, nano_format_t format,
+                         float *values, size_t count) {
+    if (data == NULL || values == NULL) {
+        LOG_ERR("NANO: nano_read_buffer_f32() -> Data or values are NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (!atomic_load(&data->locked) || data->data == NULL) {
+        LOG_ERR("NANO: nano_read_buffer_f32() -> Readback is not ready\n");
+        return NANO_FAIL;
+    }
+
+    if (nano_format_size(format, count) > data->size) {
+        LOG_ERR("NANO: nano_read_buffer_f32() -> %zu %s values do not fit "
+                "in %zu bytes\n",
+                count, nano_format_info(format)->name, data->size);
+        return NANO_FAIL;
+    }
+
+    _nano_convert(format, data->data, values, count, false);
+    return NANO_OK;
+}
+
+// Thread Safe Command Functions
+// -------------------------------------------------
+
+// Push a command onto the render thread's command queue
+// This is lock-free and can be called from any thread.
+static int _nano_push_cmd(nano_cmd_t *cmd) {
+    nano_cmd_queue_t *queue = &nano_app.cmd_queue;
+    nano_cmd_t *head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    do {
+        cmd->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+        &queue->head, &head, cmd, memory_order_release, memory_order_relaxed));
+
+    return NANO_OK;
+}
+
+// Stage a write to a buffer from any thread
+// The data is copied, so it can be reused as soon as this returns. The write
+// reaches the GPU when the render thread calls nano_start_frame(), or
+// nano_flush_commands() for a context created with nano_create_context().
+int nano_queue_write_buffer(uint32_t buffer_id, size_t offset,
+                            const void *data, size_t size) {
+    if (data == NULL || size == 0) {
+        LOG_ERR("NANO: nano_queue_write_buffer() -> Data is NULL or empty\n");
+        return NANO_FAIL;
+    }
+
+    nano_cmd_t *cmd = (nano_cmd_t *)malloc(sizeof(nano_cmd_t) + size);
+    if (cmd == NULL) {
+        LOG_ERR("NANO: nano_queue_write_buffer() -> Memory allocation "
+                "failed\n");
+        return NANO_FAIL;
+    }
+
+    *cmd = (nano_cmd_t){
+        .type = NANO_CMD_WRITE_BUFFER,
+        .buffer_id = buffer_id,
+        .offset = offset,
+        .size = size,
+    };
+    memcpy(cmd->data, data, size);
+
+    return _nano_push_cmd(cmd);
+}
+
+// Request a copy of a buffer back to the CPU from any thread
+// If buffer_id is not 0, data->src is taken from that buffer when the
+// request runs, so buffers created off the render thread can be read back.
+// Poll data->locked to know when data->data is ready.
+int nano_request_readback(nano_gpu_data_t *data, uint32_t buffer_id) {
+    if (data == NULL) {
+        LOG_ERR("NANO: nano_request_readback() -> Data is NULL\n");
+        return NANO_FAIL;
+    }
+
+    nano_cmd_t *cmd = (nano_cmd_t *)calloc(1, sizeof(nano_cmd_t));
+    if (cmd == NULL) {
+        LOG_ERR("NANO: nano_request_readback() -> Memory allocation failed\n");
+        return NANO_FAIL;
+    }
+
+    atomic_store(&data->locked, false);
+    cmd->type = NANO_CMD_READBACK;
+    cmd->buffer_id = buffer_id;
+    cmd->readback = data;
+
+    return _nano_push_cmd(cmd);
+}
+
+// Run a single command on the render thread
+static void _nano_run_cmd(nano_cmd_t *cmd) {
+    if (cmd->type == NANO_CMD_RELEASE_BUFFER) {
+        wgpuBufferRelease(cmd->buffer);
+        return;
+    }
+
+    nano_buffer_t *buffer = NULL;
+    if (cmd->buffer_id != 0) {
+        buffer = nano_get_buffer(cmd->buffer_id);
+        if (buffer == NULL) {
+            LOG_ERR("NANO: Buffer %u was released before its queued command "
+                    "ran\n",
+                    cmd->buffer_id);
+            return;
+        }
+    }
+
+    switch (cmd->type) {
+    case NANO_CMD_CREATE_BUFFER: {
+        WGPUBufferDescriptor desc = {
+            .label = nano_atom_str(buffer->label),
+            .usage = cmd->usage,
+            .size = cmd->size,
+            .mappedAtCreation = false,
+        };
+        buffer->buffer = wgpuDeviceCreateBuffer(nano_app.wgpu->device, &desc);
+        if (buffer->buffer == NULL) {
+            LOG_ERR("NANO: Could not create buffer %s\n",
+                    nano_atom_str(buffer->label));
+        }
+        _nano_invalidate_packets();
+        break;
+    }
+    case NANO_CMD_WRITE_BUFFER: {
+        if (cmd->offset + cmd->size > buffer->size) {
+            LOG_ERR("NANO: Queued write of %zu bytes at %zu is out of bounds "
+                    "for buffer %s\n",
+                    cmd->size, cmd->offset, nano_atom_str(buffer->label));
+            break;
+        }
+
+        // Without a device the host copy is the buffer
+        if (!nano_has_gpu()) {
+            uint8_t *host = (uint8_t *)nano_buffer_host(buffer);
+            if (host != NULL) {
+                memcpy(host + cmd->offset, cmd->data, cmd->size);
+            }
+            break;
+        }
+
+        nano_upload_buffer(buffer->buffer, cmd->offset, cmd->data, cmd->size,
+                           NANO_TRANSFER_AUTO);
+
+        // The GPU copy is now newer than the host copy
+        buffer->gpu_dirty = true;
+        nano_app.cmd_queue.last_bytes += cmd->size;
+        break;
+    }
+    case NANO_CMD_READBACK: {
+        nano_gpu_data_t *data = cmd->readback;
+
+        // Without a device the host copy is read directly
+        if (!nano_has_gpu()) {
+            void *host = buffer ? nano_buffer_host(buffer) : NULL;
+            data->data = malloc(data->size);
+            if (host == NULL || data->data == NULL) {
+                LOG_ERR("NANO: Could not read back buffer without a GPU\n");
+                break;
+            }
+            memcpy(data->data, (uint8_t *)host + data->src_offset,
+                   data->size);
+            atomic_store(&data->locked, true);
+            break;
+        }
+
+        if (buffer != NULL) {
+            data->src = buffer->buffer;
+        }
+        nano_copy_buffer_to_cpu(data, NULL);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Run every command queued by other threads in the order they were queued
+// Called by nano_start_frame() on the render thread. Contexts created with
+// nano_create_context() never start a frame, so their render thread must
+// call this itself, otherwise queued work never runs.
+void nano_flush_commands(void) {
+    nano_cmd_queue_t *queue = &nano_app.cmd_queue;
+    queue->last_count = 0;
+    queue->last_bytes = 0;
+
+    nano_cmd_t *list =
+        atomic_exchange_explicit(&queue->head, NULL, memory_order_acquire);
+    if (list == NULL) {
+        return;
+    }
+
+    // The queue is a stack, reverse it to get submission order
+    nano_cmd_t *ordered = NULL;
+    while (list != NULL) {
+        nano_cmd_t *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    while (ordered != NULL) {
+        nano_cmd_t *next = ordered->next;
+        _nano_run_cmd(ordered);
+        free(ordered);
+        queue->last_count++;
+        ordered = next;
+    }
+}
+
 // Shader Pool Functions
 // -------------------------------------------------
 
@@ -1692,8 +4188,8 @@ static int _nano_update_shader_labels() {
     // Concatenate all shader labels into a single string
     for (int i = 0; i < NANO_MAX_SHADERS; i++) {
         if (nano_app.shader_pool.shaders[i].occupied) {
-            char *label =
-                (char *)nano_app.shader_pool.shaders[i].shader_entry.info.label;
+            const char *label = nano_atom_str(
+                nano_app.shader_pool.shaders[i].shader_entry.info.label);
             strncat(labels, label, strlen(label) + 1);
             // Separate the labels with a ? as a placeholder for ImGui \0
             // terminators
@@ -1720,1393 +4216,4912 @@ static int _nano_update_shader_labels() {
     return NANO_OK;
 }
 
-// Empty a shader slot in the shader pool and properly release the shader
-void nano_release_shader(uint32_t shader_id) {
-    assert(&nano_app.shader_pool != NULL);
-    nano_shader_pool_t *table = &nano_app.shader_pool;
+// Uniform Functions
+// -------------------------------------------------
 
-    int index = nano_find_shader_slot(table, shader_id);
-    if (index < 0) {
+// Grow the range of the shadow copy that has to be uploaded
+static void _nano_uniforms_mark_dirty(uint32_t begin, uint32_t end) {
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+    if (uniforms->dirty_end <= uniforms->dirty_begin) {
+        uniforms->dirty_begin = begin;
+        uniforms->dirty_end = end;
         return;
     }
+    if (begin < uniforms->dirty_begin) {
+        uniforms->dirty_begin = begin;
+    }
+    if (end > uniforms->dirty_end) {
+        uniforms->dirty_end = end;
+    }
+}
 
-    nano_shader_t *shader = &table->shaders[index].shader_entry;
+// Find a free range of the shared uniform buffer, returns -1 if it is full
+static int64_t _nano_uniforms_find_space(uint32_t size) {
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+    uint32_t offset = 0;
+
+    // Move past every block that overlaps the candidate range until none do
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        for (int i = 0; i < NANO_MAX_UNIFORM_BLOCKS; i++) {
+            nano_uniform_block_t *block = &uniforms->blocks[i];
+            if (block->shader_id != 0 &&
+                offset < block->offset + block->size &&
+                block->offset < offset + size) {
+                offset = (block->offset + block->size + NANO_UNIFORM_ALIGN -
+                          1) & ~(uint32_t)(NANO_UNIFORM_ALIGN - 1);
+                moved = true;
+            }
+        }
+    }
 
-    // Make sure the node in the table knows it is no longer occupied
-    table->shaders[index].occupied = false;
+    if (offset + size > NANO_UNIFORM_BUFFER_SIZE) {
+        return -1;
+    }
+    return offset;
+}
 
-    if (shader->info.source)
-        free((void *)shader->info.source);
+// Add the members of a reflected struct to a block, flattening nested
+// structs into dotted names
+static void _nano_uniforms_add_members(nano_uniform_block_t *block,
+                                       const nano_wgsl_struct_t *structs,
+                                       const nano_wgsl_struct_t *s,
+                                       const char *prefix, uint32_t base) {
+    for (int i = 0; i < s->member_count; i++) {
+        const nano_wgsl_member_t *m = &s->members[i];
+        if (block->member_count >= NANO_MAX_UNIFORM_MEMBERS) {
+            LOG_ERR("NANO: Shader %u: Too many uniform members in %s\n",
+                    block->shader_id, s->name);
+            return;
+        }
 
-    // Release the pipelines if they exist
-    if (shader->compute_pipeline)
-        wgpuComputePipelineRelease(shader->compute_pipeline);
-    if (shader->render_pipeline)
-        wgpuRenderPipelineRelease(shader->render_pipeline);
+        char name[NANO_MAX_IDENT_LENGTH];
+        snprintf(name, sizeof(name), "%s%s", prefix, m->name);
+        nano_atom_t atom = nano_intern(name);
+        if (atom == 0) {
+            LOG_ERR("NANO: Shader %u: Could not intern uniform member %s\n",
+                    block->shader_id, name);
+            return;
+        }
 
-    // Release the shader modules
-    if (shader->layout.num_layouts > 0) {
-        for (int i = 0; i < shader->layout.num_layouts; i++) {
-            wgpuBindGroupLayoutRelease(shader->layout.bg_layouts[i]);
+        block->members[block->member_count++] = (nano_uniform_member_t){
+            .name = atom,
+            .offset = base + m->offset,
+            .size = m->type.size,
+        };
+
+        if (m->type.scalar == NANO_WGSL_STRUCT && m->type.dim_count == 0) {
+            char nested[NANO_MAX_IDENT_LENGTH];
+            snprintf(nested, sizeof(nested), "%s.", name);
+            _nano_uniforms_add_members(block, structs,
+                                       &structs[m->type.struct_index], nested,
+                                       base + m->offset);
         }
     }
+}
 
-    // Release the buffer objects in the shader bindings
-    for (int i = 0; i < shader->info.binding_count; i++) {
-        nano_binding_info_t binding = shader->info.bindings[i];
-        if (binding.data.buffer)
-            wgpuBufferRelease(binding.data.buffer);
+// Check if a binding is a NanoFrame uniform, see nano_frame_uniforms_t
+static bool _nano_is_frame_binding(const nano_binding_info_t *binding) {
+    nano_atom_t type = nano_find_atom(NANO_FRAME_STRUCT);
+    return type != 0 && binding->data_type == type &&
+           binding->binding == 0 &&
+           (binding->info.buffer_usage & WGPUBufferUsage_Uniform) != 0;
+}
+
+// Create a uniform block for every var<uniform> binding of a shader whose
+// type is a struct declared in the shader, but for NanoFrame which is shared
+// by every shader
+static void _nano_uniforms_create_blocks(nano_shader_t *shader) {
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+
+    // The reflection data is only needed while the blocks are created
+    nano_arena_mark_t mark = nano_arena_mark(&nano_build_arena);
+    nano_wgsl_struct_t *structs = (nano_wgsl_struct_t *)nano_arena_alloc(
+        &nano_build_arena, NANO_REFLECT_MAX_STRUCTS * sizeof(*structs));
+    int struct_count =
+        structs ? nano_reflect_structs(shader->info.source, structs,
+                                       NANO_REFLECT_MAX_STRUCTS)
+                : -1;
+    if (struct_count < 0) {
+        LOG("NANO: Shader %u: Could not reflect the shader structs, named "
+            "uniforms are not available\n",
+            shader->id);
+        nano_arena_rewind(&nano_build_arena, mark);
+        return;
     }
 
-    // Release the vertex buffers if they exist
-    for (int i = 0; i < shader->vertex_buffer_count; i++) {
-        nano_vertex_buffer_t *vertex_buffer = &shader->vertex_buffers[i];
-        int status = nano_release_buffer(vertex_buffer->buffer_id);
-        if (status != NANO_OK) {
-            LOG_ERR("NANO: Shader %u: nano_release_shader() -> Failed to "
-                    "release vertex "
-                    "buffer %d\n",
-                    shader->id, vertex_buffer->buffer_id);
+    for (int i = 0; i < shader->info.binding_count; i++) {
+        nano_binding_info_t *binding = &shader->info.bindings[i];
+        if ((binding->info.buffer_usage & WGPUBufferUsage_Uniform) == 0 ||
+            _nano_is_frame_binding(binding)) {
+            continue;
         }
-    }
 
-    // Create a new empty shader entry at the shader slot
-    table->shaders[index].shader_entry = (nano_shader_t){0};
+        const char *type = nano_atom_str(binding->data_type);
+        const nano_wgsl_struct_t *s = NULL;
+        for (int j = 0; j < struct_count; j++) {
+            if (strcmp(structs[j].name, type) == 0) {
+                s = &structs[j];
+                break;
+            }
+        }
+        if (s == NULL) {
+            continue;
+        }
 
-    // Then decrement the shader count
-    table->shader_count--;
+        nano_uniform_block_t *block = NULL;
+        for (int j = 0; j < NANO_MAX_UNIFORM_BLOCKS; j++) {
+            if (uniforms->blocks[j].shader_id == 0) {
+                block = &uniforms->blocks[j];
+                break;
+            }
+        }
 
-    _nano_update_shader_labels();
-}
+        int64_t offset = _nano_uniforms_find_space(s->size);
+        if (block == NULL || offset < 0) {
+            LOG_ERR("NANO: Shader %u: No space left for uniform block %s\n",
+                    shader->id, nano_atom_str(binding->name));
+            break;
+        }
 
-// Binding functions
-// -------------------------------------------------
+        *block = (nano_uniform_block_t){
+            .shader_id = shader->id,
+            .generation = block->generation,
+            .group = (uint8_t)binding->group,
+            .binding = (uint8_t)binding->binding,
+            .offset = (uint32_t)offset,
+            .size = s->size,
+        };
+        _nano_uniforms_add_members(block, structs, s, "", 0);
 
-// Retrieve a binding from the shader info struct regardless of binding type
-nano_binding_info_t *nano_shader_get_binding(nano_shader_t *shader, int group,
-                                             int binding) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_get_binding() -> Shader info is NULL\n");
-        return NULL;
+        // The range may hold the values of a released block
+        memset(uniforms->shadow + block->offset, 0, block->size);
+        _nano_uniforms_mark_dirty(block->offset, block->offset + block->size);
     }
 
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_shader_get_binding() -> Shader info is NULL\n");
-        return NULL;
-    }
+    nano_arena_rewind(&nano_build_arena, mark);
+}
 
-    int index = info->group_indices[group][binding];
-    if (index == -1) {
-        LOG_ERR("NANO: nano_shader_get_binding() -> Binding not found\n");
-        return NULL;
+// Free the uniform blocks of a shader, invalidating their handles
+static void _nano_uniforms_release_blocks(uint32_t shader_id) {
+    for (int i = 0; i < NANO_MAX_UNIFORM_BLOCKS; i++) {
+        nano_uniform_block_t *block = &nano_app.uniforms.blocks[i];
+        if (block->shader_id == shader_id) {
+            *block = (nano_uniform_block_t){
+                .generation = (uint16_t)(block->generation + 1),
+            };
+        }
     }
+}
 
-    return &info->bindings[index];
+// Return the uniform block for a binding of a shader, NULL if there is none
+static nano_uniform_block_t *_nano_uniforms_find_block(uint32_t shader_id,
+                                                       int group,
+                                                       int binding) {
+    for (int i = 0; i < NANO_MAX_UNIFORM_BLOCKS; i++) {
+        nano_uniform_block_t *block = &nano_app.uniforms.blocks[i];
+        if (block->shader_id == shader_id && block->group == group &&
+            block->binding == binding) {
+            return block;
+        }
+    }
+    return NULL;
 }
 
-// Retrieve a binding from the shader info struct by the name
-// This is useful when working with a shader that we already know the
-// bindings of.
-nano_binding_info_t *nano_get_binding_by_name(nano_shader_t *shader,
-                                              const char *name) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_get_binding_by_name() -> Shader info is NULL\n");
-        return NULL;
+// Return the shared uniform buffer, creating it on first use
+static WGPUBuffer _nano_uniforms_buffer(void) {
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+    if (uniforms->buffer != NULL || !nano_has_gpu()) {
+        return uniforms->buffer;
     }
 
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_get_binding_by_name() -> Shader info is NULL\n");
+    WGPUBufferDescriptor desc = {
+        .label = "Nano Uniforms",
+        .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+        .size = NANO_UNIFORM_BUFFER_SIZE,
+        .mappedAtCreation = false,
+    };
+    uniforms->buffer = wgpuDeviceCreateBuffer(nano_app.wgpu->device, &desc);
+    if (uniforms->buffer == NULL) {
+        LOG_ERR("NANO: Could not create the uniform buffer\n");
         return NULL;
     }
 
-    for (int i = 0; i < info->binding_count; i++) {
-        nano_binding_info_t binding = info->bindings[i];
-        if (strcmp(binding.name, name) == 0) {
-            return &info->bindings[i];
+    // Upload every block that was set before the buffer existed
+    for (int i = 0; i < NANO_MAX_UNIFORM_BLOCKS; i++) {
+        nano_uniform_block_t *block = &uniforms->blocks[i];
+        if (block->shader_id != 0) {
+            _nano_uniforms_mark_dirty(block->offset,
+                                      block->offset + block->size);
         }
     }
 
-    LOG_ERR("NANO: nano_get_binding_by_name() -> Binding \"%s\" not found\n",
-            name);
-    return NULL;
+    return uniforms->buffer;
 }
 
-// Font Methods
-// -----------------------------------------------
+// Upload the dirty range of the uniform shadow copy with a single write
+static void _nano_uniforms_flush(void) {
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+    if (uniforms->dirty_end <= uniforms->dirty_begin ||
+        uniforms->buffer == NULL) {
+        return;
+    }
 
-// Load fonts into the Nano application
-// This overwrites the existing fonts in the Nano app from 0..font_count
-// You should have an array of nano_font_t structs with the font data
-// prepared before calling this function.
-int nano_load_fonts(nano_font_t *fonts, int font_count, float font_size) {
-    if (fonts == NULL) {
-        LOG_ERR("NANO: nano_load_fonts() -> Fonts are NULL\n");
+    // Queue writes must be a multiple of 4 bytes
+    uint32_t begin = uniforms->dirty_begin & ~3u;
+    uint32_t end = (uniforms->dirty_end + 3) & ~3u;
+
+    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    wgpuQueueWriteBuffer(queue, uniforms->buffer, begin,
+                         uniforms->shadow + begin, end - begin);
+
+    uniforms->last_upload = end - begin;
+    uniforms->dirty_begin = 0;
+    uniforms->dirty_end = 0;
+}
+
+// Resolve a uniform member by name so that it can be set without a lookup
+// Nested struct members are named like "light.color".
+// Returns 0 if the shader has no uniform member with that name.
+nano_uniform_t nano_shader_get_uniform(nano_shader_t *shader,
+                                       const char *name) {
+    if (shader == NULL || name == NULL) {
+        LOG_ERR("NANO: nano_shader_get_uniform() -> Invalid arguments\n");
+        return 0;
+    }
+
+    // A name that was never interned cannot belong to any member
+    nano_atom_t atom = nano_find_atom(name);
+    for (int i = 0; atom != 0 && i < NANO_MAX_UNIFORM_BLOCKS; i++) {
+        nano_uniform_block_t *block = &nano_app.uniforms.blocks[i];
+        if (block->shader_id != shader->id) {
+            continue;
+        }
+        for (int j = 0; j < block->member_count; j++) {
+            if (block->members[j].name == atom) {
+                return ((nano_uniform_t)block->generation << 16) |
+                       ((nano_uniform_t)(i + 1) << 8) | (nano_uniform_t)j;
+            }
+        }
+    }
+
+    LOG_ERR("NANO: Shader %u: nano_shader_get_uniform() -> Uniform \"%s\" "
+            "not found\n",
+            shader->id, name);
+    return 0;
+}
+
+// Copy a value into a uniform member
+// The value is only uploaded if it differs from the current value.
+int nano_uniform_set(nano_uniform_t uniform, const void *data, size_t size) {
+    // nano_shader_get_uniform() already reported the failed lookup
+    if (uniform == 0) {
         return NANO_FAIL;
     }
 
-    if (font_count == 0) {
-        LOG_ERR("NANO: nano_load_fonts() -> No fonts to load\n");
+    nano_uniforms_t *uniforms = &nano_app.uniforms;
+    uint32_t generation = uniform >> 16;
+    uint32_t block_index = ((uniform >> 8) & 0xff) - 1;
+    uint32_t member_index = uniform & 0xff;
+    if (block_index >= NANO_MAX_UNIFORM_BLOCKS ||
+        uniforms->blocks[block_index].shader_id == 0 ||
+        uniforms->blocks[block_index].generation != generation ||
+        member_index >= uniforms->blocks[block_index].member_count) {
+        LOG_ERR("NANO: nano_uniform_set() -> Invalid uniform handle\n");
         return NANO_FAIL;
     }
 
-    nano_app.font_info.font_count = font_count;
-    nano_app.font_info.font_size = font_size;
+    nano_uniform_block_t *block = &uniforms->blocks[block_index];
+    nano_uniform_member_t *member = &block->members[member_index];
+    if (size > member->size) {
+        LOG_ERR("NANO: nano_uniform_set() -> %zu bytes do not fit in "
+                "uniform %s\n",
+                size, nano_atom_str(member->name));
+        return NANO_FAIL;
+    }
 
-    // Copy the fonts to the Nano app font info
-    // This will overwrite any existing fonts
-    memcpy(nano_fonts.fonts, fonts, sizeof(nano_font_t) * font_count);
+    uint8_t *dst = uniforms->shadow + block->offset + member->offset;
+    if (memcmp(dst, data, size) == 0) {
+        return NANO_OK;
+    }
 
-    nano_app.font_info.update_fonts = true;
+    memcpy(dst, data, size);
+    uint32_t begin = block->offset + member->offset;
+    _nano_uniforms_mark_dirty(begin, begin + (uint32_t)size);
 
     return NANO_OK;
 }
 
-// Function to set the font for the ImGui context
-void nano_set_font(int index) {
-    if (index < 0 || index >= NANO_MAX_FONTS) {
-        LOG_ERR("NANO: nano_set_font() -> Invalid font index\n");
-        return;
-    }
-
-    LOG("NANO: Setting font to %s\n", nano_app.font_info.fonts[index].name);
+// Set a uniform member by name
+int nano_shader_set_uniform(nano_shader_t *shader, const char *name,
+                            const void *data, size_t size) {
+    return nano_uniform_set(nano_shader_get_uniform(shader, name), data, size);
+}
 
-// Handle the font setting for cimgui
-#ifdef NANO_CIMGUI
-    if (&(nano_app.font_info.fonts[index].imfont) == NULL) {
-        LOG_ERR("NANO: nano_set_font() -> Font is NULL\n");
-        return;
+// Define a typed setter for a uniform handle and one that looks up the
+// member by name, for example:
+// - nano_uniform_set_f32(nano_uniform_t uniform, float value)
+// - nano_shader_set_uniform_f32(nano_shader_t *shader, const char *name,
+//                               float value)
+#define DEFINE_UNIFORM_SETTERS(NAME, T, PTR, SIZE)                             \
+    int nano_uniform_set_##NAME(nano_uniform_t uniform, T value) {             \
+        return nano_uniform_set(uniform, PTR, SIZE);                           \
+    }                                                                          \
+    int nano_shader_set_uniform_##NAME(nano_shader_t *shader,                  \
+                                       const char *name, T value) {            \
+        return nano_uniform_set(nano_shader_get_uniform(shader, name), PTR,    \
+                                SIZE);                                         \
     }
 
-    ImGuiIO *io = igGetIO();
+DEFINE_UNIFORM_SETTERS(f32, float, &value, sizeof(float))
+DEFINE_UNIFORM_SETTERS(i32, int32_t, &value, sizeof(int32_t))
+DEFINE_UNIFORM_SETTERS(u32, uint32_t, &value, sizeof(uint32_t))
+DEFINE_UNIFORM_SETTERS(vec2, const float *, value, 2 * sizeof(float))
+DEFINE_UNIFORM_SETTERS(vec3, const float *, value, 3 * sizeof(float))
+DEFINE_UNIFORM_SETTERS(vec4, const float *, value, 4 * sizeof(float))
+DEFINE_UNIFORM_SETTERS(mat4, const float *, value, 16 * sizeof(float))
 
-    // Set the font as the default font
-    io->FontDefault = nano_app.font_info.fonts[index].imfont;
+// Frame Uniforms
+// -------------------------------------------------
 
-    LOG("NANO: Set font to %s\n",
-        nano_app.font_info.fonts[index].imfont->ConfigData->Name);
-#endif
+// Check if a group of a shader holds nothing but a NanoFrame uniform
+// The group indices must be built, see nano_build_bindings().
+static bool _nano_is_frame_group(const wgpu_shader_info_t *info, int group) {
+    int index = info->group_indices[group][0];
+    if (index < 0 || info->group_indices[group][1] >= 0) {
+        return false;
+    }
+    return _nano_is_frame_binding(&info->bindings[index]);
 }
 
-// Function to initialize the fonts for Nano and the ImGui context
-void nano_init_fonts(nano_font_info_t *font_info, float font_size) {
-    if (font_info->font_count == 0) {
-        LOG("NANO: nano_init_fonts() -> No Custom Fonts Assigned: Using "
-            "Default ImGui Font.\n\t\tDid you forget to define "
-            "NANO_NUM_FONTS "
-            "> 0?");
-        return;
+// Release the NanoFrame buffer, layout and bind group
+static void _nano_frame_group_release(void) {
+    nano_frame_group_t *group = &nano_app.frame_group;
+    if (group->bind_group != NULL) {
+        wgpuBindGroupRelease(group->bind_group);
+        group->bind_group = NULL;
+    }
+    if (group->layout != NULL) {
+        wgpuBindGroupLayoutRelease(group->layout);
+        group->layout = NULL;
     }
+    if (group->buffer != NULL) {
+        wgpuBufferRelease(group->buffer);
+        group->buffer = NULL;
+    }
+}
 
-    // Set the app state font info to whatever is passed in
-    memcpy(&nano_app.font_info, font_info, sizeof(nano_font_info_t));
+// Return the layout shared by every NanoFrame group, creating the buffer,
+// layout and bind group on first use
+static WGPUBindGroupLayout _nano_frame_group_layout(void) {
+    nano_frame_group_t *group = &nano_app.frame_group;
+    if (group->layout != NULL || !nano_has_gpu()) {
+        return group->layout;
+    }
 
-// We only care about the ImFont if we are using cimgui
-#ifdef NANO_CIMGUI
+    WGPUDevice device = nano_app.wgpu->device;
+    group->buffer = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Frame Uniforms",
+                    .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(nano_frame_uniforms_t),
+                    .mappedAtCreation = false,
+                });
+
+    // Visible to every stage so that the one layout fits every pipeline
+    WGPUBindGroupLayoutEntry entry = {
+        .binding = 0,
+        .visibility = WGPUShaderStage_Vertex | WGPUShaderStage_Fragment |
+                      WGPUShaderStage_Compute,
+        .buffer =
+            {
+                .type = WGPUBufferBindingType_Uniform,
+                .minBindingSize = sizeof(nano_frame_uniforms_t),
+            },
+    };
+    group->layout = wgpuDeviceCreateBindGroupLayout(
+        device, &(WGPUBindGroupLayoutDescriptor){
+                    .label = "Nano Frame Layout",
+                    .entryCount = 1,
+                    .entries = &entry,
+                });
+
+    if (group->buffer != NULL && group->layout != NULL) {
+        group->bind_group = wgpuDeviceCreateBindGroup(
+            device, &(WGPUBindGroupDescriptor){
+                        .label = "Nano Frame Bind Group",
+                        .layout = group->layout,
+                        .entryCount = 1,
+                        .entries =
+                            &(WGPUBindGroupEntry){
+                                .binding = 0,
+                                .buffer = group->buffer,
+                                .offset = 0,
+                                .size = sizeof(nano_frame_uniforms_t),
+                            },
+                    });
+    }
+
+    if (group->bind_group == NULL) {
+        LOG_ERR("NANO: Could not create the frame uniforms\n");
+        _nano_frame_group_release();
+        return NULL;
+    }
 
-    ImGuiIO *io = igGetIO();
+    // The values of the current frame, later frames write them in
+    // nano_start_frame()
+    wgpuQueueWriteBuffer(wgpuDeviceGetQueue(device), group->buffer, 0,
+                         &group->values, sizeof(nano_frame_uniforms_t));
 
-    // Make sure to clear the font atlas so we do not leak memory each
-    // time we have to update the fonts for rendering.
-    ImFontAtlas_Clear(io->Fonts);
+    return group->layout;
+}
 
-    // Iterate through the fonts and add them to the font atlas
-    for (int i = 0; i < font_info->font_count; i++) {
-        nano_font_t *cur_font = &nano_app.font_info.fonts[i];
-        cur_font->imfont = ImFontAtlas_AddFontFromMemoryTTF(
-            io->Fonts, (void *)cur_font->ttf, cur_font->ttf_len, font_size,
-            NULL, NULL);
-        strncpy((char *)&cur_font->imfont->ConfigData->Name, cur_font->name,
-                strlen(cur_font->name));
-        LOG("NANO: Added ImGui Font: %s\n", cur_font->imfont->ConfigData->Name);
-    }
-#endif
+// Integer hash with good avalanche, used for the per-frame seed
+static uint32_t _nano_hash_u32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
 
-    // Whenever we reach this point, we can assume that the font size has
-    // been updated
-    nano_app.font_info.update_fonts = false;
+// Update the NanoFrame values and upload them with a single write
+// Called once per frame by nano_start_frame()
+static void _nano_frame_uniforms_update(void) {
+    nano_frame_group_t *group = &nano_app.frame_group;
+    nano_frame_uniforms_t *values = &group->values;
+
+    values->resolution[0] = (float)nano_app.wgpu->width;
+    values->resolution[1] = (float)nano_app.wgpu->height;
+    values->mouse[0] = nano_app.wgpu->mouse_x;
+    values->mouse[1] = nano_app.wgpu->mouse_y;
+    values->time =
+        (float)((wgpu_now() - nano_app.wgpu->startup_time) / 1000.0);
+    values->delta_time = nano_app.frametime / 1000.0f;
+    values->frame = group->frame_count++;
+    values->seed = _nano_hash_u32(values->frame);
+
+    // Nothing to upload until a shader uses the values
+    if (group->buffer == NULL) {
+        return;
+    }
 
-    // Set the default font to the first font in the list (JetBrains Mono
-    // Nerd)
-    nano_set_font(nano_app.font_info.font_index);
+    wgpuQueueWriteBuffer(wgpuDeviceGetQueue(nano_app.wgpu->device),
+                         group->buffer, 0, values,
+                         sizeof(nano_frame_uniforms_t));
 }
 
-// Function to set the font size for the ImGui context
-void nano_set_font_size(float size) {
-    nano_init_fonts(&nano_app.font_info, size); // They do the same thing
+// The NanoFrame values of the current frame, for the CPU side of the app
+const nano_frame_uniforms_t *nano_get_frame_uniforms(void) {
+    return &nano_app.frame_group.values;
 }
 
-// Stats / Telemetry
-// -----------------------------------------------
+// Pipeline Cache
+// -------------------------------------------------
 
-static int _nano_find_shader_slot_with_index(int index) {
-    int count = 0;
+// Hash everything a pipeline of the shader is created from: the source, the
+// entry points, the bind group layouts and, for render pipelines, the vertex
+// layouts and the render target state. Layouts with equal descriptors are
+// interchangeable in WebGPU, so a pipeline can be reused with the layouts of
+// a later build.
+static uint64_t _nano_pipeline_key(nano_shader_t *shader,
+                                   wgsl_shader_type type) {
+    wgpu_shader_info_t *info = &shader->info;
+    uint64_t key = NANO_FNV64_OFFSET;
 
-    for (int i = 0; i < NANO_MAX_SHADERS; i++) {
-        if (nano_app.shader_pool.shaders[i].occupied) {
-            count++;
-        }
+    key = _nano_fnv1a64_bytes(key, &type, sizeof(type));
+    key = _nano_fnv1a64_bytes(key, &info->source_hash,
+                              sizeof(info->source_hash));
 
-        if (index == (count - 1)) {
-            return i;
+    for (int i = 0; i < info->entry_point_count; i++) {
+        nano_entry_t *ep = &info->entry_points[i];
+        if (type == COMPUTE ? ep->type == COMPUTE : ep->type != COMPUTE) {
+            key = _nano_fnv1a64_bytes(key, ep->entry, strlen(ep->entry) + 1);
         }
     }
 
-    return -1;
-}
-
-// Shader Building
-// -----------------------------------------------
+    for (int i = 0; i < info->binding_count; i++) {
+        nano_binding_info_t *binding = &info->bindings[i];
+        int values[4] = {binding->group, binding->binding,
+                         (int)binding->info.buffer_usage,
+                         (int)binding->visibility};
+        key = _nano_fnv1a64_bytes(key, values, sizeof(values));
+    }
 
-int nano_parse_shader(char *source, nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_parse_shader() -> Shader is NULL\n");
-        return NANO_FAIL;
+    if (type == COMPUTE) {
+        return key;
     }
 
-    // Initialize the parser with the shader source code
-    nano_wgsl_parser_t parser;
-    init_parser(&parser, source);
+    for (int i = 0; i < shader->vertex_buffer_count; i++) {
+        nano_vertex_buffer_t *vb = &shader->vertex_buffers[i];
+        WGPUVertexBufferLayout *layout = &vb->vertex_buffer_layout;
+        uint64_t values[2] = {layout->arrayStride, layout->stepMode};
+        key = _nano_fnv1a64_bytes(key, values, sizeof(values));
+        for (size_t j = 0; j < layout->attributeCount; j++) {
+            WGPUVertexAttribute *attr =
+                &shader->vertex_attributes[vb->first_attribute + j];
+            uint64_t attr_values[3] = {attr->format, attr->offset,
+                                       attr->shaderLocation};
+            key = _nano_fnv1a64_bytes(key, attr_values, sizeof(attr_values));
+        }
+    }
 
-    shader->info.binding_count = 0;
-    shader->info.entry_point_count = 0;
+    uint32_t state[3] = {(uint32_t)shader->cull_mode,
+                         nano_app.settings.gfx.msaa.sample_count,
+                         (uint32_t)wgpu_get_color_format()};
+    return _nano_fnv1a64_bytes(key, state, sizeof(state));
+}
 
-    // Parse the shader to get the entry points and binding information
-    // This will populate the shader struct with the necessary information
-    // This shader struct will ultimately be used to store the
-    // ComputePipeline and PipelineLayout objects.
-    parse_shader(&parser, &shader->info);
+// Return the cache entry for a key, counting the hit or miss
+static nano_pipeline_cache_entry_t *_nano_pipeline_cache_find(uint64_t key) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].key == key) {
+            cache->entries[i].hits++;
+            cache->entries[i].last_used = ++cache->clock;
+            cache->hits++;
+            return &cache->entries[i];
+        }
+    }
+    cache->misses++;
+    return NULL;
+}
 
-    // Make sure the shader has at least one entry point
-    if (shader->info.entry_point_count == 0) {
-        LOG_ERR("NANO: nano_parse_shader() -> Shader parsing failed\n");
-        return NANO_FAIL;
+// Check if an occupied shader slot uses a pipeline
+static bool _nano_pipeline_in_use(const void *pipeline) {
+    nano_shader_pool_t *table = &nano_app.shader_pool;
+    for (int i = 0; i < NANO_MAX_SHADERS; i++) {
+        nano_shader_t *shader = &table->shaders[i].shader_entry;
+        if (table->shaders[i].occupied &&
+            ((const void *)shader->compute_pipeline == pipeline ||
+             (const void *)shader->render_pipeline == pipeline)) {
+            return true;
+        }
     }
+    return false;
+}
 
-    return NANO_OK;
+// The pipeline of an entry, entries hold either a compute or a render one
+static const void *_nano_pipeline_cache_pipeline(
+    const nano_pipeline_cache_entry_t *entry) {
+    return entry->compute_pipeline ? (const void *)entry->compute_pipeline
+                                   : (const void *)entry->render_pipeline;
 }
 
-// Build the bindings for the shader and populate the group_indices array
-// group_indices[group][binding] = index @ binding_info[]
-int nano_build_bindings(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_build_bindings() -> Shader is NULL\n");
-        return NANO_FAIL;
+// Release the pipelines of an entry and remove it from the cache
+static void _nano_pipeline_cache_remove(int index) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    nano_pipeline_cache_entry_t *entry = &cache->entries[index];
+    if (entry->compute_pipeline) {
+        wgpuComputePipelineRelease(entry->compute_pipeline);
     }
-
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_build_bindings() -> Shader info is NULL\n");
-        return NANO_FAIL;
+    if (entry->render_pipeline) {
+        wgpuRenderPipelineRelease(entry->render_pipeline);
     }
+    *entry = cache->entries[--cache->count];
+}
 
-    // Iterate through the bindings and assign the index of the binding
-    // to the group_indices array
-    int binding_count = info->binding_count;
+// Make room in a full cache by removing the least recently used entry that
+// no shader uses. Returns false if every entry is in use.
+static bool _nano_pipeline_cache_make_room(void) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    int oldest = -1;
+    for (int i = 0; i < cache->count; i++) {
+        nano_pipeline_cache_entry_t *entry = &cache->entries[i];
+        if (_nano_pipeline_in_use(_nano_pipeline_cache_pipeline(entry))) {
+            continue;
+        }
+        if (oldest < 0 ||
+            entry->last_used < cache->entries[oldest].last_used) {
+            oldest = i;
+        }
+    }
 
-    // If there are no bindings, we can return early
-    if (binding_count == 0) {
-        return NANO_OK;
+    if (oldest < 0) {
+        return false;
     }
+    _nano_pipeline_cache_remove(oldest);
+    return true;
+}
 
-    // This allows us to index our list of bindings by group and binding
-    for (int i = 0; i < binding_count; i++) {
-        nano_binding_info_t binding = info->bindings[i];
-        info->group_indices[binding.group][binding.binding] = i;
+// Hand a new pipeline to the cache. Returns false if the cache has no room
+// or already has the key, the caller keeps ownership of the pipeline then.
+static bool _nano_pipeline_cache_insert(uint64_t key,
+                                        WGPUComputePipeline compute_pipeline,
+                                        WGPURenderPipeline render_pipeline) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    if (compute_pipeline == NULL && render_pipeline == NULL) {
+        return false;
+    }
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].key == key) {
+            return false;
+        }
+    }
+    if (cache->count >= NANO_PIPELINE_CACHE_SIZE &&
+        !_nano_pipeline_cache_make_room()) {
+        return false;
     }
 
-    return NANO_OK;
+    cache->entries[cache->count++] = (nano_pipeline_cache_entry_t){
+        .key = key,
+        .compute_pipeline = compute_pipeline,
+        .render_pipeline = render_pipeline,
+        .last_used = ++cache->clock,
+    };
+    return true;
 }
 
-// Build a pipeline layout for the shader using the bindings in the shader
-// a shader must have buffer data assigned to it before calling this
-// function. The buffer data can be assigned using
-// nano_shader_assign_buffer_data(). If no buffer data is assigned, but
-// buffer data is expected, the method will return NANO_FAIL.
-int nano_build_pipeline_layout(nano_shader_t *shader) {
-
-    if (shader == NULL) {
-        LOG_ERR("Nano: nano_build_pipeline_layout() -> Shader is NULL\n");
-        return NANO_FAIL;
+// Check if a pipeline belongs to the cache, shaders must not release those
+static bool _nano_pipeline_cache_owns(const void *pipeline) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    for (int i = 0; pipeline != NULL && i < cache->count; i++) {
+        if ((const void *)cache->entries[i].compute_pipeline == pipeline ||
+            (const void *)cache->entries[i].render_pipeline == pipeline) {
+            return true;
+        }
     }
+    return false;
+}
 
-    wgpu_shader_info_t *info = &shader->info;
-
-    if (info == NULL) {
-        LOG_ERR("Nano: nano_build_pipeline_layout() -> Compute info is NULL\n");
-        return NANO_FAIL;
+// Release a shader's pipelines, but for those owned by the cache
+static void _nano_shader_release_pipelines(nano_shader_t *shader) {
+    if (shader->compute_pipeline &&
+        !_nano_pipeline_cache_owns(shader->compute_pipeline)) {
+        wgpuComputePipelineRelease(shader->compute_pipeline);
     }
+    if (shader->render_pipeline &&
+        !_nano_pipeline_cache_owns(shader->render_pipeline)) {
+        wgpuRenderPipelineRelease(shader->render_pipeline);
+    }
+    shader->compute_pipeline = NULL;
+    shader->render_pipeline = NULL;
+}
 
-    int num_groups = 0;
+// Evict the cached pipelines of a released shader that no other shader
+// uses. Pipelines the shader stopped using when it was rebuilt stay cached
+// until they are the least recently used. The released shader must not be
+// in an occupied slot.
+static void _nano_pipeline_cache_evict(nano_shader_t *released) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    for (int i = cache->count - 1; i >= 0; i--) {
+        const void *pipeline =
+            _nano_pipeline_cache_pipeline(&cache->entries[i]);
+        if (pipeline != (const void *)released->compute_pipeline &&
+            pipeline != (const void *)released->render_pipeline) {
+            continue;
+        }
+        if (_nano_pipeline_in_use(pipeline)) {
+            continue;
+        }
 
-    // Create an array of bind group layouts for each group
-    WGPUBindGroupLayout bg_layouts[NANO_MAX_GROUPS];
-    if (info->binding_count >= NANO_MAX_GROUPS * NANO_GROUP_MAX_BINDINGS) {
-        LOG_ERR("NANO: Shader %u: Too many bindings\n", info->id);
-        return NANO_FAIL;
+        if ((const void *)released->compute_pipeline == pipeline) {
+            released->compute_pipeline = NULL;
+        }
+        if ((const void *)released->render_pipeline == pipeline) {
+            released->render_pipeline = NULL;
+        }
+        _nano_pipeline_cache_remove(i);
     }
+}
 
-    // Initialize the group binding indices array to -1
-    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
-        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
-            info->group_indices[i][j] = -1;
+// Release every cached pipeline, called when the device goes away
+static void _nano_pipeline_cache_release(void) {
+    nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+    for (int i = 0; i < cache->count; i++) {
+        if (cache->entries[i].compute_pipeline) {
+            wgpuComputePipelineRelease(cache->entries[i].compute_pipeline);
+        }
+        if (cache->entries[i].render_pipeline) {
+            wgpuRenderPipelineRelease(cache->entries[i].render_pipeline);
         }
     }
+    cache->count = 0;
+}
 
-    // If a group has bindings, we must mark the bindings in the group
-    // to be non-negative
+// The pipeline cache and its hit and miss counts
+const nano_pipeline_cache_t *nano_get_pipeline_cache(void) {
+    return &nano_app.pipeline_cache;
+}
+
+// Empty a shader slot in the shader pool and properly release the shader
+void nano_release_shader(uint32_t shader_id) {
+    assert(&nano_app.shader_pool != NULL);
+    nano_shader_pool_t *table = &nano_app.shader_pool;
+
+    int index = nano_find_shader_slot(table, shader_id);
+    if (index < 0) {
+        return;
+    }
+
+    nano_shader_t *shader = &table->shaders[index].shader_entry;
+
+    // Make sure the node in the table knows it is no longer occupied
+    table->shaders[index].occupied = false;
+
+    if (shader->info.source)
+        free((void *)shader->info.source);
+
+    // Release the pipelines if they exist, cached ones stay in the cache
+    // while another shader uses them
+    _nano_pipeline_cache_evict(shader);
+    _nano_shader_release_pipelines(shader);
+
+    // Release the shader modules, the NanoFrame layout is shared
+    if (shader->layout.num_layouts > 0) {
+        for (int i = 0; i < shader->layout.num_layouts; i++) {
+            if (shader->layout.bg_layouts[i] != nano_app.frame_group.layout) {
+                wgpuBindGroupLayoutRelease(shader->layout.bg_layouts[i]);
+            }
+        }
+    }
+
+    // Release the bind groups, the NanoFrame bind group is shared
+    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+        if (shader->bind_groups[i] != NULL &&
+            shader->bind_groups[i] != nano_app.frame_group.bind_group) {
+            wgpuBindGroupRelease(shader->bind_groups[i]);
+        }
+    }
+
+    // The buffers in the bindings belong to the buffer pool, which
+    // releases them in nano_release_buffer()
+    for (int i = 0; i < shader->info.binding_count; i++) {
+        shader->info.bindings[i].data.buffer = NULL;
+    }
+
+    // Release the vertex buffers if they exist, the buffers of a mesh are
+    // only borrowed and released by nano_release_mesh()
+    for (int i = 0; i < shader->vertex_buffer_count; i++) {
+        nano_vertex_buffer_t *vertex_buffer = &shader->vertex_buffers[i];
+        if (vertex_buffer->borrowed) {
+            continue;
+        }
+        int status = nano_release_buffer(vertex_buffer->buffer_id);
+        if (status != NANO_OK) {
+            LOG_ERR("NANO: Shader %u: nano_release_shader() -> Failed to "
+                    "release vertex "
+                    "buffer %d\n",
+                    shader->id, vertex_buffer->buffer_id);
+        }
+    }
+
+    // The index buffer is owned by the shader like the vertex buffers
+    if (shader->index_buffer != 0 && !shader->index_borrowed) {
+        nano_release_buffer(shader->index_buffer);
+    }
+
+    _nano_uniforms_release_blocks(shader->id);
+
+    // Create a new empty shader entry at the shader slot
+    table->shaders[index].shader_entry = (nano_shader_t){0};
+    _nano_invalidate_packets();
+
+    // Then decrement the shader count
+    table->shader_count--;
+
+    _nano_update_shader_labels();
+}
+
+// Binding functions
+// -------------------------------------------------
+
+// Retrieve a binding from the shader info struct regardless of binding type
+nano_binding_info_t *nano_shader_get_binding(nano_shader_t *shader, int group,
+                                             int binding) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_get_binding() -> Shader info is NULL\n");
+        return NULL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_shader_get_binding() -> Shader info is NULL\n");
+        return NULL;
+    }
+
+    int index = info->group_indices[group][binding];
+    if (index == -1) {
+        LOG_ERR("NANO: nano_shader_get_binding() -> Binding not found\n");
+        return NULL;
+    }
+
+    return &info->bindings[index];
+}
+
+// Retrieve a binding from the shader info struct by the name
+// This is useful when working with a shader that we already know the
+// bindings of.
+nano_binding_info_t *nano_get_binding_by_name(nano_shader_t *shader,
+                                              const char *name) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_get_binding_by_name() -> Shader info is NULL\n");
+        return NULL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_get_binding_by_name() -> Shader info is NULL\n");
+        return NULL;
+    }
+
+    // A name that was never interned cannot belong to any binding
+    nano_atom_t atom = nano_find_atom(name);
+    for (int i = 0; atom != 0 && i < info->binding_count; i++) {
+        if (info->bindings[i].name == atom) {
+            return &info->bindings[i];
+        }
+    }
+
+    LOG_ERR("NANO: nano_get_binding_by_name() -> Binding \"%s\" not found\n",
+            name);
+    return NULL;
+}
+
+// Font Methods
+// -----------------------------------------------
+
+// Load fonts into the Nano application
+// This overwrites the existing fonts in the Nano app from 0..font_count
+// You should have an array of nano_font_t structs with the font data
+// prepared before calling this function.
+int nano_load_fonts(nano_font_t *fonts, int font_count, float font_size) {
+    if (fonts == NULL) {
+        LOG_ERR("NANO: nano_load_fonts() -> Fonts are NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (font_count == 0) {
+        LOG_ERR("NANO: nano_load_fonts() -> No fonts to load\n");
+        return NANO_FAIL;
+    }
+
+    nano_app.font_info.font_count = font_count;
+    nano_app.font_info.font_size = font_size;
+
+    // Copy the fonts to the Nano app font info
+    // This will overwrite any existing fonts
+    memcpy(nano_fonts.fonts, fonts, sizeof(nano_font_t) * font_count);
+
+    nano_app.font_info.update_fonts = true;
+
+    return NANO_OK;
+}
+
+// Function to set the font for the ImGui context
+void nano_set_font(int index) {
+    if (index < 0 || index >= NANO_MAX_FONTS) {
+        LOG_ERR("NANO: nano_set_font() -> Invalid font index\n");
+        return;
+    }
+
+    LOG("NANO: Setting font to %s\n", nano_app.font_info.fonts[index].name);
+
+// Handle the font setting for cimgui
+#ifdef NANO_CIMGUI
+    if (&(nano_app.font_info.fonts[index].imfont) == NULL) {
+        LOG_ERR("NANO: nano_set_font() -> Font is NULL\n");
+        return;
+    }
+
+    ImGuiIO *io = igGetIO();
+
+    // Set the font as the default font
+    io->FontDefault = nano_app.font_info.fonts[index].imfont;
+
+    LOG("NANO: Set font to %s\n",
+        nano_app.font_info.fonts[index].imfont->ConfigData->Name);
+#endif
+}
+
+// Function to initialize the fonts for Nano and the ImGui context
+void nano_init_fonts(nano_font_info_t *font_info, float font_size) {
+    if (font_info == NULL || font_info->font_count == 0) {
+        LOG("NANO: nano_init_fonts() -> No Custom Fonts Assigned: Using "
+            "Default ImGui Font.\n\t\tDid you forget to define "
+            "NANO_NUM_FONTS "
+            "> 0?");
+        return;
+    }
+
+    // Set the app state font info to whatever is passed in
+    memcpy(&nano_app.font_info, font_info, sizeof(nano_font_info_t));
+
+// We only care about the ImFont if we are using cimgui
+#ifdef NANO_CIMGUI
+
+    // ImGui is created on first use with ui_on_demand, the fonts are loaded
+    // then
+    if (nano_cimgui_get_backend_data() == NULL) {
+        nano_app.font_info.font_size = font_size;
+        nano_app.fonts_deferred = true;
+        return;
+    }
+
+    ImGuiIO *io = igGetIO();
+
+    // Make sure to clear the font atlas so we do not leak memory each
+    // time we have to update the fonts for rendering.
+    ImFontAtlas_Clear(io->Fonts);
+
+    // Iterate through the fonts and add them to the font atlas
+    for (int i = 0; i < font_info->font_count; i++) {
+        nano_font_t *cur_font = &nano_app.font_info.fonts[i];
+        cur_font->imfont = ImFontAtlas_AddFontFromMemoryTTF(
+            io->Fonts, (void *)cur_font->ttf, cur_font->ttf_len, font_size,
+            NULL, NULL);
+        strncpy((char *)&cur_font->imfont->ConfigData->Name, cur_font->name,
+                strlen(cur_font->name));
+        LOG("NANO: Added ImGui Font: %s\n", cur_font->imfont->ConfigData->Name);
+    }
+
+    // The font texture is uploaded again with the new atlas
+    nano_cimgui_invalidate_device_objects();
+#endif
+
+    // Whenever we reach this point, we can assume that the font size has
+    // been updated
+    nano_app.font_info.update_fonts = false;
+
+    // Set the default font to the first font in the list (JetBrains Mono
+    // Nerd)
+    nano_set_font(nano_app.font_info.font_index);
+}
+
+// Function to set the font size for the ImGui context
+void nano_set_font_size(float size) {
+    nano_init_fonts(&nano_app.font_info, size); // They do the same thing
+}
+
+// Startup Timeline
+// -----------------------------------------------
+
+// Phases of the startup recorded so far, in milliseconds since
+// nano_start_app(). end is negative for phases still running.
+const wgpu_startup_event_t *nano_get_startup_events(int *count) {
+    wgpu_state_t *wgpu = wgpu_get_state();
+    if (count != NULL) {
+        *count = wgpu->startup_event_count;
+    }
+    return wgpu->startup_events;
+}
+
+// Close the startup timeline and log it, called on the first frame.
+// Pipelines compiling asynchronously are logged as pending.
+void nano_log_startup_timeline(void) {
+    int event = wgpu_startup_begin("first frame", NULL);
+    wgpu_startup_end(event);
+    wgpu_startup_close();
+
+    int count = 0;
+    const wgpu_startup_event_t *events = nano_get_startup_events(&count);
+
+    LOG("NANO: Startup timeline, ms since nano_start_app()\n");
+    LOG("NANO: %9s %9s %9s  %s\n", "start", "end", "duration", "phase");
+    for (int i = 0; i < count; i++) {
+        const wgpu_startup_event_t *e = &events[i];
+        if (e->end < 0.0) {
+            LOG("NANO: %9.2f %9s %9s  %s %s\n", e->start, "pending", "",
+                e->phase, e->label ? e->label : "");
+        } else {
+            LOG("NANO: %9.2f %9.2f %9.2f  %s %s\n", e->start, e->end,
+                e->end - e->start, e->phase, e->label ? e->label : "");
+        }
+    }
+}
+
+// Stats / Telemetry
+// -----------------------------------------------
+
+static int _nano_find_shader_slot_with_index(int index) {
+    int count = 0;
+
+    for (int i = 0; i < NANO_MAX_SHADERS; i++) {
+        if (nano_app.shader_pool.shaders[i].occupied) {
+            count++;
+        }
+
+        if (index == (count - 1)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Shader Building
+// -----------------------------------------------
+
+int nano_parse_shader(char *source, nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_parse_shader() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    // Initialize the parser with the shader source code
+    nano_wgsl_parser_t parser;
+    init_parser(&parser, source);
+
+    shader->info.binding_count = 0;
+    shader->info.entry_point_count = 0;
+
+    // Parse the shader to get the entry points and binding information
+    // This will populate the shader struct with the necessary information
+    // This shader struct will ultimately be used to store the
+    // ComputePipeline and PipelineLayout objects.
+    parse_shader(&parser, &shader->info);
+
+    // Make sure the shader has at least one entry point
+    if (shader->info.entry_point_count == 0) {
+        LOG_ERR("NANO: nano_parse_shader() -> Shader parsing failed\n");
+        return NANO_FAIL;
+    }
+
+    return NANO_OK;
+}
+
+// Build the bindings for the shader and populate the group_indices array
+// group_indices[group][binding] = index @ binding_info[]
+int nano_build_bindings(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_build_bindings() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_build_bindings() -> Shader info is NULL\n");
+        return NANO_FAIL;
+    }
+
+    // Iterate through the bindings and assign the index of the binding
+    // to the group_indices array
+    int binding_count = info->binding_count;
+
+    // If there are no bindings, we can return early
+    if (binding_count == 0) {
+        return NANO_OK;
+    }
+
+    // This allows us to index our list of bindings by group and binding
+    for (int i = 0; i < binding_count; i++) {
+        nano_binding_info_t *binding = &info->bindings[i];
+        info->group_indices[binding->group][binding->binding] = i;
+    }
+
+    return NANO_OK;
+}
+
+// Build a pipeline layout for the shader using the bindings in the shader
+// a shader must have buffer data assigned to it before calling this
+// function. The buffer data can be assigned using
+// nano_shader_assign_buffer_data(). If no buffer data is assigned, but
+// buffer data is expected, the method will return NANO_FAIL.
+int nano_build_pipeline_layout(nano_shader_t *shader) {
+
+    if (shader == NULL) {
+        LOG_ERR("Nano: nano_build_pipeline_layout() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+
+    if (info == NULL) {
+        LOG_ERR("Nano: nano_build_pipeline_layout() -> Compute info is NULL\n");
+        return NANO_FAIL;
+    }
+
+    int num_groups = 0;
+
+    // Create an array of bind group layouts for each group
+    WGPUBindGroupLayout bg_layouts[NANO_MAX_GROUPS];
+    if (info->binding_count >= NANO_MAX_GROUPS * NANO_GROUP_MAX_BINDINGS) {
+        LOG_ERR("NANO: Shader %u: Too many bindings\n", info->id);
+        return NANO_FAIL;
+    }
+
+    // Initialize the group binding indices array to -1
+    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
+            info->group_indices[i][j] = -1;
+        }
+    }
+
+    // If a group has bindings, we must mark the bindings in the group
+    // to be non-negative
     int status = nano_build_bindings(shader);
     if (status != NANO_OK) {
-        LOG_ERR("NANO: Shader %u: Could not build bindings\n", info->id);
+        LOG_ERR("NANO: Shader %u: Could not build bindings\n", info->id);
+        return NANO_FAIL;
+    }
+
+    // Iterate through the groups and create the bind group layout
+    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+
+        // Bind group layout entries for the group
+        WGPUBindGroupLayoutEntry bgl_entries[NANO_GROUP_MAX_BINDINGS];
+        int num_bindings = 0;
+
+        // Iterate through the bindings in the group and create the bind
+        // group layout entries
+        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
+            int index = info->group_indices[i][j];
+
+            // If the index is -1, we can break out of the loop early since
+            // we can assume that there are no more bindings in the group
+            if (index == -1) {
+                break;
+            }
+
+            // Get the binding information from the shaderinfo struct
+            nano_binding_info_t *binding =
+                &info->bindings[info->group_indices[i][j]];
+            WGPUBufferUsageFlags buffer_usage = binding->info.buffer_usage;
+
+            // The binding type is inferred from the binding usage. Storage
+            // buffers without write access, var<storage> and
+            // var<storage, read>, are read-only.
+            WGPUBufferBindingType type = WGPUBufferBindingType_Storage;
+            if ((buffer_usage & WGPUBufferUsage_Uniform) != 0) {
+                type = WGPUBufferBindingType_Uniform;
+            } else if ((buffer_usage & WGPUBufferUsage_CopyDst) == 0) {
+                type = WGPUBufferBindingType_ReadOnlyStorage;
+            }
+
+            // Set the according bindgroup layout entry for the
+            // binding, visible only to the stages that use it
+            bgl_entries[j] = (WGPUBindGroupLayoutEntry){
+                .binding = (uint32_t)binding->binding,
+                .visibility = binding->visibility,
+                .buffer = {.type = type},
+            };
+
+            num_bindings++;
+        } // Middle level (j) for-loop
+
+        // BINDGROUP LAYOUT CREATION
+        WGPUBindGroupLayoutDescriptor bg_layout_desc = {
+            .entryCount = (size_t)num_bindings,
+            .entries = bgl_entries,
+        };
+
+        // Every NanoFrame group uses the same layout
+        if (num_bindings != 0 && _nano_is_frame_group(info, i)) {
+            bg_layouts[i] = _nano_frame_group_layout();
+            if (bg_layouts[i] == NULL) {
+                return NANO_FAIL;
+            }
+            num_groups++;
+        } else if (num_bindings != 0) {
+            LOG("NANO: Shader %u: Creating bind group layout for group "
+                "%d with %d entries\n",
+                info->id, num_groups, num_bindings);
+
+            // Assign the bind group layout to the bind group layout
+            // array so that we can create the
+            // WGPUPipelineLayoutDescriptor later.
+            bg_layouts[i] = wgpuDeviceCreateBindGroupLayout(
+                nano_app.wgpu->device, &bg_layout_desc);
+            if (bg_layouts[i] == NULL) {
+                LOG_ERR("NANO: Shader %u: Could not create bind group "
+                        "layout for group %d\n",
+                        info->id, num_groups);
+                return NANO_FAIL;
+            }
+
+            num_groups++;
+        } else {
+            // If there are no bindings in the group, we can break out of
+            // the loop early
+            break;
+        }
+
+    } // Top level (i) for-loop
+
+    // Release the layouts of a previous build
+    for (int i = 0; i < shader->layout.num_layouts; i++) {
+        if (shader->layout.bg_layouts[i] != nano_app.frame_group.layout) {
+            wgpuBindGroupLayoutRelease(shader->layout.bg_layouts[i]);
+        }
+    }
+
+    // Assign the number of layouts to the output layout
+    shader->layout.num_layouts = num_groups;
+    if (num_groups > 0) {
+        LOG("NANO: Shader %u: Created %d bind group layouts\n", info->id,
+            num_groups);
+    }
+
+    // Copy the bind group layouts to the output layout
+    memcpy(shader->layout.bg_layouts, &bg_layouts, sizeof(bg_layouts));
+
+    return NANO_OK;
+}
+
+// Build the shader pipelines for the shader
+// If the shader has multiple entry points, we can build multiple pipelines
+// The renderpipeline depends on the vertex and fragment entry points
+// The computepipeline depends on the compute entry point
+// A pipeline compiled with wgpuDeviceCreate*PipelineAsync()
+typedef struct {
+    uint32_t shader_id;
+    uint32_t request;
+    int event;
+    uint64_t key;
+} _nano_pipeline_request_t;
+
+// Counts every pipeline build so late results of older builds are dropped
+static uint32_t _nano_pipeline_requests = 0;
+
+// Start an asynchronous pipeline compile for the shader's current build.
+// Returns NULL to compile synchronously instead.
+static _nano_pipeline_request_t *
+_nano_pipeline_request(nano_shader_t *shader, uint64_t key) {
+    // Only the pipelines built before the first frame with fast_start
+    if (!nano_app.wgpu->desc.fast_start || nano_app.wgpu->startup_closed) {
+        return NULL;
+    }
+
+    _nano_pipeline_request_t *request =
+        (_nano_pipeline_request_t *)malloc(sizeof(_nano_pipeline_request_t));
+    if (request == NULL) {
+        return NULL;
+    }
+
+    *request = (_nano_pipeline_request_t){
+        .shader_id = shader->id,
+        .request = shader->pipeline_request,
+        .event = wgpu_startup_begin("pipeline",
+                                    nano_atom_str(shader->info.label)),
+        .key = key,
+    };
+    shader->pending_pipelines++;
+    return request;
+}
+
+// Return the shader a compiled pipeline belongs to, or NULL if the shader
+// was released or rebuilt since the pipeline was requested
+static nano_shader_t *
+_nano_pipeline_request_done(_nano_pipeline_request_t *request) {
+    wgpu_startup_end(request->event);
+
+    nano_shader_t *shader = nano_get_shader(request->shader_id);
+    if (shader != NULL && shader->pipeline_request != request->request) {
+        shader = NULL;
+    }
+    free(request);
+
+    if (shader != NULL) {
+        shader->pending_pipelines--;
+        _nano_invalidate_packets();
+    }
+    return shader;
+}
+
+static void _nano_compute_pipeline_cb(WGPUCreatePipelineAsyncStatus status,
+                                      WGPUComputePipeline pipeline,
+                                      const char *message, void *userdata) {
+    _nano_pipeline_request_t *request = (_nano_pipeline_request_t *)userdata;
+    uint32_t shader_id = request->shader_id;
+    uint64_t key = request->key;
+    nano_shader_t *shader = _nano_pipeline_request_done(request);
+
+    if (status != WGPUCreatePipelineAsyncStatus_Success) {
+        LOG_ERR("NANO: Shader %u: Could not create the compute pipeline: %s\n",
+                shader_id, message ? message : "");
+        return;
+    }
+
+    // Nothing would hit the entry of a released or rebuilt shader
+    if (shader == NULL) {
+        wgpuComputePipelineRelease(pipeline);
+        return;
+    }
+    _nano_pipeline_cache_insert(key, pipeline, NULL);
+    shader->compute_pipeline = pipeline;
+    LOG("NANO: Shader %u: Created Compute Pipeline\n", shader_id);
+}
+
+static void _nano_render_pipeline_cb(WGPUCreatePipelineAsyncStatus status,
+                                     WGPURenderPipeline pipeline,
+                                     const char *message, void *userdata) {
+    _nano_pipeline_request_t *request = (_nano_pipeline_request_t *)userdata;
+    uint32_t shader_id = request->shader_id;
+    uint64_t key = request->key;
+    nano_shader_t *shader = _nano_pipeline_request_done(request);
+
+    if (status != WGPUCreatePipelineAsyncStatus_Success) {
+        LOG_ERR("NANO: Shader %u: Could not create the render pipeline: %s\n",
+                shader_id, message ? message : "");
+        return;
+    }
+
+    // Nothing would hit the entry of a released or rebuilt shader
+    if (shader == NULL) {
+        wgpuRenderPipelineRelease(pipeline);
+        return;
+    }
+    _nano_pipeline_cache_insert(key, NULL, pipeline);
+    shader->render_pipeline = pipeline;
+    LOG("NANO: Shader %u: Created Render Pipeline\n", shader_id);
+}
+
+int nano_build_shader_pipelines(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_build_shader_pipelines() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+
+    // Pipelines of earlier builds that are still compiling are dropped
+    shader->pipeline_request = ++_nano_pipeline_requests;
+    shader->pending_pipelines = 0;
+
+    int retval = NANO_OK;
+    int compute_index = info->entry_indices.compute;
+    int vertex_index = info->entry_indices.vertex;
+    int fragment_index = info->entry_indices.fragment;
+
+    // The pipelines of the last build, or of another shader with the same
+    // source and state, are reused from the pipeline cache
+    _nano_shader_release_pipelines(shader);
+
+    // Packets copy the pipelines, so the shader's packet is stale now
+    _nano_invalidate_packets();
+
+    uint64_t compute_key = 0;
+    uint64_t render_key = 0;
+    nano_pipeline_cache_entry_t *compute_hit = NULL;
+    nano_pipeline_cache_entry_t *render_hit = NULL;
+    if (compute_index != -1) {
+        compute_key = _nano_pipeline_key(shader, COMPUTE);
+        compute_hit = _nano_pipeline_cache_find(compute_key);
+    }
+    if (vertex_index != -1 && fragment_index != -1) {
+        render_key = _nano_pipeline_key(shader, VERTEX);
+        render_hit = _nano_pipeline_cache_find(render_key);
+    }
+
+    // Take the hits right away, so making room for the other pipeline
+    // can't evict them
+    if (compute_hit != NULL) {
+        shader->compute_pipeline = compute_hit->compute_pipeline;
+    }
+    if (render_hit != NULL) {
+        shader->render_pipeline = render_hit->render_pipeline;
+    }
+    bool compile = (compute_index != -1 && compute_hit == NULL) ||
+                   (render_key != 0 && render_hit == NULL);
+
+    // Create the pipeline layout descriptor
+    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
+        .label = nano_atom_str(info->label),
+        .bindGroupLayoutCount = shader->layout.num_layouts,
+        .bindGroupLayouts = shader->layout.bg_layouts,
+    };
+
+    // Create the pipeline layout object for the wgpu pipeline descriptor
+    // Nothing is compiled when every pipeline is cached.
+    WGPUPipelineLayout pipeline_layout_obj =
+        compile ? wgpuDeviceCreatePipelineLayout(nano_app.wgpu->device,
+                                                 &pipeline_layout_desc)
+                : NULL;
+
+    // Create the compute shader module for WGSL shaders
+    WGPUShaderModuleWGSLDescriptor wgsl_desc = {
+        .chain =
+            {
+                .next = NULL,
+                .sType = WGPUSType_ShaderModuleWGSLDescriptor,
+            },
+        .code = info->source,
+    };
+
+    // This is the main descriptor that will be used to create the
+    // compute shader. We must include the WGSL descriptor in the
+    // nextInChain field.
+    WGPUShaderModuleDescriptor shader_desc = {
+        .nextInChain = (WGPUChainedStruct *)&wgsl_desc,
+        .label = nano_atom_str(info->label),
+    };
+
+    // Declare shader modules for the different shader types
+    WGPUShaderModule shader_module =
+        compile ? wgpuDeviceCreateShaderModule(nano_app.wgpu->device,
+                                               &shader_desc)
+                : NULL;
+
+    // Create the compute pipeline if the compute entry index is valid
+    if (compute_index != -1) {
+
+        WGPUComputePipelineDescriptor pipeline_desc = {
+            .layout = pipeline_layout_obj,
+            .compute =
+                {
+                    .module = shader_module,
+                    .entryPoint = info->entry_points[compute_index].entry,
+                },
+        };
+
+        // Set the WGPU pipeline object in our shader info struct, a cached
+        // one was already set above
+        _nano_pipeline_request_t *request =
+            compute_hit ? NULL : _nano_pipeline_request(shader, compute_key);
+        if (compute_hit == NULL && request != NULL) {
+            wgpuDeviceCreateComputePipelineAsync(nano_app.wgpu->device,
+                                                 &pipeline_desc,
+                                                 _nano_compute_pipeline_cb,
+                                                 request);
+        } else if (compute_hit == NULL) {
+            int event = wgpu_startup_begin("pipeline",
+                                           nano_atom_str(info->label));
+            shader->compute_pipeline = wgpuDeviceCreateComputePipeline(
+                nano_app.wgpu->device, &pipeline_desc);
+            wgpu_startup_end(event);
+            _nano_pipeline_cache_insert(compute_key, shader->compute_pipeline,
+                                        NULL);
+        }
+    }
+
+    // If both the vertex and fragment entry indices are valid, we can
+    // create a render pipeline for the shader
+    if (vertex_index != -1 && fragment_index != -1) {
+
+        // The layouts are stored in nano_vertex_buffer_t, but WGPU expects
+        // a contiguous array of them that points at the shader's attributes
+        WGPUVertexBufferLayout layouts[NANO_MAX_VERTEX_BUFFERS];
+        for (int i = 0; i < shader->vertex_buffer_count; i++) {
+            nano_vertex_buffer_t *vb = &shader->vertex_buffers[i];
+            layouts[i] = vb->vertex_buffer_layout;
+            layouts[i].attributes =
+                &shader->vertex_attributes[vb->first_attribute];
+        }
+
+        WGPURenderPipelineDescriptor renderPipelineDesc = {
+            .label = nano_atom_str(info->label),
+            .layout = pipeline_layout_obj,
+            .vertex =
+                {
+                    .module = shader_module,
+                    .entryPoint = info->entry_points[vertex_index].entry,
+                    .bufferCount = shader->vertex_buffer_count,
+                    .buffers = layouts,
+                },
+            .primitive = {.topology = WGPUPrimitiveTopology_TriangleList,
+                          .stripIndexFormat = WGPUIndexFormat_Undefined,
+                          .frontFace = WGPUFrontFace_CCW,
+                          .cullMode = shader->cull_mode},
+            .multisample =
+                (WGPUMultisampleState){
+                    .count = nano_app.settings.gfx.msaa.sample_count,
+                    .mask = ~0u,
+                    .alphaToCoverageEnabled = false,
+                },
+            .fragment =
+                &(WGPUFragmentState){
+                    .module = shader_module,
+                    .entryPoint = info->entry_points[fragment_index].entry,
+                    .targetCount = 1,
+                    .targets =
+                        &(WGPUColorTargetState){
+                            .format = wgpu_get_color_format(),
+                            .blend =
+                                &(WGPUBlendState){
+                                    .color =
+                                        (WGPUBlendComponent){
+                                            .operation = WGPUBlendOperation_Add,
+                                            .srcFactor = WGPUBlendFactor_One,
+                                            .dstFactor = WGPUBlendFactor_One,
+                                        },
+                                    .alpha =
+                                        (WGPUBlendComponent){
+                                            .operation = WGPUBlendOperation_Add,
+                                            .srcFactor = WGPUBlendFactor_One,
+                                            .dstFactor = WGPUBlendFactor_One,
+                                        },
+                                },
+                            .writeMask = WGPUColorWriteMask_All,
+                        },
+                },
+            // TODO: Add other render pipeline attributes here
+        };
+
+        // Assign the render pipeline to the shader info struct, a cached
+        // one was already set above
+        _nano_pipeline_request_t *request =
+            render_hit ? NULL : _nano_pipeline_request(shader, render_key);
+        if (render_hit == NULL && request != NULL) {
+            wgpuDeviceCreateRenderPipelineAsync(nano_app.wgpu->device,
+                                                &renderPipelineDesc,
+                                                _nano_render_pipeline_cb,
+                                                request);
+        } else if (render_hit == NULL) {
+            int event = wgpu_startup_begin("pipeline",
+                                           nano_atom_str(info->label));
+            shader->render_pipeline = wgpuDeviceCreateRenderPipeline(
+                nano_app.wgpu->device, &renderPipelineDesc);
+            wgpu_startup_end(event);
+            _nano_pipeline_cache_insert(render_key, NULL,
+                                        shader->render_pipeline);
+        }
+
+        // Write the vertex buffer data to the GPU so it can be used in the
+        // shader pipeline
+        WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+
+        // Write the vertex buffer data to the GPU
+        for (int i = 0; i < shader->vertex_buffer_count; i++) {
+            nano_vertex_buffer_t *vertex_buffer = &shader->vertex_buffers[i];
+            nano_buffer_t *buffer = nano_get_buffer(vertex_buffer->buffer_id);
+            if (buffer == NULL) {
+                LOG_ERR("NANO: Shader %u: Could not find vertex buffer %u. Did "
+                        "you create it?\n",
+                        info->id, vertex_buffer->buffer_id);
+                // Fall through so the module and layout are released
+                retval = NANO_FAIL;
+                break;
+            }
+            // Mesh buffers are uploaded when they are loaded and keep no
+            // host data
+            if (buffer->data == NULL) {
+                continue;
+            }
+
+            // Write the buffer data to the GPU
+            nano_write_buffer(buffer);
+            LOG("NANO: Shader %u: Wrote vertex buffer data to GPU buffer "
+                "%p\n",
+                info->id, buffer->buffer);
+        }
+        LOG("NANO: Shader %u: Created Render Pipeline\n", info->id);
+
+        // If the vertex or fragment entry indices are valid, but the other
+        // is not, we can't create a render pipeline
+    } else if (vertex_index != -1 || fragment_index != -1) {
+        LOG_ERR("NANO: Shader %u: Could not create render pipeline. Missing "
+                "paired vertex/fragment shader\n",
+                info->id);
+        retval = NANO_FAIL;
+    }
+
+    // Release the shader modules if they are not null
+    if (shader_module)
+        wgpuShaderModuleRelease(shader_module);
+
+    // The pipelines keep their own reference to the layout
+    if (pipeline_layout_obj)
+        wgpuPipelineLayoutRelease(pipeline_layout_obj);
+
+    return retval;
+}
+
+// Called by nano_validate_shader() to build the bind groups for the shader
+// Do not call this function directly
+int nano_build_bindgroups(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_build_bindgroups() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    // Return early if the shader has no layouts
+    if (shader->layout.num_layouts <= 0) {
+        return NANO_OK;
+    }
+
+    if (shader->in_use) {
+        fprintf(stderr, "NANO: nano_build_bindgroups() -> Shader is "
+                        "currently in use\n");
+        return NANO_FAIL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_build_bindgroups() -> Shader info is NULL\n");
+        return NANO_FAIL;
+    }
+
+    // Packets copy the bind groups, rebuild them with the new ones
+    _nano_invalidate_packets();
+
+    // Iterate through the groups and create the bind groups
+    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+
+        bool group_empty = true;
+        uint32_t count = 0;
+
+        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
+
+            // If a binding is empty, we can break out of the loop early
+            // and assume that there are no more bindings in the group
+            if (info->group_indices[i][j] == -1) {
+                break;
+            } else {
+                group_empty = false;
+                count++;
+            }
+        }
+
+        // If the group is empty, we can break out of the loop early
+        // and assume that there are no more groups to build
+        if (group_empty) {
+            break;
+        }
+
+        // The NanoFrame group is shared and never released by the shader
+        if (_nano_is_frame_group(info, i)) {
+            if (shader->bind_groups[i] != NULL &&
+                shader->bind_groups[i] != nano_app.frame_group.bind_group) {
+                wgpuBindGroupRelease(shader->bind_groups[i]);
+            }
+            shader->bind_groups[i] = nano_app.frame_group.bind_group;
+            continue;
+        }
+
+        // Otherwise we create a BindGroupEntry list for each binding in the
+        // group
+        WGPUBindGroupEntry bg_entry[NANO_GROUP_MAX_BINDINGS];
+
+        // Iterate through the bindings in the group and create the bind
+        // group. Remember: when defining bindings, make sure to not skip
+        // numbers. Always increase the binding number by 1, or increase the
+        // group number by 1 and return to 0.
+        for (int j = 0; j < count; j++) {
+            int index = info->group_indices[i][j];
+            nano_binding_info_t *binding = &info->bindings[index];
+
+            // If the buffer usage is not none, we can create the bindgroup
+            // entry
+            // TODO: Add support for textures and samplers as bindings
+            if (binding->info.buffer_usage != WGPUBufferUsage_None) {
+                // Retrieve the buffer id from the shader info struct
+                uint32_t buffer_id = shader->buffers[i][j];
+
+                // Uniforms without a buffer of their own use their block in
+                // the shared uniform buffer
+                nano_uniform_block_t *block =
+                    buffer_id == 0 ? _nano_uniforms_find_block(
+                                         shader->id, i, binding->binding)
+                                   : NULL;
+                if (block != NULL) {
+                    WGPUBuffer uniform_buffer = _nano_uniforms_buffer();
+                    if (uniform_buffer == NULL) {
+                        return NANO_FAIL;
+                    }
+                    bg_entry[j] = (WGPUBindGroupEntry){
+                        .binding = (uint32_t)binding->binding,
+                        .buffer = uniform_buffer,
+                        .offset = block->offset,
+                        .size = block->size,
+                    };
+                    continue;
+                }
+
+                // Retrieve the buffer from the buffer pool using the id
+                nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+                if (buffer == NULL) {
+                    LOG_ERR("NANO: Shader %u: Could not find buffer %u\n",
+                            info->id, buffer_id);
+                    return NANO_FAIL;
+                }
+
+                // Create the bind group entry for the buffer
+                bg_entry[j] = (WGPUBindGroupEntry){
+                    .binding = (uint32_t)binding->binding,
+                    .buffer = buffer->buffer,
+                    .offset = buffer->offset,
+                    .size = buffer->size,
+                };
+            }
+        }
+
+        WGPUBindGroupDescriptor bg_desc = {
+            .layout = shader->layout.bg_layouts[i],
+            .entryCount = count,
+            .entries = bg_entry,
+        };
+
+        if (shader->bind_groups[i] != NULL &&
+            shader->bind_groups[i] != nano_app.frame_group.bind_group) {
+            wgpuBindGroupRelease(shader->bind_groups[i]);
+        }
+
+        shader->bind_groups[i] =
+            wgpuDeviceCreateBindGroup(nano_app.wgpu->device, &bg_desc);
+        if (shader->bind_groups[i] == NULL) {
+            fprintf(stderr,
+                    "NANO: Shader %u: Could not create bind group for "
+                    "group %d\n",
+                    info->id, i);
+            return NANO_FAIL;
+        }
+    }
+
+    return NANO_OK;
+}
+
+WGPUBindGroup nano_get_bindgroup(nano_shader_t *shader, int group) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_get_bindgroup() -> Shader is NULL\n");
+        return NULL;
+    }
+
+    if (group < 0 || group >= NANO_MAX_GROUPS) {
+        LOG_ERR("NANO: nano_get_bindgroup() -> Invalid group\n");
+        return NULL;
+    }
+
+    return shader->bind_groups[group];
+}
+
+// Find the indices of the entry points in the shader info struct
+wgsl_shader_indices_t nano_precompute_entry_indices(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_precompute_entry_indices() -> Shader is NULL\n");
+        return (wgsl_shader_indices_t){-1, -1, -1};
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_precompute_entry_indices() -> Shader info is "
+                "NULL\n");
+        return (wgsl_shader_indices_t){-1, -1, -1};
+    }
+
+    // -1 means no entry point found
+    wgsl_shader_indices_t indices = {-1, -1, -1};
+
+    // Iterate through the entry points and find the index of the
+    // entry point in the shader info struct
+    for (int i = 0; i < info->entry_point_count; i++) {
+        switch (info->entry_points[i].type) {
+            case VERTEX:
+                indices.vertex = i;
+                break;
+            case FRAGMENT:
+                indices.fragment = i;
+                break;
+            case COMPUTE:
+                indices.compute = i;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return indices;
+}
+
+// Shader Functions
+// -------------------------------------------------
+
+// validate a shader to ensure that it is ready to be used
+int nano_validate_shader(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_validate_shader() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+    if (shader->in_use) {
+        LOG_ERR("NANO: Shader %u is currently in use\n", shader->id);
+        return NANO_FAIL;
+    }
+
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_reload_shader() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    LOG("NANO: Shader %u: Validating...\n", info->id);
+
+    // Parse the compute shader to get the workgroup size as well
+    // and group layout requirements. These are stored in the info
+    // struct.
+    int status = nano_parse_shader(info->source, shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to parse compute shader: %s\n",
+                nano_atom_str(info->path));
+        return NANO_FAIL;
+    }
+
+    // Get the entry indices for the shader
+    info->entry_indices = nano_precompute_entry_indices(shader);
+    int compute_index = info->entry_indices.compute;
+    int vertex_index = info->entry_indices.vertex;
+    int fragment_index = info->entry_indices.fragment;
+
+    // Log entry point information if it exists
+    if (compute_index != -1) {
+        nano_entry_t *entry = &info->entry_points[compute_index];
+        LOG("NANO: Shader %u: compute entry: %s | workgroup size: (%d, "
+            "%d, %d)\n",
+            info->id, entry->entry, entry->workgroup_size.x,
+            entry->workgroup_size.y, entry->workgroup_size.z);
+    }
+    if (vertex_index != -1) {
+        nano_entry_t *entry = &info->entry_points[vertex_index];
+        LOG("NANO: Shader %u: vertex entry: %s\n", info->id, entry->entry);
+    }
+    if (fragment_index != -1) {
+        nano_entry_t *entry = &info->entry_points[fragment_index];
+        LOG("NANO: Shader %u: frag entry: %s\n", info->id, entry->entry);
+    }
+
+    status = nano_build_bindings(shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to build bindings for shader %u\n", info->id);
+        return NANO_FAIL;
+    }
+
+    // Once we reach this point, we can assume that the shader has been
+    // successfully validated and reflects the shader source code.
+    // If anything goes wrong, the shader will technically not be able to be
+    // used until the shader is successfully validated.
+
+    return NANO_OK;
+}
+
+// Reflect the @location inputs of the vertex entry point of a shader
+// Shaders without a vertex entry point have no inputs.
+static void _nano_shader_reflect_vertex_inputs(nano_shader_t *shader) {
+    shader->vertex_input_count = 0;
+    int vertex_index = shader->info.entry_indices.vertex;
+    if (vertex_index < 0) {
+        return;
+    }
+
+    // The structs are only needed while the inputs are reflected
+    nano_arena_mark_t mark = nano_arena_mark(&nano_build_arena);
+    nano_wgsl_struct_t *structs = (nano_wgsl_struct_t *)nano_arena_alloc(
+        &nano_build_arena, NANO_REFLECT_MAX_STRUCTS * sizeof(*structs));
+    int count =
+        structs ? nano_reflect_vertex_inputs(
+                      shader->info.source,
+                      shader->info.entry_points[vertex_index].entry, structs,
+                      NANO_REFLECT_MAX_STRUCTS, shader->vertex_inputs,
+                      NANO_MAX_VERTEX_ATTRIBUTES)
+                : -1;
+    nano_arena_rewind(&nano_build_arena, mark);
+
+    if (count < 0) {
+        LOG("NANO: Shader %u: Could not reflect the vertex inputs, vertex "
+            "layouts have to be bound by hand\n",
+            shader->id);
+        return;
+    }
+
+    shader->vertex_input_count = (uint8_t)count;
+}
+
+// Create our nano_shader_t struct to hold the compute shader and
+// pipeline, return shader id on success, 0 on failure Label
+// optional. This only supports WGSL shaders for the time being.
+// I'll explore SPIRV at a later time
+uint32_t nano_create_shader(const char *shader_source, const char *label) {
+    if (shader_source == NULL) {
+        LOG_ERR("NANO: nano_create_shader() -> "
+                "Shader source is NULL\n");
+        return 0;
+    }
+
+    // Get shader id hash for the compute shader by hashing the
+    // shader path
+    uint32_t shader_id = nano_hash_shader(shader_source);
+
+    // Find a slot in the shader pool to store the shader
+    int slot = nano_find_shader_slot(&nano_app.shader_pool, shader_id);
+    if (slot < 0) {
+        LOG_ERR("NANO: Shader pool is full. Could not insert "
+                "shader %u\n",
+                shader_id);
+        return NANO_FAIL;
+    }
+
+    // If the label is NULL, use the default label
+    if (label == NULL) {
+        // Shader label
+        char default_label[64];
+        snprintf(default_label, 64, "Shader %u", shader_id);
+        label = default_label;
+        LOG("NANO: Using default label for shader %u\n", shader_id);
+        LOG("NANO: Default label: %s\n", label);
+    }
+
+    nano_atom_t label_atom = nano_intern(label);
+    if (label_atom == 0) {
+        LOG_ERR("NANO: nano_create_shader() -> Could not intern the label "
+                "%s\n",
+                label);
+        return 0;
+    }
+
+    // Initialize the shader info struct
+    wgpu_shader_info_t info = {
+        .id = shader_id,
+        .source = strdup(shader_source),
+        .source_hash = _nano_fnv1a64_bytes(NANO_FNV64_OFFSET, shader_source,
+                                           strlen(shader_source)),
+        .label = label_atom,
+    };
+
+    nano_shader_t shader = (nano_shader_t){
+        .id = shader_id,
+        .info = info,
+        .vertex_count = 3, // Default vertex count is 3 for a triangle
+        .instance_count = 1,
+        .cull_mode = WGPUCullMode_None,
+        .packet_index = -1,
+    };
+
+    // Parse the compute shader to get the workgroup size as well
+    // and group layout requirements. These are stored in the info
+    // struct.
+    int status = nano_validate_shader(&shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to validate shader %u\n", shader_id);
+        return NANO_FAIL;
+    }
+
+    // Bindings are found by name, which needs room in the intern table
+    for (int i = 0; i < shader.info.binding_count; i++) {
+        if (shader.info.bindings[i].name == 0) {
+            LOG_ERR("NANO: nano_create_shader() -> Could not intern the "
+                    "binding names of shader %u\n",
+                    shader_id);
+            free((void *)shader.info.source);
+            return 0;
+        }
+    }
+
+    // Add the shader to the shader pool
+    memcpy(&nano_app.shader_pool.shaders[slot].shader_entry, &shader,
+           sizeof(nano_shader_t));
+    // Set the slot as occupied
+    nano_app.shader_pool.shaders[slot].occupied = true;
+
+    _nano_shader_reflect_vertex_inputs(
+        &nano_app.shader_pool.shaders[slot].shader_entry);
+
+    // Give every uniform struct a block so it can be set by name, replacing
+    // the blocks of a shader created from the same source
+    _nano_uniforms_release_blocks(shader_id);
+    _nano_uniforms_create_blocks(
+        &nano_app.shader_pool.shaders[slot].shader_entry);
+
+    // Increment the shader count
+    nano_app.shader_pool.shader_count++;
+
+    LOG("NANO: Shader %u: Successfully created!\n", shader_id);
+
+    // Update the shader labels for the ImGui combo boxes
+    _nano_update_shader_labels();
+
+    return shader_id;
+}
+
+// Create a shader from a file path
+uint32_t nano_create_shader_from_file(const char *path, const char *label) {
+    if (path == NULL) {
+        LOG_ERR("NANO: nano_create_shader_from_file() -> "
+                "Shader path is NULL\n");
+        return 0;
+    }
+
+    // Reading and parsing the shader is a phase of the startup
+    nano_atom_t path_atom = nano_intern(path);
+    int event = wgpu_startup_begin("shader load", nano_atom_str(path_atom));
+
+    // Read the shader source from the file into the build arena, the shader
+    // keeps its own copy of the source
+    nano_arena_mark_t mark = nano_arena_mark(&nano_build_arena);
+    char *source = _nano_read_file_into(path, &nano_build_arena);
+    if (source == NULL) {
+        LOG_ERR("NANO: nano_create_shader_from_file() -> "
+                "Could not read shader source\n");
+        nano_arena_rewind(&nano_build_arena, mark);
+        wgpu_startup_end(event);
+        return 0;
+    }
+
+    // Create the shader from the source
+    uint32_t shader_id = nano_create_shader(source, label);
+    nano_arena_rewind(&nano_build_arena, mark);
+    wgpu_startup_end(event);
+
+    nano_shader_t *shader = nano_get_shader(shader_id);
+    if (shader == NULL) {
+        return 0;
+    }
+
+    // Set the path of the shader
+    shader->info.path = path_atom;
+
+    return shader_id;
+}
+
+// Job data for nano_create_shaders_from_files()
+typedef struct {
+    const char **paths;
+    char **sources;
+} _nano_shader_read_job_t;
+
+static void _nano_read_shader_files(void *data, uint32_t begin, uint32_t end) {
+    _nano_shader_read_job_t *job = (_nano_shader_read_job_t *)data;
+    for (uint32_t i = begin; i < end; i++) {
+        job->sources[i] = nano_read_file(job->paths[i]);
+    }
+}
+
+// Create several shaders from file paths at once.
+// The files are read in parallel on the job system, then each shader is
+// parsed and added to the shader pool in order. Labels may be NULL.
+// ids[i] is set to the shader id, or 0 if the shader could not be created.
+// Returns the number of shaders that were created.
+int nano_create_shaders_from_files(const char **paths, const char **labels,
+                                   uint32_t *ids, int count) {
+    if (paths == NULL || ids == NULL || count <= 0) {
+        LOG_ERR("NANO: nano_create_shaders_from_files() -> Invalid "
+                "arguments\n");
+        return 0;
+    }
+
+    // The files are read on worker threads so their contents are allocated
+    // with malloc(), only the array of sources lives in the build arena
+    nano_arena_mark_t mark = nano_arena_mark(&nano_build_arena);
+    char **sources =
+        (char **)nano_arena_calloc(&nano_build_arena, count, sizeof(char *));
+    if (sources == NULL) {
+        LOG_ERR("NANO: nano_create_shaders_from_files() -> Memory allocation "
+                "failed\n");
+        return 0;
+    }
+
+    _nano_shader_read_job_t job = {.paths = paths, .sources = sources};
+    nano_parallel_for(count, 1, _nano_read_shader_files, &job);
+
+    // The shader pool is not thread safe, so shaders are added one at a time
+    int created = 0;
+    for (int i = 0; i < count; i++) {
+        ids[i] = 0;
+        if (sources[i] == NULL) {
+            LOG_ERR("NANO: nano_create_shaders_from_files() -> Could not read "
+                    "%s\n",
+                    paths[i]);
+            continue;
+        }
+
+        uint32_t shader_id =
+            nano_create_shader(sources[i], labels ? labels[i] : NULL);
+        free(sources[i]);
+
+        nano_shader_t *shader = nano_get_shader(shader_id);
+        if (shader == NULL) {
+            continue;
+        }
+
+        shader->info.path = nano_intern(paths[i]);
+        ids[i] = shader_id;
+        created++;
+    }
+
+    nano_arena_rewind(&nano_build_arena, mark);
+
+    return created;
+}
+
+// Copy the dispatch and draw parameters of a shader into its packet
+// These may change every frame, so they are patched into the packet instead
+// of rebuilding the packets. Returns NANO_FAIL if a buffer is missing.
+static int _nano_packet_set_params(nano_shader_t *shader,
+                                   nano_shader_packet_t *packet) {
+    packet->vertex_count = (uint32_t)shader->vertex_count;
+    packet->instance_count = shader->instance_count;
+
+    // Explicit workgroups win over the ones derived from num_elems
+    if (shader->workgroups[0] != 0) {
+        for (int i = 0; i < 3; i++) {
+            packet->workgroups[i] = shader->workgroups[i];
+        }
+    } else if (packet->compute_index >= 0) {
+        wgsl_workgroup_size_t workgroup_sizes =
+            shader->info.entry_points[packet->compute_index].workgroup_size;
+        size_t workgroup_size =
+            workgroup_sizes.x * workgroup_sizes.y * workgroup_sizes.z;
+
+        // TODO: ADJUST WORKGROUP SIZE BASED ON SIZE OF OUTPUT BUFFER
+        packet->workgroups[0] = (uint32_t)(
+            (shader->num_elems + workgroup_size - 1) / workgroup_size);
+        packet->workgroups[1] = 1;
+        packet->workgroups[2] = 1;
+    }
+
+    // Resolve the vertex buffers for the render pass
+    packet->vertex_buffer_count = shader->vertex_buffer_count;
+    for (int j = 0; j < shader->vertex_buffer_count; j++) {
+        nano_vertex_buffer_t *vb = &shader->vertex_buffers[j];
+        packet->vertex_buffers[j] = nano_get_buffer(vb->buffer_id);
+        packet->vertex_offsets[j] = vb->offset;
+        if (packet->vertex_buffers[j] == NULL) {
+            LOG_ERR("NANO: Shader %u: Could not find vertex buffer %u\n",
+                    shader->id, vb->buffer_id);
+            return NANO_FAIL;
+        }
+    }
+
+    packet->index_buffer = NULL;
+    if (shader->index_buffer != 0) {
+        packet->index_buffer = nano_get_buffer(shader->index_buffer);
+        packet->index_format = shader->index_format;
+        if (packet->index_buffer == NULL) {
+            LOG_ERR("NANO: Shader %u: Could not find index buffer %u\n",
+                    shader->id, shader->index_buffer);
+            return NANO_FAIL;
+        }
+    }
+
+    packet->indirect_buffer = NULL;
+    if (shader->indirect_buffer != 0) {
+        packet->indirect_buffer = nano_get_buffer(shader->indirect_buffer);
+        packet->indirect_offset = shader->indirect_offset;
+        if (packet->indirect_buffer == NULL) {
+            LOG_ERR("NANO: Shader %u: Could not find indirect buffer %u\n",
+                    shader->id, shader->indirect_buffer);
+            return NANO_FAIL;
+        }
+    }
+
+    return NANO_OK;
+}
+
+// Apply new dispatch or draw parameters to the packet of an active shader
+// The packets are rebuilt instead if they are already stale or the shader
+// has no packet.
+static void _nano_shader_update_packet(nano_shader_t *shader) {
+    nano_shader_pool_t *pool = &nano_app.shader_pool;
+    if (!shader->in_use || pool->packets_dirty) {
+        return;
+    }
+
+    int index = shader->packet_index;
+    if (index < 0 || index >= pool->packet_count ||
+        pool->packets[index].shader != shader ||
+        _nano_packet_set_params(shader, &pool->packets[index]) != NANO_OK) {
+        _nano_invalidate_packets();
+    }
+}
+
+// Set the number of elements expected to be processed by the compute shader
+// This is used to determine the number of workgroups to dispatch. It can
+// change every frame, even while the shader is active.
+int nano_shader_set_num_elems(nano_shader_t *shader, size_t count) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_num_elems() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (count == 0) {
+        LOG_ERR("NANO: nano_shader_set_num_elems() -> Count cannot be 0\n");
+        return NANO_FAIL;
+    }
+
+    shader->num_elems = count;
+    _nano_shader_update_packet(shader);
+
+    return NANO_OK;
+}
+
+// Set the number of workgroups dispatched in each dimension
+// Overrides the workgroups derived from nano_shader_set_num_elems(), pass
+// 0, 0, 0 to go back to them. It can change every frame.
+int nano_shader_set_workgroups(nano_shader_t *shader, uint32_t x, uint32_t y,
+                               uint32_t z) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_workgroups() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    bool reset = x == 0 && y == 0 && z == 0;
+    if (!reset && (x == 0 || y == 0 || z == 0)) {
+        LOG_ERR("NANO: nano_shader_set_workgroups() -> Every dimension "
+                "needs at least one workgroup\n");
+        return NANO_FAIL;
+    }
+
+    // The default maxComputeWorkgroupsPerDimension limit
+    if (x > 65535 || y > 65535 || z > 65535) {
+        LOG_ERR("NANO: nano_shader_set_workgroups() -> At most 65535 "
+                "workgroups per dimension\n");
+        return NANO_FAIL;
+    }
+
+    shader->workgroups[0] = x;
+    shader->workgroups[1] = y;
+    shader->workgroups[2] = z;
+    _nano_shader_update_packet(shader);
+
+    return NANO_OK;
+}
+
+// Set the vertex count for the draw call of the render pipeline
+int nano_shader_set_vertex_count(nano_shader_t *shader, uint32_t count) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_vertex_count() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+    if (count < 3) {
+        LOG_ERR("NANO: nano_shader_set_vertex_count() -> Vertex count "
+                "must be greater than 3\n");
+        return NANO_FAIL;
+    }
+
+    shader->vertex_count = count;
+    _nano_shader_update_packet(shader);
+    return NANO_OK;
+}
+
+// Set the instance count for the draw call of the render pipeline
+// Vertex buffers bound per instance advance once per instance. It can change
+// every frame, 0 skips the draw.
+int nano_shader_set_instance_count(nano_shader_t *shader, uint32_t count) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_instance_count() -> Shader is "
+                "NULL\n");
+        return NANO_FAIL;
+    }
+
+    shader->instance_count = count;
+    _nano_shader_update_packet(shader);
+    return NANO_OK;
+}
+
+// Replace the buffer of a vertex buffer slot and set its byte offset
+// The vertex layout stays the same, so this works while the shader is
+// active and never rebuilds its pipeline.
+int nano_shader_set_vertex_buffer(nano_shader_t *shader, uint8_t slot,
+                                  uint32_t buffer_id, uint64_t offset) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_vertex_buffer() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (slot >= shader->vertex_buffer_count) {
+        LOG_ERR("NANO: Shader %u: nano_shader_set_vertex_buffer() -> Slot %u "
+                "has no vertex buffer\n",
+                shader->id, slot);
+        return NANO_FAIL;
+    }
+
+    nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+    if (buffer == NULL) {
+        LOG_ERR("NANO: nano_shader_set_vertex_buffer() -> Buffer not found "
+                "in the buffer pool\n");
+        return NANO_FAIL;
+    }
+
+    if (offset % 4 != 0 || offset >= buffer->size) {
+        LOG_ERR("NANO: nano_shader_set_vertex_buffer() -> Offset must be a "
+                "multiple of 4 inside the buffer\n");
+        return NANO_FAIL;
+    }
+
+    shader->vertex_buffers[slot].buffer_id = buffer_id;
+    shader->vertex_buffers[slot].offset = offset;
+    _nano_shader_update_packet(shader);
+    return NANO_OK;
+}
+
+// Draw the render pipeline with indices from a buffer in the buffer pool
+// count is the number of indices to draw. Pass 0 as the buffer id to go back
+// to drawing the vertices in order.
+int nano_shader_set_index_buffer(nano_shader_t *shader, uint32_t buffer_id,
+                                 WGPUIndexFormat format, uint32_t count) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_index_buffer() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (buffer_id != 0) {
+        if (nano_get_buffer(buffer_id) == NULL) {
+            LOG_ERR("NANO: nano_shader_set_index_buffer() -> Buffer not "
+                    "found in the buffer pool\n");
+            return NANO_FAIL;
+        }
+        if (format != WGPUIndexFormat_Uint16 &&
+            format != WGPUIndexFormat_Uint32) {
+            LOG_ERR("NANO: nano_shader_set_index_buffer() -> Index format "
+                    "must be Uint16 or Uint32\n");
+            return NANO_FAIL;
+        }
+        shader->vertex_count = count;
+    }
+
+    shader->index_buffer = buffer_id;
+    shader->index_format = format;
+    shader->index_borrowed = false;
+    _nano_shader_update_packet(shader);
+    return NANO_OK;
+}
+
+// Take the vertex or index count and the instance count of the draw call
+// from a buffer in the buffer pool, so they can be written by a compute
+// shader. The buffer needs WGPUBufferUsage_Indirect and holds the arguments
+// of DrawIndexedIndirect if the shader has an index buffer, DrawIndirect
+// otherwise. Pass 0 as the buffer id to go back to direct draws.
+int nano_shader_set_indirect_buffer(nano_shader_t *shader, uint32_t buffer_id,
+                                    uint64_t offset) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_indirect_buffer() -> Shader is "
+                "NULL\n");
+        return NANO_FAIL;
+    }
+
+    if (buffer_id != 0) {
+        nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+        if (buffer == NULL) {
+            LOG_ERR("NANO: nano_shader_set_indirect_buffer() -> Buffer not "
+                    "found in the buffer pool\n");
+            return NANO_FAIL;
+        }
+        if (offset % 4 != 0 || offset + 5 * sizeof(uint32_t) > buffer->size) {
+            LOG_ERR("NANO: nano_shader_set_indirect_buffer() -> Offset must "
+                    "be a multiple of 4 with room for the arguments\n");
+            return NANO_FAIL;
+        }
+    }
+
+    shader->indirect_buffer = buffer_id;
+    shader->indirect_offset = buffer_id != 0 ? offset : 0;
+    _nano_shader_update_packet(shader);
+    return NANO_OK;
+}
+
+// Set which faces the render pipeline culls, WGPUCullMode_None by default
+// Takes effect the next time the shader is built.
+int nano_shader_set_cull_mode(nano_shader_t *shader, WGPUCullMode mode) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_cull_mode() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    shader->cull_mode = mode;
+    return NANO_OK;
+}
+
+// Build the bindings, pipeline layout, bindgroups, and pipelines for the
+// shader Can be called by the developer to build the shader manually, or
+// can be called as part of the activation process as a boolean parameter.
+int nano_shader_build(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_build() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    LOG("NANO: Shader %u: Building...\n", shader->id);
+
+    // Verify that the shader can be parsed properly before building it
+    int status = nano_validate_shader(shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to validate shader %u\n", shader->id);
+        return NANO_FAIL;
+    }
+
+    // Without a device there are no GPU objects to build, the shader can
+    // only run through its CPU kernels
+    if (!nano_has_gpu()) {
+        shader->built = true;
+        LOG("NANO: Shader %u: Built for the CPU only.\n", shader->id);
+        return NANO_OK;
+    }
+
+    LOG("NANO: Shader %u: Building pipeline layouts...\n", shader->id);
+
+    // Build the pipeline layout
+    status = nano_build_pipeline_layout(shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to build pipeline layout for shader %u\n",
+                shader->info.id);
+        return status;
+    }
+
+    LOG("NANO: Shader %u: Building bindgroups...\n", shader->id);
+
+    // Build bind groups for the shader so we can bind the buffers
+    status = nano_build_bindgroups(shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to build bindgroup for shader %u\n",
+                shader->info.id);
+        return status;
+    }
+
+    LOG("NANO: Shader %u: Building final pipelines...\n", shader->id);
+
+    // Build the shader pipelines
+    status = nano_build_shader_pipelines(shader);
+    if (status != NANO_OK) {
+        LOG_ERR("NANO: Failed to build shader pipelines for shader %u\n",
+                shader->info.id);
+        return 0;
+    }
+
+    // Set the built flag to true so we don't have to rebuild the shader
+    // unless we explicitly want to by passing the build flag
+    shader->built = true;
+
+    LOG("NANO: Shader %u: Built!\n", shader->id);
+
+    return NANO_OK;
+}
+
+// Set a shader to the active state.
+// Build bindings, pipeline layout, bindgroups, and pipelines
+int nano_shader_activate(nano_shader_t *shader, bool build) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_activate() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+    if (shader->in_use) {
+        LOG_ERR("NANO: Shader %u is already active\n", shader->id);
+        return NANO_OK;
+    }
+
+    LOG("NANO: Shader %u: Activating...\n", shader->id);
+
+    // If the shader has not been built, we build it now
+    // If the build flag is set, we rebuild the shader
+    if (!shader->built || build) {
+        int status = nano_shader_build(shader);
+        if (status != NANO_OK) {
+            LOG_ERR("NANO: Failed to build shader %u\n", shader->id);
+            return NANO_FAIL;
+        }
+    }
+
+    // If the shader is not active, we can activate it
+    shader->in_use = true;
+
+    // Add the shader to the active shaders list
+    nano_shader_array_push(&nano_app.shader_pool.active_shaders, shader->id);
+    _nano_invalidate_packets();
+
+    LOG("NANO: Shader %u: Activated!\n", shader->id);
+
+    return NANO_OK;
+}
+
+// Deactivate a shader from the active list
+int nano_shader_deactivate(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_deactivate() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    // If the shader is not active, return early
+    if (!shader->in_use) {
+        return NANO_OK;
+    }
+
+    // If the shader is active, we can deactivate it
+    shader->in_use = false;
+
+    // Remove the shader from the active shaders list
+    nano_shader_array_remove(&nano_app.shader_pool.active_shaders, shader->id);
+    _nano_invalidate_packets();
+
+    _nano_update_shader_labels();
+
+    return NANO_OK;
+}
+
+// Return shader id from the shader pool using the index
+int nano_get_active_shader_id(nano_shader_pool_t *table, int index) {
+    if (index < 0 || index >= table->active_shaders.top + 1) {
+        LOG_ERR("NANO: nano_get_active_shader_id() -> Invalid index\n");
+        return 0;
+    }
+
+    return table->active_shaders.data[index];
+}
+
+// Check if a shader is active
+bool nano_is_shader_active(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_is_shader_active() -> Shader is NULL\n");
+        return false;
+    }
+
+    return shader->in_use;
+}
+
+// Get the number of active shaders
+int nano_num_active_shaders(nano_shader_pool_t *table) {
+    return table->active_shaders.top + 1;
+}
+
+// Return a string of shader pipeline type for ImGui
+const char *nano_get_shader_type_str(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_get_shader_type_str() -> Shader is NULL\n");
+        return "Unknown";
+    }
+    wgpu_shader_info_t *info = &shader->info;
+    if (info == NULL) {
+        LOG_ERR("NANO: nano_get_shader_type_str() -> Shader info is NULL\n");
+        return "Unknown";
+    }
+    return (info->entry_indices.compute != -1 &&
+            info->entry_indices.vertex != -1 &&
+            info->entry_indices.fragment != -1)
+               ? "Compute & Render"
+           : (info->entry_indices.compute != -1) ? "Compute"
+                                                 : "Render";
+}
+
+// Get the compute pipeline from the shader info struct if it exists
+WGPUComputePipeline nano_get_compute_pipeline(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_get_compute_pipeline() -> Shader is NULL\n");
+        return NULL;
+    }
+
+    if (shader->compute_pipeline == NULL) {
+        LOG_ERR("NANO: nano_get_compute_pipeline() -> Compute pipeline "
+                "not found\n");
+        return NULL;
+    }
+
+    return shader->compute_pipeline;
+}
+
+// Get the render pipeline from the shader info struct if it exists
+WGPURenderPipeline nano_get_render_pipeline(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_get_render_pipeline() -> Shader is NULL\n");
+        return NULL;
+    }
+
+    if (shader->render_pipeline == NULL) {
+        fprintf(stderr, "NANO: nano_get_render_pipeline() -> Render "
+                        "pipeline not found\n");
+        return NULL;
+    }
+
+    return shader->render_pipeline;
+}
+
+// CPU Fallback Functions
+// -------------------------------------------------
+
+// Assign a CPU implementation to a compute entry point of a shader
+// The kernel is used when the shader's execution mode picks the CPU, or
+// when Nano is running without a device.
+int nano_shader_set_cpu_kernel(nano_shader_t *shader, const char *entry,
+                               nano_cpu_kernel_t kernel) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_cpu_kernel() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+    if (entry == NULL) {
+        LOG_ERR("NANO: nano_shader_set_cpu_kernel() -> Entry is NULL\n");
+        return NANO_FAIL;
+    }
+
+    for (int i = 0; i < shader->info.entry_point_count; i++) {
+        nano_entry_t *entry_point = &shader->info.entry_points[i];
+        if (strcmp(entry_point->entry, entry) != 0) {
+            continue;
+        }
+
+        if (entry_point->type != COMPUTE) {
+            LOG_ERR("NANO: nano_shader_set_cpu_kernel() -> Entry point %s "
+                    "is not a compute entry point\n",
+                    entry);
+            return NANO_FAIL;
+        }
+
+        shader->cpu_kernels[i] = kernel;
+        _nano_invalidate_packets();
+
+        // A new kernel has to be measured again
+        shader->cpu_ns_per_elem = 0.0;
+        return NANO_OK;
+    }
+
+    LOG_ERR("NANO: nano_shader_set_cpu_kernel() -> Entry point %s not found "
+            "in shader %u\n",
+            entry, shader->id);
+    return NANO_FAIL;
+}
+
+// Choose where the compute entry points of a shader with CPU kernels run
+int nano_shader_set_exec_mode(nano_shader_t *shader, nano_exec_mode_t mode) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_set_exec_mode() -> Shader is NULL\n");
+        return NANO_FAIL;
+    }
+
+    shader->exec_mode = mode;
+    return NANO_OK;
+}
+
+// Check if a binding can be written by the shader
+static bool _nano_binding_is_writable(const nano_binding_info_t *binding) {
+    wgsl_buffer_usage_t usage = binding->info.buffer_usage;
+    return binding->binding_type == BUFFER &&
+           (usage & WGPUBufferUsage_Storage) &&
+           (usage & WGPUBufferUsage_CopyDst);
+}
+
+// Called once the queue has finished the work timed by
+// _nano_gpu_latency_begin()
+static void _nano_gpu_latency_cb(WGPUQueueWorkDoneStatus status,
+                                 void *userdata) {
+    // The callback may run while another context is current
+    nano_context_t *ctx = (nano_context_t *)userdata;
+    ctx->gpu_latency_pending = false;
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        return;
+    }
+
+    float elapsed = (float)(wgpu_now() - ctx->gpu_latency_start);
+    ctx->gpu_latency_ms = 0.75f * ctx->gpu_latency_ms + 0.25f * elapsed;
+}
+
+// Time how long the queue takes to finish the work submitted so far
+// Only one measurement is in flight at a time.
+static void _nano_gpu_latency_begin(WGPUQueue queue) {
+    if (nano_app.gpu_latency_pending) {
+        return;
+    }
+
+    nano_app.gpu_latency_pending = true;
+    nano_app.gpu_latency_start = wgpu_now();
+    wgpuQueueOnSubmittedWorkDone(queue, _nano_gpu_latency_cb,
+                                 nano_current_context);
+}
+
+// Mark every buffer the shader can write as modified by the GPU
+static void _nano_shader_mark_gpu_dirty(nano_shader_t *shader) {
+    for (int i = 0; i < shader->info.binding_count; i++) {
+        nano_binding_info_t *binding = &shader->info.bindings[i];
+        if (!_nano_binding_is_writable(binding)) {
+            continue;
+        }
+
+        nano_buffer_t *buffer =
+            nano_get_buffer(shader->buffers[binding->group][binding->binding]);
+        if (buffer != NULL) {
+            buffer->gpu_dirty = true;
+        }
+    }
+}
+
+// Check if any buffer bound to the shader was modified by the GPU
+static bool _nano_shader_has_gpu_dirty(nano_shader_t *shader) {
+    for (int i = 0; i < shader->info.binding_count; i++) {
+        nano_binding_info_t *binding = &shader->info.bindings[i];
+        if (binding->binding_type != BUFFER) {
+            continue;
+        }
+
+        nano_buffer_t *buffer =
+            nano_get_buffer(shader->buffers[binding->group][binding->binding]);
+        if (buffer != NULL && buffer->gpu_dirty) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Decide if a compute entry point should run on the CPU
+static bool _nano_shader_use_cpu(nano_shader_t *shader, int index) {
+    if (shader->cpu_kernels[index] == NULL) {
+        return false;
+    }
+    if (!nano_has_gpu()) {
+        return true;
+    }
+
+    switch (shader->exec_mode) {
+    case NANO_EXEC_GPU:
+        return false;
+    case NANO_EXEC_CPU:
+        return true;
+    case NANO_EXEC_AUTO:
+    default:
+        break;
+    }
+
+    // The host copies are stale, reading them back would cost more than
+    // any time the CPU could save
+    if (_nano_shader_has_gpu_dirty(shader)) {
+        return false;
+    }
+
+    // Time small dispatches on the CPU once so there is a cost to compare
+    if (shader->cpu_ns_per_elem <= 0.0) {
+        return shader->num_elems <= NANO_CPU_PROBE_ELEMS;
+    }
+
+    double cpu_ms = shader->cpu_ns_per_elem * (double)shader->num_elems / 1e6;
+    return cpu_ms < nano_app.gpu_latency_ms;
+}
+
+// Job data for running a CPU kernel with nano_parallel_for()
+typedef struct {
+    nano_cpu_kernel_t kernel;
+    const nano_cpu_bindings_t *bindings;
+} _nano_cpu_job_t;
+
+static void _nano_cpu_kernel_job(void *data, uint32_t begin, uint32_t end) {
+    _nano_cpu_job_t *job = (_nano_cpu_job_t *)data;
+    job->kernel(job->bindings, begin, end);
+}
+
+// Run a compute entry point's CPU kernel over every element of the shader
+// Buffers the kernel can write are uploaded afterwards when there is a
+// device, so GPU passes and readbacks see the results.
+static int _nano_shader_run_cpu_kernel(nano_shader_t *shader, int index) {
+    nano_cpu_kernel_t kernel = shader->cpu_kernels[index];
+    if (kernel == NULL) {
+        LOG_ERR("NANO: Shader %u: Entry point %s has no CPU kernel\n",
+                shader->id, shader->info.entry_points[index].entry);
+        return NANO_FAIL;
+    }
+
+    if (shader->num_elems == 0) {
+        LOG_ERR("NANO: Shader %u: Number of elements is 0. Be sure to set the "
+                "number of elements using nano_shader_set_num_elems()\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    if (shader->num_elems > UINT32_MAX) {
+        LOG_ERR("NANO: Shader %u: Too many elements for a CPU kernel\n",
+                shader->id);
+        return NANO_FAIL;
+    }
+
+    // Gather the host memory for every bound buffer
+    nano_cpu_bindings_t bindings = {.num_elems = shader->num_elems};
+    for (int i = 0; i < shader->info.binding_count; i++) {
+        nano_binding_info_t *binding = &shader->info.bindings[i];
+        if (binding->binding_type != BUFFER) {
+            continue;
+        }
+
+        uint32_t buffer_id = shader->buffers[binding->group][binding->binding];
+        nano_uniform_block_t *block =
+            buffer_id == 0 ? _nano_uniforms_find_block(
+                                 shader->id, binding->group, binding->binding)
+                           : NULL;
+        if (block != NULL) {
+            bindings.data[binding->group][binding->binding] =
+                nano_app.uniforms.shadow + block->offset;
+            bindings.size[binding->group][binding->binding] = block->size;
+            continue;
+        }
+
+        nano_buffer_t *buffer = nano_get_buffer(buffer_id);
+        if (buffer == NULL) {
+            LOG_ERR("NANO: Shader %u: No buffer bound to @group(%d) "
+                    "@binding(%d)\n",
+                    shader->id, binding->group, binding->binding);
+            return NANO_FAIL;
+        }
+
+        if (buffer->gpu_dirty) {
+            LOG("NANO: Shader %u: Buffer %s was written by the GPU, the CPU "
+                "kernel will read stale data\n",
+                shader->id, nano_atom_str(buffer->label));
+        }
+
+        bindings.data[binding->group][binding->binding] =
+            nano_buffer_host(buffer);
+        bindings.size[binding->group][binding->binding] = buffer->size;
+    }
+
+    _nano_cpu_job_t job = {.kernel = kernel, .bindings = &bindings};
+
+    double start = wgpu_now();
+    nano_parallel_for((uint32_t)shader->num_elems, NANO_CPU_GRAIN,
+                      _nano_cpu_kernel_job, &job);
+    double elapsed_ns = (wgpu_now() - start) * 1e6;
+
+    // Keep a moving average of the cost per element
+    double ns_per_elem = elapsed_ns / (double)shader->num_elems;
+    if (shader->cpu_ns_per_elem <= 0.0) {
+        shader->cpu_ns_per_elem = ns_per_elem;
+    } else {
+        shader->cpu_ns_per_elem =
+            0.75 * shader->cpu_ns_per_elem + 0.25 * ns_per_elem;
+    }
+
+    shader->ran_on_cpu = true;
+
+    // Upload the results so the GPU copies match the host copies
+    if (nano_has_gpu()) {
+        WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+        for (int i = 0; i < shader->info.binding_count; i++) {
+            nano_binding_info_t *binding = &shader->info.bindings[i];
+            if (!_nano_binding_is_writable(binding)) {
+                continue;
+            }
+
+            nano_buffer_t *buffer = nano_get_buffer(
+                shader->buffers[binding->group][binding->binding]);
+            wgpuQueueWriteBuffer(queue, buffer->buffer, buffer->offset,
+                                 nano_buffer_host(buffer), buffer->size);
+        }
+    }
+
+    return NANO_OK;
+}
+
+// Run every compute entry point of a shader on the CPU, regardless of the
+// execution mode. Every compute entry point needs a CPU kernel.
+// Useful for checking GPU results against a reference implementation.
+int nano_shader_execute_cpu(nano_shader_t *shader) {
+    if (shader == NULL) {
+        LOG_ERR("NANO: nano_shader_execute_cpu() -> Shader is NULL\n");
         return NANO_FAIL;
     }
 
-    // Iterate through the groups and create the bind group layout
-    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+    for (int i = 0; i < shader->info.entry_point_count; i++) {
+        if (shader->info.entry_points[i].type != COMPUTE) {
+            continue;
+        }
+
+        if (_nano_shader_run_cpu_kernel(shader, i) != NANO_OK) {
+            return NANO_FAIL;
+        }
+    }
+
+    return NANO_OK;
+}
+
+// Copy the data needed to execute a shader into a packet
+// Returns NANO_FAIL if the shader cannot be executed in its current state.
+static int _nano_build_packet(nano_shader_t *shader,
+                              nano_shader_packet_t *packet) {
+    *packet = (nano_shader_packet_t){
+        .shader_id = shader->id,
+        .num_layouts = (uint8_t)shader->layout.num_layouts,
+        .compute_index = -1,
+        .compute_pipeline = shader->compute_pipeline,
+        .render_pipeline = shader->render_pipeline,
+        .shader = shader,
+    };
+
+    for (int j = 0; j < shader->layout.num_layouts; j++) {
+        packet->bind_groups[j] = shader->bind_groups[j];
+    }
+
+    // Find the uniform buffer for the shader if it exists
+    if (shader->uniform_buffer != 0) {
+        packet->uniform_buffer = nano_get_buffer(shader->uniform_buffer);
+        if (packet->uniform_buffer == NULL) {
+            LOG_ERR("NANO: Shader %u: Could not find uniform buffer %u\n",
+                    shader->id, shader->uniform_buffer);
+            return NANO_FAIL;
+        }
+    }
+
+    for (int i = 0; i < shader->info.entry_point_count; i++) {
+        nano_entry_t *entry = &shader->info.entry_points[i];
+
+        // We handle compute shaders separately from vertex and fragment
+        if (entry->type == COMPUTE) {
+            packet->has_compute = true;
+            packet->compute_index = (int8_t)i;
+            packet->has_cpu_kernel = shader->cpu_kernels[i] != NULL;
+
+            // The number of workgroups is based on the number of elements
+            // expected to be processed by the compute shader
+            if (shader->num_elems == 0 && shader->workgroups[0] == 0) {
+                LOG_ERR("NANO: nano_shader_execute() -> Compute Shader %u: "
+                        "Number of elements is 0. Be sure to set the number of "
+                        "elements using nano_shader_set_num_elems()\n",
+                        shader->id);
+                return NANO_FAIL;
+            }
+        } else if (entry->type == VERTEX || entry->type == FRAGMENT) {
+            packet->has_render = true;
+        }
+    }
+
+    // Workgroups, counts, vertex and index buffers
+    return _nano_packet_set_params(shader, packet);
+}
+
+// Rebuild the packet array from the active shaders in order of activation
+static void _nano_build_packets(void) {
+    nano_shader_pool_t *pool = &nano_app.shader_pool;
+    pool->packet_count = 0;
+
+    int num_active_shaders = nano_num_active_shaders(pool);
+    for (int i = 0; i < num_active_shaders; i++) {
+        uint32_t shader_id = nano_get_active_shader_id(pool, i);
+        nano_shader_t *shader = nano_get_shader(shader_id);
+        if (shader == NULL) {
+            LOG_ERR("NANO: Shader %u is NULL\n", shader_id);
+            continue;
+        }
+
+        nano_shader_packet_t *packet = &pool->packets[pool->packet_count];
+        shader->packet_index = -1;
+        if (_nano_build_packet(shader, packet) == NANO_OK) {
+            shader->packet_index = (int16_t)pool->packet_count++;
+        }
+    }
+
+    pool->packets_dirty = false;
+}
 
-        // Bind group layout entries for the group
-        WGPUBindGroupLayoutEntry bgl_entries[NANO_GROUP_MAX_BINDINGS];
-        int num_bindings = 0;
+// Dispatch and draw a single packet
+static void _nano_execute_packet(nano_shader_packet_t *packet) {
 
-        // Iterate through the bindings in the group and create the bind
-        // group layout entries
-        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
-            int index = info->group_indices[i][j];
+    // Upload every uniform set since the last execution in one write
+    _nano_uniforms_flush();
 
-            // If the index is -1, we can break out of the loop early since
-            // we can assume that there are no more bindings in the group
-            if (index == -1) {
-                break;
+    // Update the uniform buffer data for the shader if it exists
+    if (packet->uniform_buffer != NULL) {
+        nano_write_buffer(packet->uniform_buffer);
+    }
+
+    if (packet->has_compute) {
+        // Run the entry point on the CPU if it has a kernel and we
+        // expect it to finish there before the GPU would
+        if (packet->has_cpu_kernel &&
+            _nano_shader_use_cpu(packet->shader, packet->compute_index)) {
+            _nano_shader_run_cpu_kernel(packet->shader, packet->compute_index);
+        } else if (!nano_has_gpu()) {
+            LOG_ERR("NANO: Shader %u: No device and no CPU kernel\n",
+                    packet->shader_id);
+            return;
+        } else if (packet->compute_pipeline == NULL) {
+            // Nothing to report while the pipeline is still compiling
+            if (packet->shader->pending_pipelines == 0) {
+                LOG_ERR("NANO: Shader %u: Compute pipeline is NULL\n",
+                        packet->shader_id);
             }
+            return;
+        } else {
+            packet->shader->ran_on_cpu = false;
 
-            // Get the binding information from the shaderinfo struct
-            nano_binding_info_t *binding =
-                &info->bindings[info->group_indices[i][j]];
-            WGPUBufferUsageFlags buffer_usage = binding->info.buffer_usage;
+            // Create a new command encoder for the compute pass
+            // We create a new command encoder for each compute pass
+            // to ensure that the compute shader is dispatched separately
+            WGPUCommandEncoder command_encoder =
+                wgpuDeviceCreateCommandEncoder(nano_app.wgpu->device, NULL);
 
-            // Set the according bindgroup layout entry for the
-            // binding
-            bgl_entries[j] = (WGPUBindGroupLayoutEntry){
-                .binding = (uint32_t)binding->binding,
-                // Temporarily set the visibility to none
-                .visibility = WGPUShaderStage_None,
-                // We use a ternary operator to determine the
-                // buffer type by inferring the type from
-                // binding usage. If it is a uniform, we know
-                // the binding type is a uniform buffer.
-                // Otherwise, we assume it is a storage buffer.
-                .buffer = {.type = (buffer_usage & WGPUBufferUsage_Uniform) != 0
-                                       ? WGPUBufferBindingType_Uniform
-                                       : WGPUBufferBindingType_Storage},
-            };
+            // Begin a compute pass to execute compute shader
+            WGPUComputePassEncoder compute_pass =
+                wgpuCommandEncoderBeginComputePass(command_encoder, NULL);
+            wgpuComputePassEncoderSetPipeline(compute_pass,
+                                              packet->compute_pipeline);
 
-            // Set the visibility of the binding based on the
-            // available entry point types in the shader
-            if (info->entry_indices.compute != -1) {
-                bgl_entries[j].visibility |= WGPUShaderStage_Compute;
-            }
-            if (info->entry_indices.fragment != -1) {
-                bgl_entries[j].visibility |= WGPUShaderStage_Fragment;
-            }
-            if (info->entry_indices.vertex != -1) {
-                bgl_entries[j].visibility |= WGPUShaderStage_Vertex;
+            // Set the bind groups for the compute pass
+            for (int j = 0; j < packet->num_layouts; j++) {
+                wgpuComputePassEncoderSetBindGroup(
+                    compute_pass, j, packet->bind_groups[j], 0, NULL);
             }
 
-            num_bindings++;
-        } // Middle level (j) for-loop
+            wgpuComputePassEncoderDispatchWorkgroups(
+                compute_pass, packet->workgroups[0], packet->workgroups[1],
+                packet->workgroups[2]);
 
-        // BINDGROUP LAYOUT CREATION
-        WGPUBindGroupLayoutDescriptor bg_layout_desc = {
-            .entryCount = (size_t)num_bindings,
-            .entries = bgl_entries,
-        };
+            // Finish the compute pass
+            wgpuComputePassEncoderEnd(compute_pass);
+            wgpuComputePassEncoderRelease(compute_pass);
 
-        if (num_bindings != 0) {
-            LOG("NANO: Shader %u: Creating bind group layout for group "
-                "%d with %d entries\n",
-                info->id, num_groups, num_bindings);
+            // submit the command buffer that contains the compute
+            WGPUCommandBuffer command_buffer =
+                wgpuCommandEncoderFinish(command_encoder, NULL);
+            WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+            wgpuQueueSubmit(queue, 1, &command_buffer);
 
-            // Assign the bind group layout to the bind group layout
-            // array so that we can create the
-            // WGPUPipelineLayoutDescriptor later.
-            bg_layouts[i] = wgpuDeviceCreateBindGroupLayout(
-                nano_app.wgpu->device, &bg_layout_desc);
-            if (bg_layouts[i] == NULL) {
-                LOG_ERR("NANO: Shader %u: Could not create bind group "
-                        "layout for group %d\n",
-                        info->id, num_groups);
-                return NANO_FAIL;
-            }
+            // Release the command encoder after we submit to the queue
+            wgpuCommandBufferRelease(command_buffer);
+            wgpuCommandEncoderRelease(command_encoder);
 
-            num_groups++;
-        } else {
-            // If there are no bindings in the group, we can break out of
-            // the loop early
-            break;
+            // The host copies of any written buffers are now stale
+            _nano_shader_mark_gpu_dirty(packet->shader);
+            _nano_gpu_latency_begin(queue);
         }
+    }
 
-    } // Top level (i) for-loop
+    // Nothing can be drawn without a device, or without instances
+    // The instance count of an indirect draw is only known by the GPU
+    if (!packet->has_render || !nano_has_gpu() ||
+        (packet->instance_count == 0 && packet->indirect_buffer == NULL)) {
+        return;
+    }
 
-    // Assign the number of layouts to the output layout
-    shader->layout.num_layouts = num_groups;
-    if (num_groups > 0) {
-        LOG("NANO: Shader %u: Created %d bind group layouts\n", info->id,
-            num_groups);
+    // Nothing to report while the pipeline is still compiling
+    if (packet->render_pipeline == NULL) {
+        if (packet->shader->pending_pipelines == 0) {
+            LOG_ERR("NANO: Shader %u: Render pipeline is NULL\n",
+                    packet->shader_id);
+        }
+        return;
     }
 
-    // Copy the bind group layouts to the output layout
-    memcpy(shader->layout.bg_layouts, &bg_layouts, sizeof(bg_layouts));
+    // Get the command encoder for the current nano pass
+    WGPUCommandEncoder command_encoder = nano_app.wgpu->cmd_encoder;
+
+    // If a shader has a vertex and fragment entry point, we can
+    // queue a render pass here. The render pass is recorded on the shared
+    // frame encoder, a compute shader gets its own command encoder so
+    // that it is dispatched separately.
+    WGPURenderPassDescriptor render_pass_desc = {
+        .colorAttachmentCount = 1,
+        .colorAttachments =
+            &(WGPURenderPassColorAttachment){
+                .view = wgpu_get_render_view(),
+                .depthSlice = ~0u,
+                .resolveTarget = wgpu_get_resolve_view(),
+                .loadOp = WGPULoadOp_Load,
+                .storeOp = WGPUStoreOp_Store,
+            },
+        .depthStencilAttachment = NULL,
+    };
 
-    return NANO_OK;
+    WGPURenderPassEncoder render_pass =
+        wgpuCommandEncoderBeginRenderPass(command_encoder, &render_pass_desc);
+    wgpuRenderPassEncoderSetPipeline(render_pass, packet->render_pipeline);
+
+    // Assign the bind groups for the render pass
+    for (int j = 0; j < packet->num_layouts; j++) {
+        wgpuRenderPassEncoderSetBindGroup(render_pass, j,
+                                          packet->bind_groups[j], 0, NULL);
+    }
+
+    // Assign the vertex buffers for the render pass
+    for (int j = 0; j < packet->vertex_buffer_count; j++) {
+        nano_buffer_t *buffer = packet->vertex_buffers[j];
+        uint64_t offset = packet->vertex_offsets[j];
+        wgpuRenderPassEncoderSetVertexBuffer(render_pass, j, buffer->buffer,
+                                             buffer->offset + offset,
+                                             buffer->size - offset);
+    }
+
+    // Draw the vertex buffer, vertex_count is the number of indices for
+    // indexed draws. Indirect draws read the counts from their buffer.
+    nano_buffer_t *indirect = packet->indirect_buffer;
+    if (packet->index_buffer != NULL) {
+        nano_buffer_t *buffer = packet->index_buffer;
+        wgpuRenderPassEncoderSetIndexBuffer(render_pass, buffer->buffer,
+                                            packet->index_format, 0,
+                                            buffer->size);
+        if (indirect != NULL) {
+            wgpuRenderPassEncoderDrawIndexedIndirect(
+                render_pass, indirect->buffer, packet->indirect_offset);
+        } else {
+            wgpuRenderPassEncoderDrawIndexed(render_pass, packet->vertex_count,
+                                             packet->instance_count, 0, 0, 0);
+        }
+    } else if (indirect != NULL) {
+        wgpuRenderPassEncoderDrawIndirect(render_pass, indirect->buffer,
+                                          packet->indirect_offset);
+    } else {
+        wgpuRenderPassEncoderDraw(render_pass, packet->vertex_count,
+                                  packet->instance_count, 0, 0);
+    }
+    wgpuRenderPassEncoderEnd(render_pass);
+    wgpuRenderPassEncoderRelease(render_pass);
 }
 
-// Build the shader pipelines for the shader
-// If the shader has multiple entry points, we can build multiple pipelines
-// The renderpipeline depends on the vertex and fragment entry points
-// The computepipeline depends on the compute entry point
-int nano_build_shader_pipelines(nano_shader_t *shader) {
+// Execute a shader pass for a single shader based on the
+// pipelines, and the bindgroups.
+// To access the data from the shader execution, we can use
+// nano_copy_buffer_to_cpu(...) to copy the data from the GPU buffer
+// to a struct in memory.
+void nano_shader_execute(nano_shader_t *shader) {
     if (shader == NULL) {
-        LOG_ERR("NANO: nano_build_shader_pipelines() -> Shader is NULL\n");
-        return NANO_FAIL;
+        LOG_ERR("NANO: nano_shader_execute() -> Shader is NULL\n");
+        return;
+    }
+    if (!shader->in_use) {
+        LOG_ERR("NANO: nano_shader_execute() -> Shader %u is not active\n",
+                shader->id);
+        return;
     }
 
-    wgpu_shader_info_t *info = &shader->info;
+    nano_shader_packet_t packet;
+    if (_nano_build_packet(shader, &packet) != NANO_OK) {
+        return;
+    }
 
-    int retval = NANO_OK;
-    int compute_index = info->entry_indices.compute;
-    int vertex_index = info->entry_indices.vertex;
-    int fragment_index = info->entry_indices.fragment;
+    _nano_execute_packet(&packet);
+}
 
-    // Create the pipeline layout descriptor
-    WGPUPipelineLayoutDescriptor pipeline_layout_desc = {
-        .label = (const char *)info->label,
-        .bindGroupLayoutCount = shader->layout.num_layouts,
-        .bindGroupLayouts = shader->layout.bg_layouts,
-    };
+// Iterate over all active shaders in the shader pool and execute each
+// shader with the appropriate bindgroups and pipelines loaded into the GPU.
+// Shaders are executed from the packet array, which is only rebuilt when
+// the active shaders change.
+void nano_execute_shaders(void) {
+    nano_shader_pool_t *pool = &nano_app.shader_pool;
+    if (pool->packets_dirty) {
+        _nano_build_packets();
+    }
 
-    // Create the pipeline layout object for the wgpu pipeline descriptor
-    WGPUPipelineLayout pipeline_layout_obj = wgpuDeviceCreatePipelineLayout(
-        nano_app.wgpu->device, &pipeline_layout_desc);
+    for (int i = 0; i < pool->packet_count; i++) {
+        _nano_execute_packet(&pool->packets[i]);
+    }
+}
 
-    // Create the compute shader module for WGSL shaders
-    WGPUShaderModuleWGSLDescriptor wgsl_desc = {
-        .chain =
-            {
-                .next = NULL,
-                .sType = WGPUSType_ShaderModuleWGSLDescriptor,
-            },
-        .code = info->source,
-    };
+// Mesh Functions
+// -------------------------------------------------
 
-    // This is the main descriptor that will be used to create the
-    // compute shader. We must include the WGSL descriptor in the
-    // nextInChain field.
-    WGPUShaderModuleDescriptor shader_desc = {
-        .nextInChain = (WGPUChainedStruct *)&wgsl_desc,
-        .label = (const char *)info->label,
-    };
+// Vertex format that reads an attribute stream as is
+// Returns WGPUVertexFormat_Undefined if WebGPU has no matching format.
+static WGPUVertexFormat
+_nano_mesh_vertex_format(const nano_mesh_stream_t *stream) {
+    bool norm = stream->normalized;
+    switch (stream->component_type) {
+    case NANO_MESH_F32: {
+        static const WGPUVertexFormat formats[] = {
+            WGPUVertexFormat_Float32,
+            WGPUVertexFormat_Float32x2,
+            WGPUVertexFormat_Float32x3,
+            WGPUVertexFormat_Float32x4,
+        };
+        return formats[stream->components - 1];
+    }
+    case NANO_MESH_U8:
+        if (stream->components == 2)
+            return norm ? WGPUVertexFormat_Unorm8x2 : WGPUVertexFormat_Uint8x2;
+        if (stream->components == 4)
+            return norm ? WGPUVertexFormat_Unorm8x4 : WGPUVertexFormat_Uint8x4;
+        break;
+    case NANO_MESH_I8:
+        if (stream->components == 2)
+            return norm ? WGPUVertexFormat_Snorm8x2 : WGPUVertexFormat_Sint8x2;
+        if (stream->components == 4)
+            return norm ? WGPUVertexFormat_Snorm8x4 : WGPUVertexFormat_Sint8x4;
+        break;
+    case NANO_MESH_U16:
+        if (stream->components == 2)
+            return norm ? WGPUVertexFormat_Unorm16x2
+                        : WGPUVertexFormat_Uint16x2;
+        if (stream->components == 4)
+            return norm ? WGPUVertexFormat_Unorm16x4
+                        : WGPUVertexFormat_Uint16x4;
+        break;
+    case NANO_MESH_I16:
+        if (stream->components == 2)
+            return norm ? WGPUVertexFormat_Snorm16x2
+                        : WGPUVertexFormat_Sint16x2;
+        if (stream->components == 4)
+            return norm ? WGPUVertexFormat_Snorm16x4
+                        : WGPUVertexFormat_Sint16x4;
+        break;
+    case NANO_MESH_U32: {
+        static const WGPUVertexFormat formats[] = {
+            WGPUVertexFormat_Uint32,
+            WGPUVertexFormat_Uint32x2,
+            WGPUVertexFormat_Uint32x3,
+            WGPUVertexFormat_Uint32x4,
+        };
+        return formats[stream->components - 1];
+    }
+    }
+    return WGPUVertexFormat_Undefined;
+}
 
-    // Declare shader modules for the different shader types
-    WGPUShaderModule shader_module =
-        wgpuDeviceCreateShaderModule(nano_app.wgpu->device, &shader_desc);
+// Round a value to a signed or unsigned normalized integer
+static inline int32_t _nano_mesh_snorm(float value, float max) {
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (int32_t)(value * max + (value < 0.0f ? -0.5f : 0.5f));
+}
 
-    // Create the compute pipeline if the compute entry index is valid
-    if (compute_index != -1) {
+static inline uint32_t _nano_mesh_unorm(float value, float max) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (uint32_t)(value * max + 0.5f);
+}
 
-        WGPUComputePipelineDescriptor pipeline_desc = {
-            .layout = pipeline_layout_obj,
-            .compute =
-                {
-                    .module = shader_module,
-                    .entryPoint = info->entry_points[compute_index].entry,
-                },
-        };
+// Quantize a float attribute stream into the frame arena
+// Sets the stride and format of the packed stream, returns NULL if the
+// arena is out of memory.
+static void *_nano_mesh_quantize(const nano_mesh_stream_t *stream,
+                                 nano_mesh_attribute_t attribute,
+                                 const nano_mesh_t *mesh, uint32_t *stride,
+                                 WGPUVertexFormat *format) {
+    uint32_t count = mesh->vertex_count;
+    *stride = attribute == NANO_MESH_POSITION ? 8 : 4;
+    uint8_t *packed = (uint8_t *)nano_arena_alloc(&nano_frame_arena,
+                                                  (size_t)count * *stride);
+    if (packed == NULL) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        float v[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        memcpy(v, stream->data + (size_t)i * stream->stride,
+               stream->components * sizeof(float));
+        uint8_t *out = packed + (size_t)i * *stride;
 
-        if (shader->compute_pipeline) {
-            wgpuComputePipelineRelease(shader->compute_pipeline);
+        switch (attribute) {
+        case NANO_MESH_POSITION: {
+            // w stays 1 so the shader can read the position as a vec4
+            int16_t q[4] = {0, 0, 0, 32767};
+            for (int c = 0; c < 3; c++) {
+                q[c] = (int16_t)_nano_mesh_snorm(
+                    (v[c] - mesh->offset[c]) / mesh->scale[c], 32767.0f);
+            }
+            memcpy(out, q, sizeof(q));
+            break;
         }
+        case NANO_MESH_NORMAL: {
+            int8_t q[4] = {0, 0, 0, 0};
+            for (int c = 0; c < 3; c++) {
+                q[c] = (int8_t)_nano_mesh_snorm(v[c], 127.0f);
+            }
+            memcpy(out, q, sizeof(q));
+            break;
+        }
+        case NANO_MESH_TEXCOORD: {
+            // Coordinates outside of [0, 1] for wrapping are clamped
+            uint16_t q[2];
+            for (int c = 0; c < 2; c++) {
+                q[c] = (uint16_t)_nano_mesh_unorm(v[c], 65535.0f);
+            }
+            memcpy(out, q, sizeof(q));
+            break;
+        }
+        default:
+            for (int c = 0; c < 4; c++) {
+                out[c] = (uint8_t)_nano_mesh_unorm(v[c], 255.0f);
+            }
+            break;
+        }
+    }
+
+    static const WGPUVertexFormat formats[NANO_MESH_ATTRIBUTE_COUNT] = {
+        [NANO_MESH_POSITION] = WGPUVertexFormat_Snorm16x4,
+        [NANO_MESH_NORMAL] = WGPUVertexFormat_Snorm8x4,
+        [NANO_MESH_TEXCOORD] = WGPUVertexFormat_Unorm16x2,
+        [NANO_MESH_COLOR] = WGPUVertexFormat_Unorm8x4,
+    };
+    *format = formats[attribute];
 
-        // Set the WGPU pipeline object in our shader info struct
-        shader->compute_pipeline = wgpuDeviceCreateComputePipeline(
-            nano_app.wgpu->device, &pipeline_desc);
+    return packed;
+}
+
+// Create a buffer in the buffer pool and upload size bytes of data to it
+// Meshes write straight from the mapped file, data may be NULL to leave the
+// buffer zeroed. WGPU only writes multiples of 4 bytes, so a partial last
+// word is copied and padded first. The id is unique even if the label is
+// not, so the same mesh can be loaded twice.
+static uint32_t _nano_create_pool_buffer(const char *label,
+                                         WGPUBufferUsageFlags usage,
+                                         const void *data, size_t size) {
+    size_t aligned_size = (size + 3) & ~(size_t)3;
+    nano_atom_t label_atom = nano_intern(label);
+    if (label_atom == 0) {
+        LOG_ERR("NANO: Could not intern the label of buffer %s\n", label);
+        return 0;
     }
 
-    // If both the vertex and fragment entry indices are valid, we can
-    // create a render pipeline for the shader
-    if (vertex_index != -1 && fragment_index != -1) {
+    WGPUBuffer gpu_buffer = wgpuDeviceCreateBuffer(
+        nano_app.wgpu->device, &(WGPUBufferDescriptor){
+                                   .label = nano_atom_str(label_atom),
+                                   .usage = usage | WGPUBufferUsage_CopyDst,
+                                   .size = aligned_size,
+                               });
+    if (gpu_buffer == NULL) {
+        LOG_ERR("NANO: Could not create buffer %s\n", label);
+        return 0;
+    }
 
-        WGPURenderPipelineDescriptor renderPipelineDesc = {
-            .label = (const char *)info->label,
-            .layout = pipeline_layout_obj,
-            .vertex =
-                {
-                    .module = shader_module,
-                    .entryPoint = info->entry_points[vertex_index].entry,
-                    .bufferCount = shader->vertex_buffer_count,
-                    .buffers = &shader->vertex_buffers[0].vertex_buffer_layout,
-                },
-            .primitive = {.topology = WGPUPrimitiveTopology_TriangleList,
-                          .stripIndexFormat = WGPUIndexFormat_Undefined,
-                          .frontFace = WGPUFrontFace_CCW,
-                          .cullMode = WGPUCullMode_None},
-            .multisample =
-                (WGPUMultisampleState){
-                    .count = nano_app.settings.gfx.msaa.sample_count,
-                    .mask = ~0u,
-                    .alphaToCoverageEnabled = false,
-                },
-            .fragment =
-                &(WGPUFragmentState){
-                    .module = shader_module,
-                    .entryPoint = info->entry_points[fragment_index].entry,
-                    .targetCount = 1,
-                    .targets =
-                        &(WGPUColorTargetState){
-                            .format = wgpu_get_color_format(),
-                            .blend =
-                                &(WGPUBlendState){
-                                    .color =
-                                        (WGPUBlendComponent){
-                                            .operation = WGPUBlendOperation_Add,
-                                            .srcFactor = WGPUBlendFactor_One,
-                                            .dstFactor = WGPUBlendFactor_One,
-                                        },
-                                    .alpha =
-                                        (WGPUBlendComponent){
-                                            .operation = WGPUBlendOperation_Add,
-                                            .srcFactor = WGPUBlendFactor_One,
-                                            .dstFactor = WGPUBlendFactor_One,
-                                        },
-                                },
-                            .writeMask = WGPUColorWriteMask_All,
-                        },
-                },
-            // TODO: Add other render pipeline attributes here
-        };
+    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    size_t body_size = size & ~(size_t)3;
+    if (data != NULL && body_size > 0) {
+        wgpuQueueWriteBuffer(queue, gpu_buffer, 0, data, body_size);
+    }
+    if (data != NULL && body_size < size) {
+        uint8_t tail[4] = {0};
+        memcpy(tail, (const uint8_t *)data + body_size, size - body_size);
+        wgpuQueueWriteBuffer(queue, gpu_buffer, body_size, tail, 4);
+    }
 
-        if (shader->render_pipeline) {
-            wgpuRenderPipelineRelease(shader->render_pipeline);
-        }
-        // Assign the render pipeline to the shader info struct
-        shader->render_pipeline = wgpuDeviceCreateRenderPipeline(
-            nano_app.wgpu->device, &renderPipelineDesc);
+    nano_buffer_pool_t *pool = &nano_app.buffer_pool;
+    nano_spin_lock(&pool->lock);
+
+    // Start from the hash of the label and skip the ids that are taken
+    uint32_t buffer_id = fnv1a_32(label);
+    while (buffer_id == 0 || nano_find_buffer_slot(pool, buffer_id) >= 0) {
+        buffer_id++;
+    }
+
+    // The GPU copy is the only copy, so the buffer has no host data
+    nano_buffer_t buffer = {
+        .id = buffer_id,
+        .buffer = gpu_buffer,
+        .size = aligned_size,
+        .count = 1,
+        .label = label_atom,
+    };
+
+    int slot = nano_find_empty_buffer_slot(pool, buffer_id);
+    if (slot < 0) {
+        nano_spin_unlock(&pool->lock);
+        LOG_ERR("NANO: Could not add buffer %s, the buffer pool is full\n",
+                label);
+        wgpuBufferRelease(gpu_buffer);
+        return 0;
+    }
 
-        // Write the vertex buffer data to the GPU so it can be used in the
-        // shader pipeline
-        WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    pool->buffers[slot].buffer_entry = buffer;
+    nano_buffer_array_push(&pool->active_buffers, slot);
+    pool->buffer_count++;
+    pool->buffers[slot].occupied = true;
+    nano_spin_unlock(&pool->lock);
 
-        // Write the vertex buffer data to the GPU
-        for (int i = 0; i < shader->vertex_buffer_count; i++) {
-            nano_vertex_buffer_t *vertex_buffer = &shader->vertex_buffers[i];
-            nano_buffer_t *buffer = nano_get_buffer(vertex_buffer->buffer_id);
-            if (buffer == NULL) {
-                LOG_ERR("NANO: Shader %u: Could not find vertex buffer %u. Did "
-                        "you create it?\n",
-                        info->id, vertex_buffer->buffer_id);
-                return NANO_FAIL;
-            }
-            // Write the buffer data to the GPU
-            nano_write_buffer(buffer);
-            LOG("NANO: Shader %u: Wrote vertex buffer data to GPU buffer "
-                "%p\n",
-                info->id, buffer->buffer);
-        }
-        LOG("NANO: Shader %u: Created Render Pipeline\n", info->id);
+    return buffer_id;
+}
 
-        // If the vertex or fragment entry indices are valid, but the other
-        // is not, we can't create a render pipeline
-    } else if (vertex_index != -1 || fragment_index != -1) {
-        LOG_ERR("NANO: Shader %u: Could not create render pipeline. Missing "
-                "paired vertex/fragment shader\n",
-                info->id);
-        retval = NANO_FAIL;
+// Release the buffers of a mesh
+// Shaders bound to the mesh only borrow its buffers, so this must be called
+// once the mesh is no longer drawn.
+void nano_release_mesh(nano_mesh_t *mesh) {
+    if (mesh == NULL) {
+        return;
     }
 
-    // Release the shader modules if they are not null
-    if (shader_module)
-        wgpuShaderModuleRelease(shader_module);
+    for (int i = 0; i < NANO_MESH_ATTRIBUTE_COUNT; i++) {
+        if (mesh->vertex_buffers[i] != 0) {
+            nano_release_buffer(mesh->vertex_buffers[i]);
+        }
+    }
+    if (mesh->index_buffer != 0) {
+        nano_release_buffer(mesh->index_buffer);
+    }
 
-    return retval;
+    *mesh = (nano_mesh_t){0};
 }
 
-// Called by nano_validate_shader() to build the bind groups for the shader
-// Do not call this function directly
-int nano_build_bindgroups(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_build_bindgroups() -> Shader is NULL\n");
+// Load a .obj or .glb file into vertex and index buffers in the buffer pool
+// Every attribute gets its own vertex buffer. glTF data is uploaded straight
+// from the mapped file unless it is quantized, see nano_mesh_flags_t.
+// Must be called on the render thread.
+int nano_load_mesh(const char *path, uint32_t flags, nano_mesh_t *mesh) {
+    if (path == NULL || mesh == NULL) {
+        LOG_ERR("NANO: nano_load_mesh() -> Path or mesh is NULL\n");
         return NANO_FAIL;
     }
 
-    // Return early if the shader has no layouts
-    int num_layouts = shader->layout.num_layouts;
-    if (shader->layout.num_layouts <= 0) {
-        return NANO_OK;
+    if (!nano_has_gpu() || !nano_is_render_thread()) {
+        LOG_ERR("NANO: nano_load_mesh() -> Meshes can only be loaded on the "
+                "render thread\n");
+        return NANO_FAIL;
     }
 
-    if (shader->in_use) {
-        fprintf(stderr, "NANO: nano_build_bindgroups() -> Shader is "
-                        "currently in use\n");
+    nano_mesh_data_t data;
+    if (!nano_mesh_load(path, &data)) {
+        LOG_ERR("NANO: nano_load_mesh() -> Could not load %s\n", path);
         return NANO_FAIL;
     }
 
-    wgpu_shader_info_t *info = &shader->info;
+    *mesh = (nano_mesh_t){
+        .vertex_count = data.vertex_count,
+        .index_count = data.index_count,
+        .quantized = (flags & NANO_MESH_QUANTIZE) != 0,
+    };
 
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_build_bindgroups() -> Shader info is NULL\n");
-        return NANO_FAIL;
+    for (int c = 0; c < 3; c++) {
+        mesh->bounds_min[c] = data.bounds_min[c];
+        mesh->bounds_max[c] = data.bounds_max[c];
+        mesh->scale[c] = 1.0f;
+        mesh->offset[c] = 0.0f;
+
+        // Quantized positions cover the bounds from -1 to 1
+        float extent = (data.bounds_max[c] - data.bounds_min[c]) * 0.5f;
+        if (mesh->quantized && extent > 0.0f) {
+            mesh->scale[c] = extent;
+            mesh->offset[c] = data.bounds_min[c] + extent;
+        }
     }
 
-    WGPUBindGroupEntry *bg_entries[num_layouts];
-
-    // Iterate through the groups and create the bind groups
-    for (int i = 0; i < NANO_MAX_GROUPS; i++) {
+    static const char *attribute_labels[NANO_MESH_ATTRIBUTE_COUNT] = {
+        [NANO_MESH_POSITION] = "Positions",
+        [NANO_MESH_NORMAL] = "Normals",
+        [NANO_MESH_TEXCOORD] = "Texcoords",
+        [NANO_MESH_COLOR] = "Colors",
+    };
 
-        bool group_empty = true;
-        uint32_t count = 0;
+    char label[NANO_MAX_IDENT_LENGTH];
+    int status = NANO_OK;
+    nano_arena_mark_t mark = nano_arena_mark(&nano_frame_arena);
 
-        for (int j = 0; j < NANO_GROUP_MAX_BINDINGS; j++) {
+    for (int i = 0; i < NANO_MESH_ATTRIBUTE_COUNT && status == NANO_OK; i++) {
+        nano_mesh_stream_t *stream = &data.attributes[i];
+        if (stream->data == NULL) {
+            continue;
+        }
 
-            // If a binding is empty, we can break out of the loop early
-            // and assume that there are no more bindings in the group
-            if (info->group_indices[i][j] == -1) {
+        const void *bytes = stream->data;
+        size_t size = stream->size;
+        uint32_t stride = stream->stride;
+        WGPUVertexFormat format = _nano_mesh_vertex_format(stream);
+
+        if (mesh->quantized && stream->component_type == NANO_MESH_F32) {
+            bytes = _nano_mesh_quantize(stream, (nano_mesh_attribute_t)i,
+                                        mesh, &stride, &format);
+            size = (size_t)stride * mesh->vertex_count;
+            if (bytes == NULL) {
+                LOG_ERR("NANO: nano_load_mesh() -> Memory allocation "
+                        "failed\n");
+                status = NANO_FAIL;
                 break;
-            } else {
-                group_empty = false;
-                count++;
             }
         }
 
-        // If the group is empty, we can break out of the loop early
-        // and assume that there are no more groups to build
-        if (group_empty) {
-            break;
+        if (format == WGPUVertexFormat_Undefined) {
+            LOG_ERR("NANO: nano_load_mesh() -> %s: %s have no matching "
+                    "vertex format, skipping them\n",
+                    path, attribute_labels[i]);
+            continue;
         }
 
-        // Otherwise we create a BindGroupEntry list for each binding in the
-        // group
-        WGPUBindGroupEntry bg_entry[count];
-
-        // Iterate through the bindings in the group and create the bind
-        // group. Remember: when defining bindings, make sure to not skip
-        // numbers. Always increase the binding number by 1, or increase the
-        // group number by 1 and return to 0.
-        for (int j = 0; j < count; j++) {
-            int index = info->group_indices[i][j];
-            nano_binding_info_t binding = info->bindings[index];
-
-            // If the buffer usage is not none, we can create the bindgroup
-            // entry
-            // TODO: Add support for textures and samplers as bindings
-            if (binding.info.buffer_usage != WGPUBufferUsage_None) {
-                // Retrieve the buffer id from the shader info struct
-                uint32_t buffer_id = shader->buffers[i][j];
-                // Retrieve the buffer from the buffer pool using the id
-                nano_buffer_t *buffer = nano_get_buffer(buffer_id);
-                if (buffer == NULL) {
-                    LOG_ERR("NANO: Shader %u: Could not find buffer %u\n",
-                            info->id, buffer_id);
-                    return NANO_FAIL;
-                }
-
-                // Create the bind group entry for the buffer
-                bg_entry[j] = (WGPUBindGroupEntry){
-                    .binding = (uint32_t)binding.binding,
-                    .buffer = buffer->buffer,
-                    .offset = buffer->offset,
-                    .size = buffer->size,
-                };
-            }
+        snprintf(label, sizeof(label), "%s %s", path, attribute_labels[i]);
+        mesh->vertex_buffers[i] = _nano_create_pool_buffer(
+            label, WGPUBufferUsage_Vertex, bytes, size);
+        if (mesh->vertex_buffers[i] == 0) {
+            status = NANO_FAIL;
+            break;
         }
 
-        WGPUBindGroupDescriptor bg_desc = {
-            .layout = shader->layout.bg_layouts[i],
-            .entryCount = count,
-            .entries = bg_entry,
+        mesh->attributes[i] = (WGPUVertexAttribute){
+            .format = format,
+            .offset = 0,
+            .shaderLocation = (uint32_t)i,
         };
+        mesh->strides[i] = stride;
+    }
 
-        if (shader->bind_groups[i] != NULL) {
-            wgpuBindGroupRelease(shader->bind_groups[i]);
-        }
+    nano_arena_rewind(&nano_frame_arena, mark);
 
-        shader->bind_groups[i] =
-            wgpuDeviceCreateBindGroup(nano_app.wgpu->device, &bg_desc);
-        if (shader->bind_groups[i] == NULL) {
-            fprintf(stderr,
-                    "NANO: Shader %u: Could not create bind group for "
-                    "group %d\n",
-                    info->id, i);
-            return NANO_FAIL;
+    if (status == NANO_OK && data.indices.data != NULL) {
+        snprintf(label, sizeof(label), "%s Indices", path);
+        mesh->index_buffer =
+            _nano_create_pool_buffer(label, WGPUBufferUsage_Index,
+                                     data.indices.data, data.indices.size);
+        mesh->index_format = data.indices.component_type == NANO_MESH_U32
+                                 ? WGPUIndexFormat_Uint32
+                                 : WGPUIndexFormat_Uint16;
+        if (mesh->index_buffer == 0) {
+            status = NANO_FAIL;
         }
     }
 
-    return NANO_OK;
-}
+    // The GPU has its own copy, the file can be unmapped
+    nano_mesh_free(&data);
 
-WGPUBindGroup nano_get_bindgroup(nano_shader_t *shader, int group) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_get_bindgroup() -> Shader is NULL\n");
-        return NULL;
+    if (status != NANO_OK) {
+        nano_release_mesh(mesh);
+        return NANO_FAIL;
     }
 
-    if (group < 0 || group >= NANO_MAX_GROUPS) {
-        LOG_ERR("NANO: nano_get_bindgroup() -> Invalid group\n");
-        return NULL;
-    }
+    LOG("NANO: Loaded mesh %s: %u vertices, %u indices%s\n", path,
+        mesh->vertex_count, mesh->index_count,
+        mesh->quantized ? " (quantized)" : "");
 
-    return shader->bind_groups[group];
+    return NANO_OK;
 }
 
-// Find the indices of the entry points in the shader info struct
-wgsl_shader_indices_t nano_precompute_entry_indices(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_precompute_entry_indices() -> Shader is NULL\n");
-        return (wgsl_shader_indices_t){-1, -1, -1};
+// Map a vertex input name to the mesh attribute it reads
+// Returns -1 if the name does not look like any attribute.
+static int _nano_mesh_match_input(const char *name) {
+    char lower[NANO_REFLECT_NAME_LENGTH];
+    size_t i = 0;
+    for (; name[i] != '\0' && i < sizeof(lower) - 1; i++) {
+        lower[i] = (char)tolower((unsigned char)name[i]);
+    }
+    lower[i] = '\0';
+
+    if (strstr(lower, "pos"))
+        return NANO_MESH_POSITION;
+    if (strstr(lower, "norm"))
+        return NANO_MESH_NORMAL;
+    if (strstr(lower, "uv") || strstr(lower, "tex"))
+        return NANO_MESH_TEXCOORD;
+    if (strstr(lower, "col"))
+        return NANO_MESH_COLOR;
+    return -1;
+}
+
+// Bind the vertex and index buffers of a mesh to a render shader
+// The reflected @location inputs of the vertex entry point, including the
+// members of struct inputs, are matched to the mesh attributes by name:
+// position, normal, uv or texcoord, and color. Must be called before the
+// shader is activated. The shader borrows the buffers, they stay owned by
+// the mesh and are released by nano_release_mesh().
+int nano_shader_bind_mesh(nano_shader_t *shader, nano_mesh_t *mesh) {
+    if (shader == NULL || mesh == NULL) {
+        LOG_ERR("NANO: nano_shader_bind_mesh() -> Shader or mesh is NULL\n");
+        return NANO_FAIL;
     }
 
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_precompute_entry_indices() -> Shader info is "
-                "NULL\n");
-        return (wgsl_shader_indices_t){-1, -1, -1};
+    if (shader->vertex_input_count == 0) {
+        LOG_ERR("NANO: Shader %u: nano_shader_bind_mesh() -> Shader has no "
+                "vertex inputs\n",
+                shader->id);
+        return NANO_FAIL;
     }
 
-    // -1 means no entry point found
-    wgsl_shader_indices_t indices = {-1, -1, -1};
+    for (int i = 0; i < shader->vertex_input_count; i++) {
+        nano_wgsl_vertex_input_t *input = &shader->vertex_inputs[i];
+        int attribute = _nano_mesh_match_input(input->name);
+        if (attribute < 0 || mesh->vertex_buffers[attribute] == 0) {
+            LOG_ERR("NANO: Shader %u: nano_shader_bind_mesh() -> Mesh has no "
+                    "attribute for input %s\n",
+                    shader->id, input->name);
+            return NANO_FAIL;
+        }
 
-    // Iterate through the entry points and find the index of the
-    // entry point in the shader info struct
-    for (int i = 0; i < info->entry_point_count; i++) {
-        switch (info->entry_points[i].type) {
-            case VERTEX:
-                indices.vertex = i;
-                break;
-            case FRAGMENT:
-                indices.fragment = i;
-                break;
-            case COMPUTE:
-                indices.compute = i;
-                break;
-            default:
-                break;
+        WGPUVertexAttribute vertex_attribute = mesh->attributes[attribute];
+        vertex_attribute.shaderLocation = input->location;
+        int status = _nano_shader_add_vertex_buffer(
+            shader, mesh->vertex_buffers[attribute], &vertex_attribute, 1,
+            mesh->strides[attribute], WGPUVertexStepMode_Vertex);
+        if (status != NANO_OK) {
+            return NANO_FAIL;
         }
+
+        // The mesh keeps ownership of its buffers
+        shader->vertex_buffers[shader->vertex_buffer_count - 1].borrowed =
+            true;
     }
 
-    return indices;
+    if (mesh->index_buffer != 0) {
+        int status = nano_shader_set_index_buffer(
+            shader, mesh->index_buffer, mesh->index_format, mesh->index_count);
+        shader->index_borrowed = status == NANO_OK;
+        return status;
+    }
+
+    return nano_shader_set_vertex_count(shader, mesh->vertex_count);
 }
 
-// Shader Functions
+// GPU Statistics Functions
 // -------------------------------------------------
 
-// validate a shader to ensure that it is ready to be used
-int nano_validate_shader(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_validate_shader() -> Shader is NULL\n");
-        return NANO_FAIL;
+// WGSL source for the built-in statistics kernels
+// Every kernel grid-strides over the source buffer so the number of
+// workgroups is capped and the partial results stay small enough to be
+// reduced by a single workgroup.
+const char *nano_stats_wgsl =
+    "const WG_SIZE: u32 = 256u;\n"
+    "const TOP_K_WG_SIZE: u32 = 64u;\n"
+    "const TOP_K: u32 = 16u;\n"
+    "const F32_MAX: f32 = 3.40282347e+38;\n"
+    "\n"
+    "struct Params {\n"
+    "    count: u32,\n"
+    "    bin_count: u32,\n"
+    "    range_min: f32,\n"
+    "    range_max: f32,\n"
+    "    partial_count: u32,\n"
+    "    top_k_partial_count: u32,\n"
+    "    pad0: u32,\n"
+    "    pad1: u32,\n"
+    "};\n"
+    "\n"
+    "struct Moments {\n"
+    "    count: f32,\n"
+    "    mean: f32,\n"
+    "    m2: f32,\n"
+    "    min_value: f32,\n"
+    "    max_value: f32,\n"
+    "};\n"
+    "\n"
+    "struct Candidate {\n"
+    "    value: f32,\n"
+    "    index: u32,\n"
+    "};\n"
+    "\n"
+    "struct Result {\n"
+    "    min_value: f32,\n"
+    "    max_value: f32,\n"
+    "    mean: f32,\n"
+    "    variance: f32,\n"
+    "    count: u32,\n"
+    "    pad0: u32,\n"
+    "    pad1: u32,\n"
+    "    pad2: u32,\n"
+    "    top_k_values: array<f32, 16>,\n"
+    "    top_k_indices: array<u32, 16>,\n"
+    "    bins: array<atomic<u32>, 256>,\n"
+    "};\n"
+    "\n"
+    "@group(0) @binding(0) var<uniform> params: Params;\n"
+    "@group(0) @binding(1) var<storage, read> src: array<f32>;\n"
+    "@group(0) @binding(2) var<storage, read_write> result: Result;\n"
+    "@group(0) @binding(3) var<storage, read_write> partials: "
+    "array<Moments>;\n"
+    "@group(0) @binding(4) var<storage, read_write> top_k_partials: "
+    "array<Candidate>;\n"
+    "\n"
+    "var<workgroup> local_bins: array<atomic<u32>, 256>;\n"
+    "var<workgroup> local_moments: array<Moments, 256>;\n"
+    "var<workgroup> local_top_k: array<Candidate, 1024>;\n"
+    "\n"
+    "@compute @workgroup_size(256)\n"
+    "fn histogram(@builtin(global_invocation_id) gid: vec3<u32>,\n"
+    "             @builtin(local_invocation_index) lid: u32,\n"
+    "             @builtin(num_workgroups) nwg: vec3<u32>) {\n"
+    "    atomicStore(&local_bins[lid], 0u);\n"
+    "    workgroupBarrier();\n"
+    "    let stride = nwg.x * WG_SIZE;\n"
+    "    let last = i32(params.bin_count) - 1;\n"
+    "    let scale = f32(params.bin_count) / "
+    "(params.range_max - params.range_min);\n"
+    "    for (var i = gid.x; i < params.count; i = i + stride) {\n"
+    "        let t = (src[i] - params.range_min) * scale;\n"
+    "        let b = clamp(i32(floor(t)), 0, last);\n"
+    "        atomicAdd(&local_bins[b], 1u);\n"
+    "    }\n"
+    "    workgroupBarrier();\n"
+    "    if (lid < params.bin_count) {\n"
+    "        let n = atomicLoad(&local_bins[lid]);\n"
+    "        if (n > 0u) {\n"
+    "            atomicAdd(&result.bins[lid], n);\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "fn empty_moments() -> Moments {\n"
+    "    return Moments(0.0, 0.0, 0.0, F32_MAX, -F32_MAX);\n"
+    "}\n"
+    "\n"
+    "// Chan et al. parallel combination of two partial moments\n"
+    "fn combine(a: Moments, b: Moments) -> Moments {\n"
+    "    let n = a.count + b.count;\n"
+    "    if (n == 0.0) {\n"
+    "        return a;\n"
+    "    }\n"
+    "    let d = b.mean - a.mean;\n"
+    "    var r: Moments;\n"
+    "    r.count = n;\n"
+    "    r.mean = a.mean + d * b.count / n;\n"
+    "    r.m2 = a.m2 + b.m2 + d * d * a.count * b.count / n;\n"
+    "    r.min_value = min(a.min_value, b.min_value);\n"
+    "    r.max_value = max(a.max_value, b.max_value);\n"
+    "    return r;\n"
+    "}\n"
+    "\n"
+    "// Grid-stride over the source with Welford's online update\n"
+    "fn accumulate_moments(first: u32, stride: u32) -> Moments {\n"
+    "    var m = empty_moments();\n"
+    "    for (var i = first; i < params.count; i = i + stride) {\n"
+    "        let v = src[i];\n"
+    "        m.count = m.count + 1.0;\n"
+    "        let d = v - m.mean;\n"
+    "        m.mean = m.mean + d / m.count;\n"
+    "        m.m2 = m.m2 + d * (v - m.mean);\n"
+    "        m.min_value = min(m.min_value, v);\n"
+    "        m.max_value = max(m.max_value, v);\n"
+    "    }\n"
+    "    return m;\n"
+    "}\n"
+    "\n"
+    "fn load_partial(lid: u32) -> Moments {\n"
+    "    if (lid < params.partial_count) {\n"
+    "        return partials[lid];\n"
+    "    }\n"
+    "    return empty_moments();\n"
+    "}\n"
+    "\n"
+    "fn store_moments(r: Moments) {\n"
+    "    result.min_value = r.min_value;\n"
+    "    result.max_value = r.max_value;\n"
+    "    result.mean = r.mean;\n"
+    "    result.variance = select(0.0, r.m2 / r.count, r.count > 0.0);\n"
+    "    result.count = u32(r.count);\n"
+    "}\n"
+    "\n"
+    "// Merge two sorted (descending) candidate lists into list a\n"
+    "fn merge_top_k(a: u32, b: u32) {\n"
+    "    var merged: array<Candidate, 16>;\n"
+    "    var i = 0u;\n"
+    "    var j = 0u;\n"
+    "    for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "        let ca = local_top_k[a * TOP_K + i];\n"
+    "        let cb = local_top_k[b * TOP_K + j];\n"
+    "        if (ca.value >= cb.value) {\n"
+    "            merged[n] = ca;\n"
+    "            i = i + 1u;\n"
+    "        } else {\n"
+    "            merged[n] = cb;\n"
+    "            j = j + 1u;\n"
+    "        }\n"
+    "    }\n"
+    "    for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "        local_top_k[a * TOP_K + n] = merged[n];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "fn reduce_top_k(lid: u32) {\n"
+    "    for (var s = TOP_K_WG_SIZE / 2u; s > 0u; s = s >> 1u) {\n"
+    "        if (lid < s) {\n"
+    "            merge_top_k(lid, lid + s);\n"
+    "        }\n"
+    "        workgroupBarrier();\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(64)\n"
+    "fn top_k_partial(@builtin(global_invocation_id) gid: vec3<u32>,\n"
+    "                 @builtin(local_invocation_index) lid: u32,\n"
+    "                 @builtin(workgroup_id) wid: vec3<u32>,\n"
+    "                 @builtin(num_workgroups) nwg: vec3<u32>) {\n"
+    "    var best: array<Candidate, 16>;\n"
+    "    for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "        best[n] = Candidate(-F32_MAX, 0xffffffffu);\n"
+    "    }\n"
+    "    let stride = nwg.x * TOP_K_WG_SIZE;\n"
+    "    for (var i = gid.x; i < params.count; i = i + stride) {\n"
+    "        let v = src[i];\n"
+    "        if (v > best[TOP_K - 1u].value) {\n"
+    "            var p = TOP_K - 1u;\n"
+    "            while (p > 0u && best[p - 1u].value < v) {\n"
+    "                best[p] = best[p - 1u];\n"
+    "                p = p - 1u;\n"
+    "            }\n"
+    "            best[p] = Candidate(v, i);\n"
+    "        }\n"
+    "    }\n"
+    "    for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "        local_top_k[lid * TOP_K + n] = best[n];\n"
+    "    }\n"
+    "    workgroupBarrier();\n"
+    "    reduce_top_k(lid);\n"
+    "    if (lid == 0u) {\n"
+    "        for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "            top_k_partials[wid.x * TOP_K + n] = local_top_k[n];\n"
+    "        }\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(64)\n"
+    "fn top_k_final(@builtin(local_invocation_index) lid: u32) {\n"
+    "    for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "        var c = Candidate(-F32_MAX, 0xffffffffu);\n"
+    "        if (lid < params.top_k_partial_count) {\n"
+    "            c = top_k_partials[lid * TOP_K + n];\n"
+    "        }\n"
+    "        local_top_k[lid * TOP_K + n] = c;\n"
+    "    }\n"
+    "    workgroupBarrier();\n"
+    "    reduce_top_k(lid);\n"
+    "    if (lid == 0u) {\n"
+    "        for (var n = 0u; n < TOP_K; n = n + 1u) {\n"
+    "            result.top_k_values[n] = local_top_k[n].value;\n"
+    "            result.top_k_indices[n] = local_top_k[n].index;\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// Moments kernels that reduce through workgroup memory
+// Works on every device and is the fallback for the subgroup variant.
+const char *nano_stats_shared_wgsl =
+    "fn reduce_moments(lid: u32) {\n"
+    "    workgroupBarrier();\n"
+    "    for (var s = WG_SIZE / 2u; s > 0u; s = s >> 1u) {\n"
+    "        if (lid < s) {\n"
+    "            local_moments[lid] = combine(local_moments[lid],\n"
+    "                                         local_moments[lid + s]);\n"
+    "        }\n"
+    "        workgroupBarrier();\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(256)\n"
+    "fn moments_partial(@builtin(global_invocation_id) gid: vec3<u32>,\n"
+    "                   @builtin(local_invocation_index) lid: u32,\n"
+    "                   @builtin(workgroup_id) wid: vec3<u32>,\n"
+    "                   @builtin(num_workgroups) nwg: vec3<u32>) {\n"
+    "    local_moments[lid] = accumulate_moments(gid.x, nwg.x * WG_SIZE);\n"
+    "    reduce_moments(lid);\n"
+    "    if (lid == 0u) {\n"
+    "        partials[wid.x] = local_moments[0];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(256)\n"
+    "fn moments_final(@builtin(local_invocation_index) lid: u32) {\n"
+    "    local_moments[lid] = load_partial(lid);\n"
+    "    reduce_moments(lid);\n"
+    "    if (lid == 0u) {\n"
+    "        store_moments(local_moments[0]);\n"
+    "    }\n"
+    "}\n";
+
+// Moments kernels that reduce within each subgroup using shuffles
+// Only one value per subgroup goes through workgroup memory, so a reduction
+// needs a single barrier instead of nine.
+const char *nano_stats_subgroup_wgsl =
+    "var<workgroup> subgroup_count: atomic<u32>;\n"
+    "\n"
+    "// Butterfly reduction, every invocation ends up with the result\n"
+    "fn subgroup_moments(value: Moments, sg_size: u32) -> Moments {\n"
+    "    var m = value;\n"
+    "    for (var s = 1u; s < sg_size; s = s << 1u) {\n"
+    "        var o: Moments;\n"
+    "        o.count = subgroupShuffleXor(m.count, s);\n"
+    "        o.mean = subgroupShuffleXor(m.mean, s);\n"
+    "        o.m2 = subgroupShuffleXor(m.m2, s);\n"
+    "        o.min_value = subgroupShuffleXor(m.min_value, s);\n"
+    "        o.max_value = subgroupShuffleXor(m.max_value, s);\n"
+    "        m = combine(m, o);\n"
+    "    }\n"
+    "    return m;\n"
+    "}\n"
+    "\n"
+    "// Subgroups are not guaranteed to be contiguous ranges of\n"
+    "// local_invocation_index, so each one claims a slot with an atomic\n"
+    "fn reduce_moments(value: Moments, lid: u32, sg_lane: u32,\n"
+    "                  sg_size: u32) {\n"
+    "    let m = subgroup_moments(value, sg_size);\n"
+    "    if (sg_lane == 0u) {\n"
+    "        local_moments[atomicAdd(&subgroup_count, 1u)] = m;\n"
+    "    }\n"
+    "    workgroupBarrier();\n"
+    "    if (lid == 0u) {\n"
+    "        let n = atomicLoad(&subgroup_count);\n"
+    "        var total = local_moments[0];\n"
+    "        for (var i = 1u; i < n; i = i + 1u) {\n"
+    "            total = combine(total, local_moments[i]);\n"
+    "        }\n"
+    "        local_moments[0] = total;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(256)\n"
+    "fn moments_partial(@builtin(global_invocation_id) gid: vec3<u32>,\n"
+    "                   @builtin(local_invocation_index) lid: u32,\n"
+    "                   @builtin(workgroup_id) wid: vec3<u32>,\n"
+    "                   @builtin(num_workgroups) nwg: vec3<u32>,\n"
+    "                   @builtin(subgroup_invocation_id) sg_lane: u32,\n"
+    "                   @builtin(subgroup_size) sg_size: u32) {\n"
+    "    let m = accumulate_moments(gid.x, nwg.x * WG_SIZE);\n"
+    "    reduce_moments(m, lid, sg_lane, sg_size);\n"
+    "    if (lid == 0u) {\n"
+    "        partials[wid.x] = local_moments[0];\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(256)\n"
+    "fn moments_final(@builtin(local_invocation_index) lid: u32,\n"
+    "                 @builtin(subgroup_invocation_id) sg_lane: u32,\n"
+    "                 @builtin(subgroup_size) sg_size: u32) {\n"
+    "    reduce_moments(load_partial(lid), lid, sg_lane, sg_size);\n"
+    "    if (lid == 0u) {\n"
+    "        store_moments(local_moments[0]);\n"
+    "    }\n"
+    "}\n";
+
+// Name of a kernel variant for logs and the debug UI
+const char *nano_kernel_variant_name(nano_kernel_variant_t variant) {
+    switch (variant) {
+    case NANO_KERNEL_AUTO:
+        return "Auto";
+    case NANO_KERNEL_SHARED_MEMORY:
+        return "Shared Memory";
+    case NANO_KERNEL_SUBGROUPS:
+        return "Subgroups";
+    default:
+        return "Unknown";
     }
-    if (shader->in_use) {
-        LOG_ERR("NANO: Shader %u is currently in use\n", shader->id);
-        return NANO_FAIL;
+}
+
+// Pick the variant that is built for a requested variant
+// Subgroup variants fall back to shared memory when the device lacks the
+// subgroups feature.
+static nano_kernel_variant_t
+_nano_resolve_kernel_variant(nano_kernel_variant_t requested) {
+    if (requested == NANO_KERNEL_SHARED_MEMORY) {
+        return NANO_KERNEL_SHARED_MEMORY;
     }
 
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_reload_shader() -> Shader is NULL\n");
-        return NANO_FAIL;
+    if (!nano_has_subgroups()) {
+        if (requested == NANO_KERNEL_SUBGROUPS) {
+            LOG("NANO: Subgroups are not supported, using shared memory "
+                "kernels\n");
+        }
+        return NANO_KERNEL_SHARED_MEMORY;
     }
 
-    LOG("NANO: Shader %u: Validating...\n", info->id);
+    return NANO_KERNEL_SUBGROUPS;
+}
 
-    // Parse the compute shader to get the workgroup size as well
-    // and group layout requirements. These are stored in the info
-    // struct.
-    int status = nano_parse_shader(info->source, shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to parse compute shader: %s\n", info->path);
+// Create a compute pipeline for one of the statistics entry points
+static WGPUComputePipeline _nano_stats_create_pipeline(const char *entry) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    return wgpuDeviceCreateComputePipeline(
+        nano_app.wgpu->device, &(WGPUComputePipelineDescriptor){
+                                   .label = entry,
+                                   .layout = kernels->layout,
+                                   .compute =
+                                       {
+                                           .module = kernels->module,
+                                           .entryPoint = entry,
+                                       },
+                               });
+}
+
+// Create the shader module and pipelines for a kernel variant
+// The layouts are kept across variants so existing stats bind groups stay
+// valid when the variant changes.
+static int _nano_stats_build_pipelines(nano_kernel_variant_t variant) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+
+    bool subgroups = variant == NANO_KERNEL_SUBGROUPS;
+    const char *enable = subgroups ? "enable subgroups;\n" : "";
+    const char *moments =
+        subgroups ? nano_stats_subgroup_wgsl : nano_stats_shared_wgsl;
+
+    // Enable directives have to come before any declaration
+    nano_arena_mark_t mark = nano_arena_mark(&nano_build_arena);
+    size_t length =
+        strlen(enable) + strlen(nano_stats_wgsl) + strlen(moments) + 1;
+    char *source = (char *)nano_arena_alloc(&nano_build_arena, length);
+    if (source == NULL) {
+        LOG_ERR("NANO: nano_init_stats_kernels() -> Memory allocation "
+                "failed\n");
         return NANO_FAIL;
     }
+    snprintf(source, length, "%s%s%s", enable, nano_stats_wgsl, moments);
 
-    // Get the entry indices for the shader
-    info->entry_indices = nano_precompute_entry_indices(shader);
-    int compute_index = info->entry_indices.compute;
-    int vertex_index = info->entry_indices.vertex;
-    int fragment_index = info->entry_indices.fragment;
+    WGPUShaderModuleWGSLDescriptor wgsl_desc = {
+        .chain =
+            {
+                .next = NULL,
+                .sType = WGPUSType_ShaderModuleWGSLDescriptor,
+            },
+        .code = source,
+    };
 
-    // Log entry point information if it exists
-    if (compute_index != -1) {
-        nano_entry_t *entry = &info->entry_points[compute_index];
-        LOG("NANO: Shader %u: compute entry: %s | workgroup size: (%d, "
-            "%d, %d)\n",
-            info->id, entry->entry, entry->workgroup_size.x,
-            entry->workgroup_size.y, entry->workgroup_size.z);
-    }
-    if (vertex_index != -1) {
-        nano_entry_t *entry = &info->entry_points[vertex_index];
-        LOG("NANO: Shader %u: vertex entry: %s\n", info->id, entry->entry);
-    }
-    if (fragment_index != -1) {
-        nano_entry_t *entry = &info->entry_points[fragment_index];
-        LOG("NANO: Shader %u: frag entry: %s\n", info->id, entry->entry);
+    kernels->module = wgpuDeviceCreateShaderModule(
+        nano_app.wgpu->device,
+        &(WGPUShaderModuleDescriptor){
+            .nextInChain = (WGPUChainedStruct *)&wgsl_desc,
+            .label = "Nano Stats Kernels",
+        });
+    nano_arena_rewind(&nano_build_arena, mark);
+
+    if (kernels->module == NULL) {
+        LOG_ERR("NANO: nano_init_stats_kernels() -> Could not create shader "
+                "module\n");
+        return NANO_FAIL;
     }
 
-    status = nano_build_bindings(shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to build bindings for shader %u\n", info->id);
+    kernels->histogram = _nano_stats_create_pipeline("histogram");
+    kernels->moments_partial = _nano_stats_create_pipeline("moments_partial");
+    kernels->moments_final = _nano_stats_create_pipeline("moments_final");
+    kernels->top_k_partial = _nano_stats_create_pipeline("top_k_partial");
+    kernels->top_k_final = _nano_stats_create_pipeline("top_k_final");
+
+    if (!kernels->histogram || !kernels->moments_partial ||
+        !kernels->moments_final || !kernels->top_k_partial ||
+        !kernels->top_k_final) {
+        LOG_ERR("NANO: nano_init_stats_kernels() -> Could not create stats "
+                "pipelines\n");
         return NANO_FAIL;
     }
 
-    // Once we reach this point, we can assume that the shader has been
-    // successfully validated and reflects the shader source code.
-    // If anything goes wrong, the shader will technically not be able to be
-    // used until the shader is successfully validated.
+    kernels->variant = variant;
+
+    LOG("NANO: Stats kernels using %s\n", nano_kernel_variant_name(variant));
 
     return NANO_OK;
 }
 
-// Create our nano_shader_t struct to hold the compute shader and
-// pipeline, return shader id on success, 0 on failure Label
-// optional. This only supports WGSL shaders for the time being.
-// I'll explore SPIRV at a later time
-uint32_t nano_create_shader(const char *shader_source, const char *label) {
-    if (shader_source == NULL) {
-        LOG_ERR("NANO: nano_create_shader() -> "
-                "Shader source is NULL\n");
-        return 0;
-    }
+// Release the shader module and pipelines of the current variant
+static void _nano_stats_release_pipelines(void) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
 
-    // Get shader id hash for the compute shader by hashing the
-    // shader path
-    uint32_t shader_id = nano_hash_shader(shader_source);
+    WGPUComputePipeline *pipelines[5] = {
+        &kernels->histogram,     &kernels->moments_partial,
+        &kernels->moments_final, &kernels->top_k_partial,
+        &kernels->top_k_final,
+    };
+    for (int i = 0; i < 5; i++) {
+        if (*pipelines[i]) {
+            wgpuComputePipelineRelease(*pipelines[i]);
+            *pipelines[i] = NULL;
+        }
+    }
 
-    // Find a slot in the shader pool to store the shader
-    int slot = nano_find_shader_slot(&nano_app.shader_pool, shader_id);
-    if (slot < 0) {
-        LOG_ERR("NANO: Shader pool is full. Could not insert "
-                "shader %u\n",
-                shader_id);
-        return NANO_FAIL;
+    if (kernels->module) {
+        wgpuShaderModuleRelease(kernels->module);
+        kernels->module = NULL;
     }
+}
 
-    // If the label is NULL, use the default label
-    if (label == NULL) {
-        // Shader label
-        char default_label[64];
-        snprintf(default_label, 64, "Shader %u", shader_id);
-        label = default_label;
-        LOG("NANO: Using default label for shader %u\n", shader_id);
-        LOG("NANO: Default label: %s\n", label);
+// Build the shared statistics pipelines
+// Called lazily by nano_create_stats() so apps that never request
+// statistics do not pay for the extra shader module.
+int nano_init_stats_kernels(void) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    if (kernels->ready) {
+        return NANO_OK;
     }
 
-    // Initialize the shader info struct
-    wgpu_shader_info_t info = {
-        .id = shader_id,
-        .source = strdup(shader_source),
-    };
+    if (nano_app.wgpu == NULL || nano_app.wgpu->device == NULL) {
+        LOG_ERR("NANO: nano_init_stats_kernels() -> Device is NULL\n");
+        return NANO_FAIL;
+    }
 
-    strncpy((char *)&info.label, label, strlen(label) + 1);
+    WGPUDevice device = nano_app.wgpu->device;
 
-    nano_shader_t shader = (nano_shader_t){
-        .id = shader_id,
-        .info = info,
-        .vertex_count = 3, // Default vertex count is 3 for a triangle
+    // params, src, result, partials, top_k_partials
+    WGPUBufferBindingType types[5] = {
+        WGPUBufferBindingType_Uniform,
+        WGPUBufferBindingType_ReadOnlyStorage,
+        WGPUBufferBindingType_Storage,
+        WGPUBufferBindingType_Storage,
+        WGPUBufferBindingType_Storage,
     };
 
-    // Parse the compute shader to get the workgroup size as well
-    // and group layout requirements. These are stored in the info
-    // struct.
-    int status = nano_validate_shader(&shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to validate shader %u\n", shader_id);
+    WGPUBindGroupLayoutEntry entries[5];
+    for (int i = 0; i < 5; i++) {
+        entries[i] = (WGPUBindGroupLayoutEntry){
+            .binding = i,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {.type = types[i]},
+        };
+    }
+
+    kernels->bg_layout = wgpuDeviceCreateBindGroupLayout(
+        device, &(WGPUBindGroupLayoutDescriptor){
+                    .label = "Nano Stats Bind Group Layout",
+                    .entryCount = 5,
+                    .entries = entries,
+                });
+
+    kernels->layout = wgpuDeviceCreatePipelineLayout(
+        device, &(WGPUPipelineLayoutDescriptor){
+                    .label = "Nano Stats Pipeline Layout",
+                    .bindGroupLayoutCount = 1,
+                    .bindGroupLayouts = &kernels->bg_layout,
+                });
+
+    nano_kernel_variant_t variant =
+        _nano_resolve_kernel_variant(kernels->requested);
+    if (_nano_stats_build_pipelines(variant) != NANO_OK) {
+        _nano_stats_release_pipelines();
         return NANO_FAIL;
     }
 
-    // Add the shader to the shader pool
-    memcpy(&nano_app.shader_pool.shaders[slot].shader_entry, &shader,
-           sizeof(nano_shader_t));
-    // Set the slot as occupied
-    nano_app.shader_pool.shaders[slot].occupied = true;
+    kernels->ready = true;
 
-    // Increment the shader count
-    nano_app.shader_pool.shader_count++;
+    LOG("NANO: Stats kernels ready\n");
 
-    LOG("NANO: Shader %u: Successfully created!\n", shader_id);
+    return NANO_OK;
+}
 
-    // Update the shader labels for the ImGui combo boxes
-    _nano_update_shader_labels();
+// Release the shared statistics pipelines
+void nano_release_stats_kernels(void) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    if (!kernels->ready) {
+        return;
+    }
 
-    return shader_id;
+    _nano_stats_release_pipelines();
+    wgpuPipelineLayoutRelease(kernels->layout);
+    wgpuBindGroupLayoutRelease(kernels->bg_layout);
+
+    // Keep the requested variant for the next nano_init_stats_kernels()
+    *kernels = (nano_stats_kernels_t){.requested = kernels->requested};
 }
 
-// Create a shader from a file path
-uint32_t nano_create_shader_from_file(const char *path, const char *label) {
-    if (path == NULL) {
-        LOG_ERR("NANO: nano_create_shader_from_file() -> "
-                "Shader path is NULL\n");
-        return 0;
-    }
+// Choose which variant of the statistics kernels is used
+// NANO_KERNEL_AUTO picks subgroups when the device supports them. If the
+// kernels were already built they are rebuilt right away, so this can be
+// called between dispatches to compare the variants.
+int nano_stats_set_variant(nano_kernel_variant_t variant) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    kernels->requested = variant;
 
-    // Read the shader source from the file
-    char *source = nano_read_file(path);
-    if (source == NULL) {
-        LOG_ERR("NANO: nano_create_shader_from_file() -> "
-                "Could not read shader source\n");
-        return 0;
+    if (!kernels->ready) {
+        return NANO_OK;
     }
 
-    // Create the shader from the source
-    uint32_t shader_id = nano_create_shader(source, label);
-    nano_shader_t *shader = nano_get_shader(shader_id);
+    nano_kernel_variant_t resolved = _nano_resolve_kernel_variant(variant);
+    if (resolved == kernels->variant) {
+        return NANO_OK;
+    }
 
-    // Set the path of the shader
-    strncpy((char *)&shader->info.path, path, strlen(path) + 1);
+    _nano_stats_release_pipelines();
+    if (_nano_stats_build_pipelines(resolved) != NANO_OK) {
+        LOG_ERR("NANO: nano_stats_set_variant() -> Could not build %s "
+                "kernels\n",
+                nano_kernel_variant_name(resolved));
+        _nano_stats_release_pipelines();
+        _nano_stats_build_pipelines(NANO_KERNEL_SHARED_MEMORY);
+        return NANO_FAIL;
+    }
 
-    return shader_id;
+    return NANO_OK;
 }
 
-// Set the number of elements expected to be processed by the compute shader
-// This is used to determine the number of workgroups to dispatch
-int nano_shader_set_num_elems(nano_shader_t *shader, size_t count) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_set_num_elems() -> Shader is NULL\n");
+// Create the small GPU buffers needed to compute statistics for desc->src
+// Nothing but the result struct ever crosses back to the CPU, so reading
+// the statistics of a large buffer costs a few hundred bytes at most.
+int nano_create_stats(nano_stats_t *stats, const nano_stats_desc_t *desc) {
+    if (stats == NULL || desc == NULL) {
+        LOG_ERR("NANO: nano_create_stats() -> Stats or desc is NULL\n");
         return NANO_FAIL;
     }
 
-    if (shader->in_use) {
-        LOG_ERR("NANO: nano_shader_set_num_elems() -> Shader is "
-                "currently in use.\n");
+    if (desc->src == NULL) {
+        LOG_ERR("NANO: nano_create_stats() -> Source buffer is NULL\n");
         return NANO_FAIL;
     }
 
-    if (count == 0) {
-        LOG_ERR("NANO: nano_shader_set_num_elems() -> Count cannot be 0\n");
+    if (desc->src_offset % 256 != 0) {
+        LOG_ERR("NANO: nano_create_stats() -> Source offset must be a "
+                "multiple of 256 bytes\n");
         return NANO_FAIL;
     }
 
-    shader->num_elems = count;
-
-    return NANO_OK;
-}
-
-// Set the vertex count for the draw call of the render pipeline
-int nano_shader_set_vertex_count(nano_shader_t *shader, uint32_t count) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_set_vertex_count() -> Shader is NULL\n");
+    if (desc->bin_count > NANO_STATS_MAX_BINS) {
+        LOG_ERR("NANO: nano_create_stats() -> Bin count must be <= %d\n",
+                NANO_STATS_MAX_BINS);
         return NANO_FAIL;
     }
-    if (count < 3) {
-        LOG_ERR("NANO: nano_shader_set_vertex_count() -> Vertex count "
-                "must be greater than 3\n");
+
+    if (desc->top_k > NANO_STATS_MAX_TOP_K) {
+        LOG_ERR("NANO: nano_create_stats() -> Top k must be <= %d\n",
+                NANO_STATS_MAX_TOP_K);
         return NANO_FAIL;
     }
 
-    shader->vertex_count = count;
-    return NANO_OK;
-}
+    if ((desc->flags & NANO_STATS_HISTOGRAM) &&
+        (desc->bin_count == 0 || desc->range_max <= desc->range_min)) {
+        LOG_ERR("NANO: nano_create_stats() -> Histogram needs a bin count "
+                "and range_max > range_min\n");
+        return NANO_FAIL;
+    }
 
-// Build the bindings, pipeline layout, bindgroups, and pipelines for the
-// shader Can be called by the developer to build the shader manually, or
-// can be called as part of the activation process as a boolean parameter.
-int nano_shader_build(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_build() -> Shader is NULL\n");
+    if (nano_init_stats_kernels() != NANO_OK) {
+        LOG_ERR("NANO: nano_create_stats() -> Stats kernels unavailable\n");
         return NANO_FAIL;
     }
 
-    LOG("NANO: Shader %u: Building...\n", shader->id);
+    WGPUDevice device = nano_app.wgpu->device;
 
-    // Verify that the shader can be parsed properly before building it
-    int status = nano_validate_shader(shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to validate shader %u\n", shader->id);
+    *stats = (nano_stats_t){.desc = *desc};
+
+    stats->params = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Stats Params",
+                    .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(nano_stats_params_t),
+                });
+    stats->result = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Stats Result",
+                    .usage = WGPUBufferUsage_Storage |
+                             WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(nano_stats_result_t),
+                });
+    stats->partials = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Stats Partials",
+                    .usage = WGPUBufferUsage_Storage,
+                    .size = NANO_STATS_MAX_PARTIALS * 5 * sizeof(float),
+                });
+    stats->top_k_partials = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Stats Top K Partials",
+                    .usage = WGPUBufferUsage_Storage,
+                    .size = NANO_STATS_MAX_TOP_K_PARTIALS *
+                            NANO_STATS_MAX_TOP_K * 2 * sizeof(uint32_t),
+                });
+    stats->staging = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Stats Staging",
+                    .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_MapRead,
+                    .size = sizeof(nano_stats_result_t),
+                });
+
+    if (!stats->params || !stats->result || !stats->partials ||
+        !stats->top_k_partials || !stats->staging) {
+        LOG_ERR("NANO: nano_create_stats() -> Could not create stats "
+                "buffers\n");
         return NANO_FAIL;
     }
 
-    LOG("NANO: Shader %u: Building pipeline layouts...\n", shader->id);
+    WGPUBindGroupEntry entries[5] = {
+        {.binding = 0, .buffer = stats->params, .size = WGPU_WHOLE_SIZE},
+        {.binding = 1,
+         .buffer = desc->src,
+         .offset = desc->src_offset,
+         .size = WGPU_WHOLE_SIZE},
+        {.binding = 2, .buffer = stats->result, .size = WGPU_WHOLE_SIZE},
+        {.binding = 3, .buffer = stats->partials, .size = WGPU_WHOLE_SIZE},
+        {.binding = 4,
+         .buffer = stats->top_k_partials,
+         .size = WGPU_WHOLE_SIZE},
+    };
 
-    // Build the pipeline layout
-    status = nano_build_pipeline_layout(shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to build pipeline layout for shader %u\n",
-                shader->info.id);
-        return status;
+    stats->bind_group = wgpuDeviceCreateBindGroup(
+        device, &(WGPUBindGroupDescriptor){
+                    .label = "Nano Stats Bind Group",
+                    .layout = nano_app.stats_kernels.bg_layout,
+                    .entryCount = 5,
+                    .entries = entries,
+                });
+
+    if (stats->bind_group == NULL) {
+        LOG_ERR("NANO: nano_create_stats() -> Could not create bind group\n");
+        return NANO_FAIL;
     }
 
-    LOG("NANO: Shader %u: Building bindgroups...\n", shader->id);
+    return NANO_OK;
+}
 
-    // Build bind groups for the shader so we can bind the buffers
-    status = nano_build_bindgroups(shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to build bindgroup for shader %u\n",
-                shader->info.id);
-        return status;
+// Callback to copy the mapped statistics into the nano_stats_t struct
+void nano_stats_map_callback(WGPUBufferMapAsyncStatus status,
+                             void *userdata) {
+    nano_stats_t *stats = (nano_stats_t *)userdata;
+    if (stats == NULL) {
+        LOG_ERR("NANO: nano_stats_map_callback() -> Userdata is NULL\n");
+        return;
     }
 
-    LOG("NANO: Shader %u: Building final pipelines...\n", shader->id);
+    stats->pending = false;
 
-    // Build the shader pipelines
-    status = nano_build_shader_pipelines(shader);
-    if (status != NANO_OK) {
-        LOG_ERR("NANO: Failed to build shader pipelines for shader %u\n",
-                shader->info.id);
-        return 0;
+    if (status != WGPUBufferMapAsyncStatus_Success) {
+        LOG("NANO: Failed to map stats buffer for reading.\n");
+        return;
     }
 
-    // Set the built flag to true so we don't have to rebuild the shader
-    // unless we explicitly want to by passing the build flag
-    shader->built = true;
-
-    LOG("NANO: Shader %u: Built!\n", shader->id);
+    const void *mapped = wgpuBufferGetConstMappedRange(stats->staging, 0,
+                                                       stats->readback_size);
+    memcpy(&stats->data, mapped, stats->readback_size);
+    wgpuBufferUnmap(stats->staging);
 
-    return NANO_OK;
+    stats->ready = true;
 }
 
-// Set a shader to the active state.
-// Build bindings, pipeline layout, bindgroups, and pipelines
-int nano_shader_activate(nano_shader_t *shader, bool build) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_activate() -> Shader is NULL\n");
+// Queue the requested statistics kernels and an asynchronous readback of
+// the result struct. The results are available in stats->data once
+// stats->ready is true. Returns NANO_FAIL if the previous readback is still
+// in flight, so it is safe to call this every frame.
+int nano_stats_dispatch(nano_stats_t *stats) {
+    if (stats == NULL || stats->bind_group == NULL) {
+        LOG_ERR("NANO: nano_stats_dispatch() -> Stats were not created\n");
         return NANO_FAIL;
     }
-    if (shader->in_use) {
-        LOG_ERR("NANO: Shader %u is already active\n", shader->id);
-        return NANO_OK;
-    }
 
-    LOG("NANO: Shader %u: Activating...\n", shader->id);
+    if (stats->pending) {
+        return NANO_FAIL;
+    }
 
-    // If the shader has not been built, we build it now
-    // If the build flag is set, we rebuild the shader
-    if (!shader->built || build) {
-        int status = nano_shader_build(shader);
-        if (status != NANO_OK) {
-            LOG_ERR("NANO: Failed to build shader %u\n", shader->id);
-            return NANO_FAIL;
-        }
+    nano_stats_desc_t *desc = &stats->desc;
+    if (desc->count == 0 || desc->flags == 0) {
+        LOG_ERR("NANO: nano_stats_dispatch() -> Nothing to compute\n");
+        return NANO_FAIL;
     }
 
-    // If the shader is not active, we can activate it
-    shader->in_use = true;
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    WGPUDevice device = nano_app.wgpu->device;
+    WGPUQueue queue = wgpuDeviceGetQueue(device);
+
+    // Cap the number of workgroups so the partials fit in one workgroup
+    uint32_t groups = (desc->count + 255) / 256;
+    if (groups > NANO_STATS_MAX_PARTIALS)
+        groups = NANO_STATS_MAX_PARTIALS;
+
+    uint32_t top_k_groups = (desc->count + 63) / 64;
+    if (top_k_groups > NANO_STATS_MAX_TOP_K_PARTIALS)
+        top_k_groups = NANO_STATS_MAX_TOP_K_PARTIALS;
+
+    nano_stats_params_t params = {
+        .count = desc->count,
+        .bin_count = desc->bin_count,
+        .range_min = desc->range_min,
+        .range_max = desc->range_max,
+        .partial_count = groups,
+        .top_k_partial_count = top_k_groups,
+    };
+    wgpuQueueWriteBuffer(queue, stats->params, 0, &params, sizeof(params));
 
-    // Add the shader to the active shaders list
-    nano_shader_array_push(&nano_app.shader_pool.active_shaders, shader->id);
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(
+        device,
+        &(WGPUCommandEncoderDescriptor){.label = "Nano Stats Encoder"});
 
-    LOG("NANO: Shader %u: Activated!\n", shader->id);
+    // The histogram bins are accumulated with atomics so they must be
+    // cleared before every dispatch
+    wgpuCommandEncoderClearBuffer(encoder, stats->result, 0,
+                                  sizeof(nano_stats_result_t));
 
-    return NANO_OK;
-}
+    WGPUComputePassEncoder pass =
+        wgpuCommandEncoderBeginComputePass(encoder, NULL);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, stats->bind_group, 0, NULL);
 
-// Deactivate a shader from the active list
-int nano_shader_deactivate(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_deactivate() -> Shader is NULL\n");
-        return NANO_FAIL;
+    // Only copy back the sections of the result that were requested
+    stats->readback_size = offsetof(nano_stats_result_t, top_k_values);
+
+    if (desc->flags & NANO_STATS_MOMENTS) {
+        wgpuComputePassEncoderSetPipeline(pass, kernels->moments_partial);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, groups, 1, 1);
+        wgpuComputePassEncoderSetPipeline(pass, kernels->moments_final);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
     }
 
-    // If the shader is not active, return early
-    if (!shader->in_use) {
-        return NANO_OK;
+    if (desc->flags & NANO_STATS_TOP_K) {
+        wgpuComputePassEncoderSetPipeline(pass, kernels->top_k_partial);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, top_k_groups, 1, 1);
+        wgpuComputePassEncoderSetPipeline(pass, kernels->top_k_final);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
+        stats->readback_size = offsetof(nano_stats_result_t, bins);
     }
 
-    // If the shader is active, we can deactivate it
-    shader->in_use = false;
+    if (desc->flags & NANO_STATS_HISTOGRAM) {
+        wgpuComputePassEncoderSetPipeline(pass, kernels->histogram);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, groups, 1, 1);
+        stats->readback_size = offsetof(nano_stats_result_t, bins) +
+                               desc->bin_count * sizeof(uint32_t);
+    }
 
-    // Remove the shader from the active shaders list
-    nano_shader_array_remove(&nano_app.shader_pool.active_shaders, shader->id);
+    wgpuComputePassEncoderEnd(pass);
 
-    _nano_update_shader_labels();
+    wgpuCommandEncoderCopyBufferToBuffer(encoder, stats->result, 0,
+                                         stats->staging, 0,
+                                         stats->readback_size);
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(queue, 1, &command_buffer);
+
+    wgpuCommandBufferRelease(command_buffer);
+    wgpuComputePassEncoderRelease(pass);
+    wgpuCommandEncoderRelease(encoder);
+
+    stats->pending = true;
+    wgpuBufferMapAsync(stats->staging, WGPUMapMode_Read, 0,
+                       stats->readback_size, nano_stats_map_callback,
+                       (void *)stats);
 
     return NANO_OK;
 }
 
-// Return shader id from the shader pool using the index
-int nano_get_active_shader_id(nano_shader_pool_t *table, int index) {
-    if (index < 0 || index >= table->active_shaders.top + 1) {
-        LOG_ERR("NANO: nano_get_active_shader_id() -> Invalid index\n");
-        return 0;
+// Release the GPU buffers owned by a nano_stats_t
+// Do not call this while a readback is still pending.
+int nano_release_stats(nano_stats_t *stats) {
+    if (stats == NULL) {
+        LOG_ERR("NANO: nano_release_stats() -> Stats is NULL\n");
+        return NANO_FAIL;
     }
 
-    return table->active_shaders.data[index];
-}
+    if (stats->bind_group)
+        wgpuBindGroupRelease(stats->bind_group);
+    if (stats->params)
+        wgpuBufferRelease(stats->params);
+    if (stats->result)
+        wgpuBufferRelease(stats->result);
+    if (stats->partials)
+        wgpuBufferRelease(stats->partials);
+    if (stats->top_k_partials)
+        wgpuBufferRelease(stats->top_k_partials);
+    if (stats->staging)
+        wgpuBufferRelease(stats->staging);
 
-// Check if a shader is active
-bool nano_is_shader_active(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_is_shader_active() -> Shader is NULL\n");
-        return false;
-    }
+    *stats = (nano_stats_t){0};
 
-    return shader->in_use;
+    return NANO_OK;
 }
 
-// Get the number of active shaders
-int nano_num_active_shaders(nano_shader_pool_t *table) {
-    return table->active_shaders.top + 1;
+#ifdef NANO_CIMGUI
+
+// Getter so ImGui can plot the integer bins without a float copy
+static float _nano_stats_bin_getter(void *data, int idx) {
+    return (float)((nano_stats_t *)data)->data.bins[idx];
 }
 
-// Return a string of shader pipeline type for ImGui
-const char *nano_get_shader_type_str(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_get_shader_type_str() -> Shader is NULL\n");
-        return "Unknown";
+// Draw the latest statistics straight into the current ImGui window
+void nano_stats_draw_ui(const char *label, nano_stats_t *stats) {
+    if (stats == NULL || !stats->ready) {
+        igText("%s: Waiting for GPU statistics...", label);
+        return;
     }
-    wgpu_shader_info_t *info = &shader->info;
-    if (info == NULL) {
-        LOG_ERR("NANO: nano_get_shader_type_str() -> Shader info is NULL\n");
-        return "Unknown";
+
+    nano_stats_desc_t *desc = &stats->desc;
+    nano_stats_result_t *data = &stats->data;
+
+    igSeparatorText(label);
+
+    if (desc->flags & NANO_STATS_MOMENTS) {
+        igBulletText("Count: %u", data->count);
+        igBulletText("Min: %f  Max: %f", data->min, data->max);
+        igBulletText("Mean: %f  Variance: %f", data->mean, data->variance);
+    }
+
+    if (desc->flags & NANO_STATS_TOP_K) {
+        for (uint32_t i = 0; i < desc->top_k; i++) {
+            igBulletText("Top %u: %f (index %u)", i + 1,
+                         data->top_k_values[i], data->top_k_indices[i]);
+        }
+    }
+
+    if (desc->flags & NANO_STATS_HISTOGRAM) {
+        igPlotHistogram_FnFloatPtr(label, _nano_stats_bin_getter, stats,
+                                   desc->bin_count, 0, NULL, 0.0f, FLT_MAX,
+                                   (ImVec2){0, 80});
     }
-    return (info->entry_indices.compute != -1 &&
-            info->entry_indices.vertex != -1 &&
-            info->entry_indices.fragment != -1)
-               ? "Compute & Render"
-           : (info->entry_indices.compute != -1) ? "Compute"
-                                                 : "Render";
 }
 
-// Get the compute pipeline from the shader info struct if it exists
-WGPUComputePipeline nano_get_compute_pipeline(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_get_compute_pipeline() -> Shader is NULL\n");
-        return NULL;
+#endif
+
+// GPU Culling Functions
+// -------------------------------------------------
+
+// WGSL source for the built-in culling kernels
+// reset writes the draw arguments for zero instances and cull appends the
+// index of every instance whose sphere is inside the six frustum planes.
+// Visible instances are counted per workgroup first, so there is a single
+// global atomic per workgroup instead of one per instance.
+const char *nano_cull_wgsl =
+    "const WG_SIZE: u32 = 64u;\n"
+    "\n"
+    "struct Params {\n"
+    "    planes: array<vec4<f32>, 6>,\n"
+    "    count: u32,\n"
+    "    element_count: u32,\n"
+    "};\n"
+    "\n"
+    "@group(0) @binding(0) var<uniform> params: Params;\n"
+    "@group(0) @binding(1) var<storage, read> spheres: array<vec4<f32>>;\n"
+    "@group(0) @binding(2) var<storage, read_write> visible: array<u32>;\n"
+    "@group(0) @binding(3) var<storage, read_write> args: "
+    "array<atomic<u32>, 5>;\n"
+    "\n"
+    "var<workgroup> group_count: atomic<u32>;\n"
+    "var<workgroup> group_base: u32;\n"
+    "\n"
+    "fn is_visible(sphere: vec4<f32>) -> bool {\n"
+    "    for (var i = 0u; i < 6u; i++) {\n"
+    "        let plane = params.planes[i];\n"
+    "        if (dot(plane.xyz, sphere.xyz) + plane.w < -sphere.w) {\n"
+    "            return false;\n"
+    "        }\n"
+    "    }\n"
+    "    return true;\n"
+    "}\n"
+    "\n"
+    "@compute @workgroup_size(1)\n"
+    "fn reset() {\n"
+    "    atomicStore(&args[0], params.element_count);\n"
+    "    for (var i = 1u; i < 5u; i++) {\n"
+    "        atomicStore(&args[i], 0u);\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "// The loop bounds only depend on the workgroup, so the barriers stay\n"
+    "// in uniform control flow\n"
+    "@compute @workgroup_size(WG_SIZE)\n"
+    "fn cull(@builtin(workgroup_id) group_id: vec3<u32>,\n"
+    "        @builtin(num_workgroups) num_groups: vec3<u32>,\n"
+    "        @builtin(local_invocation_index) local_index: u32) {\n"
+    "    let stride = num_groups.x * WG_SIZE;\n"
+    "    for (var base = group_id.x * WG_SIZE; base < params.count;\n"
+    "         base += stride) {\n"
+    "        if (local_index == 0u) {\n"
+    "            atomicStore(&group_count, 0u);\n"
+    "        }\n"
+    "        workgroupBarrier();\n"
+    "\n"
+    "        let index = base + local_index;\n"
+    "        let keep = index < params.count && is_visible(spheres[index]);\n"
+    "        var slot = 0u;\n"
+    "        if (keep) {\n"
+    "            slot = atomicAdd(&group_count, 1u);\n"
+    "        }\n"
+    "        workgroupBarrier();\n"
+    "\n"
+    "        if (local_index == 0u) {\n"
+    "            group_base = atomicAdd(&args[1], atomicLoad(&group_count));\n"
+    "        }\n"
+    "        workgroupBarrier();\n"
+    "\n"
+    "        if (keep) {\n"
+    "            visible[group_base + slot] = index;\n"
+    "        }\n"
+    "    }\n"
+    "}\n";
+
+// Create a compute pipeline for one of the culling entry points
+static WGPUComputePipeline _nano_cull_create_pipeline(const char *entry) {
+    nano_cull_kernels_t *kernels = &nano_app.cull_kernels;
+    return wgpuDeviceCreateComputePipeline(
+        nano_app.wgpu->device, &(WGPUComputePipelineDescriptor){
+                                   .label = entry,
+                                   .layout = kernels->layout,
+                                   .compute =
+                                       {
+                                           .module = kernels->module,
+                                           .entryPoint = entry,
+                                       },
+                               });
+}
+
+// Release the shared culling pipelines
+void nano_release_cull_kernels(void) {
+    nano_cull_kernels_t *kernels = &nano_app.cull_kernels;
+
+    if (kernels->reset)
+        wgpuComputePipelineRelease(kernels->reset);
+    if (kernels->cull)
+        wgpuComputePipelineRelease(kernels->cull);
+    if (kernels->module)
+        wgpuShaderModuleRelease(kernels->module);
+    if (kernels->layout)
+        wgpuPipelineLayoutRelease(kernels->layout);
+    if (kernels->bg_layout)
+        wgpuBindGroupLayoutRelease(kernels->bg_layout);
+
+    // Keep the counter so buffers of older culls never share an id
+    *kernels = (nano_cull_kernels_t){.created = kernels->created};
+}
+
+// Build the shared culling pipelines
+// Called lazily by nano_create_cull() so apps that never cull do not pay
+// for the extra shader module.
+int nano_init_cull_kernels(void) {
+    nano_cull_kernels_t *kernels = &nano_app.cull_kernels;
+    if (kernels->ready) {
+        return NANO_OK;
     }
 
-    if (shader->compute_pipeline == NULL) {
-        LOG_ERR("NANO: nano_get_compute_pipeline() -> Compute pipeline "
-                "not found\n");
-        return NULL;
+    if (nano_app.wgpu == NULL || nano_app.wgpu->device == NULL) {
+        LOG_ERR("NANO: nano_init_cull_kernels() -> Device is NULL\n");
+        return NANO_FAIL;
     }
 
-    return shader->compute_pipeline;
-}
+    WGPUDevice device = nano_app.wgpu->device;
 
-// Get the render pipeline from the shader info struct if it exists
-WGPURenderPipeline nano_get_render_pipeline(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_get_render_pipeline() -> Shader is NULL\n");
-        return NULL;
-    }
+    // params, spheres, visible, args
+    WGPUBufferBindingType types[4] = {
+        WGPUBufferBindingType_Uniform,
+        WGPUBufferBindingType_ReadOnlyStorage,
+        WGPUBufferBindingType_Storage,
+        WGPUBufferBindingType_Storage,
+    };
 
-    if (shader->render_pipeline == NULL) {
-        fprintf(stderr, "NANO: nano_get_render_pipeline() -> Render "
-                        "pipeline not found\n");
-        return NULL;
+    WGPUBindGroupLayoutEntry entries[4];
+    for (int i = 0; i < 4; i++) {
+        entries[i] = (WGPUBindGroupLayoutEntry){
+            .binding = i,
+            .visibility = WGPUShaderStage_Compute,
+            .buffer = {.type = types[i]},
+        };
     }
 
-    return shader->render_pipeline;
-}
+    kernels->bg_layout = wgpuDeviceCreateBindGroupLayout(
+        device, &(WGPUBindGroupLayoutDescriptor){
+                    .label = "Nano Cull Bind Group Layout",
+                    .entryCount = 4,
+                    .entries = entries,
+                });
 
-// Execute a shader pass for a single shader based on the
-// pipelines, and the bindgroups.
-// To access the data from the shader execution, we can use
-// nano_copy_buffer_to_cpu(...) to copy the data from the GPU buffer
-// to a struct in memory.
-void nano_shader_execute(nano_shader_t *shader) {
-    if (shader == NULL) {
-        LOG_ERR("NANO: nano_shader_execute() -> Shader is NULL\n");
-        return;
+    kernels->layout = wgpuDeviceCreatePipelineLayout(
+        device, &(WGPUPipelineLayoutDescriptor){
+                    .label = "Nano Cull Pipeline Layout",
+                    .bindGroupLayoutCount = 1,
+                    .bindGroupLayouts = &kernels->bg_layout,
+                });
+
+    WGPUShaderModuleWGSLDescriptor wgsl_desc = {
+        .chain =
+            {
+                .next = NULL,
+                .sType = WGPUSType_ShaderModuleWGSLDescriptor,
+            },
+        .code = nano_cull_wgsl,
+    };
+
+    kernels->module = wgpuDeviceCreateShaderModule(
+        device, &(WGPUShaderModuleDescriptor){
+                    .nextInChain = (WGPUChainedStruct *)&wgsl_desc,
+                    .label = "Nano Cull Kernels",
+                });
+
+    if (kernels->module != NULL) {
+        kernels->reset = _nano_cull_create_pipeline("reset");
+        kernels->cull = _nano_cull_create_pipeline("cull");
     }
-    if (!shader->in_use) {
-        LOG_ERR("NANO: nano_shader_execute() -> Shader %u is not active\n",
-                shader->id);
-        return;
+
+    if (!kernels->bg_layout || !kernels->layout || !kernels->reset ||
+        !kernels->cull) {
+        LOG_ERR("NANO: nano_init_cull_kernels() -> Could not create cull "
+                "pipelines\n");
+        nano_release_cull_kernels();
+        return NANO_FAIL;
     }
 
-    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    kernels->ready = true;
 
-    // Update the uniform buffer data for the shader if it exists
-    if (shader->uniform_buffer != 0) {
-        nano_buffer_t *buffer = nano_get_buffer(shader->uniform_buffer);
-        if (buffer == NULL) {
-            LOG_ERR("NANO: Shader %u: Could not find uniform buffer %u\n",
-                    shader->id, shader->uniform_buffer);
-            return;
-        }
-        nano_write_buffer(buffer);
+    LOG("NANO: Cull kernels ready\n");
+
+    return NANO_OK;
+}
+
+// Release the buffers and bind group of a nano_cull_t
+// Buffers that were already released with the buffer pool are skipped.
+int nano_release_cull(nano_cull_t *cull) {
+    if (cull == NULL) {
+        LOG_ERR("NANO: nano_release_cull() -> Cull is NULL\n");
+        return NANO_FAIL;
     }
 
-    // Find the compute shader in the shader info entry points list
-    for (int i = 0; i < shader->info.entry_point_count; i++) {
-        // We handle compute shaders separately from vertex and fragment
-        if (shader->info.entry_points[i].type == COMPUTE) {
+    if (cull->bind_group)
+        wgpuBindGroupRelease(cull->bind_group);
+    if (cull->params)
+        wgpuBufferRelease(cull->params);
+    if (cull->spheres)
+        nano_release_buffer(cull->spheres);
+    if (cull->visible)
+        nano_release_buffer(cull->visible);
+    if (cull->args)
+        nano_release_buffer(cull->args);
 
-            if (shader->compute_pipeline == NULL) {
-                LOG_ERR("NANO: Shader %u: Compute pipeline is NULL\n",
-                        shader->id);
-                return;
-            }
+    *cull = (nano_cull_t){0};
 
-            // Create a new command encoder for the compute pass
-            // We create a new command encoder for each compute pass
-            // to ensure that the compute shader is dispatched separately
-            WGPUCommandEncoder command_encoder =
-                wgpuDeviceCreateCommandEncoder(nano_app.wgpu->device, NULL);
+    return NANO_OK;
+}
 
-            // Begin a compute pass to execute compute shader
-            WGPUComputePassEncoder compute_pass =
-                wgpuCommandEncoderBeginComputePass(command_encoder, NULL);
-            wgpuComputePassEncoderSetPipeline(compute_pass,
-                                              shader->compute_pipeline);
+// Create the buffers and bind group to cull desc->count instances
+// The spheres, visible and args buffers are added to the buffer pool. Bind
+// spheres and visible to the render shader as var<storage, read> arrays and
+// give it args with nano_shader_set_indirect_buffer(), then the vertex
+// shader finds its instance at visible[instance_index].
+// Must be called on the render thread.
+int nano_create_cull(nano_cull_t *cull, const nano_cull_desc_t *desc) {
+    if (cull == NULL || desc == NULL) {
+        LOG_ERR("NANO: nano_create_cull() -> Cull or desc is NULL\n");
+        return NANO_FAIL;
+    }
 
-            // Set the bind groups for the compute pass
-            for (int j = 0; j < shader->layout.num_layouts; j++) {
-                wgpuComputePassEncoderSetBindGroup(
-                    compute_pass, j, nano_get_bindgroup(shader, j), 0, NULL);
-            }
+    if (desc->count == 0) {
+        LOG_ERR("NANO: nano_create_cull() -> Count cannot be 0\n");
+        return NANO_FAIL;
+    }
 
-            // Get the workgroup size from the shader info
-            wgsl_workgroup_size_t workgroup_sizes =
-                shader->info.entry_points[i].workgroup_size;
+    if (!nano_is_render_thread()) {
+        LOG_ERR("NANO: nano_create_cull() -> Culls can only be created on "
+                "the render thread\n");
+        return NANO_FAIL;
+    }
 
-            // Calculate the workgroup size
-            size_t workgroup_size =
-                workgroup_sizes.x * workgroup_sizes.y * workgroup_sizes.z;
+    if (nano_init_cull_kernels() != NANO_OK) {
+        LOG_ERR("NANO: nano_create_cull() -> Cull kernels unavailable\n");
+        return NANO_FAIL;
+    }
 
-            // Calculate the number of workgroups based on the number of
-            // elements expected to be processed by the compute shader
-            if (shader->num_elems == 0) {
-                LOG_ERR("NANO: nano_shader_execute() -> Compute Shader %u: "
-                        "Number of elements is 0. Be sure to set the number of "
-                        "elements using nano_shader_set_num_elems()\n",
-                        shader->id);
-                return;
-            }
+    nano_cull_kernels_t *kernels = &nano_app.cull_kernels;
+    WGPUDevice device = nano_app.wgpu->device;
 
-            size_t num_workgroups =
-                (shader->num_elems + workgroup_size - 1) / workgroup_size;
+    *cull = (nano_cull_t){
+        .count = desc->count,
+        .element_count = desc->element_count,
+    };
 
-            // TODO: ADJUST WORKGROUP SIZE BASED ON SIZE OF OUTPUT BUFFER
-            wgpuComputePassEncoderDispatchWorkgroups(compute_pass,
-                                                     num_workgroups, 1, 1);
+    uint32_t index = kernels->created++;
+    char label[64];
 
-            // Finish the compute pass
-            wgpuComputePassEncoderEnd(compute_pass);
+    snprintf(label, sizeof(label), "Nano Cull %u Spheres", index);
+    cull->spheres = _nano_create_pool_buffer(
+        label, WGPUBufferUsage_Storage, desc->spheres,
+        (size_t)desc->count * 4 * sizeof(float));
+
+    snprintf(label, sizeof(label), "Nano Cull %u Visible", index);
+    cull->visible =
+        _nano_create_pool_buffer(label, WGPUBufferUsage_Storage, NULL,
+                                 (size_t)desc->count * sizeof(uint32_t));
+
+    // DrawIndexedIndirect takes five arguments, DrawIndirect the first four
+    snprintf(label, sizeof(label), "Nano Cull %u Args", index);
+    cull->args = _nano_create_pool_buffer(
+        label, WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect, NULL,
+        5 * sizeof(uint32_t));
+
+    cull->params = wgpuDeviceCreateBuffer(
+        device, &(WGPUBufferDescriptor){
+                    .label = "Nano Cull Params",
+                    .usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst,
+                    .size = sizeof(nano_cull_params_t),
+                });
+
+    if (!cull->spheres || !cull->visible || !cull->args || !cull->params) {
+        LOG_ERR("NANO: nano_create_cull() -> Could not create cull "
+                "buffers\n");
+        nano_release_cull(cull);
+        return NANO_FAIL;
+    }
 
-            // submit the command buffer that contains the compute
-            WGPUCommandBuffer command_buffer =
-                wgpuCommandEncoderFinish(command_encoder, NULL);
-            wgpuQueueSubmit(queue, 1, &command_buffer);
+    uint32_t ids[3] = {cull->spheres, cull->visible, cull->args};
+    WGPUBindGroupEntry entries[4] = {
+        {.binding = 0, .buffer = cull->params, .size = WGPU_WHOLE_SIZE},
+    };
+    for (int i = 0; i < 3; i++) {
+        entries[i + 1] = (WGPUBindGroupEntry){
+            .binding = i + 1,
+            .buffer = nano_get_buffer(ids[i])->buffer,
+            .size = WGPU_WHOLE_SIZE,
+        };
+    }
 
-            // Release the command encoder after we submit to the queue
-            wgpuCommandEncoderRelease(command_encoder);
+    cull->bind_group = wgpuDeviceCreateBindGroup(
+        device, &(WGPUBindGroupDescriptor){
+                    .label = "Nano Cull Bind Group",
+                    .layout = kernels->bg_layout,
+                    .entryCount = 4,
+                    .entries = entries,
+                });
 
-        } else if (shader->info.entry_points[i].type == VERTEX ||
-                   shader->info.entry_points[i].type == FRAGMENT) {
-
-            // Get the command encoder for the current nano pass
-            WGPUCommandEncoder command_encoder = nano_app.wgpu->cmd_encoder;
-
-            // If a shader has a vertex and fragment entry point, we can
-            // queue a render pass here.
-            // If the shader has both, this is only called once to make
-            // sure the same render pass is not queued multiple times.
-            WGPURenderPassDescriptor render_pass_desc = {
-                .colorAttachmentCount = 1,
-                .colorAttachments =
-                    &(WGPURenderPassColorAttachment){
-                        .view = wgpu_get_render_view(),
-                        .depthSlice = ~0u,
-                        .resolveTarget = wgpu_get_resolve_view(),
-                        .loadOp = WGPULoadOp_Load,
-                        .storeOp = WGPUStoreOp_Store,
-                    },
-                .depthStencilAttachment = NULL,
-            };
+    if (cull->bind_group == NULL) {
+        LOG_ERR("NANO: nano_create_cull() -> Could not create bind group\n");
+        nano_release_cull(cull);
+        return NANO_FAIL;
+    }
 
-            WGPURenderPassEncoder render_pass =
-                wgpuCommandEncoderBeginRenderPass(command_encoder,
-                                                  &render_pass_desc);
-            wgpuRenderPassEncoderSetPipeline(render_pass,
-                                             shader->render_pipeline);
+    return NANO_OK;
+}
 
-            // Assign the bind groups for the render pass
-            for (int j = 0; j < shader->layout.num_layouts; j++) {
-                wgpuRenderPassEncoderSetBindGroup(
-                    render_pass, j, nano_get_bindgroup(shader, j), 0, NULL);
+// Extract the normalized frustum planes of a column major view projection
+// matrix with WebGPU's 0 to 1 depth range. A point p is inside a plane when
+// dot(plane.xyz, p) + plane.w >= 0, and the distance is in world units.
+static void _nano_cull_planes(const float *m, float planes[6][4]) {
+    // Left, right, bottom, top, near and far as the w row plus or minus
+    // another row. Near is the z row on its own since depth starts at 0.
+    static const int rows[6] = {0, 0, 1, 1, 2, 2};
+    static const float signs[6] = {1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f};
+    static const float w_rows[6] = {1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+
+    for (int i = 0; i < 6; i++) {
+        float length = 0.0f;
+        for (int j = 0; j < 4; j++) {
+            planes[i][j] =
+                w_rows[i] * m[j * 4 + 3] + signs[i] * m[j * 4 + rows[i]];
+            if (j < 3) {
+                length += planes[i][j] * planes[i][j];
             }
+        }
 
-            // Assign the vertex buffers for the render pass
-            for (int j = 0; j < shader->vertex_buffer_count; j++) {
-                nano_vertex_buffer_t *vb = &shader->vertex_buffers[j];
-                nano_buffer_t *buffer = nano_get_buffer(vb->buffer_id);
-                if (buffer == NULL) {
-                    LOG_ERR(
-                        "NANO: Shader %u: Could not find vertex buffer %u\n",
-                        shader->id, buffer->id);
-                    return;
-                }
-                wgpuRenderPassEncoderSetVertexBuffer(
-                    render_pass, j, buffer->buffer, buffer->offset,
-                    buffer->size);
+        length = sqrtf(length);
+        if (length > 0.0f) {
+            for (int j = 0; j < 4; j++) {
+                planes[i][j] /= length;
             }
-
-            // Draw the vertex buffer
-            wgpuRenderPassEncoderDraw(render_pass, shader->vertex_count, 1, 0,
-                                      0);
-            wgpuRenderPassEncoderEnd(render_pass);
-
-            // Break out of the loop early since the only remaining
-            // entry point is the fragment shader which is already compiled
-            // We don't want to end this command encoder early since it is
-            // shared for drawn shaders. A compute shader gets its own
-            // command so that it is dispatched separately.
-            break;
         }
     }
 }
 
-// Iterate over all active shaders in the shader pool and execute each
-// shader with the appropriate bindgroups and pipelines loaded into the GPU.
-void nano_execute_shaders(void) {
+// Queue the culling kernels for the current spheres
+// view_proj is the column major matrix the instances are drawn with, or NULL
+// to keep every instance. The draw arguments are rewritten on the GPU, so
+// the render shader must be executed after this, usually every frame right
+// before nano_execute_shaders().
+int nano_cull_dispatch(nano_cull_t *cull, const float *view_proj) {
+    if (cull == NULL || cull->bind_group == NULL) {
+        LOG_ERR("NANO: nano_cull_dispatch() -> Cull was not created\n");
+        return NANO_FAIL;
+    }
 
-    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    nano_cull_kernels_t *kernels = &nano_app.cull_kernels;
+    WGPUDevice device = nano_app.wgpu->device;
+    WGPUQueue queue = wgpuDeviceGetQueue(device);
 
-    // Iterate over all active shaders in the shader pool
-    int num_active_shaders = nano_num_active_shaders(&nano_app.shader_pool);
-    for (int i = 0; i < num_active_shaders; i++) {
-        uint32_t shader_id =
-            nano_get_active_shader_id(&nano_app.shader_pool, i);
-        nano_shader_t *shader = nano_get_shader(shader_id);
-        if (shader == NULL) {
-            LOG_ERR("NANO: Shader %u is NULL\n", shader_id);
-            continue;
-        }
-        nano_shader_execute(shader);
+    // Planes of all zeros keep every sphere
+    nano_cull_params_t params = {
+        .count = cull->count,
+        .element_count = cull->element_count,
+    };
+    if (view_proj != NULL) {
+        _nano_cull_planes(view_proj, params.planes);
     }
+    wgpuQueueWriteBuffer(queue, cull->params, 0, &params, sizeof(params));
+
+    // The kernel grid-strides, so the number of workgroups stays within
+    // the default maxComputeWorkgroupsPerDimension limit
+    uint32_t groups = (cull->count + NANO_CULL_WORKGROUP_SIZE - 1) /
+                      NANO_CULL_WORKGROUP_SIZE;
+    if (groups > 65535)
+        groups = 65535;
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(
+        device, &(WGPUCommandEncoderDescriptor){.label = "Nano Cull Encoder"});
+
+    WGPUComputePassEncoder pass =
+        wgpuCommandEncoderBeginComputePass(encoder, NULL);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, cull->bind_group, 0, NULL);
+    wgpuComputePassEncoderSetPipeline(pass, kernels->reset);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
+    wgpuComputePassEncoderSetPipeline(pass, kernels->cull);
+    wgpuComputePassEncoderDispatchWorkgroups(pass, groups, 1, 1);
+    wgpuComputePassEncoderEnd(pass);
+
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(queue, 1, &command_buffer);
+
+    wgpuCommandBufferRelease(command_buffer);
+    wgpuComputePassEncoderRelease(pass);
+    wgpuCommandEncoderRelease(encoder);
+
+    return NANO_OK;
 }
 
 // Core Application Functions (init, event, cleanup)
 // -------------------------------------------------
 
-// Function called by sokol_app to initialize the application with
-// WebGPU sokol_gfx sglue & cimgui
-void nano_default_init(void) {
-    LOG("NANO: Initializing NANO WGPU app...\n");
+// Initialize the parts of the application that don't need the device
+static void _nano_init_core(void) {
 
     // Retrieve the WGPU state from the wgpu_entry.h file
     // This state is created and ready to use when running an
     // application with wgpu_start().
     nano_app.wgpu = wgpu_get_state();
 
+    // This thread is the only one allowed to use the WGPU device and queue
+    nano_app.render_thread = &nano_thread_tag;
+
     // Initialize the buffer pool
     nano_init_buffer_pool(&nano_app.buffer_pool);
 
     // Initialize the shader pool
     nano_init_shader_pool(&nano_app.shader_pool);
 
-    // Set the fonts
-    if (nano_fonts.font_count != 0)
-        nano_init_fonts(&nano_fonts, 16.0f);
-    else
-        nano_init_fonts(NULL, 16.0f);
+    // Start the worker threads used by CPU kernels
+    nano_jobs_init();
 
     nano_app.settings = nano_default_settings();
 
     nano_app.settings.gfx.msaa.sample_count = nano_app.wgpu->desc.sample_count;
+}
+
+// Function called by sokol_app to initialize the application with
+// WebGPU sokol_gfx sglue & cimgui
+void nano_default_init(void) {
+    LOG("NANO: Initializing NANO WGPU app...\n");
+
+    // The pools may already hold the shaders created in preload_cb
+    if (!nano_app.preloaded) {
+        _nano_init_core();
+    }
+
+    // Set the fonts, ImGui is only initialized when there is a device
+    if (nano_has_gpu()) {
+        nano_font_info_t *fonts = nano_fonts.font_count != 0 ? &nano_fonts
+                                                             : NULL;
+        if (nano_app.wgpu->desc.fast_start && fonts != NULL) {
+            memcpy(&nano_app.font_info, fonts, sizeof(nano_font_info_t));
+            nano_app.fonts_deferred = true;
+        } else {
+            int event = wgpu_startup_begin("fonts", NULL);
+            nano_init_fonts(fonts, 16.0f);
+            wgpu_startup_end(event);
+        }
+
+        // Device objects of the 2D renderer are created on first use
+        nano_draw_init(nano_app.wgpu->device, wgpu_get_color_format(), 2);
+    }
 
     LOG("NANO: Initialized\n");
 }
 
-// Free any resources that were allocated
-void nano_default_cleanup(void) {
+// Release the shaders, buffers and kernels of the current context
+static void _nano_release_context_resources(void) {
+
+    // Run anything other threads queued since the last frame
+    nano_flush_commands();
 
     // Clean up the shader pool
     if (nano_app.shader_pool.shader_count > 0) {
@@ -3116,9 +9131,6 @@ void nano_default_cleanup(void) {
                     nano_app.shader_pool.shaders[i].shader_entry.id);
             }
         }
-
-        // Free the shader shader
-        free(nano_app.shader_pool.shader_labels);
     }
 
     // Clean up the buffer pool
@@ -3131,9 +9143,111 @@ void nano_default_cleanup(void) {
         }
     }
 
+    // Release the statistics and culling kernels if they were ever used
+    nano_release_stats_kernels();
+    nano_release_cull_kernels();
+
+    // Release the staging buffers kept for transfers
+    nano_release_staging_buffers();
+
+    // Release the shared uniform buffer
+    if (nano_app.uniforms.buffer != NULL) {
+        wgpuBufferRelease(nano_app.uniforms.buffer);
+        nano_app.uniforms.buffer = NULL;
+    }
+
+    // Release the frame uniforms shared by every shader
+    _nano_frame_group_release();
+
+    // Release the pipelines kept for shaders that are gone now
+    _nano_pipeline_cache_release();
+}
+
+// Free any resources that were allocated
+void nano_default_cleanup(void) {
+
+    _nano_release_context_resources();
+
+    // Release the 2D renderer
+    nano_draw_shutdown();
+
+    // Free the transient memory of the render thread
+    nano_arena_release(&nano_frame_arena);
+    nano_arena_release(&nano_build_arena);
+
+    // Stop the worker threads
+    nano_jobs_shutdown();
+
     wgpu_stop();
 }
 
+// Context Functions
+// -------------------------------------------------
+
+// Create a context with its own pools, settings and statistics kernels.
+// wgpu can point at a state with a separate device, or be NULL for a
+// context that only runs CPU kernels. The calling thread becomes the
+// context's render thread. nano_start_frame() and nano_end_frame() drive
+// the canvas, so they only apply to the context created with the app.
+// Buffers that other threads create, write or read back for this context
+// are queued until its render thread calls nano_flush_commands().
+nano_context_t *nano_create_context(nano_wgpu_state_t *wgpu) {
+    nano_context_t *ctx = (nano_context_t *)calloc(1, sizeof(nano_context_t));
+    if (ctx == NULL) {
+        LOG_ERR("NANO: nano_create_context() -> Memory allocation failed\n");
+        return NULL;
+    }
+
+    ctx->wgpu = wgpu;
+    ctx->show_debug = NANO_DEBUG_UI;
+    ctx->gpu_latency_ms = NANO_GPU_LATENCY_MS;
+    ctx->render_thread = &nano_thread_tag;
+
+    nano_init_buffer_pool(&ctx->buffer_pool);
+    nano_init_shader_pool(&ctx->shader_pool);
+
+    ctx->settings = nano_default_settings();
+    if (wgpu != NULL && wgpu->desc.sample_count > 0) {
+        ctx->settings.gfx.msaa.sample_count = wgpu->desc.sample_count;
+    }
+
+    // Every context shares the same worker threads
+    nano_jobs_init();
+
+    return ctx;
+}
+
+// Release everything owned by a context created with nano_create_context()
+// Must be called from the context's render thread.
+void nano_destroy_context(nano_context_t *ctx) {
+    if (ctx == NULL) {
+        LOG_ERR("NANO: nano_destroy_context() -> Context is NULL\n");
+        return;
+    }
+    if (ctx == &nano_default_context) {
+        LOG_ERR("NANO: nano_destroy_context() -> The default context is "
+                "released by nano_default_cleanup()\n");
+        return;
+    }
+
+    nano_context_t *previous = nano_current_context;
+    nano_current_context = ctx;
+    _nano_release_context_resources();
+    nano_current_context = previous == ctx ? &nano_default_context : previous;
+
+    free(ctx);
+}
+
+// Make a context current for the calling thread, NULL selects the default
+// context. Worker threads that create or write buffers for a context must
+// make it current first, their work is still handed to its render thread.
+void nano_set_context(nano_context_t *ctx) {
+    nano_current_context = ctx != NULL ? ctx : &nano_default_context;
+}
+
+// Return the calling thread's current context
+nano_context_t *nano_get_context(void) { return nano_current_context; }
+
 #ifdef NANO_CIMGUI
 
 // This represents the demo window that has all of the Nano application
@@ -3213,6 +9327,38 @@ void nano_draw_debug_ui() {
             igBulletText("Frames Per Second: %.2f", nano_app.fps);
             igBulletText("Render Resolution: (%d, %d)",
                          (int)nano_app.wgpu->width, (int)nano_app.wgpu->height);
+            igBulletText("Queued Commands: %u (%zu bytes uploaded)",
+                         nano_app.cmd_queue.last_count,
+                         nano_app.cmd_queue.last_bytes);
+            nano_draw_stats_t draw_stats = nano_draw_get_stats();
+            igBulletText("2D Primitives: %u in %u draw calls",
+                         draw_stats.instances, draw_stats.draw_calls);
+
+            igSeparatorEx(ImGuiSeparatorFlags_Horizontal, 5.0f);
+
+            igText("Arena Usage");
+            igSeparator();
+            nano_arena_t *arenas[] = {&nano_frame_arena, &nano_build_arena};
+            for (int i = 0; i < 2; i++) {
+                nano_arena_t *arena = arenas[i];
+                igBulletText("%s: %.1f / %.1f KB (Peak %.1f KB)", arena->name,
+                             arena->used / 1024.0, arena->capacity / 1024.0,
+                             arena->peak / 1024.0);
+                igText("    Blocks: %u, System Allocations: %u",
+                       arena->block_count, arena->system_allocs);
+            }
+            igBulletText("Uniform Upload: %u bytes",
+                         nano_app.uniforms.last_upload);
+            igBulletText("Shader F16: %s", nano_has_f16() ? "Yes" : "No");
+            igBulletText("Subgroups: %s", nano_has_subgroups() ? "Yes" : "No");
+            if (nano_app.stats_kernels.ready) {
+                igBulletText("Stats Kernels: %s",
+                             nano_kernel_variant_name(
+                                 nano_app.stats_kernels.variant));
+            }
+            igBulletText("Interned Strings: %u (%u bytes)",
+                         nano_intern_table.atom_count,
+                         nano_intern_table.storage_used);
 
             igSeparatorEx(ImGuiSeparatorFlags_Horizontal, 5.0f);
 
@@ -3318,7 +9464,7 @@ void nano_draw_debug_ui() {
                 nano_shader_t *active_shader =
                     nano_get_shader(active_shader_id);
                 snprintf(active_shader_label, 64, "%d: %s", 0,
-                         active_shader->info.label);
+                         nano_atom_str(active_shader->info.label));
             }
 
             // Basic shader pool information
@@ -3327,6 +9473,12 @@ void nano_draw_debug_ui() {
                          nano_app.shader_pool.shader_count);
             igBulletText("Active Shaders: %d",
                          nano_num_active_shaders(&nano_app.shader_pool));
+            nano_pipeline_cache_t *cache = &nano_app.pipeline_cache;
+            uint32_t lookups = cache->hits + cache->misses;
+            igBulletText("Pipeline Cache: %d pipelines, %u hits, %u misses "
+                         "(%.0f%% hit rate)",
+                         cache->count, cache->hits, cache->misses,
+                         lookups ? 100.0 * cache->hits / lookups : 0.0);
 
             igSeparatorEx(ImGuiSeparatorFlags_Horizontal, 5.0f);
 
@@ -3359,13 +9511,14 @@ void nano_draw_debug_ui() {
                                     nano_get_shader(shader_id);
                                 char label[64];
                                 snprintf(label, 64, "%d: %s", i,
-                                         shader->info.label);
+                                         nano_atom_str(shader->info.label));
                                 if (igSelectable_Bool(label, false,
                                                       ImGuiSelectableFlags_None,
                                                       (ImVec2){0, 0})) {
                                     active_shader_id = shader_id;
                                     snprintf(active_shader_label, 64, "%d: %s",
-                                             i, shader->info.label);
+                                             i,
+                                             nano_atom_str(shader->info.label));
                                 }
                             }
                             igEndCombo();
@@ -3385,7 +9538,7 @@ void nano_draw_debug_ui() {
                             nano_shader_t *active_shader =
                                 nano_get_shader(active_shader_id);
                             snprintf(active_shader_label, 64, "%d: %s", 0,
-                                     active_shader->info.label);
+                                     nano_atom_str(active_shader->info.label));
                         }
                     }
                 }
@@ -3421,7 +9574,7 @@ void nano_draw_debug_ui() {
                             &nano_app.shader_pool.shaders[slot].shader_entry;
 
                         char *source = shader->info.source;
-                        char *label = (char *)shader->info.label;
+                        const char *label = nano_atom_str(shader->info.label);
 
                         // Calculate the size of the input text box based on
                         // the visual text size of the shader source
@@ -3435,6 +9588,13 @@ void nano_draw_debug_ui() {
                         igText("Shader ID: %u", shader->id);
                         igText("Shader Type: %s",
                                nano_get_shader_type_str(shader));
+                        if (shader->cpu_ns_per_elem > 0.0) {
+                            igText("Last Run On: %s (CPU %.2f ns/elem, "
+                                   "GPU latency %.2f ms)",
+                                   shader->ran_on_cpu ? "CPU" : "GPU",
+                                   shader->cpu_ns_per_elem,
+                                   nano_app.gpu_latency_ms);
+                        }
 
                         // Display the shader source in a text box
                         igInputTextMultiline(label, source, strlen(source) * 2,
@@ -3489,6 +9649,39 @@ void nano_draw_debug_ui() {
 
 #endif
 
+// Start an ImGui frame for this frame, creating ImGui on first use
+// Call it after nano_start_frame() and before any ig* call when the app was
+// started with ui_on_demand, it does nothing if the frame already has one.
+// Returns false if there is no UI, e.g. without NANO_CIMGUI or a device.
+bool nano_ui_begin(void) {
+#ifdef NANO_CIMGUI
+    if (nano_app.ui_frame) {
+        return true;
+    }
+    if (!nano_has_gpu() || !wgpu_imgui_init()) {
+        return false;
+    }
+
+    // Fonts set before ImGui existed, fast_start loads them after the
+    // first draw instead
+    if (nano_app.fonts_deferred && !nano_app.wgpu->desc.fast_start) {
+        nano_app.fonts_deferred = false;
+        nano_init_fonts(&nano_app.font_info, nano_app.font_info.font_size);
+    }
+
+    // Set the display size for ImGui
+    ImGuiIO *io = igGetIO();
+    io->DisplaySize =
+        (ImVec2){(float)nano_app.wgpu->width, (float)nano_app.wgpu->height};
+
+    nano_cimgui_new_frame();
+    nano_app.ui_frame = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
 // -------------------------------------------------------------------------------
 // Nano Frame Update Functions
 // nano_start_frame() - Called at the beginning of the frame
@@ -3501,16 +9694,28 @@ void nano_draw_debug_ui() {
 // Calculate current frames per second
 WGPUCommandEncoder nano_start_frame() {
 
+    // The startup ends with the first frame
+    if (!nano_app.wgpu->startup_closed) {
+        nano_log_startup_timeline();
+    }
+
     // Update the dimensions of the window
     nano_app.wgpu->width = wgpu_width();
     nano_app.wgpu->height = wgpu_height();
 
-#ifdef NANO_CIMGUI
-    // Set the display size for ImGui
-    ImGuiIO *io = igGetIO();
-    io->DisplaySize =
-        (ImVec2){(float)nano_app.wgpu->width, (float)nano_app.wgpu->height};
-#endif
+    // Everything allocated from the frame arena last frame is done with
+    nano_arena_reset(&nano_frame_arena);
+
+    // Create, write and read back buffers for other threads
+    nano_flush_commands();
+
+    // Without a device there is nothing to draw, but the frame time is
+    // still useful for CPU-only applications
+    if (!nano_has_gpu()) {
+        nano_app.frametime = wgpu_frametime();
+        nano_app.fps = 1000 / nano_app.frametime;
+        return NULL;
+    }
 
     // Get the frame time and calculate the frames per second with
     // delta time
@@ -3519,6 +9724,9 @@ WGPUCommandEncoder nano_start_frame() {
     // Calculate the frames per second
     nano_app.fps = 1000 / nano_app.frametime;
 
+    // Write the NanoFrame values every shader shares
+    _nano_frame_uniforms_update();
+
     // Start the frame and return the command encoder
     // This command encoder should be passed around from
     // function to function to perform multiple render passes
@@ -3557,11 +9765,15 @@ WGPUCommandEncoder nano_start_frame() {
         WGPURenderPassEncoder pass = wgpuCommandEncoderBeginRenderPass(
             nano_app.wgpu->cmd_encoder, &render_pass_desc);
         wgpuRenderPassEncoderEnd(pass);
+        wgpuRenderPassEncoderRelease(pass);
     } // End of clear swapchain
 
-// Start the ImGui frame if nano_cimgui is enabled
+// Start the ImGui frame if nano_cimgui is enabled, with ui_on_demand only
+// nano_ui_begin() starts one
 #ifdef NANO_CIMGUI
-    nano_cimgui_new_frame();
+    if (!nano_app.wgpu->desc.ui_on_demand) {
+        nano_ui_begin();
+    }
 #endif
 
     return nano_app.wgpu->cmd_encoder;
@@ -3573,22 +9785,36 @@ WGPUCommandEncoder nano_start_frame() {
 void nano_end_frame() {
 
     assert(nano_app.wgpu != NULL && "Nano WGPU app is NULL\n");
+
+    // Nothing to present without a device
+    if (!nano_has_gpu()) {
+        return;
+    }
     assert(nano_app.wgpu->device != NULL && "Nano WGPU device is NULL\n");
     assert(nano_app.wgpu->swapchain != NULL && "Nano WGPU swapchain is NULL\n");
     assert(nano_app.wgpu->cmd_encoder != NULL &&
            "Nano WGPU command encoder is NULL\n");
 
+    // Draw the 2D primitives of the frame on top of the shaders
+    nano_draw_flush(nano_app.wgpu->cmd_encoder, wgpu_get_render_view(),
+                    wgpu_get_resolve_view(), (uint32_t)nano_app.wgpu->width,
+                    (uint32_t)nano_app.wgpu->height,
+                    nano_app.settings.gfx.msaa.sample_count);
+
 // If nano_cimgui is enabled, draw the debug UI if needed
 // and end the ImGui frame so we can render the ImGuiDrawData
 #ifdef NANO_CIMGUI
-    if (nano_app.show_debug) {
+    if (nano_app.show_debug && nano_ui_begin()) {
         nano_draw_debug_ui();
     }
 
     // We pass our command encoder to nano_cimgui to render the
-    // ImGuiDrawData onto the frame
-    nano_cimgui_end_frame(nano_app.wgpu->cmd_encoder, wgpu_get_render_view,
-                          wgpu_get_resolve_view);
+    // ImGuiDrawData onto the frame, frames without UI skip ImGui entirely
+    if (nano_app.ui_frame) {
+        nano_cimgui_end_frame(nano_app.wgpu->cmd_encoder,
+                              wgpu_get_render_view, wgpu_get_resolve_view);
+        nano_app.ui_frame = false;
+    }
 #endif
 
     // Create a command buffer so that we can submit the command
@@ -3643,6 +9869,15 @@ void nano_end_frame() {
         }
     }
 
+#ifdef NANO_CIMGUI
+    // Load the deferred fonts once ImGui has drawn something, they are used
+    // from the next frame on
+    if (nano_app.fonts_deferred && nano_cimgui_has_device_objects()) {
+        nano_app.fonts_deferred = false;
+        nano_init_fonts(&nano_app.font_info, nano_app.font_info.font_size);
+    }
+#endif
+
     // Update the font size if the flag is set
     if (nano_app.font_info.update_fonts) {
         nano_init_fonts(&nano_app.font_info, nano_app.font_info.font_size);
@@ -138,11 +138,40 @@ typedef struct {
     float res_y;
     uint32_t sample_count;
     bool no_depth_buffer;
+    // Keep running without a device if no adapter or device is available.
+    // Compute shaders with CPU kernels still run, rendering is skipped.
+    bool cpu_fallback;
+    // Start faster: pipelines are compiled asynchronously during startup
+    // and custom fonts are loaded once ImGui first draws something. See
+    // nano_start_app().
+    bool fast_start;
+    // Create ImGui and start its frames only when a UI is requested, see
+    // nano_ui_begin(). Hidden overlays cost nothing per frame.
+    bool ui_on_demand;
     wgpu_init_func init_cb;
+    // Optional, called once while the adapter and device are requested and
+    // always before init_cb. There is no device yet.
+    wgpu_init_func preload_cb;
     wgpu_frame_func frame_cb;
     wgpu_shutdown_func shutdown_cb;
 } wgpu_desc_t;
 
+// Startup Timeline
+// ----------------------------------------------------------------------------
+
+#ifndef WGPU_MAX_STARTUP_EVENTS
+#define WGPU_MAX_STARTUP_EVENTS 64
+#endif
+
+// A phase of the startup, times are in milliseconds since wgpu_start().
+// end is negative while the phase is still running.
+typedef struct {
+    const char *phase;
+    const char *label;
+    double start;
+    double end;
+} wgpu_startup_event_t;
+
 typedef struct {
     wgpu_desc_t desc;
     float width;
@@ -167,9 +196,23 @@ typedef struct {
     wgpu_mouse_btn_func mouse_btn_up_cb;
     wgpu_mouse_pos_func mouse_pos_cb;
     wgpu_mouse_wheel_func mouse_wheel_cb;
+    // Last cursor or touch position on the canvas
+    float mouse_x, mouse_y;
     bool async_setup_done;
     bool async_setup_failed;
+    // True when the device was created with the shader-f16 feature
+    bool has_f16;
+    // True when the device was created with the subgroups feature
+    bool has_subgroups;
     double last_frame_time;
+    // Phases recorded from wgpu_start() until the timeline is closed
+    wgpu_startup_event_t startup_events[WGPU_MAX_STARTUP_EVENTS];
+    int startup_event_count;
+    double startup_time;
+    bool startup_closed;
+    int adapter_event;
+    int device_event;
+    bool preload_done;
 #ifdef NANO_CIMGUI
     nano_cimgui_data *imgui_data;
 #endif
@@ -206,6 +249,7 @@ void wgpu_start(const wgpu_desc_t *desc) {
     assert(desc->init_cb && desc->frame_cb && desc->shutdown_cb);
 
     state.desc = *desc;
+    state.startup_time = emscripten_get_now();
     state.width = state.desc.res_x;
     state.height = state.desc.res_y;
     state.desc.sample_count = wgpu_def(state.desc.sample_count, 1);
@@ -219,6 +263,10 @@ wgpu_state_t *wgpu_get_state(void) { return &state; }
 
 WGPUDevice wgpu_get_device(void) { return state.device; }
 
+bool wgpu_has_f16(void) { return state.has_f16; }
+
+bool wgpu_has_subgroups(void) { return state.has_subgroups; }
+
 int wgpu_width(void) { return state.width; }
 
 int wgpu_height(void) { return state.height; }
@@ -234,6 +282,39 @@ double wgpu_frametime(void) {
     return frame_time;
 }
 
+// Current time in milliseconds, used for timing work outside of frames
+double wgpu_now(void) { return emscripten_get_now(); }
+
+// Start timing a phase of the startup. Returns the event to pass to
+// wgpu_startup_end(), or -1 once the timeline is closed or full.
+int wgpu_startup_begin(const char *phase, const char *label) {
+    if (state.startup_closed ||
+        state.startup_event_count == WGPU_MAX_STARTUP_EVENTS) {
+        return -1;
+    }
+
+    int event = state.startup_event_count++;
+    state.startup_events[event] = (wgpu_startup_event_t){
+        .phase = phase,
+        .label = label,
+        .start = emscripten_get_now() - state.startup_time,
+        .end = -1.0,
+    };
+    return event;
+}
+
+// Phases that started before the timeline was closed can still end
+void wgpu_startup_end(int event) {
+    if (event < 0 || event >= state.startup_event_count) {
+        return;
+    }
+    state.startup_events[event].end =
+        emscripten_get_now() - state.startup_time;
+}
+
+// Stop recording new phases, the events stay readable
+void wgpu_startup_close(void) { state.startup_closed = true; }
+
 void wgpu_mouse_btn_down(wgpu_mouse_btn_func fn) {
     state.mouse_btn_down_cb = fn;
 }
@@ -278,6 +359,31 @@ static WGPUTextureFormat wgpu_get_depth_format(void) {
     }
 }
 
+#ifdef NANO_CIMGUI
+// Create the ImGui context and backend for the device, once
+// With ui_on_demand this is called the first time a UI is requested.
+static bool wgpu_imgui_init(void) {
+    if (state.imgui_data) {
+        return true;
+    }
+    if (!state.device) {
+        return false;
+    }
+
+    int event = wgpu_startup_begin("imgui init", NULL);
+    state.imgui_data = nano_cimgui_init(
+        state.device, 2, wgpu_get_color_format(), WGPUTextureFormat_Undefined,
+        state.desc.res_x, state.desc.res_y, state.width, state.height,
+        state.desc.sample_count, NULL);
+    if (!state.imgui_data) {
+        WGPU_LOG("WGPU Backend: nano_cimgui_init() failed.\n");
+        return false;
+    }
+    wgpu_startup_end(event);
+    return true;
+}
+#endif
+
 // Expose a function to toggle fullscreen so we can use any key to toggle
 static bool wgpu_toggle_fullscreen(char *id) {
     return emsc_fullscreen(id) == EMSCRIPTEN_RESULT_SUCCESS;
@@ -332,10 +438,18 @@ static EM_BOOL emsc_size_changed(int event_type,
     // // userdata.
     // wgpu_state_t *state = (wgpu_state_t *)userdata;
     emsc_update_canvas_size();
+
+    // Nothing to resize when running without a device
+    if (!state.device) {
+        return true;
+    }
+
     wgpu_swapchain_reinit(&state);
 #ifdef NANO_CIMGUI
-    nano_cimgui_scale_to_canvas(state.desc.res_x, state.desc.res_y, state.width,
-                                state.height);
+    if (state.imgui_data) {
+        nano_cimgui_scale_to_canvas(state.desc.res_x, state.desc.res_y,
+                                    state.width, state.height);
+    }
 #endif
     return true;
 }
@@ -531,6 +645,8 @@ static EM_BOOL emsc_mousemove_cb(int type, const EmscriptenMouseEvent *ev,
                                  void *userdata) {
     (void)type;
     wgpu_state_t *state = (wgpu_state_t *)userdata;
+    state->mouse_x = (float)ev->targetX;
+    state->mouse_y = (float)ev->targetY;
     #ifdef NANO_CIMGUI
         if (state->imgui_data) {
             nano_cimgui_process_mousepos_event((float)ev->targetX, (float)ev->targetY);
@@ -567,6 +683,8 @@ static EM_BOOL emsc_touchstart_cb(int eventType, const EmscriptenTouchEvent *e,
                                   void *userData) {
     wgpu_state_t *state = (wgpu_state_t *)userData;
     if (e->numTouches > 0) {
+        state->mouse_x = (float)e->touches[0].targetX;
+        state->mouse_y = (float)e->touches[0].targetY;
         if (state->mouse_btn_down_cb) {
             state->mouse_btn_down_cb(0); // Simulate left mouse button
         }
@@ -601,6 +719,8 @@ static EM_BOOL emsc_touchmove_cb(int eventType, const EmscriptenTouchEvent *e,
                                  void *userData) {
     wgpu_state_t *state = (wgpu_state_t *)userData;
     if (e->numTouches > 0) {
+        state->mouse_x = (float)e->touches[0].targetX;
+        state->mouse_y = (float)e->touches[0].targetY;
         if (state->mouse_pos_cb) {
             state->mouse_pos_cb((float)e->touches[0].targetX,
                                 (float)e->touches[0].targetY);
@@ -621,16 +741,56 @@ static void error_cb(WGPUErrorType type, const char *message, void *userdata) {
     }
 }
 
+// Run the preload callback once. It runs while the adapter and device are
+// requested, or right before init_cb if they arrive first.
+static void wgpu_preload(wgpu_state_t *state) {
+    if (state->preload_done) {
+        return;
+    }
+    state->preload_done = true;
+
+    if (state->desc.preload_cb) {
+        int event = wgpu_startup_begin("preload", NULL);
+        state->desc.preload_cb();
+        wgpu_startup_end(event);
+    }
+}
+
+// Call init_cb as a phase of the startup
+static void wgpu_run_init(wgpu_state_t *state) {
+    wgpu_preload(state);
+
+    int event = wgpu_startup_begin("init", NULL);
+    state->desc.init_cb();
+    wgpu_startup_end(event);
+}
+
+// Start the application without a device when the desc allows it.
+// Returns false if the application should stop instead.
+static bool wgpu_start_without_device(wgpu_state_t *state) {
+    if (!state->desc.cpu_fallback) {
+        state->async_setup_failed = true;
+        return false;
+    }
+
+    WGPU_LOG("WGPU Backend: No device available, continuing on the CPU.\n");
+    state->device = 0;
+    wgpu_run_init(state);
+    state->async_setup_done = true;
+    return true;
+}
+
 static void request_device_cb(WGPURequestDeviceStatus status, WGPUDevice device,
                               const char *msg, void *userdata) {
     (void)status;
     (void)msg;
     (void)userdata;
     wgpu_state_t *state = userdata;
+    wgpu_startup_end(state->device_event);
     if (status != WGPURequestDeviceStatus_Success) {
         WGPU_LOG("WGPU Backend: wgpuAdapterRequestDevice failed with %s!\n",
                  msg);
-        state->async_setup_failed = true;
+        wgpu_start_without_device(state);
         return;
     }
     state->device = device;
@@ -639,6 +799,7 @@ static void request_device_cb(WGPURequestDeviceStatus status, WGPUDevice device,
     wgpuDevicePushErrorScope(state->device, WGPUErrorFilter_Validation);
 
     // setup swapchain
+    int event = wgpu_startup_begin("swapchain", NULL);
     WGPUSurfaceDescriptorFromCanvasHTMLSelector canvas_desc = {
         .chain.sType = WGPUSType_SurfaceDescriptorFromCanvasHTMLSelector,
         .selector = "#canvas",
@@ -655,21 +816,18 @@ static void request_device_cb(WGPURequestDeviceStatus status, WGPUDevice device,
     state->render_format =
         wgpuSurfaceGetPreferredFormat(state->surface, state->adapter);
     wgpu_swapchain_init(state);
+    wgpu_startup_end(event);
 #ifdef NANO_CIMGUI
 
     // Once the swapchain is created, we can initialize ImGui
-    // This is only done if the NANO_CIMGUI macro is defined
-    state->imgui_data = nano_cimgui_init(
-        state->device, 2, wgpu_get_color_format(), WGPUTextureFormat_Undefined,
-        state->desc.res_x, state->desc.res_y, state->width, state->height,
-        state->desc.sample_count, NULL);
-    if (!state->imgui_data) {
-        WGPU_LOG("WGPU Backend: nano_cimgui_init() failed.\n");
+    // This is only done if the NANO_CIMGUI macro is defined, and waits for
+    // the first UI frame with ui_on_demand
+    if (!state->desc.ui_on_demand && !wgpu_imgui_init()) {
         state->async_setup_failed = true;
         return;
     }
 #endif
-    state->desc.init_cb();
+    wgpu_run_init(state);
     wgpuDevicePopErrorScope(state->device, error_cb, 0);
     state->async_setup_done = true;
 }
@@ -679,18 +837,37 @@ static void request_adapter_cb(WGPURequestAdapterStatus status,
                                void *userdata) {
     (void)msg;
     wgpu_state_t *state = userdata;
+    wgpu_startup_end(state->adapter_event);
     if (status != WGPURequestAdapterStatus_Success) {
         WGPU_LOG("WGPU Backend: wgpuInstanceRequestAdapter failed!\n");
-        state->async_setup_failed = true;
+        wgpu_start_without_device(state);
+        return;
     }
     state->adapter = adapter;
 
-    WGPUFeatureName requiredFeatures[1] = {
+    WGPUFeatureName requiredFeatures[3] = {
         WGPUFeatureName_Depth32FloatStencil8};
+    size_t feature_count = 1;
+
+    // Half precision in shaders is optional, only ask for it when the
+    // adapter has it so the device request can't fail because of it
+    state->has_f16 =
+        wgpuAdapterHasFeature(adapter, WGPUFeatureName_ShaderF16);
+    if (state->has_f16) {
+        requiredFeatures[feature_count++] = WGPUFeatureName_ShaderF16;
+    }
+
+    state->has_subgroups =
+        wgpuAdapterHasFeature(adapter, WGPUFeatureName_Subgroups);
+    if (state->has_subgroups) {
+        requiredFeatures[feature_count++] = WGPUFeatureName_Subgroups;
+    }
+
     WGPUDeviceDescriptor dev_desc = {
-        .requiredFeatureCount = 1,
+        .requiredFeatureCount = feature_count,
         .requiredFeatures = requiredFeatures,
     };
+    state->device_event = wgpu_startup_begin("device request", NULL);
     wgpuAdapterRequestDevice(adapter, &dev_desc, request_device_cb, userdata);
 }
 
@@ -703,6 +880,10 @@ static EM_BOOL emsc_frame(double time, void *userdata) {
     if (!state->async_setup_done) {
         return EM_TRUE;
     }
+    if (!state->device) {
+        state->desc.frame_cb();
+        return EM_TRUE;
+    }
     wgpuDevicePushErrorScope(state->device, WGPUErrorFilter_Validation);
     state->desc.frame_cb();
     wgpuDevicePopErrorScope(state->device, error_cb, 0);
@@ -745,8 +926,13 @@ void wgpu_platform_start(wgpu_state_t *state) {
     state->instance = wgpuCreateInstance(0);
     assert(state->instance);
 
+    state->adapter_event = wgpu_startup_begin("adapter request", NULL);
     wgpuInstanceRequestAdapter(state->instance, 0, request_adapter_cb, state);
 
+    // The adapter and device arrive in later tasks, anything that doesn't
+    // need them can be done in the meantime
+    wgpu_preload(state);
+
     emscripten_request_animation_frame_loop(emsc_frame, state);
 }
 
@@ -858,7 +1044,9 @@ void wgpu_swapchain_discard(wgpu_state_t *state) {
 void wgpu_swapchain_reinit(wgpu_state_t *state) {
 
 #ifdef NANO_CIMGUI
-    state->imgui_data->multiSampleCount = state->desc.sample_count;
+    if (state->imgui_data) {
+        state->imgui_data->multiSampleCount = state->desc.sample_count;
+    }
 #endif
 
     // Release the old swapchain
@@ -887,7 +1075,10 @@ void wgpu_stop(void) {
     }
 
 #ifdef NANO_CIMGUI
-    nano_cimgui_shutdown();
+    if (state.imgui_data) {
+        nano_cimgui_shutdown();
+        state.imgui_data = NULL;
+    }
 #endif
 }
 #endif // NANO_WEB_H
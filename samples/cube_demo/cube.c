@@ -0,0 +1,193 @@
+#include <math.h>
+
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+char SHADER_PATH[] = "/wgpu-shaders/%s";
+char MESH_PATH[] = "/meshes/cube.obj";
+
+// Nano Application
+// ------------------------------------------------------
+//
+// Loads a cube from an OBJ file with nano_load_mesh() and draws it with
+// nano_shader_bind_mesh(), which matches the vertex inputs of cube.wgsl to
+// the attributes of the mesh. The mesh is quantized, so its positions are
+// snorm16 and its normals snorm8 on the GPU.
+//
+// The app starts with fast_start: the shader is read and parsed in
+// preload() while the device is requested, and its pipeline compiles while
+// the first frames run.
+
+nano_shader_t *cube_shader;
+nano_mesh_t cube_mesh;
+
+float rotation_speed = 0.6f;
+float angle = 0.0f;
+float cube_color[4] = {0.9f, 0.55f, 0.2f, 1.0f};
+
+// Column major 4x4 matrices, matching mat4x4<f32> in WGSL
+typedef float mat4[16];
+
+static void mat4_mul(mat4 out, const mat4 a, const mat4 b) {
+    mat4 result;
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            result[col * 4 + row] = sum;
+        }
+    }
+    memcpy(out, result, sizeof(mat4));
+}
+
+// Perspective projection with WebGPU's 0 to 1 depth range
+static void mat4_perspective(mat4 out, float fov_y, float aspect, float near,
+                             float far) {
+    float f = 1.0f / tanf(fov_y * 0.5f);
+    memset(out, 0, sizeof(mat4));
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = far / (near - far);
+    out[11] = -1.0f;
+    out[14] = near * far / (near - far);
+}
+
+// Rotation around the y axis followed by a fixed tilt around the x axis
+static void mat4_rotation(mat4 out, float yaw, float pitch) {
+    float cy = cosf(yaw), sy = sinf(yaw);
+    float cp = cosf(pitch), sp = sinf(pitch);
+    mat4 y = {cy, 0, -sy, 0, 0, 1, 0, 0, sy, 0, cy, 0, 0, 0, 0, 1};
+    mat4 x = {1, 0, 0, 0, 0, cp, sp, 0, 0, -sp, cp, 0, 0, 0, 0, 1};
+    mat4_mul(out, x, y);
+}
+
+// Upload the matrices for the current angle
+static void update_uniforms(void) {
+    float aspect = (float)nano_app.wgpu->width / (float)nano_app.wgpu->height;
+
+    // Quantized positions are decoded with the scale and offset of the mesh
+    mat4 decode = {
+        cube_mesh.scale[0], 0, 0, 0,
+        0, cube_mesh.scale[1], 0, 0,
+        0, 0, cube_mesh.scale[2], 0,
+        cube_mesh.offset[0], cube_mesh.offset[1], cube_mesh.offset[2], 1,
+    };
+    mat4 view = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, -5.0f, 1};
+
+    mat4 projection, rotation, mvp;
+    mat4_perspective(projection, 0.8f, aspect, 0.1f, 100.0f);
+    mat4_rotation(rotation, angle, 0.5f);
+    mat4_mul(mvp, rotation, decode);
+    mat4_mul(mvp, view, mvp);
+    mat4_mul(mvp, projection, mvp);
+
+    nano_shader_set_uniform_mat4(cube_shader, "mvp", mvp);
+    nano_shader_set_uniform_mat4(cube_shader, "rotation", rotation);
+    nano_shader_set_uniform_vec4(cube_shader, "color", cube_color);
+}
+
+// Preload callback passed to nano_start_app(), there is no device yet
+static void preload(void) {
+
+    char shader_path[256];
+
+    snprintf(shader_path, sizeof(shader_path), SHADER_PATH, "cube.wgsl");
+    uint32_t cube_shader_id =
+        nano_create_shader_from_file(shader_path, "cube.wgsl");
+    cube_shader = nano_get_shader(cube_shader_id);
+    if (cube_shader == NULL) {
+        LOG("DEMO: Failed to create cube shader\n");
+    }
+}
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+
+    // Initialize the nano project
+    nano_default_init();
+
+    if (cube_shader == NULL) {
+        return;
+    }
+
+    // The mesh buffers are uploaded here, the file is unmapped afterwards
+    if (nano_load_mesh(MESH_PATH, NANO_MESH_QUANTIZE, &cube_mesh) !=
+        NANO_OK) {
+        LOG("DEMO: Failed to load %s\n", MESH_PATH);
+        return;
+    }
+
+    // Binds the position and normal buffers and the index buffer
+    if (nano_shader_bind_mesh(cube_shader, &cube_mesh) != NANO_OK) {
+        LOG("DEMO: Failed to bind the cube mesh\n");
+        return;
+    }
+
+    // There is no depth buffer, culling the back faces is enough to draw a
+    // convex mesh
+    nano_shader_set_cull_mode(cube_shader, WGPUCullMode_Back);
+
+    update_uniforms();
+    nano_shader_activate(cube_shader, true);
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+
+    if (cube_shader != NULL) {
+        angle += rotation_speed * (float)nano_app.frametime / 1000.0f;
+        update_uniforms();
+    }
+
+    nano_execute_shaders();
+
+    igBegin("Nano Cube Demo", NULL, 0);
+    igText("%s: %u vertices, %u indices", MESH_PATH, cube_mesh.vertex_count,
+           cube_mesh.index_count);
+    igText("Quantized: %s", cube_mesh.quantized ? "Yes" : "No");
+    igSliderFloat("Rotation Speed", &rotation_speed, 0.0f, 3.0f, "%.2f", 0);
+    igColorEdit3("Color", cube_color, 0);
+    igEnd();
+
+    // Change Nano app state at end of frame
+    nano_end_frame();
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) {
+    // The shader only borrows the mesh buffers, release it before the mesh
+    // that owns them
+    if (cube_shader != NULL) {
+        nano_release_shader(cube_shader->id);
+    }
+    nano_release_mesh(&cube_mesh);
+    nano_default_cleanup();
+}
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Cube Demo",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+        .fast_start = true,
+        .preload_cb = preload,
+    });
+
+    return 0;
+}
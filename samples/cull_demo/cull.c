@@ -0,0 +1,218 @@
+#include <math.h>
+
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+char SHADER_PATH[] = "/wgpu-shaders/%s";
+char MESH_PATH[] = "/meshes/cube.obj";
+
+// Nano Application
+// ------------------------------------------------------
+//
+// Draws a field of 100k cubes with GPU frustum culling. Every frame
+// nano_cull_dispatch() tests the bounding sphere of each cube against the
+// camera frustum, compacts the indices of the visible cubes and writes the
+// instance count of an indirect draw, so the CPU never touches a cube and
+// the vertex shader only runs for the cubes on screen.
+//
+// There is no depth buffer, so the camera looks straight down at a single
+// layer of cubes that never cover each other.
+
+#define GRID_X 400
+#define GRID_Z 250
+#define NUM_CUBES (GRID_X * GRID_Z)
+#define SPACING 2.5f
+
+nano_shader_t *cubes_shader;
+nano_mesh_t cube_mesh;
+nano_cull_t cull;
+
+// Bounding spheres, the center in xyz and the radius in w
+float spheres[NUM_CUBES * 4];
+
+bool culling = true;
+float height = 120.0f;
+float pan_speed = 0.1f;
+float pan_angle = 0.0f;
+float cube_color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+
+// Column major 4x4 matrices, matching mat4x4<f32> in WGSL
+typedef float mat4[16];
+
+static void mat4_mul(mat4 out, const mat4 a, const mat4 b) {
+    mat4 result;
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            result[col * 4 + row] = sum;
+        }
+    }
+    memcpy(out, result, sizeof(mat4));
+}
+
+// Perspective projection with WebGPU's 0 to 1 depth range
+static void mat4_perspective(mat4 out, float fov_y, float aspect, float near,
+                             float far) {
+    float f = 1.0f / tanf(fov_y * 0.5f);
+    memset(out, 0, sizeof(mat4));
+    out[0] = f / aspect;
+    out[5] = f;
+    out[10] = far / (near - far);
+    out[11] = -1.0f;
+    out[14] = near * far / (near - far);
+}
+
+// Camera at (x, y, z) looking down the -y axis with -z up on the screen
+static void mat4_look_down(mat4 out, float x, float y, float z) {
+    mat4 view = {1, 0, 0, 0, 0, 0, 1, 0, 0, -1, 0, 0, -x, z, -y, 1};
+    memcpy(out, view, sizeof(mat4));
+}
+
+// Place the cubes on a grid centered on the origin with a random size each
+static void fill_spheres(void) {
+    uint32_t seed = 12345u;
+    for (int i = 0; i < NUM_CUBES; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float size = 0.4f + 0.6f * (float)(seed >> 8) / 16777216.0f;
+
+        float *sphere = &spheres[i * 4];
+        sphere[0] = ((float)(i % GRID_X) - GRID_X * 0.5f) * SPACING;
+        sphere[1] = 0.0f;
+        sphere[2] = ((float)(i / GRID_X) - GRID_Z * 0.5f) * SPACING;
+        sphere[3] = size * sqrtf(3.0f);
+    }
+}
+
+// Upload the camera and cull the cubes it can not see
+static void update_camera(void) {
+    float aspect = (float)nano_app.wgpu->width / (float)nano_app.wgpu->height;
+
+    // Pan in an ellipse that stays inside the grid
+    float x = cosf(pan_angle) * GRID_X * SPACING * 0.3f;
+    float z = sinf(pan_angle) * GRID_Z * SPACING * 0.3f;
+
+    mat4 projection, view, view_proj;
+    mat4_perspective(projection, 0.8f, aspect, 1.0f, 2000.0f);
+    mat4_look_down(view, x, height, z);
+    mat4_mul(view_proj, projection, view);
+
+    nano_shader_set_uniform_mat4(cubes_shader, "view_proj", view_proj);
+    nano_shader_set_uniform_vec4(cubes_shader, "color", cube_color);
+
+    // Without a matrix every cube is kept, to compare the cost
+    nano_cull_dispatch(&cull, culling ? view_proj : NULL);
+}
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+
+    char shader_path[256];
+
+    // Initialize the nano project
+    nano_default_init();
+
+    snprintf(shader_path, sizeof(shader_path), SHADER_PATH,
+             "cull-cubes.wgsl");
+    uint32_t cubes_shader_id =
+        nano_create_shader_from_file(shader_path, "cull-cubes.wgsl");
+    cubes_shader = nano_get_shader(cubes_shader_id);
+    if (cubes_shader == NULL) {
+        LOG("DEMO: Failed to create cubes shader\n");
+        return;
+    }
+
+    if (nano_load_mesh(MESH_PATH, NANO_MESH_DEFAULT, &cube_mesh) != NANO_OK) {
+        LOG("DEMO: Failed to load %s\n", MESH_PATH);
+        cubes_shader = NULL;
+        return;
+    }
+
+    // The culling stage owns the spheres, the visible indices and the draw
+    // arguments, the render shader reads all three
+    fill_spheres();
+    int status = nano_create_cull(&cull, &(nano_cull_desc_t){
+                                             .count = NUM_CUBES,
+                                             .spheres = spheres,
+                                             .element_count =
+                                                 cube_mesh.index_count,
+                                         });
+    if (status != NANO_OK) {
+        LOG("DEMO: Failed to create the culling stage\n");
+        cubes_shader = NULL;
+        return;
+    }
+
+    nano_shader_bind_mesh(cubes_shader, &cube_mesh);
+    nano_shader_bind_buffer(cubes_shader, nano_get_buffer(cull.spheres), 0,
+                            1);
+    nano_shader_bind_buffer(cubes_shader, nano_get_buffer(cull.visible), 0,
+                            2);
+    nano_shader_set_indirect_buffer(cubes_shader, cull.args, 0);
+    nano_shader_set_cull_mode(cubes_shader, WGPUCullMode_Back);
+
+    update_camera();
+    nano_shader_activate(cubes_shader, true);
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+
+    // The culling pass is submitted before the frame's render passes
+    if (cubes_shader != NULL) {
+        pan_angle += pan_speed * (float)nano_app.frametime / 1000.0f;
+        update_camera();
+    }
+
+    nano_execute_shaders();
+
+    igBegin("Nano Cull Demo", NULL, 0);
+    igText("%d cubes, %u indices each", NUM_CUBES, cube_mesh.index_count);
+    igText("FPS: %.1f", nano_app.fps);
+    igCheckbox("GPU Frustum Culling", &culling);
+    igSliderFloat("Camera Height", &height, 10.0f, 1000.0f, "%.0f", 0);
+    igSliderFloat("Pan Speed", &pan_speed, 0.0f, 1.0f, "%.2f", 0);
+    igColorEdit3("Color", cube_color, 0);
+    igEnd();
+
+    // Change Nano app state at end of frame
+    nano_end_frame();
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) {
+    // The shader only borrows the mesh buffers, release it before the mesh
+    // that owns them
+    if (cubes_shader != NULL) {
+        nano_release_shader(cubes_shader->id);
+    }
+    nano_release_cull(&cull);
+    nano_release_mesh(&cube_mesh);
+    nano_default_cleanup();
+}
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Cull Demo",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+    });
+
+    return 0;
+}
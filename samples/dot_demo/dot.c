@@ -37,14 +37,8 @@ nano_shader_t *dot_shader;
 char shader_path[256];
 char shader_code[8192];
 
-// When using the uniform buffer with Nano, if the shader is not working as
-// expected, you should use the @align(n) directive in the shader to align the
-// buffer in multiples of 16 bytes. See assets/shaders/dot.wgsl for an example.
-struct UniformBuffer {
-    float time;          // 4 bytes
-    float padding;       // 4 bytes
-    float resolution[2]; // 8 bytes
-} uniform_data;          // 16 bytes
+// dot.wgsl declares the NanoFrame uniform, which Nano writes once per frame
+// and binds on its own. There is no buffer to create or uniform to set.
 
 // Initialization callback passed to nano_start_app()
 static void init(void) {
@@ -78,29 +72,6 @@ static void init(void) {
         return;
     }
 
-    uniform_data.time = 0.0f;
-    uniform_data.resolution[0] = nano_app.wgpu->width;
-    uniform_data.resolution[1] = nano_app.wgpu->height;
-
-    nano_binding_info_t *uniform_binding =
-        nano_shader_get_binding(dot_shader, 0, 0);
-
-    // Returns 0 if fails. It won't fail in this case though.
-    // We pass the uniform_binding information, the size of the uniform_data,
-    // the number of elements in the buffer (for uniform structs it should
-    // always be 1), the offset, and the data.
-    uint32_t buffer_id = nano_create_buffer(
-        uniform_binding, sizeof(uniform_data), 1, 0, &uniform_data);
-
-    nano_buffer_t *uniform_buffer =
-        nano_get_buffer(buffer_id);
-
-    int status = nano_shader_bind_uniforms(dot_shader, uniform_buffer, 0, 0);
-    if (status == NANO_FAIL) {
-        LOG("Failed to assign uniform buffer to dot shader\n");
-        return;
-    }
-
     // Build and activate the compute shader
     // Once a shader is built, it can be activated and deactivated
     // without incurring the cost of rebuilding the shader.
@@ -129,10 +100,6 @@ static void frame(void) {
 
     // Change Nano app state at end of frame
     nano_end_frame();
-
-    uniform_data.resolution[0] = nano_app.wgpu->width;
-    uniform_data.resolution[1] = nano_app.wgpu->height;
-    uniform_data.time += 0.01f;
 }
 
 // Shutdown callback passed to nano_start_app()
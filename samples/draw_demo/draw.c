@@ -0,0 +1,104 @@
+#include <math.h>
+
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+// Nano Application
+// ------------------------------------------------------
+//
+// Draws a spiral of lines and a swarm of points every frame with the 2D
+// batch renderer. Nothing is created up front: the primitives are queued
+// with nano_draw_line(), nano_draw_rect() and nano_draw_points(), and
+// nano_end_frame() draws all of them with a single instanced draw call.
+
+#define MAX_POINTS (1 << 18)
+
+float points[MAX_POINTS * 2];
+int point_count = 65536;
+int line_count = 512;
+float point_size = 2.0f;
+float time_seconds = 0.0f;
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+    // Initialize the nano project
+    nano_default_init();
+}
+
+// Queue the primitives of the current frame
+static void draw_scene(void) {
+    float width = (float)nano_app.wgpu->width;
+    float height = (float)nano_app.wgpu->height;
+    float cx = width * 0.5f;
+    float cy = height * 0.5f;
+    float radius = (width < height ? width : height) * 0.45f;
+
+    nano_draw_rect(0.0f, 0.0f, width, 40.0f, NANO_RGBA(30, 30, 40, 200));
+
+    // Spiral of lines rotating around the center of the screen
+    for (int i = 0; i < line_count; i++) {
+        float t = (float)i / (float)line_count;
+        float angle = t * 12.0f * 3.14159265f + time_seconds;
+        float r0 = radius * t;
+        float r1 = radius * (t + 1.0f / (float)line_count);
+        float angle1 = angle + 12.0f * 3.14159265f / (float)line_count;
+        nano_draw_line(cx + cosf(angle) * r0, cy + sinf(angle) * r0,
+                       cx + cosf(angle1) * r1, cy + sinf(angle1) * r1, 3.0f,
+                       NANO_RGBA(255, (int)(t * 255.0f), 80, 255));
+    }
+
+    // Points on a Lissajous curve, all queued with one call
+    for (int i = 0; i < point_count; i++) {
+        float t = (float)i / (float)point_count * 6.2831853f;
+        points[i * 2 + 0] = cx + sinf(3.0f * t + time_seconds) * radius;
+        points[i * 2 + 1] = cy + sinf(4.0f * t) * radius;
+    }
+    nano_draw_points(points, (size_t)point_count, point_size,
+                     NANO_RGBA(90, 200, 255, 160));
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+
+    time_seconds += (float)nano_app.frametime / 1000.0f;
+    draw_scene();
+
+    nano_draw_stats_t stats = nano_draw_get_stats();
+    igBegin("Nano Draw Demo", NULL, 0);
+    igText("%u primitives in %u draw calls", stats.instances,
+           stats.draw_calls);
+    igSliderInt("Points", &point_count, 0, MAX_POINTS, "%d", 0);
+    igSliderInt("Lines", &line_count, 1, 4096, "%d", 0);
+    igSliderFloat("Point Size", &point_size, 1.0f, 8.0f, "%.1f", 0);
+    igEnd();
+
+    // The 2D primitives are drawn here, before ImGui
+    nano_end_frame();
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) { nano_default_cleanup(); }
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Draw Demo",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+    });
+
+    return 0;
+}
@@ -0,0 +1,327 @@
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+// Benchmark of the render path
+// ------------------------------------------------------
+//
+// Runs a fixed list of scenes on their own, one after the other, and prints
+// the results of each scene as a JSON object on its own line as soon as the
+// scene is done, so a scene that fails does not lose the others:
+// - fill: N full screen passes of wave.wgsl, for fill rate and overdraw
+// - draws: N calls to nano_shader_execute() drawing a tiny triangle, for
+//   the overhead of each draw
+// - imgui: an ImGui window whose draw list grows to N rectangles
+// The fill and draw scenes run again with 4x MSAA.
+//
+// Each scene reports the frames per second, the CPU time spent encoding
+// the frame, from nano_start_frame() to the end of nano_end_frame(), and
+// the GPU time, from the submit until the queue reports the work done. One
+// GPU timing is in flight at a time, like Nano's own gpu_latency_ms.
+
+#define SHADER_PATH "/wgpu-shaders/%s"
+
+// Frames before each scene is measured, the first ones rebuild the
+// swapchain and pipelines when the sample count changes
+#define WARMUP_FRAMES 30
+#define MEASURED_FRAMES 120
+
+typedef enum {
+    SCENE_FILL,
+    SCENE_DRAWS,
+    SCENE_IMGUI,
+} scene_kind_t;
+
+typedef struct {
+    scene_kind_t kind;
+    int count;
+    uint8_t sample_count;
+} bench_scene_t;
+
+static const bench_scene_t scenes[] = {
+    {SCENE_FILL, 1, 1},      {SCENE_FILL, 4, 1},     {SCENE_FILL, 16, 1},
+    {SCENE_FILL, 64, 1},     {SCENE_DRAWS, 1, 1},    {SCENE_DRAWS, 100, 1},
+    {SCENE_DRAWS, 1000, 1},  {SCENE_DRAWS, 5000, 1}, {SCENE_FILL, 1, 4},
+    {SCENE_FILL, 4, 4},      {SCENE_FILL, 16, 4},    {SCENE_DRAWS, 1000, 4},
+    {SCENE_IMGUI, 1000, 1},  {SCENE_IMGUI, 10000, 1},
+    {SCENE_IMGUI, 100000, 1},
+};
+#define NUM_SCENES (int)(sizeof(scenes) / sizeof(scenes[0]))
+
+// Timings of one scene
+typedef struct {
+    double cpu_ms[MEASURED_FRAMES];
+    double frame_ms[MEASURED_FRAMES];
+    double gpu_ms[MEASURED_FRAMES];
+    int frames;
+    int gpu_count;
+} bench_result_t;
+
+bench_result_t results[NUM_SCENES];
+
+nano_shader_t *wave_shader;
+nano_shader_t *tiny_shader;
+
+bool bench_done = false;
+int scene_index = 0;
+int frame_index = 0;
+
+// The GPU timing in flight and the scene it belongs to, or -1
+int gpu_scene = -1;
+double gpu_start;
+
+static const char *scene_name(scene_kind_t kind) {
+    switch (kind) {
+    case SCENE_FILL:
+        return "fill";
+    case SCENE_DRAWS:
+        return "draws";
+    case SCENE_IMGUI:
+        return "imgui";
+    }
+    return "unknown";
+}
+
+static int compare_ms(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Print the mean and percentiles of count timings as a JSON object
+static void print_timings(const char *name, const double *ms, int count) {
+    if (count == 0) {
+        printf("\"%s\": null", name);
+        return;
+    }
+
+    double sorted[MEASURED_FRAMES];
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sorted[i] = ms[i];
+        sum += ms[i];
+    }
+    qsort(sorted, count, sizeof(double), compare_ms);
+
+    // Nearest rank percentiles
+    int p50 = (50 * count + 99) / 100 - 1;
+    int p95 = (95 * count + 99) / 100 - 1;
+    printf("\"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f}", name,
+           sum / count, sorted[p50 > 0 ? p50 : 0], sorted[p95 > 0 ? p95 : 0]);
+}
+
+// Print the results of a scene as one line of JSON
+// The GPU timing still in flight when the scene ends is not included.
+static void print_scene(int index) {
+    const bench_scene_t *scene = &scenes[index];
+    bench_result_t *result = &results[index];
+
+    double frame_sum = 0.0;
+    for (int j = 0; j < result->frames; j++) {
+        frame_sum += result->frame_ms[j];
+    }
+    double fps = frame_sum > 0.0 ? 1000.0 * result->frames / frame_sum : 0.0;
+
+    printf("{\"benchmark\": \"render_bench\", \"width\": %d, "
+           "\"height\": %d, \"scene\": \"%s\", \"count\": %d, "
+           "\"sample_count\": %u, \"frames\": %d, \"fps\": %.2f, ",
+           (int)nano_app.wgpu->width, (int)nano_app.wgpu->height,
+           scene_name(scene->kind), scene->count, scene->sample_count,
+           result->frames, fps);
+    print_timings("cpu_encode_ms", result->cpu_ms, result->frames);
+    printf(", ");
+    print_timings("gpu_ms", result->gpu_ms, result->gpu_count);
+    printf("}\n");
+    fflush(stdout);
+}
+
+// Switch the sample count of the swapchain and pipelines, it takes effect
+// at the end of the frame
+static void set_sample_count(uint8_t sample_count) {
+    nano_msaa_settings_t *msaa = &nano_app.settings.gfx.msaa;
+    if (msaa->sample_count == sample_count) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        if (msaa->msaa_values[i] == sample_count) {
+            msaa->msaa_index = i;
+            msaa->msaa_changed = true;
+        }
+    }
+}
+
+static void gpu_done_cb(WGPUQueueWorkDoneStatus status, void *userdata) {
+    (void)userdata;
+
+    int index = gpu_scene;
+    gpu_scene = -1;
+    if (status != WGPUQueueWorkDoneStatus_Success || index < 0) {
+        return;
+    }
+
+    bench_result_t *result = &results[index];
+    if (result->gpu_count < MEASURED_FRAMES) {
+        result->gpu_ms[result->gpu_count++] = wgpu_now() - gpu_start;
+    }
+}
+
+// Record the work of the current scene into the frame
+static void draw_scene(const bench_scene_t *scene) {
+    switch (scene->kind) {
+    case SCENE_FILL:
+        nano_shader_set_uniform_f32(wave_shader, "time",
+                                    (float)wgpu_now() / 1000.0f);
+        for (int i = 0; i < scene->count; i++) {
+            nano_shader_execute(wave_shader);
+        }
+        break;
+    case SCENE_DRAWS:
+        for (int i = 0; i < scene->count; i++) {
+            nano_shader_execute(tiny_shader);
+        }
+        break;
+    case SCENE_IMGUI: {
+        igSetNextWindowPos((ImVec2){0.0f, 0.0f}, ImGuiCond_Always,
+                           (ImVec2){0.0f, 0.0f});
+        igSetNextWindowSize((ImVec2){(float)nano_app.wgpu->width,
+                                     (float)nano_app.wgpu->height},
+                            ImGuiCond_Always);
+        igBegin("Nano Render Benchmark Draw List", NULL, 0);
+        ImDrawList *draw_list = igGetWindowDrawList();
+        for (int i = 0; i < scene->count; i++) {
+            float x = (float)(i % 256) * 5.0f;
+            float y = (float)((i / 256) % 144) * 5.0f;
+            ImDrawList_AddRectFilled(draw_list, (ImVec2){x, y},
+                                     (ImVec2){x + 4.0f, y + 4.0f},
+                                     0xff0080ffu + (uint32_t)(i & 0xff), 0.0f,
+                                     0);
+        }
+        igEnd();
+        break;
+    }
+    }
+}
+
+// Nano Application
+// ------------------------------------------------------
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+
+    char shader_path[256];
+
+    // Initialize the nano project
+    nano_default_init();
+
+    // The debug window would be measured with every scene
+    nano_app.show_debug = false;
+
+    snprintf(shader_path, sizeof(shader_path), SHADER_PATH, "wave.wgsl");
+    wave_shader = nano_get_shader(
+        nano_create_shader_from_file(shader_path, "wave.wgsl"));
+    snprintf(shader_path, sizeof(shader_path), SHADER_PATH,
+             "tiny-triangle.wgsl");
+    tiny_shader = nano_get_shader(
+        nano_create_shader_from_file(shader_path, "tiny-triangle.wgsl"));
+    if (wave_shader == NULL || tiny_shader == NULL) {
+        LOG("BENCH: Failed to create the shaders\n");
+        bench_done = true;
+        return;
+    }
+
+    float resolution[2] = {(float)nano_app.wgpu->width,
+                           (float)nano_app.wgpu->height};
+    nano_shader_set_uniform_vec2(wave_shader, "resolution", resolution);
+    nano_shader_set_uniform_f32(wave_shader, "frequency", 5.0f);
+    nano_shader_set_uniform_f32(wave_shader, "amplitude", 0.5f);
+    nano_shader_set_uniform_f32(wave_shader, "speed", 0.2f);
+    nano_shader_set_uniform_f32(wave_shader, "thickness", 0.005f);
+
+    // Active shaders get their pipelines rebuilt when the sample count
+    // changes. They are only drawn by the scenes, through
+    // nano_shader_execute().
+    nano_shader_activate(wave_shader, true);
+    nano_shader_activate(tiny_shader, true);
+
+    set_sample_count(scenes[0].sample_count);
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    if (bench_done) {
+        WGPUCommandEncoder cmd_encoder = nano_start_frame();
+        igBegin("Nano Render Benchmark", NULL, 0);
+        igText("Done, the results were printed as JSON");
+        igEnd();
+        nano_end_frame();
+        return;
+    }
+
+    const bench_scene_t *scene = &scenes[scene_index];
+    bench_result_t *result = &results[scene_index];
+    bool measured = frame_index >= WARMUP_FRAMES;
+
+    double start = wgpu_now();
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+    draw_scene(scene);
+    nano_end_frame();
+    double cpu_ms = wgpu_now() - start;
+
+    if (!measured) {
+        frame_index++;
+        return;
+    }
+
+    if (gpu_scene < 0) {
+        gpu_scene = scene_index;
+        gpu_start = start + cpu_ms;
+        wgpuQueueOnSubmittedWorkDone(wgpuDeviceGetQueue(nano_app.wgpu->device),
+                                     gpu_done_cb, NULL);
+    }
+
+    result->cpu_ms[result->frames] = cpu_ms;
+    result->frame_ms[result->frames] = nano_app.frametime;
+    result->frames++;
+
+    if (++frame_index < WARMUP_FRAMES + MEASURED_FRAMES) {
+        return;
+    }
+
+    LOG("BENCH: %s x%d at %ux done\n", scene_name(scene->kind), scene->count,
+        scene->sample_count);
+    print_scene(scene_index);
+
+    frame_index = 0;
+    if (++scene_index < NUM_SCENES) {
+        set_sample_count(scenes[scene_index].sample_count);
+        return;
+    }
+
+    bench_done = true;
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) { nano_default_cleanup(); }
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Render Benchmark",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 1,
+    });
+
+    return 0;
+}
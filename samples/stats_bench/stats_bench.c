@@ -0,0 +1,268 @@
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+// Benchmark of the statistics kernels
+// ------------------------------------------------------
+//
+// Times the moments reduction with the shared memory kernels and, when the
+// device supports subgroups, with the subgroup kernels.
+//
+// Readbacks only complete between frames, so a single dispatch can't be
+// timed from the CPU. Each batch queues BATCH_DISPATCHES moments
+// reductions followed by one nano_stats_dispatch() and measures the time
+// until its results arrive, which spreads the frame latency over the batch.
+
+#define NUM_VALUES (1 << 24)
+#define UPLOAD_CHUNK (1 << 20)
+#define BATCH_DISPATCHES 64
+#define BATCH_COUNT 8
+
+typedef enum {
+    BENCH_WARMUP,
+    BENCH_RUNNING,
+    BENCH_DONE,
+} bench_state_t;
+
+// Results for one kernel variant
+typedef struct {
+    nano_kernel_variant_t variant;
+    bool supported;
+    // Fastest batch, in milliseconds per reduction
+    double best_ms;
+    // Moments of the last batch, to check the variants agree
+    nano_stats_result_t result;
+} bench_result_t;
+
+bench_result_t results[2] = {
+    {.variant = NANO_KERNEL_SHARED_MEMORY},
+    {.variant = NANO_KERNEL_SUBGROUPS},
+};
+
+WGPUBuffer values;
+nano_stats_t stats;
+
+bench_state_t bench_state = BENCH_WARMUP;
+int current = 0;
+int batches = 0;
+bool in_flight = false;
+double batch_start;
+
+// Fill the values buffer in chunks so the whole array never has to live in
+// wasm memory
+static void upload_values(void) {
+    WGPUQueue queue = wgpuDeviceGetQueue(nano_app.wgpu->device);
+    float *chunk = (float *)malloc(UPLOAD_CHUNK * sizeof(float));
+    if (chunk == NULL) {
+        LOG("BENCH: Could not allocate the upload chunk\n");
+        return;
+    }
+
+    uint32_t seed = 12345u;
+    for (size_t first = 0; first < NUM_VALUES; first += UPLOAD_CHUNK) {
+        for (size_t i = 0; i < UPLOAD_CHUNK; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            chunk[i] = (float)(seed >> 8) / (float)(1 << 24) * 100.0f;
+        }
+        wgpuQueueWriteBuffer(queue, values, first * sizeof(float), chunk,
+                             UPLOAD_CHUNK * sizeof(float));
+    }
+
+    free(chunk);
+}
+
+// Queue BATCH_DISPATCHES moments reductions with the current stats kernels
+static void submit_batch(void) {
+    nano_stats_kernels_t *kernels = &nano_app.stats_kernels;
+    WGPUDevice device = nano_app.wgpu->device;
+
+    uint32_t groups = (NUM_VALUES + 255) / 256;
+    if (groups > NANO_STATS_MAX_PARTIALS)
+        groups = NANO_STATS_MAX_PARTIALS;
+
+    WGPUCommandEncoder encoder = wgpuDeviceCreateCommandEncoder(
+        device,
+        &(WGPUCommandEncoderDescriptor){.label = "Stats Bench Encoder"});
+    WGPUComputePassEncoder pass =
+        wgpuCommandEncoderBeginComputePass(encoder, NULL);
+    wgpuComputePassEncoderSetBindGroup(pass, 0, stats.bind_group, 0, NULL);
+
+    for (int i = 0; i < BATCH_DISPATCHES; i++) {
+        wgpuComputePassEncoderSetPipeline(pass, kernels->moments_partial);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, groups, 1, 1);
+        wgpuComputePassEncoderSetPipeline(pass, kernels->moments_final);
+        wgpuComputePassEncoderDispatchWorkgroups(pass, 1, 1, 1);
+    }
+
+    wgpuComputePassEncoderEnd(pass);
+    WGPUCommandBuffer command_buffer = wgpuCommandEncoderFinish(encoder, NULL);
+    wgpuQueueSubmit(wgpuDeviceGetQueue(device), 1, &command_buffer);
+
+    wgpuCommandBufferRelease(command_buffer);
+    wgpuComputePassEncoderRelease(pass);
+    wgpuCommandEncoderRelease(encoder);
+}
+
+// Move on to the next supported variant
+static void next_variant(void) {
+    batches = 0;
+    bench_state = BENCH_DONE;
+
+    while (++current < 2) {
+        if (results[current].supported) {
+            nano_stats_set_variant(results[current].variant);
+            bench_state = BENCH_WARMUP;
+            return;
+        }
+    }
+
+    LOG("BENCH: Shared memory %.3f ms per reduction\n", results[0].best_ms);
+    if (results[1].supported) {
+        LOG("BENCH: Subgroups %.3f ms per reduction (%.2fx)\n",
+            results[1].best_ms, results[0].best_ms / results[1].best_ms);
+    }
+}
+
+// Advance the benchmark, called once per frame
+static void run_bench(void) {
+    if (bench_state == BENCH_DONE || stats.pending) {
+        return;
+    }
+
+    bench_result_t *result = &results[current];
+
+    // The first dispatch of a variant writes the params and compiles the
+    // pipelines, so it is not timed
+    if (bench_state == BENCH_WARMUP) {
+        if (!in_flight) {
+            stats.ready = false;
+            in_flight = nano_stats_dispatch(&stats) == NANO_OK;
+        } else if (stats.ready) {
+            in_flight = false;
+            result->best_ms = 1e30;
+            bench_state = BENCH_RUNNING;
+        }
+        return;
+    }
+
+    if (!in_flight) {
+        stats.ready = false;
+        batch_start = wgpu_now();
+        submit_batch();
+        in_flight = nano_stats_dispatch(&stats) == NANO_OK;
+        return;
+    }
+
+    if (!stats.ready) {
+        return;
+    }
+
+    in_flight = false;
+    double ms = (wgpu_now() - batch_start) / (BATCH_DISPATCHES + 1);
+    if (ms < result->best_ms) {
+        result->best_ms = ms;
+    }
+    result->result = stats.data;
+
+    if (++batches == BATCH_COUNT) {
+        next_variant();
+    }
+}
+
+// Nano Application
+// ------------------------------------------------------
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+
+    // Initialize the nano project
+    nano_default_init();
+
+    values = wgpuDeviceCreateBuffer(
+        nano_app.wgpu->device,
+        &(WGPUBufferDescriptor){
+            .label = "Stats Bench Values",
+            .usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopyDst,
+            .size = NUM_VALUES * sizeof(float),
+        });
+    upload_values();
+
+    results[0].supported = true;
+    results[1].supported = nano_has_subgroups();
+
+    // Start with the fallback, the subgroup variant is measured second
+    nano_stats_set_variant(NANO_KERNEL_SHARED_MEMORY);
+
+    int status = nano_create_stats(&stats, &(nano_stats_desc_t){
+                                               .src = values,
+                                               .count = NUM_VALUES,
+                                               .flags = NANO_STATS_MOMENTS,
+                                           });
+    if (status != NANO_OK) {
+        LOG("BENCH: Failed to create stats\n");
+        bench_state = BENCH_DONE;
+    }
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+
+    run_bench();
+
+    igBegin("Nano Stats Benchmark", NULL, 0);
+    igText("%d values, %d reductions per batch", NUM_VALUES,
+           BATCH_DISPATCHES + 1);
+    for (int i = 0; i < 2; i++) {
+        bench_result_t *result = &results[i];
+        igSeparatorText(nano_kernel_variant_name(result->variant));
+        if (!result->supported) {
+            igText("Not supported by this device");
+        } else if (i > current ||
+                   (i == current && bench_state != BENCH_DONE)) {
+            igText("Running...");
+        } else {
+            igBulletText("%.3f ms per reduction", result->best_ms);
+            igBulletText("Mean: %f  Variance: %f", result->result.mean,
+                         result->result.variance);
+        }
+    }
+    if (bench_state == BENCH_DONE && results[1].supported) {
+        igSeparator();
+        igText("Subgroup speedup: %.2fx",
+               results[0].best_ms / results[1].best_ms);
+    }
+    igEnd();
+
+    // Change Nano app state at end of frame
+    nano_end_frame();
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) {
+    nano_release_stats(&stats);
+    wgpuBufferRelease(values);
+    nano_default_cleanup();
+}
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Stats Benchmark",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+    });
+
+    return 0;
+}
@@ -1,10 +1,13 @@
 // Toggles stdout logging and enables the nano debug imgui overlay
-#include <pthread.h>
 #include <time.h>
 #include <unistd.h>
 #define NANO_DEBUG
 #define NANO_CIMGUI
 
+// Number of worker threads created once by Nano's job system
+// Must fit in the -sPTHREAD_POOL_SIZE set in CMakeLists.txt
+#define NANO_NUM_WORKERS 4
+
 #define NANO_NUM_FONTS 3
 
 // Include fonts as header files
@@ -21,145 +24,96 @@ typedef struct {
 
 #define NUM_DATA 65536
 #define MAX_ITERATIONS 100000
-#define NUM_CPU_THREADS 4
+#define NUM_CPU_THREADS NANO_NUM_WORKERS
 char SHADER_PATH[] = "/wgpu-shaders/%s";
 
 // CPU Testing
 // ------------------------------------------------------
 
-// CPU test thread and completion flag
-pthread_t cpu_test_thread;
-bool cpu_test_complete = false;
-
-typedef struct {
-    Data *in;
-    Data *out;
-    int start;
-    int end;
-    int iterations;
-} cpu_thread_data_t;
-
-// Perform the equivalent shader operation on the CPU
-// This method is passed off to another thread to run on.
-void *cpu_test_simple(void *data) {
+// The CPU test runs as a job so the frame loop keeps running, the counter
+// tells us when it is done
+nano_job_counter_t cpu_test_counter;
+bool cpu_test_verified = false;
 
-    Data in[NUM_DATA];
-    Data out[NUM_DATA];
-
-    bool *complete = (bool *)data;
-
-    for (int i = 0; i < NUM_DATA; ++i) {
-        in[i].value = i * 0.1f;
-    }
+// Input and output data for the CPU test
+// These are too large for the stack of a worker thread
+Data cpu_in[NUM_DATA];
+Data cpu_out[NUM_DATA];
 
-    // Start the timer
-    clock_t test_start = clock();
+// Perform the equivalent shader operation on the CPU for a range of the data
+void cpu_test_chunk(void *data, uint32_t begin, uint32_t end) {
+    (void)data;
 
-    // Run the equivalent shader on the CPU
     for (int i = 0; i < MAX_ITERATIONS; ++i) {
-        for (int j = 0; j < NUM_DATA; ++j) {
-            out[j].value = in[j].value + 1.0f;
+        for (uint32_t j = begin; j < end; ++j) {
+            cpu_out[j].value = cpu_in[j].value + 1.0f;
         }
 
         // Copy the output data back to the input data
-        memcpy(in, out, sizeof(Data) * NUM_DATA);
+        memcpy(&cpu_in[begin], &cpu_out[begin], sizeof(Data) * (end - begin));
     }
+}
 
-    // End the timer
-    clock_t test_end = clock();
+// Reset the CPU test input data
+void cpu_test_reset(void) {
+    for (int i = 0; i < NUM_DATA; ++i) {
+        cpu_in[i].value = i * 0.1f;
+    }
+}
+
+// Run the single threaded and multithreaded CPU tests one after another.
+// This is submitted as a job, the multithreaded test then splits the data
+// across the same workers with nano_parallel_for().
+void cpu_test(void *data, uint32_t begin, uint32_t end) {
+    (void)data;
+    (void)begin;
+    (void)end;
 
-    // Calculate the time it took to run the shader
-    double time = (double)(test_end - test_start) / CLOCKS_PER_SEC;
+    // Single threaded
+    cpu_test_reset();
+    double test_start = wgpu_now();
+    cpu_test_chunk(NULL, 0, NUM_DATA);
+    double time = (wgpu_now() - test_start) / 1000.0;
 
     LOG("CPU TEST: Running single thread on CPU\n");
     LOG("\tCPU TEST: %f seconds\n", time);
     LOG("\tCPU TEST: Iterations %d\n", MAX_ITERATIONS);
     LOG("\tCPU TEST: CPU Time per iteration %f\n", time / MAX_ITERATIONS);
     LOG("\tCPU TEST: Last Output data[%d] = %f\n", NUM_DATA - 1,
-        out[NUM_DATA - 1].value);
+        cpu_out[NUM_DATA - 1].value);
     LOG("CPU TEST: Finished running equivalent shader on CPU\n");
 
-    *complete = true;
-
-    return NULL;
-}
-
-// Chunk of the CPU test that will be run on a separate thread
-void *_cpu_test_threaded(void *data) {
-
-    cpu_thread_data_t *thread_data = (cpu_thread_data_t *)data;
-    int start = thread_data->start;
-    int end = thread_data->end;
-
-    for (int i = 0; i < thread_data->iterations; ++i) {
-        for (int j = start; j < end; ++j) {
-            thread_data->out[j].value = thread_data->in[j].value + 1.0f;
-        }
-
-        // Copy the output data back to the input data
-        memcpy(&thread_data->in[start], &thread_data->out[start],
-               sizeof(Data) * (thread_data->end - thread_data->start));
-    }
-
-    return NULL;
-}
-
-// Multithreaded array processing on the CPU
-void *cpu_test_threaded(void *data) {
-
-    Data in[NUM_DATA];
-    Data out[NUM_DATA];
-
-    pthread_t threads[NUM_CPU_THREADS];
-    cpu_thread_data_t thread_data[NUM_CPU_THREADS];
-
-    bool *complete = (bool *)data;
+    // Multithreaded, one chunk of the data per worker
+    cpu_test_reset();
+    test_start = wgpu_now();
+    nano_parallel_for(NUM_DATA, NUM_DATA / NUM_CPU_THREADS, cpu_test_chunk,
+                      NULL);
+    time = (wgpu_now() - test_start) / 1000.0;
 
-    for (int i = 0; i < NUM_DATA; ++i) {
-        in[i].value = i * 0.1f;
-    }
-
-    // Get the chunk size for each thread
-    int chunk_size = NUM_DATA / NUM_CPU_THREADS;
-
-    // Start the timer
-    clock_t test_start = clock();
-
-    // Dispatch the threads on the CPU as chunks
-    // of the input data
-    for (int i = 0; i < NUM_CPU_THREADS; ++i) {
-        thread_data[i].in = (Data *)&in;
-        thread_data[i].out = (Data *)&out;
-        thread_data[i].start = i * chunk_size;
-        thread_data[i].end = (i + 1) * chunk_size;
-        thread_data[i].iterations = MAX_ITERATIONS;
-
-        if (pthread_create(&threads[i], NULL, _cpu_test_threaded,
-                           (void *)&thread_data[i]) != 0) {
-            LOG("Failed to create thread\n");
-        }
-    }
-
-    // Join threads
-    for (int i = 0; i < NUM_CPU_THREADS; ++i) {
-        if (pthread_join(threads[i], NULL) != 0) {
-            LOG("Failed to join thread %d\n", i);
-        }
-    }
-
-    clock_t test_end = clock();
-
-    double time = (double)(test_end - test_start) / CLOCKS_PER_SEC;
-
-    LOG("CPU TEST: Running multithreaded kernel on CPU\n");
+    LOG("CPU TEST: Running multithreaded kernel on CPU (%d workers)\n",
+        nano_jobs_worker_count());
     LOG("\tCPU TEST: %f seconds\n", time);
     LOG("\tCPU TEST: Iterations %d\n", MAX_ITERATIONS);
     LOG("\tCPU TEST: CPU Time per iteration %f\n", time / MAX_ITERATIONS);
     LOG("\tCPU TEST: Last Output data[%d] = %f\n", NUM_DATA - 1,
-        out[NUM_DATA - 1].value);
+        cpu_out[NUM_DATA - 1].value);
     LOG("CPU TEST: Finished running equivalent shader on CPU\n");
+}
 
-    return NULL;
+// Number of GPU results that do not match the CPU results
+atomic_int mismatches;
+
+// Compare a range of the GPU results against the CPU results
+void verify_chunk(void *data, uint32_t begin, uint32_t end) {
+    Data *gpu_out = (Data *)data;
+    int count = 0;
+    for (uint32_t i = begin; i < end; ++i) {
+        float diff = gpu_out[i].value - cpu_out[i].value;
+        if (diff > 0.01f || diff < -0.01f) {
+            count++;
+        }
+    }
+    atomic_fetch_add(&mismatches, count);
 }
 
 // ------------------------------------------------------
@@ -182,12 +136,11 @@ Data input_data[NUM_DATA];
 
 // Data that will be copied to from the nano_gpu_data_t struct
 Data output_data[NUM_DATA];
+bool gpu_test_complete = false;
 
 // Initialization callback passed to wgpu_start()
 static void init(void) {
 
-    char shader_path[256];
-
     // Initialize the nano project
     nano_default_init();
 
@@ -207,33 +160,29 @@ static void init(void) {
     // Set the buffer size for the compute shader
     buffer_size = NUM_DATA * sizeof(Data);
 
-    // COMPUTE SHADER CREATION
-    char compute_shader_name[] = "compute-wgpu.wgsl";
-    snprintf(shader_path, sizeof(shader_path), SHADER_PATH,
-             compute_shader_name);
-
-    // Generate the shader from the shader path
+    // COMPUTE SHADER AND FRAGMENT/VERTEX SHADER CREATION
+    // The shader files are read in parallel on the job system
     // TODO: Implement shader hot-reloading via drag drop into cimgui window
     // if possible on the platform.
-    uint32_t compute_shader_id =
-        nano_create_shader_from_file(shader_path, (char *)compute_shader_name);
-    if (compute_shader_id == NANO_FAIL) {
-        LOG("DEMO: Failed to create shader\n");
-        return;
+    const char *shader_names[2] = {"compute-wgpu.wgsl", "uv-triangle.wgsl"};
+    char shader_paths[2][256];
+    const char *paths[2];
+    for (int i = 0; i < 2; ++i) {
+        snprintf(shader_paths[i], sizeof(shader_paths[i]), SHADER_PATH,
+                 shader_names[i]);
+        paths[i] = shader_paths[i];
     }
 
-    // Fragment and Vertex shader creation
-    char triangle_shader_name[] = "uv-triangle.wgsl";
-    snprintf(shader_path, sizeof(shader_path), SHADER_PATH,
-             triangle_shader_name);
-
-    uint32_t triangle_shader_id =
-        nano_create_shader_from_file(shader_path, (char *)triangle_shader_name);
-    if (triangle_shader_id == NANO_FAIL) {
+    uint32_t shader_ids[2];
+    if (nano_create_shaders_from_files(paths, shader_names, shader_ids, 2) !=
+        2) {
         LOG("DEMO: Failed to create shader\n");
         return;
     }
 
+    uint32_t compute_shader_id = shader_ids[0];
+    uint32_t triangle_shader_id = shader_ids[1];
+
     // Get the shader from the shader pool
     compute_shader = nano_get_shader(compute_shader_id);
     triangle_shader = nano_get_shader(triangle_shader_id);
@@ -290,6 +239,9 @@ static void init(void) {
         .size = sizeof(input_data),
         .src = output_buffer->buffer,
     };
+
+    // Start the CPU tests on the job system
+    nano_jobs_submit(cpu_test, NULL, 0, 1, 1, &cpu_test_counter);
 }
 
 
@@ -355,6 +307,9 @@ static void frame(void) {
             output_data[NUM_DATA - 1].value);
 
         LOG("GPU TEST: Finished running shader on GPU\n");
+        LOG("\tGPU TEST: Checksum %08x\n",
+            nano_checksum(output_data, buffer_size));
+        gpu_test_complete = true;
 
         // Release the status lock on the GPU copy so that it will not
         // execute again. If you do not release the lock, the copy
@@ -362,26 +317,20 @@ static void frame(void) {
         nano_release_gpu_copy(&gpu_compute);
     }
 
-    // Check if the CPU test worker is done
-    if (cpu_test_complete) {
-        // Join the single threaded CPU test
-        if (pthread_join(cpu_test_thread, NULL) != 0) {
-            LOG("Failed to join thread\n");
-        }
-        cpu_test_complete = false;
+    // Once both tests are done, check the GPU results against the CPU
+    // results on the job system
+    if (gpu_test_complete && !cpu_test_verified &&
+        nano_jobs_done(&cpu_test_counter)) {
+        cpu_test_verified = true;
 
-        // Initialize the CPU test threads
-        // Perform multithreaded CPU test once the single threaded test is done
-        if (pthread_create(&cpu_test_thread, NULL, cpu_test_threaded,
-                           (void *)&cpu_test_complete) != 0) {
-            LOG("Failed to create thread\n");
-        }
-        
-        // Join the threaded CPU test
-        if (pthread_join(cpu_test_thread, NULL) != 0) {
-            LOG("Failed to join thread\n");
-        }
-        cpu_test_complete = false;
+        atomic_store(&mismatches, 0);
+        nano_parallel_for(NUM_DATA, 4096, verify_chunk, output_data);
+
+        LOG("VERIFY: CPU checksum %08x, GPU checksum %08x\n",
+            nano_checksum(cpu_out, buffer_size),
+            nano_checksum(output_data, buffer_size));
+        LOG("VERIFY: %d of %d values differ between the CPU and GPU\n",
+            atomic_load(&mismatches), NUM_DATA);
     }
 }
 
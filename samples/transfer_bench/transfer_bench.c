@@ -0,0 +1,342 @@
+// Toggles stdout logging and enables the nano debug imgui overlay
+#define NANO_DEBUG
+#define NANO_CIMGUI
+
+// Keep the staging buffers of the largest transfers in the pool too
+#define NANO_STAGING_POOL_BYTES (768u * 1024 * 1024)
+
+#include "nano.h"
+
+// Include the cimgui header file so we can use imgui with nano
+#include "cimgui/cimgui.h"
+
+// Benchmark of the upload and readback strategies
+// ------------------------------------------------------
+//
+// Sweeps transfer sizes from 256 B to 256 MB with every upload and readback
+// strategy and reports the bandwidth and latency percentiles of each.
+//
+// One transfer is in flight at a time. Uploads are timed from the call to
+// nano_upload_buffer() until the queue reports the copy done, readbacks
+// until the data has been copied out of the staging buffer. Nano records
+// the same timings itself, so once the sweep is done nano_write_buffer()
+// and nano_copy_buffer_to_cpu() use the fastest strategy of each size class.
+
+#define MIN_SHIFT 8
+#define MAX_SHIFT 28
+#define SHIFT_STEP 2
+#define NUM_SIZES ((MAX_SHIFT - MIN_SHIFT) / SHIFT_STEP + 1)
+#define MAX_SIZE ((size_t)1 << MAX_SHIFT)
+
+// Untimed transfers before each size and strategy, the first ones create
+// the staging buffers
+#define WARMUP_ITERATIONS 2
+#define ITERATIONS 16
+// Transfers of this size and larger take long enough to need fewer runs
+#define LARGE_SIZE ((size_t)64 << 20)
+#define LARGE_ITERATIONS 4
+
+typedef struct {
+    nano_transfer_strategy_t strategy;
+    nano_transfer_dir_t dir;
+} bench_strategy_t;
+
+static const bench_strategy_t strategies[] = {
+    {NANO_TRANSFER_QUEUE_WRITE, NANO_TRANSFER_UPLOAD},
+    {NANO_TRANSFER_MAPPED_AT_CREATION, NANO_TRANSFER_UPLOAD},
+    {NANO_TRANSFER_STAGING_RING, NANO_TRANSFER_UPLOAD},
+    {NANO_TRANSFER_READ_PER_CALL, NANO_TRANSFER_READBACK},
+    {NANO_TRANSFER_READ_POOLED, NANO_TRANSFER_READBACK},
+};
+#define NUM_STRATEGIES (int)(sizeof(strategies) / sizeof(strategies[0]))
+
+// Timings of one strategy at one size
+typedef struct {
+    double ms[ITERATIONS];
+    int count;
+    bool done;
+    double gbps;
+    double p50;
+    double p95;
+    double p99;
+} bench_result_t;
+
+bench_result_t results[NUM_SIZES][NUM_STRATEGIES];
+
+WGPUBuffer device_buffer;
+uint8_t *host_data;
+nano_gpu_data_t readback;
+
+bool bench_done = false;
+int size_index = 0;
+int strategy_index = 0;
+int iteration = 0;
+bool in_flight = false;
+double transfer_start;
+double upload_done;
+
+static size_t bench_size(int index) {
+    return (size_t)1 << (MIN_SHIFT + index * SHIFT_STEP);
+}
+
+static int bench_iterations(int index) {
+    return bench_size(index) >= LARGE_SIZE ? LARGE_ITERATIONS : ITERATIONS;
+}
+
+// Print a size as B, KB or MB
+static void format_size(size_t size, char *out, size_t out_size) {
+    if (size >= (1 << 20)) {
+        snprintf(out, out_size, "%zu MB", size >> 20);
+    } else if (size >= (1 << 10)) {
+        snprintf(out, out_size, "%zu KB", size >> 10);
+    } else {
+        snprintf(out, out_size, "%zu B", size);
+    }
+}
+
+static int compare_ms(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile of sorted timings
+static double percentile(const double *sorted, int count, int percent) {
+    int rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void finish_result(bench_result_t *result, size_t size) {
+    double sorted[ITERATIONS];
+    memcpy(sorted, result->ms, result->count * sizeof(double));
+    qsort(sorted, result->count, sizeof(double), compare_ms);
+
+    result->p50 = percentile(sorted, result->count, 50);
+    result->p95 = percentile(sorted, result->count, 95);
+    result->p99 = percentile(sorted, result->count, 99);
+    result->gbps = (double)size / (result->p50 * 1e6);
+    result->done = true;
+}
+
+static void upload_done_cb(WGPUQueueWorkDoneStatus status, void *userdata) {
+    (void)status;
+    (void)userdata;
+    upload_done = wgpu_now();
+}
+
+// Start one transfer of the current size with the current strategy
+static void start_transfer(void) {
+    const bench_strategy_t *strategy = &strategies[strategy_index];
+    size_t size = bench_size(size_index);
+
+    in_flight = true;
+    transfer_start = wgpu_now();
+
+    if (strategy->dir == NANO_TRANSFER_UPLOAD) {
+        upload_done = 0.0;
+        nano_upload_buffer(device_buffer, 0, host_data, size,
+                           strategy->strategy);
+        wgpuQueueOnSubmittedWorkDone(wgpuDeviceGetQueue(nano_app.wgpu->device),
+                                     upload_done_cb, NULL);
+        return;
+    }
+
+    readback.size = size;
+    readback.src = device_buffer;
+    readback.strategy = strategy->strategy;
+    if (nano_copy_buffer_to_cpu(&readback, NULL) != NANO_OK) {
+        LOG("BENCH: Readback of %zu bytes failed\n", size);
+        in_flight = false;
+    }
+}
+
+// Time of the transfer in flight, or a negative value if it isn't done
+static double poll_transfer(void) {
+    if (strategies[strategy_index].dir == NANO_TRANSFER_UPLOAD) {
+        return upload_done > 0.0 ? upload_done - transfer_start : -1.0;
+    }
+
+    if (!readback.locked) {
+        return -1.0;
+    }
+
+    double ms = readback.latency_ms;
+    nano_release_gpu_copy(&readback);
+    return ms;
+}
+
+static void log_choices(void) {
+    LOG("BENCH: Strategies picked by Nano\n");
+    for (int i = 0; i < NUM_SIZES; i++) {
+        char label[32];
+        format_size(bench_size(i), label, sizeof(label));
+        LOG("BENCH: %8s  upload: %-20s readback: %s\n", label,
+            nano_transfer_strategy_name(
+                nano_transfer_strategy(NANO_TRANSFER_UPLOAD, bench_size(i))),
+            nano_transfer_strategy_name(nano_transfer_strategy(
+                NANO_TRANSFER_READBACK, bench_size(i))));
+    }
+}
+
+// Move on to the next strategy, then to the next size
+static void next_result(void) {
+    bench_result_t *result = &results[size_index][strategy_index];
+    const bench_strategy_t *strategy = &strategies[strategy_index];
+    size_t size = bench_size(size_index);
+    finish_result(result, size);
+
+    char label[32];
+    format_size(size, label, sizeof(label));
+    LOG("BENCH: %8s %-20s %8.2f GB/s  p50 %8.3f ms  p95 %8.3f ms  p99 "
+        "%8.3f ms\n",
+        label, nano_transfer_strategy_name(strategy->strategy), result->gbps,
+        result->p50, result->p95, result->p99);
+
+    iteration = 0;
+    if (++strategy_index < NUM_STRATEGIES) {
+        return;
+    }
+
+    strategy_index = 0;
+    if (++size_index < NUM_SIZES) {
+        return;
+    }
+
+    bench_done = true;
+    log_choices();
+}
+
+// Advance the benchmark, called once per frame
+static void run_bench(void) {
+    if (bench_done) {
+        return;
+    }
+
+    if (!in_flight) {
+        start_transfer();
+        return;
+    }
+
+    double ms = poll_transfer();
+    if (ms < 0.0) {
+        return;
+    }
+    in_flight = false;
+
+    if (iteration++ < WARMUP_ITERATIONS) {
+        return;
+    }
+
+    bench_result_t *result = &results[size_index][strategy_index];
+    result->ms[result->count++] = ms;
+    if (result->count == bench_iterations(size_index)) {
+        next_result();
+    }
+}
+
+// Nano Application
+// ------------------------------------------------------
+
+// Initialization callback passed to nano_start_app()
+static void init(void) {
+
+    // Initialize the nano project
+    nano_default_init();
+
+    device_buffer = wgpuDeviceCreateBuffer(
+        nano_app.wgpu->device,
+        &(WGPUBufferDescriptor){
+            .label = "Transfer Bench Buffer",
+            .usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_CopySrc,
+            .size = MAX_SIZE,
+        });
+
+    host_data = (uint8_t *)malloc(MAX_SIZE);
+    if (device_buffer == NULL || host_data == NULL) {
+        LOG("BENCH: Could not allocate %zu bytes\n", MAX_SIZE);
+        bench_done = true;
+        return;
+    }
+
+    for (size_t i = 0; i < MAX_SIZE; i++) {
+        host_data[i] = (uint8_t)(i * 31u);
+    }
+}
+
+// Frame callback passed to nano_start_app()
+static void frame(void) {
+
+    WGPUCommandEncoder cmd_encoder = nano_start_frame();
+
+    run_bench();
+
+    igBegin("Nano Transfer Benchmark", NULL, 0);
+    if (bench_done) {
+        igText("Done, GB/s at the median latency");
+    } else {
+        char label[32];
+        format_size(bench_size(size_index), label, sizeof(label));
+        igText("Running %s with %s...", label,
+               nano_transfer_strategy_name(
+                   strategies[strategy_index].strategy));
+    }
+
+    if (igBeginTable("Results", NUM_STRATEGIES + 1,
+                     ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg,
+                     (ImVec2){0.0f, 0.0f}, 0.0f)) {
+        igTableSetupColumn("Size", 0, 0.0f, 0);
+        for (int i = 0; i < NUM_STRATEGIES; i++) {
+            igTableSetupColumn(
+                nano_transfer_strategy_name(strategies[i].strategy), 0, 0.0f,
+                0);
+        }
+        igTableHeadersRow();
+
+        for (int i = 0; i < NUM_SIZES; i++) {
+            char label[32];
+            format_size(bench_size(i), label, sizeof(label));
+            igTableNextRow(0, 0.0f);
+            igTableNextColumn();
+            igText("%s", label);
+
+            for (int j = 0; j < NUM_STRATEGIES; j++) {
+                bench_result_t *result = &results[i][j];
+                igTableNextColumn();
+                if (result->done) {
+                    igText("%.2f GB/s", result->gbps);
+                    igText("p99 %.3f ms", result->p99);
+                } else {
+                    igText("-");
+                }
+            }
+        }
+        igEndTable();
+    }
+    igEnd();
+
+    // Change Nano app state at end of frame
+    nano_end_frame();
+}
+
+// Shutdown callback passed to nano_start_app()
+static void shutdown(void) {
+    wgpuBufferRelease(device_buffer);
+    free(host_data);
+    nano_default_cleanup();
+}
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Transfer Benchmark",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+    });
+
+    return 0;
+}
@@ -47,20 +47,6 @@ Vertex vertex_data[] = {
     {{-0.5f, -0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
 };
 
-// Create the vertex buffer layout
-WGPUVertexAttribute attributes[2] = {
-    {
-        .format = WGPUVertexFormat_Float32x3,
-        .offset = offsetof(Vertex, position),
-        .shaderLocation = 0,
-    },
-    {
-        .format = WGPUVertexFormat_Float32x3,
-        .offset = offsetof(Vertex, color),
-        .shaderLocation = 1,
-    },
-};
-
 // Nano shader structs for the compute and triangle shaders examples
 nano_shader_t *triangle_shader;
 char shader_path[256];
@@ -107,9 +93,22 @@ static void init(void) {
     }
 
     // Bind the vertex buffer to the shader
-    int status = nano_shader_bind_vertex_buffer(
-        triangle_shader, vertex_buffer_id, (WGPUVertexAttribute *)&attributes,
-        2, sizeof(Vertex));
+    // Nano builds the vertex attributes from the inputs of vs_main. The
+    // Vertex struct is interleaved by us, so we give the offsets, and its
+    // color only has three floats while the shader reads a vec4.
+    const char *inputs[] = {"position", "color"};
+    uint32_t offsets[] = {offsetof(Vertex, position), offsetof(Vertex, color)};
+    WGPUVertexFormat formats[] = {WGPUVertexFormat_Undefined,
+                                  WGPUVertexFormat_Float32x3};
+    int status = nano_shader_bind_vertex_layout(
+        triangle_shader, vertex_buffer_id,
+        &(nano_vertex_layout_desc_t){
+            .inputs = inputs,
+            .input_count = 2,
+            .formats = formats,
+            .offsets = offsets,
+            .stride = sizeof(Vertex),
+        });
     if (status != NANO_OK) {
         LOG("DEMO: Failed to bind vertex buffer\n");
         return;
@@ -22,6 +22,10 @@
 // Include the cimgui header file so we can use imgui with nano
 #include "cimgui/cimgui.h"
 
+// C layout of the Uniforms struct in wave.wgsl, generated with
+// tools/nano_structgen.c
+#include "wave_structs.h"
+
 char SHADER_PATH[] = "/wgpu-shaders/%s";
 
 // Nano Application
@@ -32,20 +36,8 @@ nano_shader_t *wave_shader;
 char shader_path[256];
 char shader_code[8192];
 
-// When using the uniform buffer with Nano, if the shader is not working as
-// expected, you should use the @align(n) directive in the shader to align the
-// buffer in multiples of 16 bytes. See assets/shaders/dot.wgsl for an example.
-struct UniformBuffer {
-    float time;          // 4 bytes
-    float padding;       // 4 bytes
-    float resolution[2]; // 8 bytes
-    struct {
-        float freq;     // 4 bytes
-        float amp;      // 4 bytes
-        float speed;    // 4 bytes
-        float thickness; // 4 bytes
-    } wave;
-} uniform_data; // 16 bytes
+// The generated struct matches the WGSL layout, so it is uploaded as is
+Uniforms uniform_data;
 
 // Initialization callback passed to nano_start_app()
 static void init(void) {
@@ -85,10 +77,10 @@ static void init(void) {
     uniform_data.resolution[1] = nano_app.wgpu->height;
 
     // Wave parameters
-    uniform_data.wave.freq = 5.0f;
-    uniform_data.wave.amp = 0.5f;
-    uniform_data.wave.speed = 0.2f;
-    uniform_data.wave.thickness = 0.005f;
+    Uniforms_set_frequency(&uniform_data, 5.0f);
+    Uniforms_set_amplitude(&uniform_data, 0.5f);
+    Uniforms_set_speed(&uniform_data, 0.2f);
+    Uniforms_set_thickness(&uniform_data, 0.005f);
 
     // Set the vertex count for the shader (if we don't set this, it defaults to
     // 3)
@@ -151,16 +143,16 @@ static void frame(void) {
            "buffer to create a wave effect using WebGPU, WGSL, and Nano.");
     igSeparatorText("Wave Settings");
     igSetNextItemWidth(150);
-    igSliderFloat("Wave Frequency", &uniform_data.wave.freq, 0.0f, 10.0f,
+    igSliderFloat("Wave Frequency", &uniform_data.frequency, 0.0f, 10.0f,
                   "%.2f", 1.0f);
     igSetNextItemWidth(150);
-    igSliderFloat("Wave Amplitude", &uniform_data.wave.amp, 0.0f, 5.0f,
+    igSliderFloat("Wave Amplitude", &uniform_data.amplitude, 0.0f, 5.0f,
                     "%.2f", 1.0f);
     igSetNextItemWidth(150);
-    igSliderFloat("Wave Speed", &uniform_data.wave.speed, 0.0f, 1.0f,
+    igSliderFloat("Wave Speed", &uniform_data.speed, 0.0f, 1.0f,
                     "%.2f", 1.0f);
     igSetNextItemWidth(150);
-    igSliderFloat("Wave Thickness", &uniform_data.wave.thickness, 0.0f, 0.1f,
+    igSliderFloat("Wave Thickness", &uniform_data.thickness, 0.0f, 0.1f,
                     "%.3f", 1.0f);
     igEnd();
 
@@ -0,0 +1,54 @@
+// Generated by nano_structgen from wave.wgsl, do not edit.
+// Layouts follow the WGSL host-shareable layout rules.
+
+#ifndef WAVE_STRUCTS_H
+#define WAVE_STRUCTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// WGSL struct Uniforms: size 32, align 8
+typedef struct Uniforms {
+    float time;
+    uint8_t _pad0[4];
+    float resolution[2];
+    float frequency;
+    float amplitude;
+    float speed;
+    float thickness;
+} Uniforms;
+
+_Static_assert(offsetof(Uniforms, time) == 0, "Uniforms.time offset");
+_Static_assert(offsetof(Uniforms, resolution) == 8, "Uniforms.resolution offset");
+_Static_assert(offsetof(Uniforms, frequency) == 16, "Uniforms.frequency offset");
+_Static_assert(offsetof(Uniforms, amplitude) == 20, "Uniforms.amplitude offset");
+_Static_assert(offsetof(Uniforms, speed) == 24, "Uniforms.speed offset");
+_Static_assert(offsetof(Uniforms, thickness) == 28, "Uniforms.thickness offset");
+_Static_assert(sizeof(Uniforms) == 32, "Uniforms size");
+
+static inline void Uniforms_set_time(Uniforms *s, float value) {
+    s->time = value;
+}
+
+static inline void Uniforms_set_resolution(Uniforms *s, const float value[2]) {
+    memcpy(s->resolution, value, sizeof(s->resolution));
+}
+
+static inline void Uniforms_set_frequency(Uniforms *s, float value) {
+    s->frequency = value;
+}
+
+static inline void Uniforms_set_amplitude(Uniforms *s, float value) {
+    s->amplitude = value;
+}
+
+static inline void Uniforms_set_speed(Uniforms *s, float value) {
+    s->speed = value;
+}
+
+static inline void Uniforms_set_thickness(Uniforms *s, float value) {
+    s->thickness = value;
+}
+
+#endif // WAVE_STRUCTS_H
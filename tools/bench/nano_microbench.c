@@ -0,0 +1,342 @@
+// Microbenchmarks of Nano's CPU overhead
+// ------------------------------------------------------
+//
+// Runs Nano natively on top of the recording mock in nano_mock_wgpu.c, so
+// only the time spent in Nano itself is measured: pool lookups, pipeline
+// layout and bind group builds, shader encoding, the ImGui renderer and
+// whole frames. Every benchmark reports the time per call, the heap
+// allocations and wgpu calls made per call, and the WGPU objects that were
+// created without being released. The run fails if a shader that is
+// created, run and released leaves any WGPU object behind.
+//
+// Run from the root of the repository so the shaders can be found. Pass -v
+// to print the wgpu entry points called by each benchmark.
+
+// The ImGui renderer is part of what is measured
+#define NANO_CIMGUI
+
+#include "nano.h"
+
+#include "nano_mock_wgpu.h"
+
+#define SHADER_DIR "include/assets/shaders/wgpu-shaders/"
+#define NUM_ELEMS 1024
+
+typedef enum {
+    SCENE_EMPTY,
+    SCENE_SHADERS,
+    SCENE_IMGUI,
+    SCENE_DRAW,
+} scene_t;
+
+nano_shader_t *compute_shader;
+nano_shader_t *triangle_shader;
+uint32_t buffer_ids[2];
+float points[10000 * 2];
+
+scene_t scene = SCENE_EMPTY;
+bool verbose = false;
+
+// Benchmark Helpers
+// ------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    uint64_t iterations;
+    double start_ms;
+    int64_t objects_live;
+} bench_t;
+
+static bench_t bench_begin(const char *name, uint64_t iterations) {
+    nano_mock_reset_stats();
+    return (bench_t){
+        .name = name,
+        .iterations = iterations,
+        .start_ms = nano_mock_now(),
+        .objects_live = nano_mock_get_stats().objects_live,
+    };
+}
+
+static void bench_end(bench_t *bench) {
+    double elapsed_ms = nano_mock_now() - bench->start_ms;
+    nano_mock_stats_t stats = nano_mock_get_stats();
+    double n = (double)bench->iterations;
+
+    printf("%-36s %10.1f %10.2f %10.2f %10.2f\n", bench->name,
+           elapsed_ms * 1e6 / n, (double)stats.allocs / n,
+           (double)stats.calls / n,
+           (double)(stats.objects_live - bench->objects_live) / n);
+
+    if (verbose) {
+        nano_mock_print_calls(stdout);
+    }
+}
+
+// Nano Application
+// ------------------------------------------------------
+
+static void init(void) {
+    nano_default_init();
+
+    // The benchmarks measure Nano, not the debug window
+    nano_app.show_debug = false;
+
+    compute_shader = nano_get_shader(nano_create_shader_from_file(
+        SHADER_DIR "compute-wgpu.wgsl", "compute-wgpu.wgsl"));
+    triangle_shader = nano_get_shader(nano_create_shader_from_file(
+        SHADER_DIR "uv-triangle.wgsl", "uv-triangle.wgsl"));
+    if (compute_shader == NULL || triangle_shader == NULL) {
+        LOG_ERR("BENCH: Could not create the shaders, run from the root of "
+                "the repository\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        nano_binding_info_t *binding =
+            nano_shader_get_binding(compute_shader, 0, i);
+        buffer_ids[i] = nano_create_buffer(binding, NUM_ELEMS * sizeof(float),
+                                           NUM_ELEMS, 0, NULL);
+        nano_shader_bind_buffer(compute_shader, nano_get_buffer(buffer_ids[i]),
+                                0, i);
+    }
+    nano_shader_set_num_elems(compute_shader, NUM_ELEMS);
+
+    for (int i = 0; i < 10000; i++) {
+        points[i * 2 + 0] = (float)(i % 100) * 12.0f;
+        points[i * 2 + 1] = (float)(i / 100) * 7.0f;
+    }
+}
+
+static void frame(void) {
+    nano_start_frame();
+
+    switch (scene) {
+    case SCENE_EMPTY:
+        break;
+    case SCENE_SHADERS:
+        nano_execute_shaders();
+        break;
+    case SCENE_IMGUI:
+        igShowDemoWindow(NULL);
+        break;
+    case SCENE_DRAW:
+        nano_draw_points(points, 10000, 2.0f, NANO_RGBA(255, 255, 255, 255));
+        break;
+    }
+
+    nano_end_frame();
+}
+
+static void shutdown(void) {
+    // Called by nano_default_cleanup() and again at exit
+    static bool done = false;
+    if (done) {
+        return;
+    }
+    done = true;
+    nano_default_cleanup();
+}
+
+// Benchmarks
+// ------------------------------------------------------
+
+static void bench_lookups(void) {
+    volatile uintptr_t sink = 0;
+
+    bench_t bench = bench_begin("nano_get_buffer", 10000000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        sink += (uintptr_t)nano_get_buffer(buffer_ids[i & 1]);
+    }
+    bench_end(&bench);
+
+    uint32_t shader_ids[2] = {compute_shader->id, triangle_shader->id};
+    bench = bench_begin("nano_get_shader", 10000000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        sink += (uintptr_t)nano_get_shader(shader_ids[i & 1]);
+    }
+    bench_end(&bench);
+}
+
+static void bench_builds(void) {
+    bench_t bench = bench_begin("nano_build_pipeline_layout", 10000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_build_pipeline_layout(compute_shader);
+    }
+    bench_end(&bench);
+
+    bench = bench_begin("nano_build_bindgroups", 10000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_build_bindgroups(compute_shader);
+    }
+    bench_end(&bench);
+
+    bench = bench_begin("nano_shader_build (compute)", 10000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_build(compute_shader);
+    }
+    bench_end(&bench);
+
+    bench = bench_begin("nano_shader_build (render)", 10000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_build(triangle_shader);
+    }
+    bench_end(&bench);
+}
+
+static void bench_encoding(void) {
+    nano_shader_activate(compute_shader, false);
+    nano_shader_activate(triangle_shader, false);
+
+    // All calls are recorded into one frame's encoder
+    nano_start_frame();
+
+    bench_t bench = bench_begin("nano_shader_execute (compute)", 100000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_execute(compute_shader);
+    }
+    bench_end(&bench);
+
+    bench = bench_begin("nano_shader_execute (render)", 100000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_execute(triangle_shader);
+    }
+    bench_end(&bench);
+
+    bench = bench_begin("nano_execute_shaders (2 active)", 100000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_execute_shaders();
+    }
+    bench_end(&bench);
+
+    // A workload whose size changes every frame, the packet is patched
+    bench = bench_begin("nano_shader_set_num_elems (active)", 100000);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_set_num_elems(compute_shader, NUM_ELEMS - (i & 255));
+        nano_execute_shaders();
+    }
+    bench_end(&bench);
+    nano_shader_set_num_elems(compute_shader, NUM_ELEMS);
+
+    nano_end_frame();
+}
+
+static void bench_frames(void) {
+    static const struct {
+        scene_t scene;
+        const char *name;
+    } scenes[] = {
+        {SCENE_EMPTY, "frame (empty)"},
+        {SCENE_SHADERS, "frame (2 shaders)"},
+        {SCENE_IMGUI, "frame (ImGui demo window)"},
+        {SCENE_DRAW, "frame (10000 points)"},
+    };
+
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); i++) {
+        scene = scenes[i].scene;
+
+        // Let caches, pools and ImGui settle before measuring
+        nano_mock_run_frames(10);
+
+        bench_t bench = bench_begin(scenes[i].name, 1000);
+        nano_mock_run_frames((int)bench.iterations);
+        bench_end(&bench);
+    }
+
+    // The same frames with the debug window open
+    nano_app.show_debug = true;
+    scene = SCENE_SHADERS;
+    nano_mock_run_frames(10);
+
+    bench_t bench = bench_begin("frame (2 shaders, debug UI)", 1000);
+    nano_mock_run_frames((int)bench.iterations);
+    bench_end(&bench);
+
+    nano_app.show_debug = false;
+
+    // An empty frame with ImGui only started on request, nothing requests it
+    nano_app.wgpu->desc.ui_on_demand = true;
+    scene = SCENE_EMPTY;
+    nano_mock_run_frames(10);
+
+    bench = bench_begin("frame (empty, ui_on_demand)", 1000);
+    nano_mock_run_frames((int)bench.iterations);
+    bench_end(&bench);
+
+    nano_app.wgpu->desc.ui_on_demand = false;
+}
+
+// Create, run and release a shader with its own buffer. Every WGPU object
+// the cycle creates must be released again, so nothing may leak.
+static int bench_lifetimes(void) {
+    scene = SCENE_SHADERS;
+
+    bench_t bench = bench_begin("shader create/run/release", 100);
+    for (uint64_t i = 0; i < bench.iterations; i++) {
+        nano_shader_t *shader = nano_get_shader(nano_create_shader_from_file(
+            SHADER_DIR "collatz.wgsl", "collatz.wgsl"));
+        if (shader == NULL) {
+            LOG_ERR("BENCH: Could not create the collatz shader\n");
+            return NANO_FAIL;
+        }
+
+        nano_binding_info_t *binding = nano_shader_get_binding(shader, 0, 0);
+        uint32_t buffer_id = nano_create_buffer(
+            binding, NUM_ELEMS * sizeof(uint32_t), NUM_ELEMS, 0, NULL);
+        nano_shader_bind_buffer(shader, nano_get_buffer(buffer_id), 0, 0);
+        nano_shader_set_num_elems(shader, NUM_ELEMS);
+        nano_shader_activate(shader, true);
+
+        // Lets the asynchronous pipeline arrive and the shader run once
+        nano_mock_run_frames(2);
+
+        nano_release_shader(shader->id);
+        nano_release_buffer(buffer_id);
+    }
+    bench_end(&bench);
+
+    scene = SCENE_EMPTY;
+
+    int64_t leaked = nano_mock_get_stats().objects_live - bench.objects_live;
+    if (leaked != 0) {
+        LOG_ERR("BENCH: %lld WGPU objects leaked by the shader lifetime\n",
+                (long long)leaked);
+        return NANO_FAIL;
+    }
+    return NANO_OK;
+}
+
+// Program Entry Point
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        }
+    }
+
+    // Runs init() before returning, the mock delivers the adapter and device
+    // right away
+    nano_start_app(&(nano_app_desc_t){
+        .title = "Nano Microbenchmarks",
+        .res_x = 1280,
+        .res_y = 720,
+        .init_cb = init,
+        .frame_cb = frame,
+        .shutdown_cb = shutdown,
+        .sample_count = 4,
+    });
+
+    printf("%-36s %10s %10s %10s %10s\n", "benchmark", "ns/call",
+           "allocs", "wgpu calls", "leaked");
+
+    bench_lookups();
+    bench_builds();
+    bench_encoding();
+    bench_frames();
+
+    // The only check that fails the run, the benchmarks just report
+    if (bench_lifetimes() != NANO_OK) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,994 @@
+// Recording stand-in for WebGPU and the Emscripten runtime, see
+// nano_mock_wgpu.h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <webgpu/webgpu.h>
+
+#include "nano_mock_wgpu.h"
+
+// Heap Allocation Counting
+// ----------------------------------------------------------------------------
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static atomic_uint_fast64_t _mock_allocs;
+static atomic_uint_fast64_t _mock_frees;
+static atomic_uint_fast64_t _mock_alloc_bytes;
+
+void *__wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&_mock_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_mock_alloc_bytes, size, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&_mock_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_mock_alloc_bytes, count * size,
+                              memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&_mock_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&_mock_alloc_bytes, size, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr != NULL) {
+        atomic_fetch_add_explicit(&_mock_frees, 1, memory_order_relaxed);
+    }
+    __real_free(ptr);
+}
+
+// Mock State
+// ----------------------------------------------------------------------------
+
+#define MOCK_MAX_ENTRY_POINTS 128
+#define MOCK_MAX_PENDING 256
+
+// Every handle points at one of these
+typedef struct mock_object_t {
+    const char *type;
+    uint64_t size;
+    // Contents of a mapped buffer, allocated on the first map
+    void *mapped;
+    // The view returned by a swapchain every frame
+    struct mock_object_t *view;
+} mock_object_t;
+
+typedef struct {
+    const char *name;
+    uint64_t count;
+} mock_entry_point_t;
+
+// A callback that the browser would deliver after the current task
+typedef struct {
+    WGPUBufferMapCallback map_cb;
+    WGPUQueueWorkDoneCallback done_cb;
+    WGPUCreateComputePipelineAsyncCallback compute_cb;
+    WGPUCreateRenderPipelineAsyncCallback render_cb;
+    // Pipeline delivered by compute_cb or render_cb
+    void *object;
+    void *userdata;
+} mock_pending_t;
+
+static struct {
+    nano_mock_stats_t stats;
+
+    mock_entry_point_t entry_points[MOCK_MAX_ENTRY_POINTS];
+    int entry_point_count;
+
+    mock_pending_t pending[MOCK_MAX_PENDING];
+    int pending_count;
+
+    int canvas_width;
+    int canvas_height;
+    bool shader_f16;
+    bool subgroups;
+
+    mock_object_t queue;
+
+    bool (*frame_cb)(double time, void *userdata);
+    void *frame_userdata;
+} mock = {
+    .canvas_width = 1280,
+    .canvas_height = 720,
+    .queue = {.type = "WGPUQueue"},
+};
+
+// Count a call to the function it is used in. The slot of each entry point
+// is looked up once.
+#define MOCK_CALL()                                                            \
+    static int _mock_slot = -1;                                                \
+    _mock_record(&_mock_slot, __func__)
+
+static void _mock_record(int *slot, const char *name) {
+    if (*slot < 0) {
+        if (mock.entry_point_count == MOCK_MAX_ENTRY_POINTS) {
+            mock.stats.calls++;
+            return;
+        }
+        *slot = mock.entry_point_count++;
+        mock.entry_points[*slot].name = name;
+    }
+    mock.entry_points[*slot].count++;
+    mock.stats.calls++;
+}
+
+static mock_object_t *_mock_create(const char *type) {
+    mock_object_t *object =
+        (mock_object_t *)__real_calloc(1, sizeof(mock_object_t));
+    if (object == NULL) {
+        fprintf(stderr, "MOCK: Out of memory creating a %s\n", type);
+        abort();
+    }
+    object->type = type;
+    mock.stats.objects_created++;
+    mock.stats.objects_live++;
+    return object;
+}
+
+static void _mock_release(void *handle) {
+    mock_object_t *object = (mock_object_t *)handle;
+    if (object == NULL) {
+        return;
+    }
+    if (object->view != NULL) {
+        _mock_release(object->view);
+    }
+    __real_free(object->mapped);
+    __real_free(object);
+    mock.stats.objects_live--;
+}
+
+static void _mock_defer(mock_pending_t pending) {
+    if (mock.pending_count == MOCK_MAX_PENDING) {
+        nano_mock_flush_callbacks();
+    }
+    mock.pending[mock.pending_count++] = pending;
+}
+
+// Mock API
+// ----------------------------------------------------------------------------
+
+void nano_mock_reset_stats(void) {
+    int64_t live = mock.stats.objects_live;
+    memset(&mock.stats, 0, sizeof(mock.stats));
+    mock.stats.objects_live = live;
+
+    for (int i = 0; i < mock.entry_point_count; i++) {
+        mock.entry_points[i].count = 0;
+    }
+
+    atomic_store(&_mock_allocs, 0);
+    atomic_store(&_mock_frees, 0);
+    atomic_store(&_mock_alloc_bytes, 0);
+}
+
+nano_mock_stats_t nano_mock_get_stats(void) {
+    nano_mock_stats_t stats = mock.stats;
+    stats.allocs = atomic_load(&_mock_allocs);
+    stats.frees = atomic_load(&_mock_frees);
+    stats.alloc_bytes = atomic_load(&_mock_alloc_bytes);
+    return stats;
+}
+
+uint64_t nano_mock_calls(const char *entry_point) {
+    for (int i = 0; i < mock.entry_point_count; i++) {
+        if (strcmp(mock.entry_points[i].name, entry_point) == 0) {
+            return mock.entry_points[i].count;
+        }
+    }
+    return 0;
+}
+
+void nano_mock_print_calls(FILE *out) {
+    for (int i = 0; i < mock.entry_point_count; i++) {
+        if (mock.entry_points[i].count != 0) {
+            fprintf(out, "  %-44s %llu\n", mock.entry_points[i].name,
+                    (unsigned long long)mock.entry_points[i].count);
+        }
+    }
+}
+
+void nano_mock_set_canvas_size(int width, int height) {
+    mock.canvas_width = width;
+    mock.canvas_height = height;
+}
+
+void nano_mock_set_features(bool shader_f16, bool subgroups) {
+    mock.shader_f16 = shader_f16;
+    mock.subgroups = subgroups;
+}
+
+void nano_mock_flush_callbacks(void) {
+    // Callbacks may queue more work, only deliver what is pending now
+    int count = mock.pending_count;
+    mock_pending_t pending[MOCK_MAX_PENDING];
+    memcpy(pending, mock.pending, count * sizeof(mock_pending_t));
+    mock.pending_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (pending[i].map_cb != NULL) {
+            pending[i].map_cb(WGPUBufferMapAsyncStatus_Success,
+                              pending[i].userdata);
+        } else if (pending[i].done_cb != NULL) {
+            pending[i].done_cb(WGPUQueueWorkDoneStatus_Success,
+                               pending[i].userdata);
+        } else if (pending[i].compute_cb != NULL) {
+            pending[i].compute_cb(WGPUCreatePipelineAsyncStatus_Success,
+                                  (WGPUComputePipeline)pending[i].object,
+                                  NULL, pending[i].userdata);
+        } else if (pending[i].render_cb != NULL) {
+            pending[i].render_cb(WGPUCreatePipelineAsyncStatus_Success,
+                                 (WGPURenderPipeline)pending[i].object, NULL,
+                                 pending[i].userdata);
+        }
+    }
+}
+
+bool nano_mock_run_frames(int count) {
+    if (mock.frame_cb == NULL) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        nano_mock_flush_callbacks();
+        if (!mock.frame_cb(nano_mock_now(), mock.frame_userdata)) {
+            mock.frame_cb = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+double nano_mock_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// Emscripten Runtime
+// ----------------------------------------------------------------------------
+//
+// These are defined without the Emscripten headers, with types that have
+// the same calling convention. EM_BOOL is bool or int depending on the
+// Emscripten version, bool is read correctly from both.
+
+typedef int mock_em_result_t;
+
+double emscripten_get_now(void) { return nano_mock_now(); }
+
+mock_em_result_t emscripten_get_element_css_size(const char *target,
+                                                 double *width,
+                                                 double *height) {
+    (void)target;
+    *width = (double)mock.canvas_width;
+    *height = (double)mock.canvas_height;
+    return 0;
+}
+
+mock_em_result_t emscripten_get_canvas_element_size(const char *target,
+                                                   int *width, int *height) {
+    (void)target;
+    *width = mock.canvas_width;
+    *height = mock.canvas_height;
+    return 0;
+}
+
+mock_em_result_t emscripten_set_canvas_element_size(const char *target,
+                                                   int width, int height) {
+    (void)target;
+    mock.canvas_width = width;
+    mock.canvas_height = height;
+    return 0;
+}
+
+mock_em_result_t emscripten_request_fullscreen(const char *target,
+                                              bool defer) {
+    (void)target;
+    (void)defer;
+    return 0;
+}
+
+void emscripten_request_animation_frame_loop(bool (*cb)(double, void *),
+                                             void *userdata) {
+    mock.frame_cb = cb;
+    mock.frame_userdata = userdata;
+}
+
+// Input callbacks are accepted and never called. Newer html5.h versions
+// turn the setters into macros over the _on_thread variants, so both are
+// defined.
+#define MOCK_EVENT_SETTER(name)                                                \
+    mock_em_result_t name(const char *target, void *userdata, bool capture,    \
+                          void *callback) {                                    \
+        (void)target, (void)userdata, (void)capture, (void)callback;          \
+        return 0;                                                              \
+    }                                                                          \
+    mock_em_result_t name##_on_thread(const char *target, void *userdata,     \
+                                      bool capture, void *callback,           \
+                                      unsigned long thread) {                  \
+        (void)thread;                                                          \
+        return name(target, userdata, capture, callback);                      \
+    }
+
+MOCK_EVENT_SETTER(emscripten_set_resize_callback)
+MOCK_EVENT_SETTER(emscripten_set_keydown_callback)
+MOCK_EVENT_SETTER(emscripten_set_keyup_callback)
+MOCK_EVENT_SETTER(emscripten_set_keypress_callback)
+MOCK_EVENT_SETTER(emscripten_set_mousedown_callback)
+MOCK_EVENT_SETTER(emscripten_set_mouseup_callback)
+MOCK_EVENT_SETTER(emscripten_set_mousemove_callback)
+MOCK_EVENT_SETTER(emscripten_set_wheel_callback)
+MOCK_EVENT_SETTER(emscripten_set_touchstart_callback)
+MOCK_EVENT_SETTER(emscripten_set_touchend_callback)
+MOCK_EVENT_SETTER(emscripten_set_touchmove_callback)
+
+// Instance, Adapter and Device
+// ----------------------------------------------------------------------------
+
+WGPUInstance wgpuCreateInstance(WGPUInstanceDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)descriptor;
+    return (WGPUInstance)_mock_create("WGPUInstance");
+}
+
+void wgpuInstanceRelease(WGPUInstance instance) {
+    MOCK_CALL();
+    _mock_release(instance);
+}
+
+void wgpuInstanceRequestAdapter(WGPUInstance instance,
+                                WGPURequestAdapterOptions const *options,
+                                WGPURequestAdapterCallback callback,
+                                void *userdata) {
+    MOCK_CALL();
+    (void)instance;
+    (void)options;
+    callback(WGPURequestAdapterStatus_Success,
+             (WGPUAdapter)_mock_create("WGPUAdapter"), NULL, userdata);
+}
+
+WGPUSurface wgpuInstanceCreateSurface(WGPUInstance instance,
+                                      WGPUSurfaceDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)instance;
+    (void)descriptor;
+    return (WGPUSurface)_mock_create("WGPUSurface");
+}
+
+WGPUTextureFormat wgpuSurfaceGetPreferredFormat(WGPUSurface surface,
+                                                WGPUAdapter adapter) {
+    MOCK_CALL();
+    (void)surface;
+    (void)adapter;
+    return WGPUTextureFormat_BGRA8Unorm;
+}
+
+WGPUBool wgpuAdapterHasFeature(WGPUAdapter adapter, WGPUFeatureName feature) {
+    MOCK_CALL();
+    (void)adapter;
+    if (feature == WGPUFeatureName_ShaderF16) {
+        return mock.shader_f16;
+    }
+    if (feature == WGPUFeatureName_Subgroups) {
+        return mock.subgroups;
+    }
+    return feature == WGPUFeatureName_Depth32FloatStencil8;
+}
+
+void wgpuAdapterRequestDevice(WGPUAdapter adapter,
+                              WGPUDeviceDescriptor const *descriptor,
+                              WGPURequestDeviceCallback callback,
+                              void *userdata) {
+    MOCK_CALL();
+    (void)adapter;
+    (void)descriptor;
+    callback(WGPURequestDeviceStatus_Success,
+             (WGPUDevice)_mock_create("WGPUDevice"), NULL, userdata);
+}
+
+void wgpuAdapterRelease(WGPUAdapter adapter) {
+    MOCK_CALL();
+    _mock_release(adapter);
+}
+
+void wgpuDeviceRelease(WGPUDevice device) {
+    MOCK_CALL();
+    _mock_release(device);
+}
+
+WGPUBool wgpuDeviceGetLimits(WGPUDevice device, WGPUSupportedLimits *limits) {
+    MOCK_CALL();
+    (void)device;
+    memset(&limits->limits, 0, sizeof(limits->limits));
+    limits->limits.maxBindGroups = 4;
+    limits->limits.maxStorageBufferBindingSize = 128u << 20;
+    limits->limits.maxBufferSize = 256u << 20;
+    limits->limits.maxVertexBuffers = 8;
+    limits->limits.maxVertexAttributes = 16;
+    limits->limits.maxComputeWorkgroupSizeX = 256;
+    limits->limits.maxComputeWorkgroupsPerDimension = 65535;
+    limits->limits.maxComputeInvocationsPerWorkgroup = 256;
+    limits->limits.minUniformBufferOffsetAlignment = 256;
+    limits->limits.minStorageBufferOffsetAlignment = 256;
+    return true;
+}
+
+// Every device shares one queue. Nano gets the queue whenever it needs it
+// without releasing it, so it is not counted as an object.
+WGPUQueue wgpuDeviceGetQueue(WGPUDevice device) {
+    MOCK_CALL();
+    (void)device;
+    return (WGPUQueue)&mock.queue;
+}
+
+void wgpuQueueRelease(WGPUQueue queue) {
+    MOCK_CALL();
+    (void)queue;
+}
+
+void wgpuDeviceSetUncapturedErrorCallback(WGPUDevice device,
+                                          WGPUErrorCallback callback,
+                                          void *userdata) {
+    MOCK_CALL();
+    (void)device;
+    (void)callback;
+    (void)userdata;
+}
+
+void wgpuDevicePushErrorScope(WGPUDevice device, WGPUErrorFilter filter) {
+    MOCK_CALL();
+    (void)device;
+    (void)filter;
+}
+
+void wgpuDevicePopErrorScope(WGPUDevice device, WGPUErrorCallback callback,
+                             void *userdata) {
+    MOCK_CALL();
+    (void)device;
+    if (callback != NULL) {
+        callback(WGPUErrorType_NoError, "", userdata);
+    }
+}
+
+// Swapchain
+// ----------------------------------------------------------------------------
+
+WGPUSwapChain wgpuDeviceCreateSwapChain(
+    WGPUDevice device, WGPUSurface surface,
+    WGPUSwapChainDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)surface;
+    (void)descriptor;
+    mock_object_t *swapchain = _mock_create("WGPUSwapChain");
+    swapchain->view = _mock_create("WGPUTextureView");
+    return (WGPUSwapChain)swapchain;
+}
+
+// The browser hands out the same view for the whole frame
+WGPUTextureView wgpuSwapChainGetCurrentTextureView(WGPUSwapChain swapchain) {
+    MOCK_CALL();
+    return (WGPUTextureView)((mock_object_t *)swapchain)->view;
+}
+
+void wgpuSwapChainRelease(WGPUSwapChain swapchain) {
+    MOCK_CALL();
+    _mock_release(swapchain);
+}
+
+// Resources
+// ----------------------------------------------------------------------------
+
+WGPUBuffer wgpuDeviceCreateBuffer(WGPUDevice device,
+                                  WGPUBufferDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    mock_object_t *buffer = _mock_create("WGPUBuffer");
+    buffer->size = descriptor->size;
+    if (descriptor->mappedAtCreation) {
+        buffer->mapped = __real_calloc(1, descriptor->size);
+    }
+    mock.stats.buffers_created++;
+    mock.stats.buffer_bytes += descriptor->size;
+    return (WGPUBuffer)buffer;
+}
+
+void wgpuBufferDestroy(WGPUBuffer buffer) {
+    MOCK_CALL();
+    mock_object_t *object = (mock_object_t *)buffer;
+    if (object != NULL) {
+        __real_free(object->mapped);
+        object->mapped = NULL;
+    }
+}
+
+void wgpuBufferRelease(WGPUBuffer buffer) {
+    MOCK_CALL();
+    _mock_release(buffer);
+}
+
+void wgpuBufferMapAsync(WGPUBuffer buffer, WGPUMapModeFlags mode,
+                        size_t offset, size_t size,
+                        WGPUBufferMapCallback callback, void *userdata) {
+    MOCK_CALL();
+    (void)mode;
+    (void)offset;
+    (void)size;
+    mock_object_t *object = (mock_object_t *)buffer;
+    if (object->mapped == NULL) {
+        object->mapped = __real_calloc(1, object->size);
+    }
+    _mock_defer((mock_pending_t){.map_cb = callback, .userdata = userdata});
+}
+
+void *wgpuBufferGetMappedRange(WGPUBuffer buffer, size_t offset, size_t size) {
+    MOCK_CALL();
+    (void)size;
+    mock_object_t *object = (mock_object_t *)buffer;
+    if (object->mapped == NULL) {
+        return NULL;
+    }
+    return (char *)object->mapped + offset;
+}
+
+void const *wgpuBufferGetConstMappedRange(WGPUBuffer buffer, size_t offset,
+                                          size_t size) {
+    MOCK_CALL();
+    (void)size;
+    mock_object_t *object = (mock_object_t *)buffer;
+    if (object->mapped == NULL) {
+        return NULL;
+    }
+    return (const char *)object->mapped + offset;
+}
+
+void wgpuBufferUnmap(WGPUBuffer buffer) {
+    MOCK_CALL();
+    mock_object_t *object = (mock_object_t *)buffer;
+    __real_free(object->mapped);
+    object->mapped = NULL;
+}
+
+WGPUTexture wgpuDeviceCreateTexture(WGPUDevice device,
+                                    WGPUTextureDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUTexture)_mock_create("WGPUTexture");
+}
+
+WGPUTextureView
+wgpuTextureCreateView(WGPUTexture texture,
+                      WGPUTextureViewDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)texture;
+    (void)descriptor;
+    return (WGPUTextureView)_mock_create("WGPUTextureView");
+}
+
+void wgpuTextureDestroy(WGPUTexture texture) {
+    MOCK_CALL();
+    (void)texture;
+}
+
+void wgpuTextureRelease(WGPUTexture texture) {
+    MOCK_CALL();
+    _mock_release(texture);
+}
+
+void wgpuTextureViewRelease(WGPUTextureView view) {
+    MOCK_CALL();
+    _mock_release(view);
+}
+
+WGPUSampler wgpuDeviceCreateSampler(WGPUDevice device,
+                                    WGPUSamplerDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUSampler)_mock_create("WGPUSampler");
+}
+
+void wgpuSamplerRelease(WGPUSampler sampler) {
+    MOCK_CALL();
+    _mock_release(sampler);
+}
+
+// Shaders, Layouts and Pipelines
+// ----------------------------------------------------------------------------
+
+WGPUShaderModule
+wgpuDeviceCreateShaderModule(WGPUDevice device,
+                             WGPUShaderModuleDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUShaderModule)_mock_create("WGPUShaderModule");
+}
+
+void wgpuShaderModuleRelease(WGPUShaderModule module) {
+    MOCK_CALL();
+    _mock_release(module);
+}
+
+WGPUBindGroupLayout wgpuDeviceCreateBindGroupLayout(
+    WGPUDevice device, WGPUBindGroupLayoutDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUBindGroupLayout)_mock_create("WGPUBindGroupLayout");
+}
+
+void wgpuBindGroupLayoutRelease(WGPUBindGroupLayout layout) {
+    MOCK_CALL();
+    _mock_release(layout);
+}
+
+WGPUBindGroup wgpuDeviceCreateBindGroup(
+    WGPUDevice device, WGPUBindGroupDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUBindGroup)_mock_create("WGPUBindGroup");
+}
+
+void wgpuBindGroupRelease(WGPUBindGroup group) {
+    MOCK_CALL();
+    _mock_release(group);
+}
+
+WGPUPipelineLayout wgpuDeviceCreatePipelineLayout(
+    WGPUDevice device, WGPUPipelineLayoutDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUPipelineLayout)_mock_create("WGPUPipelineLayout");
+}
+
+void wgpuPipelineLayoutRelease(WGPUPipelineLayout layout) {
+    MOCK_CALL();
+    _mock_release(layout);
+}
+
+WGPURenderPipeline wgpuDeviceCreateRenderPipeline(
+    WGPUDevice device, WGPURenderPipelineDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPURenderPipeline)_mock_create("WGPURenderPipeline");
+}
+
+void wgpuDeviceCreateRenderPipelineAsync(
+    WGPUDevice device, WGPURenderPipelineDescriptor const *descriptor,
+    WGPUCreateRenderPipelineAsyncCallback callback, void *userdata) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    _mock_defer((mock_pending_t){
+        .render_cb = callback,
+        .object = _mock_create("WGPURenderPipeline"),
+        .userdata = userdata,
+    });
+}
+
+WGPUBindGroupLayout
+wgpuRenderPipelineGetBindGroupLayout(WGPURenderPipeline pipeline,
+                                     uint32_t group) {
+    MOCK_CALL();
+    (void)pipeline;
+    (void)group;
+    return (WGPUBindGroupLayout)_mock_create("WGPUBindGroupLayout");
+}
+
+void wgpuRenderPipelineRelease(WGPURenderPipeline pipeline) {
+    MOCK_CALL();
+    _mock_release(pipeline);
+}
+
+WGPUComputePipeline wgpuDeviceCreateComputePipeline(
+    WGPUDevice device, WGPUComputePipelineDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUComputePipeline)_mock_create("WGPUComputePipeline");
+}
+
+void wgpuDeviceCreateComputePipelineAsync(
+    WGPUDevice device, WGPUComputePipelineDescriptor const *descriptor,
+    WGPUCreateComputePipelineAsyncCallback callback, void *userdata) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    _mock_defer((mock_pending_t){
+        .compute_cb = callback,
+        .object = _mock_create("WGPUComputePipeline"),
+        .userdata = userdata,
+    });
+}
+
+void wgpuComputePipelineRelease(WGPUComputePipeline pipeline) {
+    MOCK_CALL();
+    _mock_release(pipeline);
+}
+
+// Command Encoding
+// ----------------------------------------------------------------------------
+
+WGPUCommandEncoder wgpuDeviceCreateCommandEncoder(
+    WGPUDevice device, WGPUCommandEncoderDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)device;
+    (void)descriptor;
+    return (WGPUCommandEncoder)_mock_create("WGPUCommandEncoder");
+}
+
+void wgpuCommandEncoderRelease(WGPUCommandEncoder encoder) {
+    MOCK_CALL();
+    _mock_release(encoder);
+}
+
+WGPUCommandBuffer
+wgpuCommandEncoderFinish(WGPUCommandEncoder encoder,
+                         WGPUCommandBufferDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)encoder;
+    (void)descriptor;
+    return (WGPUCommandBuffer)_mock_create("WGPUCommandBuffer");
+}
+
+void wgpuCommandBufferRelease(WGPUCommandBuffer buffer) {
+    MOCK_CALL();
+    _mock_release(buffer);
+}
+
+void wgpuCommandEncoderClearBuffer(WGPUCommandEncoder encoder,
+                                   WGPUBuffer buffer, uint64_t offset,
+                                   uint64_t size) {
+    MOCK_CALL();
+    (void)encoder;
+    (void)buffer;
+    (void)offset;
+    (void)size;
+}
+
+void wgpuCommandEncoderCopyBufferToBuffer(WGPUCommandEncoder encoder,
+                                          WGPUBuffer source,
+                                          uint64_t source_offset,
+                                          WGPUBuffer destination,
+                                          uint64_t destination_offset,
+                                          uint64_t size) {
+    MOCK_CALL();
+    (void)encoder;
+    (void)source;
+    (void)source_offset;
+    (void)destination;
+    (void)destination_offset;
+    mock.stats.bytes_copied += size;
+}
+
+WGPURenderPassEncoder
+wgpuCommandEncoderBeginRenderPass(WGPUCommandEncoder encoder,
+                                  WGPURenderPassDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)encoder;
+    (void)descriptor;
+    mock.stats.passes++;
+    return (WGPURenderPassEncoder)_mock_create("WGPURenderPassEncoder");
+}
+
+void wgpuRenderPassEncoderSetPipeline(WGPURenderPassEncoder pass,
+                                      WGPURenderPipeline pipeline) {
+    MOCK_CALL();
+    (void)pass;
+    (void)pipeline;
+}
+
+void wgpuRenderPassEncoderSetBindGroup(WGPURenderPassEncoder pass,
+                                       uint32_t index, WGPUBindGroup group,
+                                       size_t dynamic_offset_count,
+                                       uint32_t const *dynamic_offsets) {
+    MOCK_CALL();
+    (void)pass;
+    (void)index;
+    (void)group;
+    (void)dynamic_offset_count;
+    (void)dynamic_offsets;
+}
+
+void wgpuRenderPassEncoderSetVertexBuffer(WGPURenderPassEncoder pass,
+                                          uint32_t slot, WGPUBuffer buffer,
+                                          uint64_t offset, uint64_t size) {
+    MOCK_CALL();
+    (void)pass;
+    (void)slot;
+    (void)buffer;
+    (void)offset;
+    (void)size;
+}
+
+void wgpuRenderPassEncoderSetIndexBuffer(WGPURenderPassEncoder pass,
+                                         WGPUBuffer buffer,
+                                         WGPUIndexFormat format,
+                                         uint64_t offset, uint64_t size) {
+    MOCK_CALL();
+    (void)pass;
+    (void)buffer;
+    (void)format;
+    (void)offset;
+    (void)size;
+}
+
+void wgpuRenderPassEncoderSetScissorRect(WGPURenderPassEncoder pass,
+                                         uint32_t x, uint32_t y,
+                                         uint32_t width, uint32_t height) {
+    MOCK_CALL();
+    (void)pass;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+}
+
+void wgpuRenderPassEncoderDraw(WGPURenderPassEncoder pass,
+                               uint32_t vertex_count, uint32_t instance_count,
+                               uint32_t first_vertex,
+                               uint32_t first_instance) {
+    MOCK_CALL();
+    (void)pass;
+    (void)vertex_count;
+    (void)instance_count;
+    (void)first_vertex;
+    (void)first_instance;
+    mock.stats.draws++;
+}
+
+void wgpuRenderPassEncoderDrawIndexed(WGPURenderPassEncoder pass,
+                                      uint32_t index_count,
+                                      uint32_t instance_count,
+                                      uint32_t first_index,
+                                      int32_t base_vertex,
+                                      uint32_t first_instance) {
+    MOCK_CALL();
+    (void)pass;
+    (void)index_count;
+    (void)instance_count;
+    (void)first_index;
+    (void)base_vertex;
+    (void)first_instance;
+    mock.stats.draws++;
+}
+
+void wgpuRenderPassEncoderDrawIndirect(WGPURenderPassEncoder pass,
+                                       WGPUBuffer indirect_buffer,
+                                       uint64_t indirect_offset) {
+    MOCK_CALL();
+    (void)pass;
+    (void)indirect_buffer;
+    (void)indirect_offset;
+    mock.stats.draws++;
+}
+
+void wgpuRenderPassEncoderDrawIndexedIndirect(WGPURenderPassEncoder pass,
+                                              WGPUBuffer indirect_buffer,
+                                              uint64_t indirect_offset) {
+    MOCK_CALL();
+    (void)pass;
+    (void)indirect_buffer;
+    (void)indirect_offset;
+    mock.stats.draws++;
+}
+
+void wgpuRenderPassEncoderEnd(WGPURenderPassEncoder pass) {
+    MOCK_CALL();
+    (void)pass;
+}
+
+void wgpuRenderPassEncoderRelease(WGPURenderPassEncoder pass) {
+    MOCK_CALL();
+    _mock_release(pass);
+}
+
+WGPUComputePassEncoder wgpuCommandEncoderBeginComputePass(
+    WGPUCommandEncoder encoder, WGPUComputePassDescriptor const *descriptor) {
+    MOCK_CALL();
+    (void)encoder;
+    (void)descriptor;
+    mock.stats.passes++;
+    return (WGPUComputePassEncoder)_mock_create("WGPUComputePassEncoder");
+}
+
+void wgpuComputePassEncoderSetPipeline(WGPUComputePassEncoder pass,
+                                       WGPUComputePipeline pipeline) {
+    MOCK_CALL();
+    (void)pass;
+    (void)pipeline;
+}
+
+void wgpuComputePassEncoderSetBindGroup(WGPUComputePassEncoder pass,
+                                        uint32_t index, WGPUBindGroup group,
+                                        size_t dynamic_offset_count,
+                                        uint32_t const *dynamic_offsets) {
+    MOCK_CALL();
+    (void)pass;
+    (void)index;
+    (void)group;
+    (void)dynamic_offset_count;
+    (void)dynamic_offsets;
+}
+
+void wgpuComputePassEncoderDispatchWorkgroups(WGPUComputePassEncoder pass,
+                                              uint32_t x, uint32_t y,
+                                              uint32_t z) {
+    MOCK_CALL();
+    (void)pass;
+    (void)x;
+    (void)y;
+    (void)z;
+    mock.stats.dispatches++;
+}
+
+void wgpuComputePassEncoderEnd(WGPUComputePassEncoder pass) {
+    MOCK_CALL();
+    (void)pass;
+}
+
+void wgpuComputePassEncoderRelease(WGPUComputePassEncoder pass) {
+    MOCK_CALL();
+    _mock_release(pass);
+}
+
+// Queue
+// ----------------------------------------------------------------------------
+
+void wgpuQueueSubmit(WGPUQueue queue, size_t count,
+                     WGPUCommandBuffer const *buffers) {
+    MOCK_CALL();
+    (void)queue;
+    (void)buffers;
+    mock.stats.submits += count;
+}
+
+void wgpuQueueWriteBuffer(WGPUQueue queue, WGPUBuffer buffer,
+                          uint64_t offset, void const *data, size_t size) {
+    MOCK_CALL();
+    (void)queue;
+    (void)buffer;
+    (void)offset;
+    (void)data;
+    mock.stats.bytes_written += size;
+}
+
+void wgpuQueueWriteTexture(WGPUQueue queue,
+                           WGPUImageCopyTexture const *destination,
+                           void const *data, size_t size,
+                           WGPUTextureDataLayout const *layout,
+                           WGPUExtent3D const *write_size) {
+    MOCK_CALL();
+    (void)queue;
+    (void)destination;
+    (void)data;
+    (void)layout;
+    (void)write_size;
+    mock.stats.bytes_written += size;
+}
+
+void wgpuQueueOnSubmittedWorkDone(WGPUQueue queue,
+                                  WGPUQueueWorkDoneCallback callback,
+                                  void *userdata) {
+    MOCK_CALL();
+    (void)queue;
+    _mock_defer((mock_pending_t){.done_cb = callback, .userdata = userdata});
+}
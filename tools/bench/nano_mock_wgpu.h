@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------
+//  nano_mock_wgpu.h
+//  --------------------------------------------------------------------
+//  Recording stand-in for WebGPU and the Emscripten runtime
+//  --------------------------------------------------------------------
+//
+//  nano_mock_wgpu.c defines every wgpu* and emscripten_* function that
+//  nano.h and nano_web.h call. Linking it instead of the browser runtime
+//  lets Nano run natively with no device: handles are small fake objects,
+//  adapter and device requests succeed right away, and buffer maps, work
+//  done callbacks and asynchronous pipelines are delivered between frames
+//  like in the browser.
+//
+//  Nothing is executed. The mock counts every call per entry point, the
+//  objects that are created and still alive, the bytes that would have
+//  been uploaded or copied, and the passes, draws and dispatches that were
+//  recorded, so the CPU side of Nano can be measured on its own.
+//
+//  Heap allocations are counted through the linker's --wrap option, the
+//  program must be linked with
+//      -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free
+//  The mock's own objects are not counted.
+//
+//  The requestAnimationFrame loop is not started automatically. After
+//  nano_start_app() returns, call nano_mock_run_frames() to run frames.
+//
+//  --------------------------------------------------------------------
+
+#ifndef NANO_MOCK_WGPU_H
+#define NANO_MOCK_WGPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct nano_mock_stats_t {
+    // Calls to any wgpu* function
+    uint64_t calls;
+
+    // Objects created since the last reset, and alive right now
+    uint64_t objects_created;
+    int64_t objects_live;
+
+    // Buffers created and their total size
+    uint64_t buffers_created;
+    uint64_t buffer_bytes;
+
+    // Bytes passed to wgpuQueueWriteBuffer() and wgpuQueueWriteTexture()
+    uint64_t bytes_written;
+    // Bytes copied by wgpuCommandEncoderCopyBufferToBuffer()
+    uint64_t bytes_copied;
+
+    uint64_t passes;
+    uint64_t draws;
+    uint64_t dispatches;
+    uint64_t submits;
+
+    // Heap allocations outside the mock
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t alloc_bytes;
+} nano_mock_stats_t;
+
+// Reset every counter, objects_live is kept
+void nano_mock_reset_stats(void);
+nano_mock_stats_t nano_mock_get_stats(void);
+
+// Number of calls to one entry point since the last reset
+uint64_t nano_mock_calls(const char *entry_point);
+
+// Print the entry points called since the last reset and their counts
+void nano_mock_print_calls(FILE *out);
+
+// Size reported for the canvas, 1280x720 by default. Takes effect when
+// the app starts.
+void nano_mock_set_canvas_size(int width, int height);
+
+// Optional features reported by the adapter, none by default
+void nano_mock_set_features(bool shader_f16, bool subgroups);
+
+// Deliver the buffer map, work done and pipeline callbacks that are pending
+void nano_mock_flush_callbacks(void);
+
+// Run count iterations of the animation frame loop. Returns false if the
+// loop was never started or the frame callback stopped it.
+bool nano_mock_run_frames(int count);
+
+// Milliseconds from a monotonic clock, the same clock emscripten_get_now()
+// returns in the mock
+double nano_mock_now(void);
+
+#endif // NANO_MOCK_WGPU_H
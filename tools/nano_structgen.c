@@ -0,0 +1,104 @@
+// ---------------------------------------------------------------------
+//  nano_structgen.c
+//  --------------------------------------------------------------------
+//  Generate C headers from the structs in a WGSL shader
+//  --------------------------------------------------------------------
+//
+//  This is a native tool, build it with the host compiler:
+//
+//      cc -std=c11 -I include tools/nano_structgen.c -o nano_structgen
+//
+//  Usage:
+//
+//      nano_structgen <shader.wgsl> <output.h> [type prefix]
+//
+//  Every struct used by a var<uniform> or var<storage> binding is written
+//  to the header, see nano_reflect_write_header() in nano_reflect.h.
+//
+//  --------------------------------------------------------------------
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nano_reflect.h"
+
+// Read the whole file into a string that must be freed
+static char *read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    size_t length = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *buffer = (char *)malloc(length + 1);
+    if (buffer) {
+        length = fread(buffer, 1, length, file);
+        buffer[length] = '\0';
+    }
+    fclose(file);
+
+    return buffer;
+}
+
+// Turn the output file name into an include guard, wave_structs.h becomes
+// WAVE_STRUCTS_H
+static void make_guard(const char *path, char *guard, size_t size) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    size_t i = 0;
+    for (; name[i] && i < size - 1; i++) {
+        guard[i] = isalnum((unsigned char)name[i])
+                       ? (char)toupper((unsigned char)name[i])
+                       : '_';
+    }
+    guard[i] = '\0';
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr,
+                "Usage: %s <shader.wgsl> <output.h> [type prefix]\n",
+                argv[0]);
+        return 1;
+    }
+
+    char *source = read_file(argv[1]);
+    if (source == NULL) {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return 1;
+    }
+
+    nano_wgsl_struct_t structs[NANO_REFLECT_MAX_STRUCTS];
+    int count = nano_reflect_structs(source, structs, NANO_REFLECT_MAX_STRUCTS);
+    free(source);
+    if (count < 0) {
+        fprintf(stderr, "Could not reflect the structs in %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (out == NULL) {
+        fprintf(stderr, "Could not open %s\n", argv[2]);
+        return 1;
+    }
+
+    char guard[256];
+    make_guard(argv[2], guard, sizeof(guard));
+
+    const char *source_name = strrchr(argv[1], '/');
+    source_name = source_name ? source_name + 1 : argv[1];
+
+    int written = nano_reflect_write_header(
+        out, structs, count, guard, argc > 3 ? argv[3] : "", source_name);
+    fclose(out);
+
+    printf("Wrote %d struct%s to %s\n", written, written == 1 ? "" : "s",
+           argv[2]);
+    return 0;
+}